@@ -1,6 +1,7 @@
 #include "kv_store.h"
 #include "../consistent_hashing/consistent_hash.h"
-#include <algorithm>
+#include <charconv>
+#include <limits>
 #include <stdexcept>
 
 KeyValueStore::KeyValueStore(int virtualNodesPerNode)
@@ -26,7 +27,7 @@ bool KeyValueStore::addServer(const std::string& serverId) {
     hashRing_->addNode(serverId);
     
     // Initialize empty key list for this server
-    serverKeys_[serverId] = std::vector<std::string>();
+    serverKeys_[serverId] = std::set<std::string>();
     
     return true;
 }
@@ -40,7 +41,7 @@ bool KeyValueStore::removeServer(const std::string& serverId) {
     }
     
     // Get all keys that were on this server
-    std::vector<std::string> keysToReassign = it->second;
+    std::set<std::string> keysToReassign = std::move(it->second);
     
     // Remove server from hash ring
     hashRing_->removeNode(serverId);
@@ -62,12 +63,45 @@ bool KeyValueStore::removeServer(const std::string& serverId) {
 }
 
 bool KeyValueStore::set(const std::string& key, const std::string& value) {
-    if (key.empty()) {
-        return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return setLocked(key, value, true);
+}
+
+std::vector<bool> KeyValueStore::setBatch(const std::vector<std::pair<std::string, std::string>>& entries,
+                                          bool overwrite) {
+    std::vector<bool> stored(entries.size(), false);
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    for (size_t i = 0; i < entries.size(); ++i) {
+        stored[i] = setLocked(entries[i].first, entries[i].second, overwrite);
     }
     
+    return stored;
+}
+
+std::vector<std::pair<std::string, std::string>> KeyValueStore::scan(const std::string& prefix,
+                                                                     const std::string& startAfter,
+                                                                     size_t limit) const {
+    std::vector<std::pair<std::string, std::string>> result;
     std::lock_guard<std::mutex> lock(mutex_);
     
+    // data_ is ordered, so the prefix's keys are one contiguous run
+    auto it = startAfter < prefix ? data_.lower_bound(prefix) : data_.upper_bound(startAfter);
+    for (; it != data_.end() && result.size() < limit; ++it) {
+        if (it->first.compare(0, prefix.size(), prefix) != 0) {
+            break;
+        }
+        result.emplace_back(it->first, it->second);
+    }
+    
+    return result;
+}
+
+bool KeyValueStore::setLocked(const std::string& key, const std::string& value, bool overwrite) {
+    if (key.empty()) {
+        return false;
+    }
+    
     if (hashRing_->getNodeCount() == 0) {
         return false;  // No servers available
     }
@@ -78,29 +112,51 @@ bool KeyValueStore::set(const std::string& key, const std::string& value) {
         return false;
     }
     
-    // Check if key already exists on a different server
-    bool keyExists = (data_.find(key) != data_.end());
-    if (keyExists) {
+    // Store the key-value pair; one lookup both finds and inserts the key
+    auto inserted = data_.try_emplace(key, value);
+    if (!inserted.second) {
+        if (!overwrite) {
+            return false;
+        }
+        inserted.first->second = value;
+        
         // Find old server and remove key from its tracking
         for (auto& pair : serverKeys_) {
-            auto& keys = pair.second;
-            auto keyIt = std::find(keys.begin(), keys.end(), key);
-            if (keyIt != keys.end()) {
-                keys.erase(keyIt);
+            if (pair.second.erase(key) > 0) {
                 break;
             }
         }
     }
     
-    // Store the key-value pair
-    data_[key] = value;
-    
     // Update server key tracking
     updateServerKeys(key, serverId);
     
     return true;
 }
 
+bool KeyValueStore::increment(const std::string& key, uint64_t delta, uint64_t& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    uint64_t current = 0;
+    auto it = data_.find(key);
+    if (it != data_.end()) {
+        const std::string& stored = it->second;
+        auto parsed = std::from_chars(stored.data(), stored.data() + stored.size(), current);
+        if (parsed.ec != std::errc() || parsed.ptr != stored.data() + stored.size()) {
+            return false;
+        }
+    }
+    if (delta > std::numeric_limits<uint64_t>::max() - current) {
+        return false;
+    }
+    
+    if (!setLocked(key, std::to_string(current + delta), true)) {
+        return false;
+    }
+    value = current + delta;
+    return true;
+}
+
 std::string KeyValueStore::get(const std::string& key) const {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -112,6 +168,20 @@ std::string KeyValueStore::get(const std::string& key) const {
     return "";
 }
 
+std::vector<std::string> KeyValueStore::getBatch(const std::vector<std::string>& keys) const {
+    std::vector<std::string> values(keys.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    for (size_t i = 0; i < keys.size(); ++i) {
+        auto it = data_.find(keys[i]);
+        if (it != data_.end()) {
+            values[i] = it->second;
+        }
+    }
+    
+    return values;
+}
+
 bool KeyValueStore::remove(const std::string& key) {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -142,7 +212,7 @@ std::vector<std::string> KeyValueStore::getKeysForServer(const std::string& serv
     
     auto it = serverKeys_.find(serverId);
     if (it != serverKeys_.end()) {
-        return it->second;
+        return std::vector<std::string>(it->second.begin(), it->second.end());
     }
     
     return std::vector<std::string>();
@@ -198,19 +268,14 @@ size_t KeyValueStore::getTotalEntries() const {
 void KeyValueStore::updateServerKeys(const std::string& key, const std::string& serverId) {
     auto it = serverKeys_.find(serverId);
     if (it != serverKeys_.end()) {
-        auto& keys = it->second;
-        // Check if key is not already in the list
-        if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
-            keys.push_back(key);
-        }
+        it->second.insert(key);
     }
 }
 
 void KeyValueStore::removeFromServerKeys(const std::string& key, const std::string& serverId) {
     auto it = serverKeys_.find(serverId);
     if (it != serverKeys_.end()) {
-        auto& keys = it->second;
-        keys.erase(std::remove(keys.begin(), keys.end(), key), keys.end());
+        it->second.erase(key);
     }
 }
 
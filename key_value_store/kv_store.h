@@ -3,10 +3,13 @@
 
 #include <string>
 #include <map>
+#include <set>
 #include <vector>
 #include <mutex>
 #include <memory>
 #include <functional>
+#include <cstdint>
+#include <utility>
 
 // Forward declaration
 class ConsistentHash;
@@ -52,6 +55,41 @@ public:
      */
     bool set(const std::string& key, const std::string& value);
     
+    /**
+     * Store many key-value pairs under one lock, in order
+     * @param entries Pairs to store
+     * @param overwrite Whether existing keys take the new value; if false they
+     *        keep the old one, as do repeats of a key within entries (default: true)
+     * @return One flag per entry: true if the entry was stored
+     */
+    std::vector<bool> setBatch(const std::vector<std::pair<std::string, std::string>>& entries,
+                               bool overwrite = true);
+    
+    /**
+     * Atomically add to a counter stored as a decimal value, e.g. to hand
+     * out blocks of ids to several clients without a read-modify-write race
+     * @param key The key; a missing key counts as 0
+     * @param delta Amount to add; 0 just reads the counter
+     * @param value Output: the counter after the addition
+     * @return true if successful; false if the value isn't a number, the
+     *         addition would overflow, or no server is available
+     */
+    bool increment(const std::string& key, uint64_t delta, uint64_t& value);
+    
+    /**
+     * Read a range of keys sharing a prefix, in key order
+     *
+     * Meant for paging through large key spaces: pass the last key of one
+     * page as startAfter of the next, so the lock is held for one page at a time.
+     * @param prefix Prefix the keys must start with
+     * @param startAfter Only keys greater than this are returned; empty to start at the beginning
+     * @param limit Maximum number of pairs returned
+     * @return Matching key-value pairs, sorted by key
+     */
+    std::vector<std::pair<std::string, std::string>> scan(const std::string& prefix,
+                                                          const std::string& startAfter,
+                                                          size_t limit) const;
+    
     /**
      * Retrieve a value by key
      * @param key The key to look up
@@ -59,6 +97,13 @@ public:
      */
     std::string get(const std::string& key) const;
     
+    /**
+     * Retrieve many values under one lock
+     * @param keys Keys to look up
+     * @return One value per key, in order; empty string where a key is missing
+     */
+    std::vector<std::string> getBatch(const std::vector<std::string>& keys) const;
+    
     /**
      * Delete a key-value pair
      * @param key The key to delete
@@ -119,9 +164,16 @@ public:
 private:
     std::unique_ptr<ConsistentHash> hashRing_;  // Consistent hash ring for server selection
     std::map<std::string, std::string> data_;    // Key-value storage (simplified - in real implementation, this would be distributed)
-    std::map<std::string, std::vector<std::string>> serverKeys_;  // Track which keys belong to which server
+    std::map<std::string, std::set<std::string>> serverKeys_;  // Track which keys belong to which server
     mutable std::mutex mutex_;  // Mutex for thread safety
     
+    /**
+     * Store a key-value pair; the caller holds mutex_
+     * @return false if the key is invalid, no server is available, or the
+     *         key exists and overwrite is false
+     */
+    bool setLocked(const std::string& key, const std::string& value, bool overwrite);
+    
     /**
      * Internal method to update server key tracking
      */
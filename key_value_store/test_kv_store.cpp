@@ -5,6 +5,8 @@
 #include <vector>
 #include <atomic>
 #include <cassert>
+#include <algorithm>
+#include <string>
 
 void testBasicOperations() {
     std::cout << "=== Basic Operations Test ===" << std::endl;
@@ -366,6 +368,100 @@ void testEdgeCases() {
     std::cout << std::endl;
 }
 
+void testBatchAndScan() {
+    std::cout << "=== Batch Set, Get and Scan Test ===" << std::endl;
+    
+    KeyValueStore store;
+    store.addServer("server1");
+    store.addServer("server2");
+    
+    std::vector<std::pair<std::string, std::string>> batch;
+    for (int i = 0; i < 10; ++i) {
+        batch.emplace_back("item:" + std::to_string(i), "value" + std::to_string(i));
+    }
+    batch.emplace_back("other:1", "not an item");
+    std::vector<bool> stored = store.setBatch(batch);
+    std::cout << "Stored " << std::count(stored.begin(), stored.end(), true) << " of "
+              << batch.size() << " entries in one batch" << std::endl;
+    
+    // Without overwrite, existing keys and repeats keep their first value
+    std::vector<bool> merged = store.setBatch({{"item:3", "changed"}, {"item:10", "new"}, {"item:10", "repeat"}}, false);
+    std::cout << "Merge batch stored: " << merged[0] << merged[1] << merged[2]
+              << " (expected 010); item:3 -> " << store.get("item:3")
+              << ", item:10 -> " << store.get("item:10") << std::endl;
+    
+    std::vector<std::string> values = store.getBatch({"item:0", "missing", "item:9"});
+    std::cout << "Batch get: " << values[0] << ", '" << values[1] << "', " << values[2]
+              << " (expected value0, '', value9)" << std::endl;
+    
+    // Page through the "item:" keys, 4 at a time
+    std::string last;
+    int pages = 0;
+    std::cout << "Scanning item: keys in pages of 4:" << std::endl;
+    while (true) {
+        auto page = store.scan("item:", last, 4);
+        if (page.empty()) {
+            break;
+        }
+        std::cout << "  page " << ++pages << ":";
+        for (const auto& entry : page) {
+            std::cout << " " << entry.first;
+        }
+        std::cout << std::endl;
+        last = page.back().first;
+    }
+    std::cout << std::endl;
+}
+
+void testIncrement() {
+    std::cout << "=== Atomic Increment Test ===" << std::endl;
+    
+    KeyValueStore store;
+    store.addServer("server1");
+    
+    // Threads taking blocks of 100 must never get overlapping ranges
+    const int numThreads = 8;
+    const int blocksPerThread = 50;
+    std::vector<std::vector<uint64_t>> ends(numThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&store, &ends, t]() {
+            for (int i = 0; i < blocksPerThread; ++i) {
+                uint64_t end;
+                if (store.increment("counter", 100, end)) {
+                    ends[t].push_back(end);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    std::vector<uint64_t> all;
+    for (const auto& threadEnds : ends) {
+        all.insert(all.end(), threadEnds.begin(), threadEnds.end());
+    }
+    std::sort(all.begin(), all.end());
+    bool disjoint = std::adjacent_find(all.begin(), all.end()) == all.end();
+    std::cout << "Blocks taken: " << all.size() << " (expected " << numThreads * blocksPerThread
+              << "), disjoint: " << (disjoint ? "yes" : "no")
+              << ", counter: " << store.get("counter") << " (expected 40000)" << std::endl;
+    assert(all.size() == size_t(numThreads * blocksPerThread) && disjoint);
+    
+    uint64_t value = 0;
+    store.set("name", "not a number");
+    bool notNumber = store.increment("name", 1, value);
+    store.set("big", "18446744073709551615");
+    bool overflow = store.increment("big", 1, value);
+    bool read = store.increment("big", 0, value);
+    std::cout << "Increment non-number: " << (notNumber ? "Success" : "Failed (expected)")
+              << ", overflow: " << (overflow ? "Success" : "Failed (expected)")
+              << ", read with delta 0: " << value << std::endl;
+    assert(!notNumber && !overflow && read);
+    std::cout << std::endl;
+}
+
 void runAllTests() {
     try {
         testBasicOperations();
@@ -378,6 +474,8 @@ void runAllTests() {
         testConcurrentAccess();
         testServerKeysRetrieval();
         testEdgeCases();
+        testBatchAndScan();
+        testIncrement();
         
         std::cout << "========================================" << std::endl;
         std::cout << "All tests completed successfully!" << std::endl;
@@ -0,0 +1,161 @@
+#include "adaptive_concurrency_limiter.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+AdaptiveConcurrencyLimiter::AdaptiveConcurrencyLimiter(
+    Algorithm algorithm, int initialLimit, int minLimit, int maxLimit, int sampleWindow)
+    : algorithm_(algorithm)
+    , initialLimit_(initialLimit)
+    , minLimit_(minLimit)
+    , maxLimit_(maxLimit)
+    , sampleWindow_(sampleWindow)
+    , limit_(initialLimit)
+    , inFlight_(0)
+    , windowSamples_(0)
+    , windowLatencySumNs_(0)
+    , windowDrops_(0)
+    , windowMaxInFlight_(0)
+    , minLatencyNs_(0)
+    , estimatedLimit_(initialLimit)
+{
+    if (minLimit <= 0 || sampleWindow <= 0) {
+        throw std::invalid_argument("Min limit and sample window must be positive");
+    }
+    if (initialLimit < minLimit || initialLimit > maxLimit) {
+        throw std::invalid_argument("Initial limit must be between min and max limit");
+    }
+}
+
+bool AdaptiveConcurrencyLimiter::onStart() {
+    int current = inFlight_.load(std::memory_order_relaxed);
+    
+    // Claim a slot only while below the limit
+    while (current < limit_.load(std::memory_order_relaxed)) {
+        if (inFlight_.compare_exchange_weak(current, current + 1,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+void AdaptiveConcurrencyLimiter::onComplete(std::chrono::nanoseconds latency) {
+    int inFlight = inFlight_.fetch_sub(1, std::memory_order_release);
+    recordInFlight(inFlight);
+    
+    windowLatencySumNs_.fetch_add(latency.count(), std::memory_order_relaxed);
+    if (windowSamples_.fetch_add(1, std::memory_order_acq_rel) + 1 >= sampleWindow_) {
+        updateLimit();
+    }
+}
+
+void AdaptiveConcurrencyLimiter::onDropped() {
+    int inFlight = inFlight_.fetch_sub(1, std::memory_order_release);
+    recordInFlight(inFlight);
+    
+    windowDrops_.fetch_add(1, std::memory_order_relaxed);
+    if (windowSamples_.fetch_add(1, std::memory_order_acq_rel) + 1 >= sampleWindow_) {
+        updateLimit();
+    }
+}
+
+int AdaptiveConcurrencyLimiter::getLimit() const {
+    return limit_.load(std::memory_order_relaxed);
+}
+
+int AdaptiveConcurrencyLimiter::getInFlight() const {
+    return inFlight_.load(std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds AdaptiveConcurrencyLimiter::getMinLatency() const {
+    return std::chrono::nanoseconds(minLatencyNs_.load(std::memory_order_relaxed));
+}
+
+AdaptiveConcurrencyLimiter::Algorithm AdaptiveConcurrencyLimiter::getAlgorithm() const {
+    return algorithm_;
+}
+
+void AdaptiveConcurrencyLimiter::reset() {
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    
+    estimatedLimit_ = initialLimit_;
+    limit_.store(initialLimit_, std::memory_order_relaxed);
+    windowSamples_.store(0, std::memory_order_relaxed);
+    windowLatencySumNs_.store(0, std::memory_order_relaxed);
+    windowDrops_.store(0, std::memory_order_relaxed);
+    windowMaxInFlight_.store(0, std::memory_order_relaxed);
+    minLatencyNs_.store(0, std::memory_order_relaxed);
+}
+
+void AdaptiveConcurrencyLimiter::updateLimit() {
+    // Whoever holds the lock is already closing this window
+    std::unique_lock<std::mutex> lock(updateMutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    
+    int samples = windowSamples_.exchange(0, std::memory_order_acq_rel);
+    int64_t latencySum = windowLatencySumNs_.exchange(0, std::memory_order_relaxed);
+    int drops = windowDrops_.exchange(0, std::memory_order_relaxed);
+    int maxInFlight = windowMaxInFlight_.exchange(0, std::memory_order_relaxed);
+    int completions = samples - drops;
+    if (samples <= 0) {
+        return;
+    }
+    
+    // Track the no-load latency as the best window average seen so far
+    double minLatency = static_cast<double>(minLatencyNs_.load(std::memory_order_relaxed));
+    double avgLatency = 0.0;
+    if (completions > 0) {
+        avgLatency = static_cast<double>(latencySum) / completions;
+        if (minLatency <= 0.0 || avgLatency < minLatency) {
+            minLatency = avgLatency;
+            minLatencyNs_.store(static_cast<int64_t>(minLatency), std::memory_order_relaxed);
+        }
+    }
+    
+    // Don't grow a limit the caller isn't even using
+    bool appLimited = maxInFlight < estimatedLimit_ / 2;
+    double newLimit = estimatedLimit_;
+    
+    if (drops > 0) {
+        newLimit = estimatedLimit_ * BACKOFF_RATIO;
+    } else if (completions > 0) {
+        switch (algorithm_) {
+            case Algorithm::Aimd:
+                if (avgLatency > minLatency * LATENCY_TOLERANCE) {
+                    newLimit = estimatedLimit_ * BACKOFF_RATIO;
+                } else if (!appLimited) {
+                    newLimit = estimatedLimit_ + 1.0;
+                }
+                break;
+            
+            case Algorithm::Gradient: {
+                // Below 1.0 once latency inflates past the tolerance: shrink proportionally
+                double gradient = std::max(0.5, std::min(1.0,
+                    GRADIENT_TOLERANCE * minLatency / avgLatency));
+                double target = estimatedLimit_ * gradient + std::sqrt(estimatedLimit_);
+                if (appLimited) {
+                    target = std::min(target, estimatedLimit_);
+                }
+                newLimit = estimatedLimit_ * (1.0 - SMOOTHING) + target * SMOOTHING;
+                break;
+            }
+        }
+    }
+    
+    estimatedLimit_ = std::max(static_cast<double>(minLimit_),
+                               std::min(static_cast<double>(maxLimit_), newLimit));
+    limit_.store(static_cast<int>(estimatedLimit_), std::memory_order_relaxed);
+}
+
+void AdaptiveConcurrencyLimiter::recordInFlight(int inFlight) {
+    // Only writes while the window's peak is still rising
+    int peak = windowMaxInFlight_.load(std::memory_order_relaxed);
+    while (inFlight > peak &&
+           !windowMaxInFlight_.compare_exchange_weak(peak, inFlight, std::memory_order_relaxed)) {
+    }
+}
@@ -0,0 +1,136 @@
+#ifndef ADAPTIVE_CONCURRENCY_LIMITER_H
+#define ADAPTIVE_CONCURRENCY_LIMITER_H
+
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Adaptive Concurrency Limiter
+ *
+ * Limits the number of requests in flight instead of the request rate, and
+ * adjusts that limit from observed latency instead of a hand-tuned constant:
+ * - onStart() admits a request if fewer than the current limit are in flight
+ * - onComplete(latency) reports a finished request; onDropped() a failed one
+ * - Every sample window the limit is recomputed from the window's average
+ *   latency relative to the no-load latency (the lowest window average seen)
+ *
+ * Two update rules are available:
+ * - AIMD: +1 while latency stays within tolerance, x0.9 on queueing or drops
+ * - Gradient: scales the limit by minLatency / latency and adds sqrt(limit)
+ *   headroom, converging on the knee of the throughput/latency curve
+ *
+ * In-flight accounting and latency sampling are lock-free; only the thread
+ * that closes a sample window takes a mutex to recompute the limit.
+ */
+class AdaptiveConcurrencyLimiter {
+public:
+    /**
+     * Limit update rule
+     */
+    enum class Algorithm {
+        Aimd,
+        Gradient
+    };
+    
+    /**
+     * Constructor
+     * @param algorithm Limit update rule (default: Gradient)
+     * @param initialLimit Starting concurrency limit (default: 20)
+     * @param minLimit Lowest limit the algorithm may choose (default: 1)
+     * @param maxLimit Highest limit the algorithm may choose (default: 1000)
+     * @param sampleWindow Completions per limit update (default: 50)
+     */
+    explicit AdaptiveConcurrencyLimiter(
+        Algorithm algorithm = Algorithm::Gradient,
+        int initialLimit = 20,
+        int minLimit = 1,
+        int maxLimit = 1000,
+        int sampleWindow = 50
+    );
+    
+    /**
+     * Try to start a request
+     * @return true if the request may proceed (caller must later call onComplete or onDropped),
+     *         false if the concurrency limit is reached
+     */
+    bool onStart();
+    
+    /**
+     * Report that an admitted request finished successfully
+     * @param latency Time the request took
+     */
+    void onComplete(std::chrono::nanoseconds latency);
+    
+    /**
+     * Report that an admitted request failed or timed out (treated as overload)
+     */
+    void onDropped();
+    
+    /**
+     * Get the current concurrency limit
+     * @return Maximum requests allowed in flight
+     */
+    int getLimit() const;
+    
+    /**
+     * Get the number of requests currently in flight
+     * @return Requests started but not yet completed or dropped
+     */
+    int getInFlight() const;
+    
+    /**
+     * Get the current no-load latency estimate
+     * @return Lowest sample window average latency seen (zero before the first window)
+     */
+    std::chrono::nanoseconds getMinLatency() const;
+    
+    /**
+     * Get the limit update rule
+     * @return Algorithm in use
+     */
+    Algorithm getAlgorithm() const;
+    
+    /**
+     * Reset the limit and latency estimates (in-flight requests are kept)
+     * Call after a backend's baseline latency changes for good, e.g. on redeploy.
+     */
+    void reset();
+
+private:
+    Algorithm algorithm_;       // Limit update rule
+    int initialLimit_;          // Starting limit
+    int minLimit_;              // Lower bound for the limit
+    int maxLimit_;              // Upper bound for the limit
+    int sampleWindow_;          // Completions per limit update
+    
+    std::atomic<int> limit_;                    // Current concurrency limit
+    std::atomic<int> inFlight_;                 // Requests currently in flight
+    std::atomic<int> windowSamples_;            // Completions and drops in the current window
+    std::atomic<int64_t> windowLatencySumNs_;   // Latency sum of the current window
+    std::atomic<int> windowDrops_;              // Drops in the current window
+    std::atomic<int> windowMaxInFlight_;        // Peak in-flight count seen in the current window
+    std::atomic<int64_t> minLatencyNs_;         // No-load latency estimate (0 = unknown)
+    
+    std::mutex updateMutex_;    // Serializes limit updates
+    double estimatedLimit_;     // Fractional limit behind limit_ (guarded by updateMutex_)
+    
+    // Tuning constants shared by both algorithms
+    static constexpr double LATENCY_TOLERANCE = 2.0;   // AIMD: latency above tolerance x min means queueing
+    static constexpr double BACKOFF_RATIO = 0.9;       // Multiplicative decrease on drops (and AIMD queueing)
+    static constexpr double GRADIENT_TOLERANCE = 1.5;  // Gradient: latency inflation accepted before shrinking
+    static constexpr double SMOOTHING = 0.2;           // Gradient: weight of the new estimate
+    
+    /**
+     * Close the current sample window and recompute the limit
+     */
+    void updateLimit();
+    
+    /**
+     * Fold an in-flight count into the current window's peak
+     */
+    void recordInFlight(int inFlight);
+};
+
+#endif // ADAPTIVE_CONCURRENCY_LIMITER_H
@@ -0,0 +1,214 @@
+#include "aligned_fixed_window.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+
+uint64_t pack(uint32_t epoch, uint32_t count) {
+    return (static_cast<uint64_t>(epoch) << 32) | count;
+}
+
+uint32_t epochOf(uint64_t word) {
+    return static_cast<uint32_t>(word >> 32);
+}
+
+uint32_t countOf(uint64_t word) {
+    return static_cast<uint32_t>(word);
+}
+
+// True if window a comes after window b (wrap-safe)
+bool isAfter(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b) > 0;
+}
+
+// Number of the aligned window containing the current wall-clock time
+uint32_t currentEpoch(int windowSizeSeconds) {
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+    return static_cast<uint32_t>(seconds / windowSizeSeconds);
+}
+
+// Add count to a packed window word if it fits under max
+bool tryAdd(std::atomic<uint64_t>& state, uint32_t epoch, uint32_t count, uint32_t max) {
+    uint64_t word = state.load(std::memory_order_acquire);
+    
+    for (;;) {
+        uint32_t wordEpoch = epochOf(word);
+        
+        // First request of a new window: start it with our count
+        if (isAfter(epoch, wordEpoch)) {
+            if (state.compare_exchange_weak(word, pack(epoch, count),
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+                return true;
+            }
+            continue;
+        }
+        
+        // Rejection never writes, so a flood of rejected requests doesn't
+        // bounce the cache line between cores
+        if (static_cast<uint64_t>(countOf(word)) + count > max) {
+            return false;
+        }
+        
+        uint64_t prev = state.fetch_add(count, std::memory_order_acq_rel);
+        bool stale = isAfter(epoch, epochOf(prev));
+        if (!stale && static_cast<uint64_t>(countOf(prev)) + count <= max) {
+            return true;
+        }
+        
+        // Lost the race at the limit (or added to a window that has just
+        // ended): take the increment back unless a reset already wiped it
+        uint64_t current = prev + count;
+        while (epochOf(current) == epochOf(prev) &&
+               !state.compare_exchange_weak(current, current - count,
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+        }
+        
+        if (!stale) {
+            return false;
+        }
+        word = state.load(std::memory_order_acquire);
+    }
+}
+
+// Whole units charged for a cost, or 0 if the cost can never be admitted
+uint32_t unitsFor(double cost, int max) {
+    // Negated so NaN is rejected too
+    if (!(cost > 0) || cost > max) {
+        return 0;
+    }
+    return static_cast<uint32_t>(std::ceil(cost));
+}
+
+// Count in the current window, hiding any transient overshoot
+int countIn(const std::atomic<uint64_t>& state, uint32_t epoch, int max) {
+    uint64_t word = state.load(std::memory_order_acquire);
+    if (epochOf(word) != epoch) {
+        return 0;
+    }
+    return std::min(static_cast<int>(countOf(word)), max);
+}
+
+} // namespace
+
+AlignedFixedWindow::AlignedFixedWindow(int maxRequests, int windowSizeSeconds)
+    : maxRequests_(maxRequests)
+    , windowSizeSeconds_(windowSizeSeconds)
+    , state_(0)
+{
+    if (maxRequests <= 0 || windowSizeSeconds <= 0) {
+        throw std::invalid_argument("Max requests and window size must be positive");
+    }
+}
+
+bool AlignedFixedWindow::tryAllow() {
+    return tryAllow(1);
+}
+
+bool AlignedFixedWindow::tryAllow(int count) {
+    return tryAcquire(count);
+}
+
+bool AlignedFixedWindow::tryAcquire(double cost) {
+    uint32_t units = unitsFor(cost, maxRequests_);
+    if (units == 0) {
+        return false;
+    }
+    
+    return tryAdd(state_, currentEpoch(windowSizeSeconds_), units, maxRequests_);
+}
+
+int AlignedFixedWindow::getCurrentCount() const {
+    return countIn(state_, currentEpoch(windowSizeSeconds_), maxRequests_);
+}
+
+int AlignedFixedWindow::getMaxRequests() const {
+    return maxRequests_;
+}
+
+int AlignedFixedWindow::getWindowSizeSeconds() const {
+    return windowSizeSeconds_;
+}
+
+double AlignedFixedWindow::getTimeRemainingInWindow() const {
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+    int64_t windowNanos = static_cast<int64_t>(windowSizeSeconds_) * 1000000000;
+    
+    return (windowNanos - nanos % windowNanos) / 1e9;  // Convert to seconds
+}
+
+void AlignedFixedWindow::reset() {
+    state_.store(pack(currentEpoch(windowSizeSeconds_), 0), std::memory_order_release);
+}
+
+KeyedAlignedFixedWindow::KeyedAlignedFixedWindow(int maxRequests, int windowSizeSeconds,
+                                                 size_t numSlots)
+    : maxRequests_(maxRequests)
+    , windowSizeSeconds_(windowSizeSeconds)
+    , slots_(numSlots)
+{
+    if (maxRequests <= 0 || windowSizeSeconds <= 0) {
+        throw std::invalid_argument("Max requests and window size must be positive");
+    }
+    if (numSlots == 0) {
+        throw std::invalid_argument("Number of slots must be positive");
+    }
+    
+    reset();
+}
+
+bool KeyedAlignedFixedWindow::tryAllow(const std::string& key) {
+    return tryAllow(key, 1);
+}
+
+bool KeyedAlignedFixedWindow::tryAllow(const std::string& key, int count) {
+    return tryAcquire(key, count);
+}
+
+bool KeyedAlignedFixedWindow::tryAcquire(const std::string& key, double cost) {
+    uint32_t units = unitsFor(cost, maxRequests_);
+    if (units == 0) {
+        return false;
+    }
+    
+    return tryAdd(slots_[slotIndex(key)], currentEpoch(windowSizeSeconds_), units, maxRequests_);
+}
+
+int KeyedAlignedFixedWindow::getCurrentCount(const std::string& key) const {
+    return countIn(slots_[slotIndex(key)], currentEpoch(windowSizeSeconds_), maxRequests_);
+}
+
+int KeyedAlignedFixedWindow::getMaxRequests() const {
+    return maxRequests_;
+}
+
+int KeyedAlignedFixedWindow::getWindowSizeSeconds() const {
+    return windowSizeSeconds_;
+}
+
+size_t KeyedAlignedFixedWindow::getNumSlots() const {
+    return slots_.size();
+}
+
+void KeyedAlignedFixedWindow::reset(const std::string& key) {
+    slots_[slotIndex(key)].store(pack(currentEpoch(windowSizeSeconds_), 0), std::memory_order_release);
+}
+
+void KeyedAlignedFixedWindow::reset() {
+    // Window 0 is long past, so every slot reads as empty
+    for (auto& slot : slots_) {
+        slot.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t KeyedAlignedFixedWindow::slotIndex(const std::string& key) const {
+    return std::hash<std::string>()(key) % slots_.size();
+}
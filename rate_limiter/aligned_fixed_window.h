@@ -0,0 +1,182 @@
+#ifndef ALIGNED_FIXED_WINDOW_H
+#define ALIGNED_FIXED_WINDOW_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Aligned Fixed Window Rate Limiter
+ *
+ * A lock-free fixed window counter whose windows are aligned to the Unix
+ * epoch rather than to construction time:
+ * - Window n covers [n * windowSize, (n + 1) * windowSize) seconds since the
+ *   epoch, so every instance (and every host with a synced clock) agrees on
+ *   where windows start and end
+ * - The window number and the request count are packed into one 64-bit
+ *   atomic word (epoch << 32 | count)
+ * - An admission is a single fetch_add in the common case; rejections are a
+ *   plain load, and the first request of a new window resets the word by CAS
+ *
+ * The count may briefly overshoot maxRequests while concurrent requests
+ * race at the limit, but every request that lands over it is rejected and
+ * its increment undone, so no more than maxRequests are ever admitted.
+ *
+ * The packed count is an integer: fractional costs passed to tryAcquire()
+ * are rounded up, so they are charged at most one unit too much.
+ */
+class AlignedFixedWindow {
+public:
+    /**
+     * Constructor
+     * @param maxRequests Maximum number of requests allowed per window
+     * @param windowSizeSeconds Size of each window in seconds
+     */
+    AlignedFixedWindow(int maxRequests, int windowSizeSeconds);
+    
+    /**
+     * Try to allow a request
+     * @return true if request was allowed, false if rate limited
+     */
+    bool tryAllow();
+    
+    /**
+     * Try to allow multiple requests
+     * @param count Number of requests to allow
+     * @return true if all requests were allowed, false otherwise
+     */
+    bool tryAllow(int count);
+    
+    /**
+     * Try to allow a request with an arbitrary cost (fractional costs are rounded up)
+     * @param cost Share of the window's limit the request uses; costs above maxRequests never succeed
+     * @return true if the request was allowed, false if rate limited
+     */
+    bool tryAcquire(double cost);
+    
+    /**
+     * Get the current number of requests in the current window
+     * @return Number of requests in current window
+     */
+    int getCurrentCount() const;
+    
+    /**
+     * Get the maximum requests allowed per window
+     * @return Maximum requests per window
+     */
+    int getMaxRequests() const;
+    
+    /**
+     * Get the window size in seconds
+     * @return Window size in seconds
+     */
+    int getWindowSizeSeconds() const;
+    
+    /**
+     * Get the time remaining in the current window (in seconds)
+     * @return Seconds until the next aligned window starts
+     */
+    double getTimeRemainingInWindow() const;
+    
+    /**
+     * Reset the counter (the current aligned window is kept)
+     */
+    void reset();
+
+private:
+    int maxRequests_;               // Maximum requests per window
+    int windowSizeSeconds_;         // Window size in seconds
+    std::atomic<uint64_t> state_;   // Window number << 32 | request count
+};
+
+/**
+ * Keyed Aligned Fixed Window Rate Limiter
+ *
+ * One aligned fixed window per key, where each key's state is a single
+ * 8-byte packed word in a fixed-size table. Keys are hashed to slots
+ * without storing the key itself; keys that collide share a counter, which
+ * can only make the limiter stricter for them, never more permissive. Size
+ * the table well above the number of active keys to keep that rare.
+ */
+class KeyedAlignedFixedWindow {
+public:
+    /**
+     * Constructor
+     * @param maxRequests Maximum number of requests allowed per key per window
+     * @param windowSizeSeconds Size of each window in seconds
+     * @param numSlots Number of counters in the table (default: 65536, 512 KiB)
+     */
+    KeyedAlignedFixedWindow(int maxRequests, int windowSizeSeconds, size_t numSlots = 65536);
+    
+    /**
+     * Try to allow a request for a key
+     * @param key Client identifier
+     * @return true if request was allowed, false if rate limited
+     */
+    bool tryAllow(const std::string& key);
+    
+    /**
+     * Try to allow multiple requests for a key
+     * @param key Client identifier
+     * @param count Number of requests to allow
+     * @return true if all requests were allowed, false otherwise
+     */
+    bool tryAllow(const std::string& key, int count);
+    
+    /**
+     * Try to allow a request for a key with an arbitrary cost (fractional costs are rounded up)
+     * @param key Client identifier
+     * @param cost Share of the window's limit the request uses; costs above maxRequests never succeed
+     * @return true if the request was allowed, false if rate limited
+     */
+    bool tryAcquire(const std::string& key, double cost);
+    
+    /**
+     * Get the number of requests a key has made in the current window
+     * @param key Client identifier
+     * @return Number of requests in current window (including colliding keys)
+     */
+    int getCurrentCount(const std::string& key) const;
+    
+    /**
+     * Get the maximum requests allowed per key per window
+     * @return Maximum requests per window
+     */
+    int getMaxRequests() const;
+    
+    /**
+     * Get the window size in seconds
+     * @return Window size in seconds
+     */
+    int getWindowSizeSeconds() const;
+    
+    /**
+     * Get the number of counters in the table
+     * @return Number of slots
+     */
+    size_t getNumSlots() const;
+    
+    /**
+     * Reset one key's counter
+     * @param key Client identifier
+     */
+    void reset(const std::string& key);
+    
+    /**
+     * Reset every counter
+     */
+    void reset();
+
+private:
+    int maxRequests_;                           // Maximum requests per key per window
+    int windowSizeSeconds_;                     // Window size in seconds
+    std::vector<std::atomic<uint64_t>> slots_;  // Packed window number << 32 | count per slot
+    
+    /**
+     * Get the index of the counter a key hashes to
+     */
+    size_t slotIndex(const std::string& key) const;
+};
+
+#endif // ALIGNED_FIXED_WINDOW_H
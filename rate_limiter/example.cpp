@@ -6,6 +6,13 @@ void runAllLeakingBucketTests();
 void runAllFixedWindowTests();
 void runAllSlidingWindowLogTests();
 void runAllSlidingWindowCounterTests();
+void runAllShardedTokenBucketTests();
+void runAllAdaptiveConcurrencyLimiterTests();
+void runAllSharedTokenBucketTests();
+void runAllAlignedFixedWindowTests();
+void runAllRateLimiterPolicyTests();
+void runAllKeyedTokenBucketTests();
+void runAllRateLimiterTelemetryTests();
 
 int main() {
     try {
@@ -41,6 +48,48 @@ int main() {
         std::cout << "\n[SLIDING WINDOW COUNTER TESTS]\n" << std::endl;
         runAllSlidingWindowCounterTests();
         
+        std::cout << "\n========================================\n" << std::endl;
+        
+        // Run Sharded Token Bucket tests
+        std::cout << "\n[SHARDED TOKEN BUCKET TESTS]\n" << std::endl;
+        runAllShardedTokenBucketTests();
+        
+        std::cout << "\n========================================\n" << std::endl;
+        
+        // Run Adaptive Concurrency Limiter tests
+        std::cout << "\n[ADAPTIVE CONCURRENCY LIMITER TESTS]\n" << std::endl;
+        runAllAdaptiveConcurrencyLimiterTests();
+        
+        std::cout << "\n========================================\n" << std::endl;
+        
+        // Run Shared Token Bucket tests
+        std::cout << "\n[SHARED TOKEN BUCKET TESTS]\n" << std::endl;
+        runAllSharedTokenBucketTests();
+        
+        std::cout << "\n========================================\n" << std::endl;
+        
+        // Run Aligned Fixed Window tests
+        std::cout << "\n[ALIGNED FIXED WINDOW TESTS]\n" << std::endl;
+        runAllAlignedFixedWindowTests();
+        
+        std::cout << "\n========================================\n" << std::endl;
+        
+        // Run policy-based RateLimiter tests
+        std::cout << "\n[RATE LIMITER POLICY TESTS]\n" << std::endl;
+        runAllRateLimiterPolicyTests();
+        
+        std::cout << "\n========================================\n" << std::endl;
+        
+        // Run Keyed Token Bucket tests
+        std::cout << "\n[KEYED TOKEN BUCKET TESTS]\n" << std::endl;
+        runAllKeyedTokenBucketTests();
+        
+        std::cout << "\n========================================\n" << std::endl;
+        
+        // Run Rate Limiter Telemetry tests
+        std::cout << "\n[RATE LIMITER TELEMETRY TESTS]\n" << std::endl;
+        runAllRateLimiterTelemetryTests();
+        
         std::cout << "\n========================================" << std::endl;
         std::cout << "All tests completed successfully!" << std::endl;
         std::cout << "========================================" << std::endl;
@@ -1,11 +1,12 @@
 #include "fixed_window.h"
 #include <stdexcept>
 #include <algorithm>
+#include <cmath>
 
 FixedWindow::FixedWindow(int maxRequests, int windowSizeSeconds)
     : maxRequests_(maxRequests)
     , windowSizeSeconds_(windowSizeSeconds)
-    , currentCount_(0)
+    , currentCount_(0.0)
     , windowStart_(std::chrono::steady_clock::now())
 {
     if (maxRequests <= 0 || windowSizeSeconds <= 0) {
@@ -18,7 +19,12 @@ bool FixedWindow::tryAllow() {
 }
 
 bool FixedWindow::tryAllow(int count) {
-    if (count <= 0) {
+    return tryAcquire(count);
+}
+
+bool FixedWindow::tryAcquire(double cost) {
+    // Negated so NaN is rejected too
+    if (!(cost > 0)) {
         return false;
     }
     
@@ -27,9 +33,9 @@ bool FixedWindow::tryAllow(int count) {
     // Check if we need to start a new window
     updateWindow();
     
-    // Check if we have capacity for the requests
-    if (currentCount_ + count <= maxRequests_) {
-        currentCount_ += count;
+    // Check if we have capacity for the request's cost
+    if (currentCount_ + cost <= maxRequests_) {
+        currentCount_ += cost;
         return true;
     }
     
@@ -42,10 +48,11 @@ int FixedWindow::getCurrentCount() const {
     // Create a non-const reference to call updateWindow
     const_cast<FixedWindow*>(this)->updateWindow();
     
-    return currentCount_;
+    return static_cast<int>(std::ceil(currentCount_));
 }
 
 int FixedWindow::getMaxRequests() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     return maxRequests_;
 }
 
@@ -65,9 +72,22 @@ double FixedWindow::getTimeRemainingInWindow() const {
     return std::max(0.0, remaining);
 }
 
+void FixedWindow::setMaxRequests(int maxRequests) {
+    if (maxRequests <= 0) {
+        throw std::invalid_argument("Max requests must be positive");
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    updateWindow();
+    
+    currentCount_ *= static_cast<double>(maxRequests) / maxRequests_;
+    maxRequests_ = maxRequests;
+}
+
 void FixedWindow::reset() {
     std::lock_guard<std::mutex> lock(mutex_);
-    currentCount_ = 0;
+    currentCount_ = 0.0;
     windowStart_ = std::chrono::steady_clock::now();
 }
 
@@ -79,7 +99,7 @@ void FixedWindow::updateWindow() {
     
     // If we've moved to a new window, reset the counter
     if (elapsed >= windowSizeSeconds_) {
-        currentCount_ = 0;
+        currentCount_ = 0.0;
         windowStart_ = now;
     }
 }
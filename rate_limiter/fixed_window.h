@@ -35,9 +35,16 @@ public:
      */
     bool tryAllow(int count);
     
+    /**
+     * Try to allow a request with an arbitrary (possibly fractional) cost
+     * @param cost Share of the window's limit the request uses; costs above maxRequests never succeed
+     * @return true if the request was allowed, false if rate limited
+     */
+    bool tryAcquire(double cost);
+    
     /**
      * Get the current number of requests in the current window
-     * @return Number of requests in current window
+     * @return Number of requests in current window, fractional costs rounded up
      */
     int getCurrentCount() const;
     
@@ -59,6 +66,15 @@ public:
      */
     double getTimeRemainingInWindow() const;
     
+    /**
+     * Change the request limit without starting a new window
+     *
+     * The count already admitted in the current window is rescaled by
+     * newMax / oldMax, so a window that was half used stays half used.
+     * @param maxRequests New maximum number of requests per window
+     */
+    void setMaxRequests(int maxRequests);
+    
     /**
      * Reset the counter (start a new window immediately)
      */
@@ -67,7 +83,7 @@ public:
 private:
     int maxRequests_;           // Maximum requests per window
     int windowSizeSeconds_;     // Window size in seconds
-    int currentCount_;          // Current request count
+    double currentCount_;       // Cost admitted in the current window
     std::chrono::steady_clock::time_point windowStart_;  // Start time of current window
     mutable std::mutex mutex_;  // Mutex for thread safety
     
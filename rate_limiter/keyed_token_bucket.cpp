@@ -0,0 +1,293 @@
+#include "keyed_token_bucket.h"
+#include "rate_limiter_telemetry.h"
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+void validateLimits(double capacity, double refillRate) {
+    // Negated so NaN is rejected too
+    if (!(capacity > 0) || !(refillRate > 0)) {
+        throw std::invalid_argument("Capacity and refill rate must be positive");
+    }
+}
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+double parseNumber(const std::string& field, const std::string& path, int lineNumber) {
+    try {
+        size_t used = 0;
+        double value = std::stod(field, &used);
+        if (used == field.size()) {
+            return value;
+        }
+    } catch (const std::exception&) {
+    }
+    throw std::invalid_argument(path + ":" + std::to_string(lineNumber) +
+                                ": invalid number '" + field + "'");
+}
+
+} // namespace
+
+KeyedTokenBucket::KeyedTokenBucket(double capacity, double refillRate, size_t numShards)
+    : shards_(numShards)
+    , telemetry_(nullptr)
+{
+    validateLimits(capacity, refillRate);
+    if (numShards == 0) {
+        throw std::invalid_argument("Number of shards must be positive");
+    }
+    
+    auto table = std::make_shared<LimitTable>();
+    table->defaults = {capacity, refillRate};
+    table->version = 1;
+    std::atomic_store(&table_, std::shared_ptr<const LimitTable>(std::move(table)));
+}
+
+bool KeyedTokenBucket::tryConsume(const std::string& key) {
+    return tryConsume(key, 1);
+}
+
+bool KeyedTokenBucket::tryConsume(const std::string& key, int tokens) {
+    return tryAcquire(key, tokens);
+}
+
+bool KeyedTokenBucket::tryAcquire(const std::string& key, double cost) {
+    // Negated so NaN is rejected too
+    if (!(cost > 0)) {
+        return false;
+    }
+    
+    // Hold a reference so a concurrent reload can't free the table under us
+    std::shared_ptr<const LimitTable> table = std::atomic_load(&table_);
+    auto now = std::chrono::steady_clock::now();
+    
+    // Hashed once for both the shard and the telemetry key shard
+    size_t hash = std::hash<std::string>()(key);
+    Shard& shard = shardFor(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    auto it = shard.buckets.find(key);
+    if (it == shard.buckets.end()) {
+        const Limits& limits = table->limitsFor(key);
+        it = shard.buckets.emplace(key, Bucket{limits.capacity, now, limits, table->version}).first;
+    }
+    
+    Bucket& bucket = it->second;
+    settle(bucket, key, *table, now);
+    
+    bool allowed = bucket.tokens >= cost;
+    if (allowed) {
+        bucket.tokens -= cost;
+    }
+    
+    RateLimiterTelemetry* telemetry = telemetry_.load(std::memory_order_relaxed);
+    if (telemetry) {
+        telemetry->recordRemaining(hash, key, allowed, bucket.tokens, bucket.limits.capacity);
+    }
+    
+    return allowed;
+}
+
+double KeyedTokenBucket::getAvailableTokens(const std::string& key) const {
+    std::shared_ptr<const LimitTable> table = std::atomic_load(&table_);
+    auto now = std::chrono::steady_clock::now();
+    
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    auto it = shard.buckets.find(key);
+    if (it == shard.buckets.end()) {
+        return table->limitsFor(key).capacity;
+    }
+    
+    settle(it->second, key, *table, now);
+    return it->second.tokens;
+}
+
+KeyedTokenBucket::Limits KeyedTokenBucket::getLimits(const std::string& key) const {
+    return std::atomic_load(&table_)->limitsFor(key);
+}
+
+KeyedTokenBucket::Limits KeyedTokenBucket::getDefaultLimits() const {
+    return std::atomic_load(&table_)->defaults;
+}
+
+uint64_t KeyedTokenBucket::getLimitsVersion() const {
+    return std::atomic_load(&table_)->version;
+}
+
+size_t KeyedTokenBucket::getNumKeys() const {
+    size_t total = 0;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.buckets.size();
+    }
+    return total;
+}
+
+void KeyedTokenBucket::setDefaultLimits(double capacity, double refillRate) {
+    validateLimits(capacity, refillRate);
+    
+    publish([capacity, refillRate](LimitTable& table) {
+        table.defaults = {capacity, refillRate};
+    });
+}
+
+void KeyedTokenBucket::setLimits(const std::string& key, double capacity, double refillRate) {
+    validateLimits(capacity, refillRate);
+    
+    publish([&key, capacity, refillRate](LimitTable& table) {
+        table.overrides[key] = {capacity, refillRate};
+    });
+}
+
+void KeyedTokenBucket::clearLimits(const std::string& key) {
+    publish([&key](LimitTable& table) {
+        table.overrides.erase(key);
+    });
+}
+
+void KeyedTokenBucket::replaceLimits(const Limits& defaults,
+                                     const std::unordered_map<std::string, Limits>& overrides) {
+    validateLimits(defaults.capacity, defaults.refillRate);
+    for (const auto& entry : overrides) {
+        validateLimits(entry.second.capacity, entry.second.refillRate);
+    }
+    
+    publish([&defaults, &overrides](LimitTable& table) {
+        table.defaults = defaults;
+        table.overrides = overrides;
+    });
+}
+
+size_t KeyedTokenBucket::loadLimitsFromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open limit file: " + path);
+    }
+    
+    Limits defaults = getDefaultLimits();
+    std::unordered_map<std::string, Limits> overrides;
+    
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, ',')) {
+            fields.push_back(trim(field));
+        }
+        if (fields.size() != 3 || fields[0].empty()) {
+            throw std::invalid_argument(path + ":" + std::to_string(lineNumber) +
+                                        ": expected key,capacity,refillRate");
+        }
+        
+        Limits limits{parseNumber(fields[1], path, lineNumber), parseNumber(fields[2], path, lineNumber)};
+        if (!(limits.capacity > 0) || !(limits.refillRate > 0)) {
+            throw std::invalid_argument(path + ":" + std::to_string(lineNumber) +
+                                        ": capacity and refill rate must be positive");
+        }
+        
+        if (fields[0] == "*") {
+            defaults = limits;
+        } else {
+            overrides[fields[0]] = limits;
+        }
+    }
+    
+    size_t loaded = overrides.size();
+    publish([&defaults, &overrides](LimitTable& table) {
+        table.defaults = defaults;
+        table.overrides = std::move(overrides);
+    });
+    return loaded;
+}
+
+void KeyedTokenBucket::setTelemetry(RateLimiterTelemetry* telemetry) {
+    telemetry_.store(telemetry, std::memory_order_relaxed);
+}
+
+void KeyedTokenBucket::reset(const std::string& key) {
+    std::shared_ptr<const LimitTable> table = std::atomic_load(&table_);
+    
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    auto it = shard.buckets.find(key);
+    if (it != shard.buckets.end()) {
+        const Limits& limits = table->limitsFor(key);
+        it->second = Bucket{limits.capacity, std::chrono::steady_clock::now(), limits, table->version};
+    }
+}
+
+void KeyedTokenBucket::reset() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.buckets.clear();
+    }
+}
+
+const KeyedTokenBucket::Limits& KeyedTokenBucket::LimitTable::limitsFor(const std::string& key) const {
+    auto it = overrides.find(key);
+    return it == overrides.end() ? defaults : it->second;
+}
+
+KeyedTokenBucket::Shard& KeyedTokenBucket::shardFor(const std::string& key) const {
+    return shardFor(std::hash<std::string>()(key));
+}
+
+KeyedTokenBucket::Shard& KeyedTokenBucket::shardFor(size_t keyHash) const {
+    return shards_[keyHash % shards_.size()];
+}
+
+void KeyedTokenBucket::settle(Bucket& bucket, const std::string& key, const LimitTable& table,
+                              std::chrono::steady_clock::time_point now) const {
+    // Credit the time elapsed so far at the rate that was in force
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now - bucket.lastRefill
+    ).count() / 1e9;  // Convert to seconds
+    
+    if (elapsed > 0) {
+        bucket.tokens = std::min(bucket.limits.capacity,
+                                 bucket.tokens + elapsed * bucket.limits.refillRate);
+        bucket.lastRefill = now;
+    }
+    
+    // Only a key that hasn't seen this table yet pays for the map lookup.
+    // The table was loaded before the shard lock was taken, so another
+    // request may already have settled the bucket with a newer one.
+    if (table.version > bucket.version) {
+        const Limits& limits = table.limitsFor(key);
+        bucket.tokens *= limits.capacity / bucket.limits.capacity;
+        bucket.limits = limits;
+        bucket.version = table.version;
+    }
+}
+
+template <class Edit>
+void KeyedTokenBucket::publish(Edit edit) {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    
+    auto next = std::make_shared<LimitTable>(*std::atomic_load(&table_));
+    edit(*next);
+    next->version++;
+    std::atomic_store(&table_, std::shared_ptr<const LimitTable>(std::move(next)));
+}
@@ -0,0 +1,215 @@
+#ifndef KEYED_TOKEN_BUCKET_H
+#define KEYED_TOKEN_BUCKET_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class RateLimiterTelemetry;
+struct KeyedTokenBucketTest;
+
+/**
+ * Keyed Token Bucket Rate Limiter
+ *
+ * One token bucket per key, with limits that can be re-tuned under load:
+ * - Every key uses the default limits unless the limit table overrides them
+ * - The limit table is immutable and published RCU-style: writers copy it,
+ *   change the copy and swap in a new shared_ptr, so readers never block
+ *   on a reload and always see one complete table
+ * - Buckets pick up a new table lazily on their next request, crediting the
+ *   time elapsed at the old rate and rescaling their tokens by
+ *   newCapacity / oldCapacity, so a reload causes neither a burst nor a
+ *   stall. A request still holding an older table than its bucket has seen
+ *   leaves the bucket's limits alone
+ * - Buckets are spread over independently locked shards
+ *
+ * Limit files are CSV, one "key,capacity,refillRate" line per override;
+ * blank lines and lines starting with '#' are ignored, and the key "*" sets
+ * the defaults.
+ */
+class KeyedTokenBucket {
+public:
+    struct Limits {
+        double capacity;        // Maximum tokens per bucket
+        double refillRate;      // Tokens added per second
+    };
+    
+    /**
+     * Constructor
+     * @param capacity Default maximum number of tokens per key
+     * @param refillRate Default tokens added per second per key
+     * @param numShards Number of independently locked bucket maps (default: 16)
+     */
+    KeyedTokenBucket(double capacity, double refillRate, size_t numShards = 16);
+    
+    /**
+     * Try to consume a token for a key
+     * @param key Client identifier
+     * @return true if token was consumed (request allowed), false otherwise (rate limited)
+     */
+    bool tryConsume(const std::string& key);
+    
+    /**
+     * Try to consume multiple tokens for a key
+     * @param key Client identifier
+     * @param tokens Number of tokens to consume
+     * @return true if all tokens were consumed, false otherwise
+     */
+    bool tryConsume(const std::string& key, int tokens);
+    
+    /**
+     * Try to admit a request for a key with an arbitrary (possibly fractional) cost
+     * @param key Client identifier
+     * @param cost Tokens the request costs; costs above the key's capacity never succeed
+     * @return true if the cost was consumed, false otherwise
+     */
+    bool tryAcquire(const std::string& key, double cost);
+    
+    /**
+     * Get the current number of available tokens for a key
+     * @param key Client identifier
+     * @return Number of tokens currently available (capacity for unseen keys)
+     */
+    double getAvailableTokens(const std::string& key) const;
+    
+    /**
+     * Get the limits currently in force for a key
+     * @param key Client identifier
+     * @return The key's override, or the defaults
+     */
+    Limits getLimits(const std::string& key) const;
+    
+    /**
+     * Get the default limits
+     * @return Limits used by keys without an override
+     */
+    Limits getDefaultLimits() const;
+    
+    /**
+     * Get the number of published limit tables (starts at 1, +1 per change)
+     * @return Version of the current limit table
+     */
+    uint64_t getLimitsVersion() const;
+    
+    /**
+     * Get the number of keys with a bucket
+     * @return Number of tracked keys
+     */
+    size_t getNumKeys() const;
+    
+    /**
+     * Change the default limits
+     * @param capacity New default maximum number of tokens
+     * @param refillRate New default tokens added per second
+     */
+    void setDefaultLimits(double capacity, double refillRate);
+    
+    /**
+     * Override the limits for one key
+     * @param key Client identifier
+     * @param capacity Maximum number of tokens for the key
+     * @param refillRate Tokens added per second for the key
+     */
+    void setLimits(const std::string& key, double capacity, double refillRate);
+    
+    /**
+     * Remove a key's override so it falls back to the defaults
+     * @param key Client identifier
+     */
+    void clearLimits(const std::string& key);
+    
+    /**
+     * Replace every override (and the defaults) in one atomic swap
+     * @param defaults New default limits
+     * @param overrides New per-key limits; keys not listed fall back to the defaults
+     */
+    void replaceLimits(const Limits& defaults, const std::unordered_map<std::string, Limits>& overrides);
+    
+    /**
+     * Replace the limit table with the contents of a CSV file
+     *
+     * The whole file is parsed before anything is published, so a bad file
+     * leaves the current limits in force.
+     * @param path Path to the limit file
+     * @return Number of per-key overrides loaded
+     * @throws std::runtime_error if the file can't be read
+     * @throws std::invalid_argument if a line is malformed (the message names the line)
+     */
+    size_t loadLimitsFromFile(const std::string& path);
+    
+    /**
+     * Record every decision, with its key, into telemetry
+     * @param telemetry Telemetry to record into (must outlive the limiter), or nullptr to stop
+     */
+    void setTelemetry(RateLimiterTelemetry* telemetry);
+    
+    /**
+     * Refill a key's bucket to full capacity
+     * @param key Client identifier
+     */
+    void reset(const std::string& key);
+    
+    /**
+     * Drop every bucket (limits are kept)
+     */
+    void reset();
+
+private:
+    friend struct KeyedTokenBucketTest;
+    
+    // Immutable once published
+    struct LimitTable {
+        Limits defaults;
+        std::unordered_map<std::string, Limits> overrides;
+        uint64_t version;
+        
+        const Limits& limitsFor(const std::string& key) const;
+    };
+    
+    struct Bucket {
+        double tokens;
+        std::chrono::steady_clock::time_point lastRefill;
+        Limits limits;          // Limits the bucket was last settled with
+        uint64_t version;       // Table version those limits came from
+    };
+    
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Bucket> buckets;
+    };
+    
+    std::shared_ptr<const LimitTable> table_;   // Current limit table (atomic_load / atomic_store only)
+    std::mutex writerMutex_;                    // Serializes limit table writers
+    mutable std::vector<Shard> shards_;         // Buckets, partitioned by key hash
+    std::atomic<RateLimiterTelemetry*> telemetry_;  // Decision telemetry, if any
+    
+    /**
+     * Get the shard a key's bucket lives in
+     */
+    Shard& shardFor(const std::string& key) const;
+    
+    /**
+     * Get the shard for a key whose std::hash the caller already has
+     */
+    Shard& shardFor(size_t keyHash) const;
+    
+    /**
+     * Apply the table's limits if they are newer than the bucket's and
+     * refill based on elapsed time (shard mutex must be held)
+     */
+    void settle(Bucket& bucket, const std::string& key, const LimitTable& table,
+                std::chrono::steady_clock::time_point now) const;
+    
+    /**
+     * Publish a copy of the current table with edit applied (writers are serialized)
+     */
+    template <class Edit>
+    void publish(Edit edit);
+};
+
+#endif // KEYED_TOKEN_BUCKET_H
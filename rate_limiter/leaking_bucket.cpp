@@ -1,10 +1,13 @@
 #include "leaking_bucket.h"
 #include <stdexcept>
 #include <cmath>
+#include <algorithm>
+#include <thread>
 
 LeakingBucket::LeakingBucket(int capacity, double leakRate)
     : capacity_(capacity)
     , leakRate_(leakRate)
+    , level_(0.0)
     , lastLeak_(std::chrono::steady_clock::now())
 {
     if (capacity <= 0 || leakRate <= 0) {
@@ -17,7 +20,12 @@ bool LeakingBucket::tryAdd() {
 }
 
 bool LeakingBucket::tryAdd(int count) {
-    if (count <= 0) {
+    return tryAcquire(count);
+}
+
+bool LeakingBucket::tryAcquire(double cost) {
+    // Negated so NaN is rejected too
+    if (!(cost > 0)) {
         return false;
     }
     
@@ -26,43 +34,109 @@ bool LeakingBucket::tryAdd(int count) {
     // Process requests from the bucket based on elapsed time
     leak();
     
-    // Check if we have space for all requests
-    int availableSpace = capacity_ - static_cast<int>(queue_.size());
-    
-    if (availableSpace >= count) {
-        // Add requests to the queue with current timestamp
-        auto now = std::chrono::steady_clock::now();
-        for (int i = 0; i < count; ++i) {
-            queue_.push(now);
-        }
+    // Check if we have space for the whole cost
+    if (level_ + cost <= capacity_) {
+        level_ += cost;
         return true;
     }
     
     return false;
 }
 
+std::chrono::nanoseconds LeakingBucket::reserve(int count) {
+    if (count <= 0) {
+        throw std::invalid_argument("Request count must be positive");
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    leak();
+    
+    // Queue the requests now; anything past capacity waits for the leak to catch up
+    level_ += count;
+    
+    return timeUntilLevel(capacity_);
+}
+
+std::chrono::nanoseconds LeakingBucket::acquire() {
+    return acquire(1);
+}
+
+std::chrono::nanoseconds LeakingBucket::acquire(int count) {
+    auto wait = reserve(count);
+    if (wait.count() > 0) {
+        std::this_thread::sleep_for(wait);
+    }
+    return wait;
+}
+
+bool LeakingBucket::acquireFor(std::chrono::nanoseconds timeout) {
+    return acquireFor(1, timeout);
+}
+
+bool LeakingBucket::acquireFor(int count, std::chrono::nanoseconds timeout) {
+    if (count <= 0) {
+        return false;
+    }
+    
+    std::chrono::nanoseconds wait;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        leak();
+        
+        // Only queue the requests if the wait fits in the timeout
+        wait = timeUntilLevel(std::max(0, capacity_ - count));
+        if (wait > timeout) {
+            return false;
+        }
+        
+        level_ += count;
+    }
+    
+    if (wait.count() > 0) {
+        std::this_thread::sleep_for(wait);
+    }
+    return true;
+}
+
 int LeakingBucket::getQueueSize() const {
     std::lock_guard<std::mutex> lock(mutex_);
     
     // Create a non-const reference to call leak
     const_cast<LeakingBucket*>(this)->leak();
     
-    return static_cast<int>(queue_.size());
+    return static_cast<int>(std::ceil(level_));
 }
 
 int LeakingBucket::getCapacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     return capacity_;
 }
 
 double LeakingBucket::getLeakRate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     return leakRate_;
 }
 
+void LeakingBucket::setLimits(int capacity, double leakRate) {
+    if (capacity <= 0 || leakRate <= 0) {
+        throw std::invalid_argument("Capacity and leak rate must be positive");
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    // Settle the time elapsed so far at the old rate
+    leak();
+    
+    level_ *= static_cast<double>(capacity) / capacity_;
+    capacity_ = capacity;
+    leakRate_ = leakRate;
+}
+
 void LeakingBucket::reset() {
     std::lock_guard<std::mutex> lock(mutex_);
-    while (!queue_.empty()) {
-        queue_.pop();
-    }
+    level_ = 0.0;
     lastLeak_ = std::chrono::steady_clock::now();
 }
 
@@ -72,17 +146,18 @@ void LeakingBucket::leak() {
         now - lastLeak_
     ).count() / 1e9;  // Convert to seconds
     
-    if (elapsed > 0 && !queue_.empty()) {
-        // Calculate how many requests should be processed
-        double requestsToProcess = elapsed * leakRate_;
-        int requestsToRemove = static_cast<int>(std::floor(requestsToProcess));
-        
-        // Remove processed requests from the queue
-        for (int i = 0; i < requestsToRemove && !queue_.empty(); ++i) {
-            queue_.pop();
-        }
-        
+    // Drain continuously; an empty bucket doesn't bank idle time
+    if (elapsed > 0) {
+        level_ = std::max(0.0, level_ - elapsed * leakRate_);
         lastLeak_ = now;
     }
 }
 
+std::chrono::nanoseconds LeakingBucket::timeUntilLevel(double level) const {
+    if (level_ <= level) {
+        return std::chrono::nanoseconds(0);
+    }
+    
+    double seconds = (level_ - level) / leakRate_;
+    return std::chrono::nanoseconds(static_cast<int64_t>(std::ceil(seconds * 1e9)));
+}
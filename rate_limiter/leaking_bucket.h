@@ -3,7 +3,6 @@
 
 #include <chrono>
 #include <mutex>
-#include <queue>
 
 /**
  * Leaking Bucket Rate Limiter
@@ -13,6 +12,9 @@
  * - Requests are processed (leaked) at a fixed rate
  * - If the bucket is full, new requests are rejected
  * - Provides smooth, constant output rate
+ *
+ * The queue is tracked as a fill level rather than one entry per request,
+ * so every operation is O(1) regardless of capacity or request cost.
  */
 class LeakingBucket {
 public:
@@ -36,9 +38,55 @@ public:
      */
     bool tryAdd(int count);
     
+    /**
+     * Try to add a request with an arbitrary (possibly fractional) cost
+     * @param cost Bucket space the request takes; costs above capacity never succeed
+     * @return true if the request was added, false if there isn't enough space
+     */
+    bool tryAcquire(double cost);
+    
+    /**
+     * Reserve space in the bucket without waiting, queueing past capacity if it is full
+     * 
+     * Reservations are served in arrival order: while the bucket is over
+     * capacity, tryAdd() fails and later reservations queue up behind earlier ones.
+     * @param count Number of requests to add
+     * @return Time until the requests fit within capacity (zero if they fit now)
+     */
+    std::chrono::nanoseconds reserve(int count);
+    
+    /**
+     * Wait until there is space for a request and add it
+     * @return Time spent waiting
+     */
+    std::chrono::nanoseconds acquire();
+    
+    /**
+     * Wait until there is space for multiple requests and add them
+     * @param count Number of requests to add
+     * @return Time spent waiting
+     */
+    std::chrono::nanoseconds acquire(int count);
+    
+    /**
+     * Add a request, waiting at most timeout for space
+     * @param timeout Maximum time to wait
+     * @return true if the request was added, false if it would take longer than timeout
+     */
+    bool acquireFor(std::chrono::nanoseconds timeout);
+    
+    /**
+     * Add multiple requests, waiting at most timeout for space
+     * @param count Number of requests to add
+     * @param timeout Maximum time to wait
+     * @return true if the requests were added, false if it would take longer than timeout
+     */
+    bool acquireFor(int count, std::chrono::nanoseconds timeout);
+    
     /**
      * Get the current number of requests in the bucket
-     * @return Number of requests currently queued
+     * @return Number of requests currently queued, fractional costs rounded up
+     *         (above capacity while reservations are outstanding)
      */
     int getQueueSize() const;
     
@@ -54,6 +102,17 @@ public:
      */
     double getLeakRate() const;
     
+    /**
+     * Change the capacity and leak rate without dropping state
+     *
+     * The queue is drained at the old rate up to now, then its level is
+     * rescaled by newCapacity / oldCapacity so the bucket stays as full
+     * relative to its size as it was.
+     * @param capacity New maximum number of requests in the bucket
+     * @param leakRate New requests processed per second
+     */
+    void setLimits(int capacity, double leakRate);
+    
     /**
      * Reset the bucket (clear all queued requests)
      */
@@ -62,7 +121,7 @@ public:
 private:
     int capacity_;              // Maximum requests
     double leakRate_;           // Requests processed per second
-    std::queue<std::chrono::steady_clock::time_point> queue_;  // Queue of request timestamps
+    double level_;              // Queued cost (above capacity while reservations are outstanding)
     std::chrono::steady_clock::time_point lastLeak_;  // Last time requests were leaked
     mutable std::mutex mutex_;  // Mutex for thread safety
     
@@ -70,6 +129,11 @@ private:
      * Process (leak) requests from the bucket based on elapsed time
      */
     void leak();
+    
+    /**
+     * Time until the queue has drained down to the given level (mutex must be held)
+     */
+    std::chrono::nanoseconds timeUntilLevel(double level) const;
 };
 
 #endif // LEAKING_BUCKET_H
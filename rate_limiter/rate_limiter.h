@@ -0,0 +1,591 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Policy-based Rate Limiter
+ *
+ * RateLimiter<Algorithm, ClockPolicy, SyncPolicy> composes the parts that the
+ * standalone limiter classes each hard-wire:
+ * - Algorithm: the admission rule (Config, State and pure functions of them)
+ * - ClockPolicy: where "now" comes from
+ * - SyncPolicy: how State is protected from concurrent access
+ *
+ * Everything is resolved at compile time, so e.g. a per-connection limiter
+ * built from CachedClock and NullSync has no atomic operations at all, while
+ * the same algorithm with SteadyClock and AtomicSync is a lock-free limiter
+ * that can be shared by every thread.
+ *
+ * Algorithms implement:
+ *   struct Config;                                    // Parameters
+ *   struct State;                                     // Mutable state
+ *   static void validate(const Config&);              // Throws std::invalid_argument
+ *   static State initial(const Config&, int64_t now);
+ *   static bool tryAcquire(const Config&, State&, int64_t now, double cost);
+ *   static double available(const Config&, const State&, int64_t now);
+ * All times are nanoseconds on the clock policy's time line. tryAcquire may
+ * update the state on rejection (e.g. to expire old entries), but only in
+ * ways that are harmless to skip, since AtomicSync discards rejected updates.
+ */
+
+// ---------------------------------------------------------------------------
+// Clock policies
+// ---------------------------------------------------------------------------
+
+/**
+ * Reads std::chrono::steady_clock on every call
+ */
+struct SteadyClock {
+    int64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+};
+
+/**
+ * Returns a timestamp that only moves when refresh() is called
+ *
+ * Meant for single-threaded owners that already know the time, e.g. an
+ * event loop calling refresh() once per iteration: admission then costs no
+ * clock read at all. Not thread-safe.
+ */
+class CachedClock {
+public:
+    CachedClock() : nowNs_(SteadyClock().now()) {}
+    
+    int64_t now() const {
+        return nowNs_;
+    }
+    
+    /**
+     * Re-read the steady clock
+     */
+    void refresh() {
+        nowNs_ = SteadyClock().now();
+    }
+
+private:
+    int64_t nowNs_;     // Timestamp of the last refresh
+};
+
+/**
+ * Clock that only moves when told to, for deterministic tests and simulations
+ */
+class ManualClock {
+public:
+    explicit ManualClock(int64_t startNs = 0) : nowNs_(startNs) {}
+    
+    ManualClock(const ManualClock& other) : nowNs_(other.now()) {}
+    
+    int64_t now() const {
+        return nowNs_.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * Move the clock forward
+     * @param delta Time to advance by
+     */
+    void advance(std::chrono::nanoseconds delta) {
+        nowNs_.fetch_add(delta.count(), std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> nowNs_;    // Current simulated time (atomic so tests may advance it from any thread)
+};
+
+// ---------------------------------------------------------------------------
+// Sync policies
+//
+// Each policy provides Cell<State> holding the limiter state:
+//   bool update(F f)  - run f(State&) -> bool; the result is returned
+//   R read(F f) const - run f(const State&) -> R on a consistent snapshot
+//   void store(State) - replace the state
+// ---------------------------------------------------------------------------
+
+/**
+ * No synchronization: for limiters owned by a single thread
+ */
+struct NullSync {
+    template <class State>
+    class Cell {
+    public:
+        explicit Cell(State state) : state_(std::move(state)) {}
+        
+        template <class F>
+        bool update(F&& f) {
+            return f(state_);
+        }
+        
+        template <class F>
+        auto read(F&& f) const {
+            return f(state_);
+        }
+        
+        void store(State state) {
+            state_ = std::move(state);
+        }
+    
+    private:
+        State state_;
+    };
+};
+
+/**
+ * A mutex around the state: works with every algorithm
+ */
+struct MutexSync {
+    template <class State>
+    class Cell {
+    public:
+        explicit Cell(State state) : state_(std::move(state)) {}
+        
+        template <class F>
+        bool update(F&& f) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return f(state_);
+        }
+        
+        template <class F>
+        auto read(F&& f) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return f(state_);
+        }
+        
+        void store(State state) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state_ = std::move(state);
+        }
+    
+    private:
+        State state_;
+        mutable std::mutex mutex_;
+    };
+};
+
+/**
+ * Lock-free: the state lives in one atomic word and is updated by CAS
+ *
+ * Only algorithms whose State fits in 8 bytes qualify (token bucket, leaking
+ * bucket, fixed window); anything bigger fails to compile. A rejected update
+ * is never published.
+ */
+struct AtomicSync {
+    template <class State>
+    class Cell {
+        static_assert(std::is_trivially_copyable<State>::value,
+                      "AtomicSync requires a trivially copyable state");
+        static_assert(sizeof(State) <= sizeof(uint64_t),
+                      "AtomicSync requires a state that fits in one 64-bit word");
+    
+    public:
+        explicit Cell(State state) : state_(state) {}
+        
+        template <class F>
+        bool update(F&& f) {
+            State current = state_.load(std::memory_order_acquire);
+            for (;;) {
+                State next = current;
+                if (!f(next)) {
+                    return false;
+                }
+                if (state_.compare_exchange_weak(current, next,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_acquire)) {
+                    return true;
+                }
+            }
+        }
+        
+        template <class F>
+        auto read(F&& f) const {
+            return f(state_.load(std::memory_order_acquire));
+        }
+        
+        void store(State state) {
+            state_.store(state, std::memory_order_release);
+        }
+    
+    private:
+        std::atomic<State> state_;
+    };
+};
+
+// ---------------------------------------------------------------------------
+// Algorithms
+// ---------------------------------------------------------------------------
+
+/**
+ * Token bucket, stored as a GCRA theoretical arrival time (8 bytes)
+ *
+ * The bucket is full when tat <= now; every token consumed pushes tat one
+ * emission interval (1 / refillRate) into the future, and a request is
+ * rejected if that would put tat more than capacity intervals ahead of now.
+ */
+struct TokenBucketAlgorithm {
+    struct Config {
+        double capacity;        // Maximum tokens
+        double refillRate;      // Tokens per second
+    };
+    
+    struct State {
+        int64_t tat;            // Theoretical arrival time in nanoseconds
+    };
+    
+    static void validate(const Config& config) {
+        if (config.capacity <= 0 || config.refillRate <= 0) {
+            throw std::invalid_argument("Capacity and refill rate must be positive");
+        }
+    }
+    
+    static State initial(const Config&, int64_t now) {
+        return State{now};
+    }
+    
+    static bool tryAcquire(const Config& config, State& state, int64_t now, double cost) {
+        double interval = 1e9 / config.refillRate;
+        int64_t tat = std::max(state.tat, now) + std::llround(cost * interval);
+        if (tat - now > std::llround(config.capacity * interval)) {
+            return false;
+        }
+        state.tat = tat;
+        return true;
+    }
+    
+    static double available(const Config& config, const State& state, int64_t now) {
+        double debt = (std::max(state.tat, now) - now) / 1e9 * config.refillRate;
+        return config.capacity - debt;
+    }
+};
+
+/**
+ * Leaking bucket (as a meter), stored as the time the bucket drains empty (8 bytes)
+ *
+ * available() is the free space in the bucket.
+ */
+struct LeakingBucketAlgorithm {
+    struct Config {
+        double capacity;        // Maximum queued cost
+        double leakRate;        // Cost drained per second
+    };
+    
+    struct State {
+        int64_t drainedAt;      // Time the bucket will be empty, in nanoseconds
+    };
+    
+    static void validate(const Config& config) {
+        if (config.capacity <= 0 || config.leakRate <= 0) {
+            throw std::invalid_argument("Capacity and leak rate must be positive");
+        }
+    }
+    
+    static State initial(const Config&, int64_t now) {
+        return State{now};
+    }
+    
+    static bool tryAcquire(const Config& config, State& state, int64_t now, double cost) {
+        int64_t drainedAt = std::max(state.drainedAt, now) + std::llround(cost * 1e9 / config.leakRate);
+        if (drainedAt - now > std::llround(config.capacity * 1e9 / config.leakRate)) {
+            return false;
+        }
+        state.drainedAt = drainedAt;
+        return true;
+    }
+    
+    static double available(const Config& config, const State& state, int64_t now) {
+        double level = (std::max(state.drainedAt, now) - now) / 1e9 * config.leakRate;
+        return config.capacity - level;
+    }
+};
+
+/**
+ * Fixed window counter, stored as window number plus count (8 bytes)
+ *
+ * Windows are aligned to multiples of the window size on the clock's time
+ * line. The count is a float, which is exact for whole costs up to 2^24, so
+ * maxRequests is limited to that.
+ */
+struct FixedWindowAlgorithm {
+    struct Config {
+        int maxRequests;        // Maximum requests per window
+        int windowSizeSeconds;  // Window size in seconds
+    };
+    
+    struct State {
+        uint32_t window;        // Window number
+        float count;            // Cost admitted in that window
+    };
+    
+    static void validate(const Config& config) {
+        if (config.maxRequests <= 0 || config.windowSizeSeconds <= 0) {
+            throw std::invalid_argument("Max requests and window size must be positive");
+        }
+        if (config.maxRequests > (1 << 24)) {
+            throw std::invalid_argument("Max requests must not exceed 2^24");
+        }
+    }
+    
+    static State initial(const Config& config, int64_t now) {
+        return State{windowAt(config, now), 0.0f};
+    }
+    
+    static bool tryAcquire(const Config& config, State& state, int64_t now, double cost) {
+        uint32_t window = windowAt(config, now);
+        if (state.window != window) {
+            state.window = window;
+            state.count = 0.0f;
+        }
+        if (state.count + cost > config.maxRequests) {
+            return false;
+        }
+        state.count += static_cast<float>(cost);
+        return true;
+    }
+    
+    static double available(const Config& config, const State& state, int64_t now) {
+        double count = state.window == windowAt(config, now) ? state.count : 0.0;
+        return config.maxRequests - count;
+    }
+    
+    static uint32_t windowAt(const Config& config, int64_t now) {
+        return static_cast<uint32_t>(now / (config.windowSizeSeconds * int64_t(1000000000)));
+    }
+};
+
+/**
+ * Sliding window log: one (timestamp, cost) entry per admitted request
+ */
+struct SlidingWindowLogAlgorithm {
+    struct Config {
+        int maxRequests;        // Maximum requests in the window
+        int windowSizeSeconds;  // Window size in seconds
+    };
+    
+    struct State {
+        std::deque<std::pair<int64_t, double>> log;    // (timestamp, cost), oldest first
+        double total = 0.0;                             // Sum of costs in the log
+    };
+    
+    static void validate(const Config& config) {
+        if (config.maxRequests <= 0 || config.windowSizeSeconds <= 0) {
+            throw std::invalid_argument("Max requests and window size must be positive");
+        }
+    }
+    
+    static State initial(const Config&, int64_t) {
+        return State();
+    }
+    
+    static bool tryAcquire(const Config& config, State& state, int64_t now, double cost) {
+        int64_t windowStart = now - config.windowSizeSeconds * int64_t(1000000000);
+        while (!state.log.empty() && state.log.front().first <= windowStart) {
+            state.total -= state.log.front().second;
+            state.log.pop_front();
+        }
+        if (state.log.empty()) {
+            state.total = 0.0;
+        }
+        
+        if (state.total + cost > config.maxRequests) {
+            return false;
+        }
+        state.log.emplace_back(now, cost);
+        state.total += cost;
+        return true;
+    }
+    
+    static double available(const Config& config, const State& state, int64_t now) {
+        int64_t windowStart = now - config.windowSizeSeconds * int64_t(1000000000);
+        double total = state.total;
+        for (auto it = state.log.begin(); it != state.log.end() && it->first <= windowStart; ++it) {
+            total -= it->second;
+        }
+        return config.maxRequests - std::max(0.0, total);
+    }
+};
+
+/**
+ * Sliding window counter over SubWindows sub-windows
+ *
+ * The sub-windows fully inside the sliding window count in full; the one
+ * that is sliding out counts in proportion to how much of it is still in.
+ */
+template <int SubWindows = 10>
+struct SlidingWindowCounterAlgorithm {
+    static_assert(SubWindows > 0, "Need at least one sub-window");
+    
+    struct Config {
+        int maxRequests;        // Maximum requests in the window
+        int windowSizeSeconds;  // Window size in seconds
+    };
+    
+    struct State {
+        int64_t newest;                             // Number of the newest sub-window
+        std::array<double, SubWindows + 1> counts;  // Ring of per-sub-window costs
+    };
+    
+    static void validate(const Config& config) {
+        if (config.maxRequests <= 0 || config.windowSizeSeconds <= 0) {
+            throw std::invalid_argument("Max requests and window size must be positive");
+        }
+    }
+    
+    static State initial(const Config& config, int64_t now) {
+        State state;
+        state.newest = now / subWindowNs(config);
+        state.counts.fill(0.0);
+        return state;
+    }
+    
+    static bool tryAcquire(const Config& config, State& state, int64_t now, double cost) {
+        int64_t current = now / subWindowNs(config);
+        
+        // Clear the sub-windows that the ring is about to reuse
+        int64_t steps = std::min<int64_t>(current - state.newest, SubWindows + 1);
+        for (int64_t i = 1; i <= steps; ++i) {
+            state.counts[slot(state.newest + i)] = 0.0;
+        }
+        state.newest = std::max(state.newest, current);
+        
+        if (weightedCount(config, state, now) + cost > config.maxRequests) {
+            return false;
+        }
+        state.counts[slot(current)] += cost;
+        return true;
+    }
+    
+    static double available(const Config& config, const State& state, int64_t now) {
+        return config.maxRequests - weightedCount(config, state, now);
+    }
+    
+    static int64_t subWindowNs(const Config& config) {
+        return config.windowSizeSeconds * int64_t(1000000000) / SubWindows;
+    }
+    
+    static size_t slot(int64_t subWindow) {
+        // Sub-window numbers go negative when the clock starts near zero
+        int64_t n = SubWindows + 1;
+        return static_cast<size_t>((subWindow % n + n) % n);
+    }
+    
+    static double weightedCount(const Config& config, const State& state, int64_t now) {
+        int64_t length = subWindowNs(config);
+        int64_t current = now / length;
+        double total = 0.0;
+        
+        for (int64_t i = 0; i < SubWindows; ++i) {
+            int64_t subWindow = current - i;
+            if (subWindow <= state.newest && state.newest - subWindow <= SubWindows) {
+                total += state.counts[slot(subWindow)];
+            }
+        }
+        
+        int64_t oldest = current - SubWindows;
+        if (oldest <= state.newest && state.newest - oldest <= SubWindows) {
+            double stillInside = 1.0 - static_cast<double>(now % length) / length;
+            total += state.counts[slot(oldest)] * stillInside;
+        }
+        
+        return total;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// RateLimiter
+// ---------------------------------------------------------------------------
+
+/**
+ * Rate limiter assembled from an algorithm, a clock and a sync policy
+ *
+ * Typical combinations:
+ *   RateLimiter<TokenBucketAlgorithm, CachedClock, NullSync>   // per-connection, no atomics
+ *   RateLimiter<TokenBucketAlgorithm, SteadyClock, AtomicSync> // global, lock-free
+ *   RateLimiter<SlidingWindowLogAlgorithm>                     // steady clock, mutex
+ */
+template <class Algorithm, class ClockPolicy = SteadyClock, class SyncPolicy = MutexSync>
+class RateLimiter {
+public:
+    using Config = typename Algorithm::Config;
+    using State = typename Algorithm::State;
+    
+    /**
+     * Constructor
+     * @param config Algorithm parameters
+     * @param clock Clock to read the time from (default: a default-constructed ClockPolicy)
+     */
+    explicit RateLimiter(const Config& config, const ClockPolicy& clock = ClockPolicy())
+        : config_((Algorithm::validate(config), config))
+        , clock_(clock)
+        , state_(Algorithm::initial(config_, clock_.now()))
+    {
+    }
+    
+    /**
+     * Try to admit a request
+     * @param cost Share of the limit the request uses (default: 1)
+     * @return true if the request was allowed, false if rate limited
+     */
+    bool tryAcquire(double cost = 1.0) {
+        // Negated so NaN is rejected too
+        if (!(cost > 0)) {
+            return false;
+        }
+        
+        int64_t now = clock_.now();
+        return state_.update([this, now, cost](State& state) {
+            return Algorithm::tryAcquire(config_, state, now, cost);
+        });
+    }
+    
+    /**
+     * Get the remaining budget (tokens, free bucket space, or requests left in the window)
+     * @return Cost that could still be admitted right now
+     */
+    double getAvailable() const {
+        int64_t now = clock_.now();
+        return state_.read([this, now](const State& state) {
+            return Algorithm::available(config_, state, now);
+        });
+    }
+    
+    /**
+     * Get the algorithm parameters
+     * @return Configuration the limiter was built with
+     */
+    const Config& getConfig() const {
+        return config_;
+    }
+    
+    /**
+     * Get the clock, e.g. to refresh a CachedClock or advance a ManualClock
+     * @return Reference to the limiter's clock
+     */
+    ClockPolicy& getClock() {
+        return clock_;
+    }
+    
+    /**
+     * Reset the limiter to its initial state
+     */
+    void reset() {
+        state_.store(Algorithm::initial(config_, clock_.now()));
+    }
+
+private:
+    Config config_;                                         // Algorithm parameters
+    ClockPolicy clock_;                                     // Time source
+    typename SyncPolicy::template Cell<State> state_;       // Algorithm state
+};
+
+#endif // RATE_LIMITER_H
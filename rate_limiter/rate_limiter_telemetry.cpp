@@ -0,0 +1,169 @@
+#include "rate_limiter_telemetry.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+uint32_t roundUpToPowerOfTwo(uint32_t n) {
+    uint32_t power = 1;
+    while (power < n) {
+        power <<= 1;
+    }
+    return power;
+}
+
+} // namespace
+
+constexpr size_t RateLimiterTelemetry::maxKeyLength;
+
+RateLimiterTelemetry::RateLimiterTelemetry(size_t numKeyShards, uint32_t sampleEvery,
+                                           size_t ringSize, double nearLimitThreshold,
+                                           size_t maxThreads)
+    : numKeyShards_(numKeyShards)
+    , sampleMask_(roundUpToPowerOfTwo(std::max<uint32_t>(sampleEvery, 1)) - 1)
+    , nearLimitRemaining_(1.0 - nearLimitThreshold)
+    , maxThreads_(maxThreads)
+    , tickIndex_(numKeyShards * NumKinds)
+    , rowStride_((tickIndex_ + 1 + 7) / 8 * 8)  // 8 counters per cache line
+    , ringSize_(ringSize)
+    , ringHead_(0)
+{
+    if (numKeyShards == 0 || ringSize == 0) {
+        throw std::invalid_argument("Number of key shards and ring size must be positive");
+    }
+    if (numKeyShards > UINT32_MAX) {
+        throw std::invalid_argument("Number of key shards must fit in 32 bits");
+    }
+    if (sampleEvery == 0 || sampleEvery > (1u << 31)) {
+        throw std::invalid_argument("Sample rate must be between 1 and 2^31");
+    }
+    
+    // Rows start on cache line boundaries so neighbouring threads don't false-share
+    size_t numCounters = (maxThreads_ + 1) * rowStride_;
+    counters_.reset(new CounterLine[numCounters / 8]);
+    for (size_t i = 0; i < numCounters; ++i) {
+        counter(i).store(0, std::memory_order_relaxed);
+    }
+    
+    ring_.reset(new EventSlot[ringSize_]);
+    for (size_t i = 0; i < ringSize_; ++i) {
+        for (auto& word : ring_[i].keyWords) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+RateLimiterTelemetry::Counters RateLimiterTelemetry::getTotals() const {
+    Counters totals;
+    for (size_t shard = 0; shard < numKeyShards_; ++shard) {
+        Counters counters = sumShard(shard);
+        totals.allowed += counters.allowed;
+        totals.rejected += counters.rejected;
+        totals.nearLimit += counters.nearLimit;
+    }
+    return totals;
+}
+
+RateLimiterTelemetry::Counters RateLimiterTelemetry::getKeyShardCounters(size_t shard) const {
+    if (shard >= numKeyShards_) {
+        throw std::out_of_range("Key shard index out of range");
+    }
+    return sumShard(shard);
+}
+
+size_t RateLimiterTelemetry::getKeyShard(const std::string& key) const {
+    return keyShardOf(std::hash<std::string>()(key));
+}
+
+size_t RateLimiterTelemetry::getNumKeyShards() const {
+    return numKeyShards_;
+}
+
+std::vector<RateLimiterTelemetry::RejectionEvent> RateLimiterTelemetry::getRecentRejections() const {
+    std::vector<RejectionEvent> events;
+    
+    uint64_t head = ringHead_.load(std::memory_order_acquire);
+    uint64_t first = head > ringSize_ ? head - ringSize_ : 0;
+    
+    for (uint64_t n = first; n < head; ++n) {
+        const EventSlot& slot = ring_[n % ringSize_];
+        
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;  // Being written right now
+        }
+        
+        RejectionEvent event;
+        event.timestampNs = slot.timestampNs.load(std::memory_order_relaxed);
+        uint64_t bits = slot.utilizationBits.load(std::memory_order_relaxed);
+        std::memcpy(&event.utilization, &bits, sizeof(bits));
+        
+        char key[maxKeyLength];
+        size_t keyLength = std::min<uint64_t>(slot.keyLength.load(std::memory_order_relaxed), maxKeyLength);
+        for (size_t i = 0; i < maxKeyLength / 8; ++i) {
+            uint64_t word = slot.keyWords[i].load(std::memory_order_relaxed);
+            std::memcpy(key + i * 8, &word, 8);
+        }
+        
+        // The entry was rewritten while we copied it: drop the torn copy
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before || before == 0) {
+            continue;
+        }
+        
+        event.key.assign(key, keyLength);
+        events.push_back(std::move(event));
+    }
+    
+    std::sort(events.begin(), events.end(), [](const RejectionEvent& a, const RejectionEvent& b) {
+        return a.timestampNs < b.timestampNs;
+    });
+    return events;
+}
+
+void RateLimiterTelemetry::logRejection(const char* key, size_t keyLength, double utilization) {
+    EventSlot& slot = ring_[ringHead_.fetch_add(1, std::memory_order_relaxed) % ringSize_];
+    
+    // Claim the entry; if another writer lapped the ring and holds it, drop this sample
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    if ((sequence & 1) ||
+        !slot.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_relaxed)) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    slot.timestampNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count(), std::memory_order_relaxed);
+    
+    uint64_t bits;
+    std::memcpy(&bits, &utilization, sizeof(bits));
+    slot.utilizationBits.store(bits, std::memory_order_relaxed);
+    
+    char buffer[maxKeyLength] = {};
+    keyLength = std::min(keyLength, maxKeyLength);
+    if (keyLength > 0) {
+        std::memcpy(buffer, key, keyLength);
+    }
+    slot.keyLength.store(keyLength, std::memory_order_relaxed);
+    for (size_t i = 0; i < maxKeyLength / 8; ++i) {
+        uint64_t word;
+        std::memcpy(&word, buffer + i * 8, 8);
+        slot.keyWords[i].store(word, std::memory_order_relaxed);
+    }
+    
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+RateLimiterTelemetry::Counters RateLimiterTelemetry::sumShard(size_t shard) const {
+    Counters counters;
+    for (size_t row = 0; row <= maxThreads_; ++row) {
+        size_t group = row * rowStride_ + shard * NumKinds;
+        counters.allowed += counter(group + Allowed).load(std::memory_order_relaxed);
+        counters.rejected += counter(group + Rejected).load(std::memory_order_relaxed);
+        counters.nearLimit += counter(group + NearLimit).load(std::memory_order_relaxed);
+    }
+    return counters;
+}
@@ -0,0 +1,209 @@
+#include "sharded_token_bucket.h"
+#include "thread_slot.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace {
+
+int64_t toNanos(std::chrono::steady_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        tp.time_since_epoch()
+    ).count();
+}
+
+} // namespace
+
+ShardedTokenBucket::ShardedTokenBucket(double capacity, double refillRate, int numShards,
+                                       int rebalanceIntervalMs, int maxStealShards)
+    : capacity_(capacity)
+    , refillRate_(refillRate)
+    , numShards_(numShards > 0 ? numShards
+                               : std::max(1, static_cast<int>(std::thread::hardware_concurrency())))
+    , shardCapacity_(capacity / numShards_)
+    , shardRefillRate_(refillRate / numShards_)
+    , maxStealShards_(maxStealShards < 0 ? numShards_ - 1
+                                         : std::min(maxStealShards, numShards_ - 1))
+    , rebalanceInterval_(std::chrono::milliseconds(rebalanceIntervalMs))
+    , nextRebalanceNs_(0)
+    , shards_(numShards_)
+{
+    if (capacity <= 0 || refillRate <= 0) {
+        throw std::invalid_argument("Capacity and refill rate must be positive");
+    }
+    if (rebalanceIntervalMs <= 0) {
+        throw std::invalid_argument("Rebalance interval must be positive");
+    }
+    
+    reset();
+}
+
+bool ShardedTokenBucket::tryConsume() {
+    return tryConsume(1);
+}
+
+bool ShardedTokenBucket::tryConsume(int tokens) {
+    return tryAcquire(tokens);
+}
+
+bool ShardedTokenBucket::tryAcquire(double cost) {
+    // Negated so NaN is rejected too
+    if (!(cost > 0) || cost > capacity_) {
+        return false;
+    }
+    
+    auto now = std::chrono::steady_clock::now();
+    maybeRebalance(now);
+    
+    // Fast path: the calling thread's own shard
+    int home = localShardIndex();
+    {
+        Shard& shard = shards_[home];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        refillShard(shard, now);
+        
+        if (shard.tokens >= cost) {
+            shard.tokens -= cost;
+            return true;
+        }
+    }
+    
+    // Slow path: the home shard is dry, borrow from neighbours
+    return steal(home, cost, now);
+}
+
+double ShardedTokenBucket::getAvailableTokens() const {
+    auto now = std::chrono::steady_clock::now();
+    double total = 0.0;
+    
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        refillShard(shard, now);
+        total += shard.tokens;
+    }
+    
+    return total;
+}
+
+double ShardedTokenBucket::getCapacity() const {
+    return capacity_;
+}
+
+double ShardedTokenBucket::getRefillRate() const {
+    return refillRate_;
+}
+
+int ShardedTokenBucket::getNumShards() const {
+    return numShards_;
+}
+
+void ShardedTokenBucket::rebalance() {
+    auto now = std::chrono::steady_clock::now();
+    
+    // Lock every shard in index order so concurrent rebalances can't deadlock
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(shards_.size());
+    
+    double total = 0.0;
+    for (auto& shard : shards_) {
+        locks.emplace_back(shard.mutex);
+        refillShard(shard, now);
+        total += shard.tokens;
+    }
+    
+    double share = std::min(total, capacity_) / numShards_;
+    for (auto& shard : shards_) {
+        shard.tokens = share;
+    }
+}
+
+void ShardedTokenBucket::reset() {
+    auto now = std::chrono::steady_clock::now();
+    
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.tokens = shardCapacity_;
+        shard.lastRefill = now;
+    }
+    
+    nextRebalanceNs_.store(toNanos(now + rebalanceInterval_), std::memory_order_relaxed);
+}
+
+int ShardedTokenBucket::localShardIndex() const {
+    return static_cast<int>(currentThreadSlot() % static_cast<size_t>(numShards_));
+}
+
+void ShardedTokenBucket::refillShard(Shard& shard, std::chrono::steady_clock::time_point now) const {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now - shard.lastRefill
+    ).count() / 1e9;  // Convert to seconds
+    
+    if (elapsed > 0) {
+        shard.tokens = std::min(shardCapacity_, shard.tokens + elapsed * shardRefillRate_);
+        shard.lastRefill = now;
+    }
+}
+
+bool ShardedTokenBucket::steal(int home, double tokens, std::chrono::steady_clock::time_point now) {
+    Shard& homeShard = shards_[home];
+    double own = 0.0;
+    
+    {
+        std::lock_guard<std::mutex> lock(homeShard.mutex);
+        refillShard(homeShard, now);
+        own = homeShard.tokens;
+        homeShard.tokens = 0.0;
+    }
+    
+    // Only one shard lock is ever held at a time; busy neighbours are skipped
+    double gathered = own;
+    std::vector<std::pair<int, double>> taken;
+    for (int i = 1; i <= maxStealShards_ && gathered < tokens; ++i) {
+        int index = (home + i) % numShards_;
+        Shard& victim = shards_[index];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            continue;
+        }
+        
+        refillShard(victim, now);
+        double take = std::min(victim.tokens, tokens - gathered);
+        victim.tokens -= take;
+        gathered += take;
+        taken.emplace_back(index, take);
+    }
+    
+    if (gathered >= tokens) {
+        // Only the home shard's own tokens can be left over, so it stays within its share
+        std::lock_guard<std::mutex> lock(homeShard.mutex);
+        homeShard.tokens = std::min(shardCapacity_, homeShard.tokens + gathered - tokens);
+        return true;
+    }
+    
+    // Not enough anywhere: return every token to the shard it came from. The
+    // victims kept refilling meanwhile, so each is capped at its share; any
+    // tokens lost that way only make the limit stricter
+    for (const auto& take : taken) {
+        Shard& victim = shards_[take.first];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        victim.tokens = std::min(shardCapacity_, victim.tokens + take.second);
+    }
+    
+    std::lock_guard<std::mutex> lock(homeShard.mutex);
+    homeShard.tokens = std::min(shardCapacity_, homeShard.tokens + own);
+    return false;
+}
+
+void ShardedTokenBucket::maybeRebalance(std::chrono::steady_clock::time_point now) {
+    int64_t nowNs = toNanos(now);
+    int64_t due = nextRebalanceNs_.load(std::memory_order_relaxed);
+    if (nowNs < due) {
+        return;
+    }
+    
+    int64_t next = toNanos(now + rebalanceInterval_);
+    if (nextRebalanceNs_.compare_exchange_strong(due, next, std::memory_order_relaxed)) {
+        rebalance();
+    }
+}
@@ -0,0 +1,136 @@
+#ifndef SHARDED_TOKEN_BUCKET_H
+#define SHARDED_TOKEN_BUCKET_H
+
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Sharded Token Bucket Rate Limiter
+ *
+ * Splits a single token bucket across per-thread shards for very hot limits:
+ * - Capacity and refill rate are divided evenly between the shards
+ * - Each thread is pinned to one shard, so admission is a core-local operation
+ * - A shard that runs dry steals tokens from its neighbours
+ * - Shards are periodically rebalanced so idle shards don't strand tokens
+ *
+ * Tokens are only ever moved between shards, never created, and no shard ever
+ * holds more than its share (a failed steal returns each borrowed token to
+ * the shard it came from), so the aggregate never admits more than a single
+ * TokenBucket with the same parameters. The
+ * error is one-sided: a request may be rejected while other shards still hold
+ * tokens. With maxStealShards = k, at most (numShards - 1 - k) shards' worth
+ * of tokens (capacity / numShards each) can be stranded that way, and only
+ * until the next rebalance.
+ */
+class ShardedTokenBucket {
+public:
+    /**
+     * Constructor
+     * @param capacity Maximum number of tokens across all shards
+     * @param refillRate Tokens added per second across all shards
+     * @param numShards Number of shards (default: 0, one per hardware thread)
+     * @param rebalanceIntervalMs Milliseconds between rebalances (default: 100)
+     * @param maxStealShards Neighbours visited when a shard runs dry (default: -1, all of them)
+     */
+    ShardedTokenBucket(double capacity, double refillRate, int numShards = 0,
+                       int rebalanceIntervalMs = 100, int maxStealShards = -1);
+    
+    /**
+     * Try to consume a token
+     * @return true if token was consumed (request allowed), false otherwise (rate limited)
+     */
+    bool tryConsume();
+    
+    /**
+     * Try to consume multiple tokens
+     * @param tokens Number of tokens to consume
+     * @return true if all tokens were consumed, false otherwise
+     */
+    bool tryConsume(int tokens);
+    
+    /**
+     * Try to admit a request with an arbitrary (possibly fractional) cost
+     * @param cost Tokens the request costs; costs above capacity never succeed
+     * @return true if the cost was consumed, false otherwise
+     */
+    bool tryAcquire(double cost);
+    
+    /**
+     * Get the current number of available tokens across all shards
+     * @return Number of tokens currently available
+     */
+    double getAvailableTokens() const;
+    
+    /**
+     * Get the capacity of the bucket
+     * @return Maximum capacity across all shards
+     */
+    double getCapacity() const;
+    
+    /**
+     * Get the refill rate
+     * @return Tokens per second across all shards
+     */
+    double getRefillRate() const;
+    
+    /**
+     * Get the number of shards
+     * @return Number of shards
+     */
+    int getNumShards() const;
+    
+    /**
+     * Spread the available tokens evenly across all shards
+     */
+    void rebalance();
+    
+    /**
+     * Reset every shard to full capacity
+     */
+    void reset();
+
+private:
+    // Each shard sits on its own cache line so neighbouring shards don't false-share
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        double tokens = 0.0;
+        std::chrono::steady_clock::time_point lastRefill;
+    };
+    
+    double capacity_;           // Maximum tokens across all shards
+    double refillRate_;         // Tokens per second across all shards
+    int numShards_;             // Number of shards
+    double shardCapacity_;      // Maximum tokens per shard
+    double shardRefillRate_;    // Tokens per second per shard
+    int maxStealShards_;        // Neighbours visited by a dry shard
+    std::chrono::nanoseconds rebalanceInterval_;  // Time between rebalances
+    std::atomic<int64_t> nextRebalanceNs_;        // steady_clock time of the next rebalance
+    mutable std::vector<Shard> shards_;           // Per-thread sub-buckets
+    
+    /**
+     * Get the shard owned by the calling thread
+     */
+    int localShardIndex() const;
+    
+    /**
+     * Refill a shard based on elapsed time (shard mutex must be held)
+     */
+    void refillShard(Shard& shard, std::chrono::steady_clock::time_point now) const;
+    
+    /**
+     * Gather tokens from the home shard and its neighbours
+     * @return true if enough tokens were gathered and consumed; on false
+     *         every shard has been given back what was taken from it
+     */
+    bool steal(int home, double tokens, std::chrono::steady_clock::time_point now);
+    
+    /**
+     * Rebalance if the interval has elapsed (only one thread wins the race)
+     */
+    void maybeRebalance(std::chrono::steady_clock::time_point now);
+};
+
+#endif // SHARDED_TOKEN_BUCKET_H
@@ -0,0 +1,361 @@
+#include "shared_token_bucket.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Layout of the shared segment: one Header followed by maxKeys Slots.
+// Everything in it must be position-independent, since each process maps
+// the segment at a different address.
+struct SharedTokenBucket::Header {
+    std::atomic<uint32_t> magic;    // Set last by the creator; MAGIC once initialized
+    uint32_t version;               // Layout version
+    uint64_t numSlots;              // Number of key slots
+    double capacity;                // Maximum tokens per key
+    double refillRate;              // Tokens per second per key
+};
+
+struct alignas(64) SharedTokenBucket::Slot {
+    std::atomic<uint64_t> key;      // Hash of the owning key (0 = empty)
+    pthread_mutex_t mutex;          // Robust, process-shared
+    std::atomic<uint32_t> initialized;  // Key and bucket below are valid; set once, under the mutex
+    uint32_t keyLength;             // Length of the owning key
+    double tokens;                  // Current tokens
+    int64_t lastRefillNs;           // CLOCK_MONOTONIC time of the last refill
+    char keyPrefix[KeyPrefixBytes]; // First bytes of the owning key
+};
+
+constexpr size_t SharedTokenBucket::KeyPrefixBytes;
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x53544b42;  // "STKB"
+constexpr uint32_t VERSION = 2;       // 2: slots store the key's length and prefix
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+              std::atomic<uint64_t>::is_always_lock_free,
+              "Shared-memory atomics must be lock-free to work across processes");
+
+std::string segmentName(const std::string& name) {
+    if (!name.empty() && name[0] == '/') {
+        return name;
+    }
+    return "/" + name;
+}
+
+int64_t monotonicNanos() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// FNV-1a; 0 is reserved to mark empty slots
+uint64_t hashKey(const std::string& key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+std::runtime_error systemError(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// Locks a slot mutex, recovering it if the previous owner died holding it.
+// A dead owner can at worst leave a refill half-applied, which the next
+// refill absorbs, so the state is marked consistent and used as is.
+class SlotLock {
+public:
+    explicit SlotLock(pthread_mutex_t& mutex) : mutex_(mutex) {
+        int rc = pthread_mutex_lock(&mutex_);
+        if (rc == EOWNERDEAD) {
+            pthread_mutex_consistent(&mutex_);
+        } else if (rc != 0) {
+            throw std::runtime_error("Failed to lock shared bucket: " + std::string(std::strerror(rc)));
+        }
+    }
+    
+    ~SlotLock() {
+        pthread_mutex_unlock(&mutex_);
+    }
+    
+    SlotLock(const SlotLock&) = delete;
+    SlotLock& operator=(const SlotLock&) = delete;
+
+private:
+    pthread_mutex_t& mutex_;
+};
+
+} // namespace
+
+SharedTokenBucket::SharedTokenBucket(const std::string& name, double capacity, double refillRate,
+                                     size_t maxKeys)
+    : name_(segmentName(name))
+    , capacity_(capacity)
+    , refillRate_(refillRate)
+    , maxKeys_(maxKeys)
+    , mappedSize_(0)
+    , mapping_(nullptr)
+    , header_(nullptr)
+    , slots_(nullptr)
+{
+    if (capacity <= 0 || refillRate <= 0) {
+        throw std::invalid_argument("Capacity and refill rate must be positive");
+    }
+    if (maxKeys == 0) {
+        throw std::invalid_argument("Max keys must be positive");
+    }
+    if (name_.size() < 2 || name_.find('/', 1) != std::string::npos) {
+        throw std::invalid_argument("Segment name must be non-empty and contain no '/'");
+    }
+    
+    open();
+}
+
+SharedTokenBucket::~SharedTokenBucket() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mappedSize_);
+    }
+}
+
+bool SharedTokenBucket::tryConsume(const std::string& key) {
+    return tryConsume(key, 1);
+}
+
+bool SharedTokenBucket::tryConsume(const std::string& key, int tokens) {
+    return tryAcquire(key, tokens);
+}
+
+bool SharedTokenBucket::tryAcquire(const std::string& key, double cost) {
+    // Negated so NaN is rejected too
+    if (!(cost > 0)) {
+        return false;
+    }
+    
+    Slot* slot = findSlot(key, hashKey(key), true);
+    if (slot == nullptr) {
+        return false;  // Table full: reject rather than track the key nowhere
+    }
+    
+    SlotLock lock(slot->mutex);
+    refillSlot(*slot, monotonicNanos());
+    
+    if (slot->tokens >= cost) {
+        slot->tokens -= cost;
+        return true;
+    }
+    
+    return false;
+}
+
+double SharedTokenBucket::getAvailableTokens(const std::string& key) const {
+    Slot* slot = findSlot(key, hashKey(key), false);
+    if (slot == nullptr) {
+        return capacity_;
+    }
+    
+    SlotLock lock(slot->mutex);
+    refillSlot(*slot, monotonicNanos());
+    return slot->tokens;
+}
+
+double SharedTokenBucket::getCapacity() const {
+    return capacity_;
+}
+
+double SharedTokenBucket::getRefillRate() const {
+    return refillRate_;
+}
+
+size_t SharedTokenBucket::getMaxKeys() const {
+    return maxKeys_;
+}
+
+const std::string& SharedTokenBucket::getName() const {
+    return name_;
+}
+
+void SharedTokenBucket::reset(const std::string& key) {
+    Slot* slot = findSlot(key, hashKey(key), false);
+    if (slot == nullptr) {
+        return;  // Unseen keys already start full
+    }
+    
+    SlotLock lock(slot->mutex);
+    slot->tokens = capacity_;
+    slot->lastRefillNs = monotonicNanos();
+}
+
+bool SharedTokenBucket::unlink(const std::string& name) {
+    return shm_unlink(segmentName(name).c_str()) == 0;
+}
+
+void SharedTokenBucket::open() {
+    size_t slotsOffset = (sizeof(Header) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+    mappedSize_ = slotsOffset + maxKeys_ * sizeof(Slot);
+    
+    // Exactly one process wins the exclusive create and initializes the segment
+    int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    bool creator = fd >= 0;
+    if (!creator) {
+        if (errno != EEXIST) {
+            throw systemError("Failed to create shared segment " + name_);
+        }
+        fd = shm_open(name_.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            throw systemError("Failed to open shared segment " + name_);
+        }
+    }
+    
+    if (creator) {
+        if (ftruncate(fd, static_cast<off_t>(mappedSize_)) != 0) {
+            std::runtime_error error = systemError("Failed to size shared segment " + name_);
+            close(fd);
+            shm_unlink(name_.c_str());
+            throw error;
+        }
+    } else {
+        // The creator may not have sized the segment yet
+        struct stat st;
+        for (int attempt = 0; ; ++attempt) {
+            if (fstat(fd, &st) != 0) {
+                std::runtime_error error = systemError("Failed to stat shared segment " + name_);
+                close(fd);
+                throw error;
+            }
+            if (st.st_size != 0 || attempt >= 1000) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (static_cast<size_t>(st.st_size) != mappedSize_) {
+            close(fd);
+            throw std::runtime_error("Shared segment " + name_ + " was created with a different key count");
+        }
+    }
+    
+    mapping_ = mmap(nullptr, mappedSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps the segment alive
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        throw systemError("Failed to map shared segment " + name_);
+    }
+    
+    header_ = static_cast<Header*>(mapping_);
+    slots_ = reinterpret_cast<Slot*>(static_cast<char*>(mapping_) + slotsOffset);
+    
+    if (creator) {
+        new (header_) Header();
+        header_->version = VERSION;
+        header_->numSlots = maxKeys_;
+        header_->capacity = capacity_;
+        header_->refillRate = refillRate_;
+        
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        for (size_t i = 0; i < maxKeys_; ++i) {
+            Slot* slot = new (&slots_[i]) Slot();
+            pthread_mutex_init(&slot->mutex, &attr);
+        }
+        pthread_mutexattr_destroy(&attr);
+        
+        // Publish: attachers only touch the slots after seeing the magic
+        header_->magic.store(MAGIC, std::memory_order_release);
+        return;
+    }
+    
+    for (int attempt = 0; header_->magic.load(std::memory_order_acquire) != MAGIC; ++attempt) {
+        if (attempt >= 1000) {
+            munmap(mapping_, mappedSize_);
+            mapping_ = nullptr;
+            throw std::runtime_error("Shared segment " + name_ + " was never initialized (unlink it to recover)");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    
+    if (header_->version != VERSION || header_->numSlots != maxKeys_ ||
+        header_->capacity != capacity_ || header_->refillRate != refillRate_) {
+        munmap(mapping_, mappedSize_);
+        mapping_ = nullptr;
+        throw std::runtime_error("Shared segment " + name_ + " was created with different parameters");
+    }
+}
+
+SharedTokenBucket::Slot* SharedTokenBucket::findSlot(const std::string& key, uint64_t hash, bool create) const {
+    size_t start = hash % maxKeys_;
+    
+    // Linear probing; slots are claimed once and never released, so a probe
+    // can stop at the first empty slot
+    for (size_t i = 0; i < maxKeys_; ++i) {
+        Slot& slot = slots_[(start + i) % maxKeys_];
+        uint64_t owner = slot.key.load(std::memory_order_acquire);
+        
+        if (owner == 0) {
+            if (!create) {
+                return nullptr;
+            }
+            // Losing the race to a key with another hash moves the probe on
+            if (!slot.key.compare_exchange_strong(owner, hash, std::memory_order_acq_rel) && owner != hash) {
+                continue;
+            }
+        } else if (owner != hash) {
+            continue;
+        }
+        
+        if (claimSlot(slot, key, create)) {
+            return &slot;
+        }
+        if (!slot.initialized.load(std::memory_order_acquire)) {
+            return nullptr;  // Not taken yet, so the key can't be further along
+        }
+    }
+    
+    return nullptr;
+}
+
+bool SharedTokenBucket::claimSlot(Slot& slot, const std::string& key, bool create) const {
+    size_t prefixLength = std::min(key.size(), KeyPrefixBytes);
+    
+    // The key is written once, before initialized is set, so a slot seen
+    // initialized can be compared without the lock. The process that
+    // claimed the hash isn't necessarily the first to lock the slot: whoever
+    // is takes it for its own key, and a colliding key probes on.
+    if (!slot.initialized.load(std::memory_order_acquire)) {
+        if (!create) {
+            return false;
+        }
+        SlotLock lock(slot.mutex);
+        if (!slot.initialized.load(std::memory_order_relaxed)) {
+            slot.keyLength = static_cast<uint32_t>(key.size());
+            std::memcpy(slot.keyPrefix, key.data(), prefixLength);
+            slot.tokens = capacity_;
+            slot.lastRefillNs = monotonicNanos();
+            slot.initialized.store(1, std::memory_order_release);
+            return true;
+        }
+    }
+    
+    return slot.keyLength == key.size() && std::memcmp(slot.keyPrefix, key.data(), prefixLength) == 0;
+}
+
+void SharedTokenBucket::refillSlot(Slot& slot, int64_t nowNs) const {
+    double elapsed = (nowNs - slot.lastRefillNs) / 1e9;  // Convert to seconds
+    if (elapsed > 0) {
+        slot.tokens = std::min(capacity_, slot.tokens + elapsed * refillRate_);
+        slot.lastRefillNs = nowNs;
+    }
+}
@@ -0,0 +1,166 @@
+#ifndef SHARED_TOKEN_BUCKET_H
+#define SHARED_TOKEN_BUCKET_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+struct SharedTokenBucketTest;
+
+/**
+ * Shared Token Bucket Rate Limiter
+ *
+ * Keyed token buckets whose state lives in a named POSIX shared-memory
+ * segment instead of the process heap:
+ * - Every process that opens the same name shares the same buckets, so a
+ *   pre-fork worker pool enforces one exact limit per key without IPC
+ * - Bucket state outlives the processes using it, so a restarted worker
+ *   picks up where the previous one left off instead of starting full
+ * - The segment holds a fixed number of key slots (open addressing); when
+ *   every slot is taken, requests for new keys are rejected
+ * - A slot is found by a 64-bit hash of the key and confirmed against the
+ *   key's length and first 56 bytes stored in it, so keys whose hashes
+ *   collide get buckets of their own. Only keys longer than that, equal in
+ *   length and prefix, would also need equal hashes to share a bucket
+ *
+ * Each slot is guarded by a robust, process-shared mutex: a worker that dies
+ * while holding it doesn't wedge the key for everyone else. Timestamps come
+ * from the monotonic clock, which is shared by all processes on the host.
+ *
+ * The segment persists until unlink() is called or the host reboots.
+ */
+class SharedTokenBucket {
+public:
+    /**
+     * Constructor - creates the segment or attaches to an existing one
+     * @param name Segment name (a leading '/' is added if missing)
+     * @param capacity Maximum number of tokens per key
+     * @param refillRate Tokens added per second per key
+     * @param maxKeys Number of key slots in the segment (default: 4096)
+     * @throws std::invalid_argument if a parameter is out of range
+     * @throws std::runtime_error if the segment can't be mapped or was created with different parameters
+     */
+    SharedTokenBucket(const std::string& name, double capacity, double refillRate,
+                      size_t maxKeys = 4096);
+    
+    /**
+     * Destructor - detaches from the segment (the segment itself is kept)
+     */
+    ~SharedTokenBucket();
+    
+    SharedTokenBucket(const SharedTokenBucket&) = delete;
+    SharedTokenBucket& operator=(const SharedTokenBucket&) = delete;
+    
+    /**
+     * Try to consume a token for a key
+     * @param key Client identifier
+     * @return true if token was consumed (request allowed), false otherwise (rate limited)
+     */
+    bool tryConsume(const std::string& key);
+    
+    /**
+     * Try to consume multiple tokens for a key
+     * @param key Client identifier
+     * @param tokens Number of tokens to consume
+     * @return true if all tokens were consumed, false otherwise
+     */
+    bool tryConsume(const std::string& key, int tokens);
+    
+    /**
+     * Try to admit a request for a key with an arbitrary (possibly fractional) cost
+     * @param key Client identifier
+     * @param cost Tokens the request costs; costs above capacity never succeed
+     * @return true if the cost was consumed, false otherwise
+     */
+    bool tryAcquire(const std::string& key, double cost);
+    
+    /**
+     * Get the current number of available tokens for a key
+     * @param key Client identifier
+     * @return Number of tokens currently available (capacity for unseen keys)
+     */
+    double getAvailableTokens(const std::string& key) const;
+    
+    /**
+     * Get the capacity of each bucket
+     * @return Maximum capacity per key
+     */
+    double getCapacity() const;
+    
+    /**
+     * Get the refill rate
+     * @return Tokens per second per key
+     */
+    double getRefillRate() const;
+    
+    /**
+     * Get the number of key slots in the segment
+     * @return Maximum number of distinct keys
+     */
+    size_t getMaxKeys() const;
+    
+    /**
+     * Get the segment name
+     * @return Name as passed to shm_open
+     */
+    const std::string& getName() const;
+    
+    /**
+     * Refill a key's bucket to full capacity
+     * @param key Client identifier
+     */
+    void reset(const std::string& key);
+    
+    /**
+     * Remove a segment by name (processes already attached keep their mapping)
+     * @param name Segment name
+     * @return true if the segment existed and was removed
+     */
+    static bool unlink(const std::string& name);
+
+private:
+    friend struct SharedTokenBucketTest;
+    
+    struct Header;
+    struct Slot;
+    
+    static constexpr size_t KeyPrefixBytes = 56;    // Key bytes stored per slot (fills its second cache line)
+    
+    std::string name_;      // Segment name
+    double capacity_;       // Maximum tokens per key
+    double refillRate_;     // Tokens per second per key
+    size_t maxKeys_;        // Number of key slots
+    size_t mappedSize_;     // Bytes mapped
+    void* mapping_;         // Start of the mapped segment
+    Header* header_;        // Segment header
+    Slot* slots_;           // Key slots following the header
+    
+    /**
+     * Create or attach to the segment and validate its header
+     */
+    void open();
+    
+    /**
+     * Find the slot for a key, claiming an empty one if needed
+     * @param key Client identifier
+     * @param hash Hash of the key (probe start and first check)
+     * @param create Claim an empty slot if the key isn't present yet
+     * @return Slot for the key, or nullptr if absent (or the table is full)
+     */
+    Slot* findSlot(const std::string& key, uint64_t hash, bool create) const;
+    
+    /**
+     * Check whether a slot whose hash matches belongs to the key, taking
+     * the slot for it (and filling its bucket) if nobody has yet
+     * @param create Whether an untaken slot may be taken
+     * @return true if the slot holds the key's bucket
+     */
+    bool claimSlot(Slot& slot, const std::string& key, bool create) const;
+    
+    /**
+     * Refill a slot based on elapsed time (slot mutex must be held)
+     */
+    void refillSlot(Slot& slot, int64_t nowNs) const;
+};
+
+#endif // SHARED_TOKEN_BUCKET_H
@@ -8,7 +8,7 @@ SlidingWindowCounter::SlidingWindowCounter(int maxRequests, int windowSizeSecond
     , windowSizeSeconds_(windowSizeSeconds)
     , numSubWindows_(numSubWindows)
     , subWindowSize_(static_cast<double>(windowSizeSeconds) / numSubWindows)
-    , subWindowCounts_(numSubWindows, 0)
+    , subWindowCounts_(numSubWindows, 0.0)
     , subWindowStarts_(numSubWindows)
 {
     if (maxRequests <= 0 || windowSizeSeconds <= 0 || numSubWindows <= 0) {
@@ -27,7 +27,12 @@ bool SlidingWindowCounter::tryAllow() {
 }
 
 bool SlidingWindowCounter::tryAllow(int count) {
-    if (count <= 0) {
+    return tryAcquire(count);
+}
+
+bool SlidingWindowCounter::tryAcquire(double cost) {
+    // Negated so NaN is rejected too
+    if (!(cost > 0)) {
         return false;
     }
     
@@ -36,11 +41,11 @@ bool SlidingWindowCounter::tryAllow(int count) {
     // Update sub-windows and get current count
     double currentCount = updateAndGetCount();
     
-    // Check if we have capacity for the requests
-    if (currentCount + count <= maxRequests_) {
+    // Check if we have capacity for the request's cost
+    if (currentCount + cost <= maxRequests_) {
         // Add to the current sub-window
         int currentIndex = getCurrentSubWindowIndex();
-        subWindowCounts_[currentIndex] += count;
+        subWindowCounts_[currentIndex] += cost;
         return true;
     }
     
@@ -55,6 +60,7 @@ double SlidingWindowCounter::getCurrentCount() const {
 }
 
 int SlidingWindowCounter::getMaxRequests() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     return maxRequests_;
 }
 
@@ -66,9 +72,23 @@ int SlidingWindowCounter::getNumSubWindows() const {
     return numSubWindows_;
 }
 
+void SlidingWindowCounter::setMaxRequests(int maxRequests) {
+    if (maxRequests <= 0) {
+        throw std::invalid_argument("Max requests must be positive");
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    double scale = static_cast<double>(maxRequests) / maxRequests_;
+    for (auto& count : subWindowCounts_) {
+        count *= scale;
+    }
+    maxRequests_ = maxRequests;
+}
+
 void SlidingWindowCounter::reset() {
     std::lock_guard<std::mutex> lock(mutex_);
-    std::fill(subWindowCounts_.begin(), subWindowCounts_.end(), 0);
+    std::fill(subWindowCounts_.begin(), subWindowCounts_.end(), 0.0);
     
     auto now = std::chrono::steady_clock::now();
     for (auto& start : subWindowStarts_) {
@@ -88,7 +108,7 @@ double SlidingWindowCounter::updateAndGetCount() {
         
         // If sub-window is completely outside the main window, reset it
         if (subWindowStart < windowStart) {
-            subWindowCounts_[i] = 0;
+            subWindowCounts_[i] = 0.0;
             // Set to a time that will be used for the next request
             subWindowStarts_[i] = now;
             continue;
@@ -108,15 +128,24 @@ double SlidingWindowCounter::updateAndGetCount() {
             auto overlapDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(
                 overlapEnd - overlapStart
             ).count() / 1e9;
-            double weight = overlapDuration / subWindowSize_;
+            
+            // Weigh against the part of the sub-window that has already
+            // happened, so the sub-window still being filled counts in full
+            auto filledDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                overlapEnd - subWindowStart
+            ).count() / 1e9;
+            double weight = overlapDuration / filledDuration;
             totalCount += subWindowCounts_[i] * weight;
+        } else if (subWindowStart == now) {
+            // Started by this very call: nothing has expired yet
+            totalCount += subWindowCounts_[i];
         }
     }
     
     return totalCount;
 }
 
-int SlidingWindowCounter::getCurrentSubWindowIndex() const {
+int SlidingWindowCounter::getCurrentSubWindowIndex() {
     auto now = std::chrono::steady_clock::now();
     
     // Find the sub-window that should receive the current request
@@ -138,7 +167,7 @@ int SlidingWindowCounter::getCurrentSubWindowIndex() const {
     
     if (subWindowStart < windowStart) {
         // This sub-window has expired, reset it
-        subWindowCounts_[subWindowIndex] = 0;
+        subWindowCounts_[subWindowIndex] = 0.0;
         subWindowStarts_[subWindowIndex] = now;
     }
     
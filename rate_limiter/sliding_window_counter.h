@@ -37,6 +37,13 @@ public:
      */
     bool tryAllow(int count);
     
+    /**
+     * Try to allow a request with an arbitrary (possibly fractional) cost
+     * @param cost Share of the window's limit the request uses; costs above maxRequests never succeed
+     * @return true if the request was allowed, false if rate limited
+     */
+    bool tryAcquire(double cost);
+    
     /**
      * Get the current estimated count in the sliding window
      * @return Estimated number of requests in current window
@@ -61,6 +68,15 @@ public:
      */
     int getNumSubWindows() const;
     
+    /**
+     * Change the request limit without clearing the sub-windows
+     *
+     * Every sub-window count is rescaled by newMax / oldMax, so the estimate
+     * keeps the same fraction of the limit and decays as before.
+     * @param maxRequests New maximum number of requests in the window
+     */
+    void setMaxRequests(int maxRequests);
+    
     /**
      * Reset all counters (clear the window)
      */
@@ -71,7 +87,7 @@ private:
     int windowSizeSeconds_;     // Window size in seconds
     int numSubWindows_;         // Number of sub-windows
     double subWindowSize_;      // Size of each sub-window in seconds
-    std::vector<int> subWindowCounts_;  // Counters for each sub-window
+    std::vector<double> subWindowCounts_;  // Cost admitted in each sub-window
     std::vector<std::chrono::steady_clock::time_point> subWindowStarts_;  // Start time of each sub-window
     mutable std::mutex mutex_;  // Mutex for thread safety
     
@@ -84,7 +100,7 @@ private:
     /**
      * Get the index of the current sub-window based on time
      */
-    int getCurrentSubWindowIndex() const;
+    int getCurrentSubWindowIndex();
 };
 
 #endif // SLIDING_WINDOW_COUNTER_H
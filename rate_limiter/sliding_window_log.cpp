@@ -1,22 +1,67 @@
 #include "sliding_window_log.h"
 #include <stdexcept>
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr int64_t kNarrowLimit = int64_t(1) << 15;     // Deltas below this take one word
+constexpr int64_t kWideLimit = (int64_t(1) << 30) - 1; // Deltas below this take two words
+constexpr int64_t kLongDelta = kWideLimit;              // Wide delta escaping to a 64-bit one
+constexpr uint16_t kWideFlag = 0x8000;
+constexpr uint16_t kCostFlag = 0x4000;
+constexpr size_t kMaxEntryWords = 10;                   // Escaped delta + cost
+
+int64_t toNanos(std::chrono::steady_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        tp.time_since_epoch()
+    ).count();
+}
+
+} // namespace
+
+constexpr size_t SlidingWindowLog::ChunkWords;
 
 SlidingWindowLog::SlidingWindowLog(int maxRequests, int windowSizeSeconds)
     : maxRequests_(maxRequests)
     , windowSizeSeconds_(windowSizeSeconds)
+    , head_(nullptr)
+    , tail_(nullptr)
+    , readPos_(0)
+    , oldestNs_(0)
+    , oldestCost_(0.0)
+    , loggedCost_(0.0)
+    , costScale_(1.0)
+    , freeChunks_(nullptr)
+    , numChunks_(0)
 {
     if (maxRequests <= 0 || windowSizeSeconds <= 0) {
         throw std::invalid_argument("Max requests and window size must be positive");
     }
 }
 
+SlidingWindowLog::~SlidingWindowLog() {
+    for (Chunk* list : {head_, freeChunks_}) {
+        while (list) {
+            Chunk* next = list->next;
+            delete list;
+            list = next;
+        }
+    }
+}
+
 bool SlidingWindowLog::tryAllow() {
     return tryAllow(1);
 }
 
 bool SlidingWindowLog::tryAllow(int count) {
-    if (count <= 0) {
+    return tryAcquire(count);
+}
+
+bool SlidingWindowLog::tryAcquire(double cost) {
+    // Negated so NaN is rejected too
+    if (!(cost > 0)) {
         return false;
     }
     
@@ -25,13 +70,11 @@ bool SlidingWindowLog::tryAllow(int count) {
     // Remove expired requests (older than window size)
     removeExpiredRequests();
     
-    // Check if we have capacity for the requests
-    if (static_cast<int>(requestLog_.size()) + count <= maxRequests_) {
-        // Add current timestamp(s) to the log
-        auto now = std::chrono::steady_clock::now();
-        for (int i = 0; i < count; ++i) {
-            requestLog_.push_back(now);
-        }
+    // Check if we have capacity for the request's cost
+    if (loggedCost_ + cost <= maxRequests_) {
+        // One log entry per request, whatever it costs
+        append(toNanos(std::chrono::steady_clock::now()), cost / costScale_);
+        loggedCost_ += cost;
         return true;
     }
     
@@ -44,10 +87,11 @@ int SlidingWindowLog::getCurrentCount() const {
     // Create a non-const reference to call removeExpiredRequests
     const_cast<SlidingWindowLog*>(this)->removeExpiredRequests();
     
-    return static_cast<int>(requestLog_.size());
+    return static_cast<int>(std::ceil(loggedCost_));
 }
 
 int SlidingWindowLog::getMaxRequests() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     return maxRequests_;
 }
 
@@ -58,43 +102,188 @@ int SlidingWindowLog::getWindowSizeSeconds() const {
 double SlidingWindowLog::getTimeUntilOldestExpires() const {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    if (requestLog_.empty()) {
+    if (!head_) {
         return 0.0;
     }
     
     // Create a non-const reference to call removeExpiredRequests
     const_cast<SlidingWindowLog*>(this)->removeExpiredRequests();
     
-    if (requestLog_.empty()) {
+    if (!head_) {
         return 0.0;
     }
     
-    auto now = std::chrono::steady_clock::now();
-    auto oldest = requestLog_.front();
-    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
-        now - oldest
-    ).count() / 1e9;  // Convert to seconds
-    
-    double remaining = windowSizeSeconds_ - elapsed;
+    // The oldest timestamp is decoded exactly, so this is exact too
+    int64_t elapsed = toNanos(std::chrono::steady_clock::now()) - oldestNs_;
+    double remaining = windowSizeSeconds_ - elapsed / 1e9;  // Convert to seconds
     return std::max(0.0, remaining);
 }
 
+size_t SlidingWindowLog::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return numChunks_ * sizeof(Chunk);
+}
+
+void SlidingWindowLog::setMaxRequests(int maxRequests) {
+    if (maxRequests <= 0) {
+        throw std::invalid_argument("Max requests must be positive");
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    removeExpiredRequests();
+    
+    // Rescale lazily: stored costs are multiplied by costScale_ when read
+    double scale = static_cast<double>(maxRequests) / maxRequests_;
+    costScale_ *= scale;
+    oldestCost_ *= scale;
+    loggedCost_ *= scale;
+    maxRequests_ = maxRequests;
+}
+
 void SlidingWindowLog::reset() {
     std::lock_guard<std::mutex> lock(mutex_);
-    requestLog_.clear();
+    
+    while (head_) {
+        Chunk* next = head_->next;
+        releaseChunk(head_);
+        head_ = next;
+    }
+    tail_ = nullptr;
+    readPos_ = 0;
+    loggedCost_ = 0.0;
+    costScale_ = 1.0;
 }
 
 void SlidingWindowLog::removeExpiredRequests() {
-    if (requestLog_.empty()) {
+    if (!head_) {
         return;
     }
     
-    auto now = std::chrono::steady_clock::now();
-    auto windowStart = now - std::chrono::seconds(windowSizeSeconds_);
+    int64_t windowStart = toNanos(std::chrono::steady_clock::now()) -
+                          static_cast<int64_t>(windowSizeSeconds_) * 1000000000;
+    
+    // Remove all requests older than the window
+    while (head_ && oldestNs_ < windowStart) {
+        popOldest();
+    }
     
-    // Remove all timestamps older than the window
-    while (!requestLog_.empty() && requestLog_.front() < windowStart) {
-        requestLog_.pop_front();
+    // Don't let rounding error accumulate across subtractions
+    if (!head_) {
+        loggedCost_ = 0.0;
+        costScale_ = 1.0;
     }
 }
 
+void SlidingWindowLog::append(int64_t nowNs, double storedCost) {
+    bool wasEmpty = !head_;
+    
+    // Start a new chunk when the entry doesn't fit, or when a limit change
+    // has made unit requests store a different cost than the chunk's
+    double unitCost = 1.0 / costScale_;
+    if (!tail_ || tail_->used + kMaxEntryWords > ChunkWords || tail_->unitCost != unitCost) {
+        Chunk* chunk = acquireChunk();
+        chunk->firstNs = nowNs;
+        chunk->lastNs = nowNs;
+        chunk->unitCost = unitCost;
+        
+        if (tail_) {
+            tail_->next = chunk;
+        } else {
+            head_ = chunk;
+        }
+        tail_ = chunk;
+    }
+    
+    Chunk& chunk = *tail_;
+    int64_t delta = nowNs - chunk.lastNs;
+    chunk.lastNs = nowNs;
+    bool hasCost = storedCost != chunk.unitCost;
+    
+    if (delta < kNarrowLimit && !hasCost) {
+        chunk.words[chunk.used++] = static_cast<uint16_t>(delta);
+    } else {
+        int64_t wideDelta = std::min(delta, kLongDelta);
+        chunk.words[chunk.used++] = static_cast<uint16_t>(kWideFlag | (hasCost ? kCostFlag : 0) |
+                                                          (wideDelta >> 16));
+        chunk.words[chunk.used++] = static_cast<uint16_t>(wideDelta & 0xFFFF);
+        if (wideDelta == kLongDelta) {
+            std::memcpy(&chunk.words[chunk.used], &delta, sizeof(delta));
+            chunk.used += sizeof(delta) / sizeof(uint16_t);
+        }
+        if (hasCost) {
+            std::memcpy(&chunk.words[chunk.used], &storedCost, sizeof(storedCost));
+            chunk.used += sizeof(storedCost) / sizeof(uint16_t);
+        }
+    }
+    
+    // The first entry of an empty log becomes the oldest entry
+    if (wasEmpty) {
+        readPos_ = 0;
+        double cost = 1.0;
+        oldestNs_ = chunk.firstNs + decode(chunk, readPos_, cost);
+        oldestCost_ = cost * costScale_;
+    }
+}
+
+void SlidingWindowLog::popOldest() {
+    loggedCost_ -= oldestCost_;
+    
+    // Move on to the next chunk once this one is used up
+    if (readPos_ >= head_->used) {
+        Chunk* next = head_->next;
+        releaseChunk(head_);
+        head_ = next;
+        readPos_ = 0;
+        
+        if (!head_) {
+            tail_ = nullptr;
+            return;
+        }
+        oldestNs_ = head_->firstNs;
+    }
+    
+    double cost = 1.0;
+    oldestNs_ += decode(*head_, readPos_, cost);
+    oldestCost_ = cost * costScale_;
+}
+
+int64_t SlidingWindowLog::decode(const Chunk& chunk, uint16_t& pos, double& storedCost) {
+    uint16_t word = chunk.words[pos++];
+    if (!(word & kWideFlag)) {
+        storedCost = chunk.unitCost;
+        return word;
+    }
+    
+    int64_t delta = (static_cast<int64_t>(word & ~(kWideFlag | kCostFlag)) << 16) | chunk.words[pos++];
+    if (delta == kLongDelta) {
+        std::memcpy(&delta, &chunk.words[pos], sizeof(delta));
+        pos += sizeof(delta) / sizeof(uint16_t);
+    }
+    if (word & kCostFlag) {
+        std::memcpy(&storedCost, &chunk.words[pos], sizeof(storedCost));
+        pos += sizeof(storedCost) / sizeof(uint16_t);
+    } else {
+        storedCost = chunk.unitCost;
+    }
+    return delta;
+}
+
+SlidingWindowLog::Chunk* SlidingWindowLog::acquireChunk() {
+    Chunk* chunk = freeChunks_;
+    if (chunk) {
+        freeChunks_ = chunk->next;
+    } else {
+        chunk = new Chunk;
+        numChunks_++;
+    }
+    
+    chunk->next = nullptr;
+    chunk->used = 0;
+    return chunk;
+}
+
+void SlidingWindowLog::releaseChunk(Chunk* chunk) {
+    chunk->next = freeChunks_;
+    freeChunks_ = chunk;
+}
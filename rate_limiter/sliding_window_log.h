@@ -2,8 +2,9 @@
 #define SLIDING_WINDOW_LOG_H
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <mutex>
-#include <deque>
 
 /**
  * Sliding Window Log Rate Limiter
@@ -13,6 +14,18 @@
  * - Removes timestamps older than the window size
  * - Allows requests if count in current window is below limit
  * - Provides accurate rate limiting with true sliding window behavior
+ *
+ * Each admitted request is logged once together with its cost, so a
+ * request costing 50 takes one log entry, not 50.
+ *
+ * The log is stored compactly: timestamps are nanosecond deltas from the
+ * previous entry, encoded in 16 bits (gaps under 32us), 32 bits (gaps
+ * under ~1s) or, for sparse traffic, 96 bits, in fixed-size chunks that
+ * each start from an exact 64-bit timestamp. A unit-cost request takes
+ * 2-4 bytes instead of a 16-byte entry, other costs add 8 bytes. Chunks released as the window slides are
+ * kept in a free list and reused, so admissions don't allocate once the
+ * log has reached its working size. Timestamps stay exact to the
+ * nanosecond.
  */
 class SlidingWindowLog {
 public:
@@ -23,6 +36,14 @@ public:
      */
     SlidingWindowLog(int maxRequests, int windowSizeSeconds);
     
+    /**
+     * Destructor (frees the log and pooled chunks)
+     */
+    ~SlidingWindowLog();
+    
+    SlidingWindowLog(const SlidingWindowLog&) = delete;
+    SlidingWindowLog& operator=(const SlidingWindowLog&) = delete;
+    
     /**
      * Try to allow a request
      * @return true if request was allowed, false if rate limited
@@ -36,9 +57,16 @@ public:
      */
     bool tryAllow(int count);
     
+    /**
+     * Try to allow a request with an arbitrary (possibly fractional) cost
+     * @param cost Share of the window's limit the request uses; costs above maxRequests never succeed
+     * @return true if the request was allowed, false if rate limited
+     */
+    bool tryAcquire(double cost);
+    
     /**
      * Get the current number of requests in the sliding window
-     * @return Number of requests in current window
+     * @return Number of requests in current window, fractional costs rounded up
      */
     int getCurrentCount() const;
     
@@ -61,20 +89,86 @@ public:
     double getTimeUntilOldestExpires() const;
     
     /**
-     * Clear all request logs (reset)
+     * Get the memory held by the log, including pooled chunks
+     * @return Bytes allocated for log chunks
+     */
+    size_t getMemoryUsage() const;
+    
+    /**
+     * Change the request limit without clearing the log
+     *
+     * The cost of every logged request is rescaled by newMax / oldMax, so the
+     * window stays as full relative to the limit as it was and the scaled
+     * entries still expire on their original schedule.
+     * @param maxRequests New maximum number of requests in the window
+     */
+    void setMaxRequests(int maxRequests);
+    
+    /**
+     * Clear all request logs (reset); the chunks go back to the pool
      */
     void reset();
 
 private:
+    static constexpr size_t ChunkWords = 111;  // Encoded words per chunk (chunk is 256 bytes)
+    
+    // A run of delta-encoded log entries. An entry is one 16-bit word
+    // (bit 15 clear: delta below 2^15 ns), or two words (bit 15 set: 30-bit
+    // delta, bit 14 set if 4 words holding the cost as a double follow).
+    // A 30-bit delta of all ones is an escape: the delta follows in 4 words,
+    // before the cost. Entries without a cost cost unitCost.
+    struct Chunk {
+        Chunk* next;                // Next (newer) chunk, or next free chunk in the pool
+        int64_t firstNs;            // Exact timestamp of the first entry (deltas start here)
+        int64_t lastNs;             // Timestamp of the newest entry written to this chunk
+        double unitCost;            // Stored cost of a unit request when the chunk was started
+        uint16_t used;              // Words written
+        uint16_t words[ChunkWords];
+    };
+    
     int maxRequests_;           // Maximum requests in window
     int windowSizeSeconds_;     // Window size in seconds
-    std::deque<std::chrono::steady_clock::time_point> requestLog_;  // Log of request timestamps
+    Chunk* head_;               // Oldest chunk, nullptr if the log is empty
+    Chunk* tail_;               // Newest chunk
+    uint16_t readPos_;          // Word index just past the oldest entry in head_
+    int64_t oldestNs_;          // Exact timestamp of the oldest entry
+    double oldestCost_;         // Cost of the oldest entry
+    double loggedCost_;         // Sum of the costs in the log
+    double costScale_;          // Stored costs are multiplied by this (changed by setMaxRequests)
+    Chunk* freeChunks_;         // Pool of released chunks
+    size_t numChunks_;          // Chunks allocated, in use or pooled
     mutable std::mutex mutex_;  // Mutex for thread safety
     
     /**
      * Remove expired timestamps from the log (older than window size)
      */
     void removeExpiredRequests();
+    
+    /**
+     * Append an entry to the newest chunk, starting a new chunk if needed
+     */
+    void append(int64_t nowNs, double storedCost);
+    
+    /**
+     * Drop the oldest entry and decode the next one (mutex must be held)
+     */
+    void popOldest();
+    
+    /**
+     * Decode the entry at pos in chunk, advancing pos
+     * @return Delta from the previous entry in nanoseconds
+     */
+    static int64_t decode(const Chunk& chunk, uint16_t& pos, double& storedCost);
+    
+    /**
+     * Take a chunk from the pool, allocating only if the pool is empty
+     */
+    Chunk* acquireChunk();
+    
+    /**
+     * Return a chunk to the pool
+     */
+    void releaseChunk(Chunk* chunk);
 };
 
 #endif // SLIDING_WINDOW_LOG_H
@@ -0,0 +1,191 @@
+#include "adaptive_concurrency_limiter.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+
+namespace {
+
+// Simulated backend: 10ms per request up to 40 concurrent, queueing beyond that
+std::chrono::nanoseconds simulatedLatency(int concurrency) {
+    const int backendCapacity = 40;
+    double factor = std::max(1.0, static_cast<double>(concurrency) / backendCapacity);
+    return std::chrono::nanoseconds(static_cast<int64_t>(10e6 * factor));
+}
+
+// Offer 200 concurrent requests per round and complete whatever was admitted
+int runSimulation(AdaptiveConcurrencyLimiter& limiter, int rounds) {
+    for (int round = 0; round < rounds; ++round) {
+        int admitted = 0;
+        for (int i = 0; i < 200; ++i) {
+            if (limiter.onStart()) {
+                admitted++;
+            }
+        }
+        
+        auto latency = simulatedLatency(admitted);
+        for (int i = 0; i < admitted; ++i) {
+            limiter.onComplete(latency);
+        }
+    }
+    return limiter.getLimit();
+}
+
+void testBasicUsage() {
+    std::cout << "=== Adaptive Concurrency Limiter: Basic Usage Test ===" << std::endl;
+    
+    // Start at 5, sample window of 10 completions
+    AdaptiveConcurrencyLimiter limiter(AdaptiveConcurrencyLimiter::Algorithm::Aimd, 5, 1, 100, 10);
+    
+    std::cout << "Initial limit: " << limiter.getLimit() << std::endl;
+    
+    int allowed = 0;
+    int denied = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (limiter.onStart()) {
+            allowed++;
+        } else {
+            denied++;
+        }
+    }
+    
+    std::cout << "8 concurrent requests: " << allowed << " allowed, " << denied << " denied" << std::endl;
+    std::cout << "In flight: " << limiter.getInFlight() << std::endl;
+    
+    for (int i = 0; i < allowed; ++i) {
+        limiter.onComplete(std::chrono::milliseconds(5));
+    }
+    std::cout << "In flight after completion: " << limiter.getInFlight() << std::endl;
+    std::cout << std::endl;
+}
+
+void testAimdConvergence() {
+    std::cout << "=== Adaptive Concurrency Limiter: AIMD Convergence Test ===" << std::endl;
+    
+    AdaptiveConcurrencyLimiter limiter(AdaptiveConcurrencyLimiter::Algorithm::Aimd, 10, 1, 1000, 10);
+    
+    std::cout << "Backend saturates at 40 concurrent requests (10ms each)" << std::endl;
+    for (int step = 1; step <= 5; ++step) {
+        int limit = runSimulation(limiter, 200);
+        std::cout << "After " << step * 200 << " rounds: limit = " << limit
+                  << ", min latency = "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(limiter.getMinLatency()).count() / 1000.0
+                  << "ms" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testGradientConvergence() {
+    std::cout << "=== Adaptive Concurrency Limiter: Gradient Convergence Test ===" << std::endl;
+    
+    AdaptiveConcurrencyLimiter limiter(AdaptiveConcurrencyLimiter::Algorithm::Gradient, 10, 1, 1000, 10);
+    
+    std::cout << "Backend saturates at 40 concurrent requests (10ms each)" << std::endl;
+    for (int step = 1; step <= 5; ++step) {
+        int limit = runSimulation(limiter, 200);
+        std::cout << "After " << step * 200 << " rounds: limit = " << limit << std::endl;
+    }
+    
+    int limit = limiter.getLimit();
+    if (limit >= 30 && limit <= 90) {
+        std::cout << "Limit settled near the backend's knee!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testDrops() {
+    std::cout << "=== Adaptive Concurrency Limiter: Drop Backoff Test ===" << std::endl;
+    
+    AdaptiveConcurrencyLimiter limiter(AdaptiveConcurrencyLimiter::Algorithm::Gradient, 50, 1, 100, 10);
+    std::cout << "Initial limit: " << limiter.getLimit() << std::endl;
+    
+    // Every request times out
+    for (int window = 0; window < 5; ++window) {
+        for (int i = 0; i < 10; ++i) {
+            if (limiter.onStart()) {
+                limiter.onDropped();
+            }
+        }
+        std::cout << "After window " << window + 1 << " of drops: limit = " << limiter.getLimit() << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testConcurrentAccess() {
+    std::cout << "=== Adaptive Concurrency Limiter: Thread Safety Test ===" << std::endl;
+    
+    AdaptiveConcurrencyLimiter limiter(AdaptiveConcurrencyLimiter::Algorithm::Aimd, 8, 1, 8, 10);
+    std::atomic<int> allowed(0);
+    std::atomic<int> denied(0);
+    std::atomic<int> maxInFlight(0);
+    
+    auto worker = [&limiter, &allowed, &denied, &maxInFlight]() {
+        for (int i = 0; i < 200; ++i) {
+            if (limiter.onStart()) {
+                allowed++;
+                int inFlight = limiter.getInFlight();
+                int seen = maxInFlight.load();
+                while (inFlight > seen && !maxInFlight.compare_exchange_weak(seen, inFlight)) {
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                limiter.onComplete(std::chrono::microseconds(100));
+            } else {
+                denied++;
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    const int numThreads = 16;
+    
+    std::cout << "Starting " << numThreads << " threads with a limit of 8..." << std::endl;
+    
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    
+    for (auto& t : threads) {
+        t.join();
+    }
+    
+    std::cout << "Total allowed: " << allowed.load() << std::endl;
+    std::cout << "Total denied: " << denied.load() << std::endl;
+    std::cout << "Max in flight observed: " << maxInFlight.load() << std::endl;
+    if (maxInFlight.load() <= 8) {
+        std::cout << "In-flight count never exceeded the limit!" << std::endl;
+    }
+    std::cout << "In flight at end: " << limiter.getInFlight() << std::endl;
+    std::cout << std::endl;
+}
+
+void testReset() {
+    std::cout << "=== Adaptive Concurrency Limiter: Reset Test ===" << std::endl;
+    
+    AdaptiveConcurrencyLimiter limiter(AdaptiveConcurrencyLimiter::Algorithm::Aimd, 10, 1, 1000, 10);
+    runSimulation(limiter, 100);
+    std::cout << "Limit before reset: " << limiter.getLimit() << std::endl;
+    
+    limiter.reset();
+    std::cout << "Limit after reset: " << limiter.getLimit() << std::endl;
+    std::cout << std::endl;
+}
+
+} // namespace
+
+void runAllAdaptiveConcurrencyLimiterTests() {
+    try {
+        testBasicUsage();
+        testAimdConvergence();
+        testGradientConvergence();
+        testDrops();
+        testConcurrentAccess();
+        testReset();
+        
+        std::cout << "All Adaptive Concurrency Limiter tests completed successfully!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error in Adaptive Concurrency Limiter tests: " << e.what() << std::endl;
+        throw;
+    }
+}
@@ -0,0 +1,232 @@
+#include "aligned_fixed_window.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <iomanip>
+#include <string>
+
+namespace {
+
+// Avoid starting a test right before a window boundary
+void waitForFreshWindow(const AlignedFixedWindow& limiter, double minRemaining) {
+    double remaining = limiter.getTimeRemainingInWindow();
+    if (remaining < minRemaining) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(remaining + 0.01));
+    }
+}
+
+void testBasicUsage() {
+    std::cout << "=== Aligned Fixed Window: Basic Usage Test ===" << std::endl;
+    
+    // 5 requests per 2 second window, aligned to the epoch
+    AlignedFixedWindow limiter(5, 2);
+    waitForFreshWindow(limiter, 1.0);
+    
+    std::cout << "Max requests per window: " << limiter.getMaxRequests() << std::endl;
+    std::cout << "Window size: " << limiter.getWindowSizeSeconds() << " seconds" << std::endl;
+    std::cout << "Current count: " << limiter.getCurrentCount() << std::endl;
+    std::cout << std::endl;
+    
+    int allowed = 0;
+    int denied = 0;
+    
+    for (int i = 0; i < 8; ++i) {
+        if (limiter.tryAllow()) {
+            allowed++;
+            std::cout << "Request " << i + 1 << ": ALLOWED (count: "
+                      << limiter.getCurrentCount() << "/" << limiter.getMaxRequests() << ")" << std::endl;
+        } else {
+            denied++;
+            std::cout << "Request " << i + 1 << ": RATE LIMITED (count: "
+                      << limiter.getCurrentCount() << "/" << limiter.getMaxRequests() << ")" << std::endl;
+        }
+    }
+    
+    std::cout << "\nSummary: " << allowed << " allowed, " << denied << " denied" << std::endl;
+    std::cout << std::endl;
+}
+
+void testAlignment() {
+    std::cout << "=== Aligned Fixed Window: Alignment Test ===" << std::endl;
+    
+    // Created at different times, yet both agree on the window boundary
+    AlignedFixedWindow first(10, 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    AlignedFixedWindow second(10, 5);
+    
+    double firstRemaining = first.getTimeRemainingInWindow();
+    double secondRemaining = second.getTimeRemainingInWindow();
+    
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "First instance, time remaining: " << firstRemaining << "s" << std::endl;
+    std::cout << "Second instance, time remaining: " << secondRemaining << "s" << std::endl;
+    if (firstRemaining - secondRemaining < 0.05 && secondRemaining - firstRemaining < 0.05) {
+        std::cout << "Both instances agree on the window boundary!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testWindowRollover() {
+    std::cout << "=== Aligned Fixed Window: Window Rollover Test ===" << std::endl;
+    
+    AlignedFixedWindow limiter(3, 1);
+    waitForFreshWindow(limiter, 0.5);
+    
+    std::cout << "Filling window with 3 requests..." << std::endl;
+    for (int i = 0; i < 3; ++i) {
+        limiter.tryAllow();
+    }
+    if (!limiter.tryAllow()) {
+        std::cout << "Correctly denied 4th request" << std::endl;
+    }
+    
+    double remaining = limiter.getTimeRemainingInWindow();
+    std::cout << "Waiting " << std::fixed << std::setprecision(2) << remaining
+              << "s for the next aligned window..." << std::endl;
+    std::this_thread::sleep_for(std::chrono::duration<double>(remaining + 0.01));
+    
+    std::cout << "Current count after wait: " << limiter.getCurrentCount() << std::endl;
+    if (limiter.tryAllow()) {
+        std::cout << "Successfully allowed request in the new window!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testConcurrentAccess() {
+    std::cout << "=== Aligned Fixed Window: Thread Safety Test ===" << std::endl;
+    
+    AlignedFixedWindow limiter(1000, 60);
+    waitForFreshWindow(limiter, 5.0);
+    std::atomic<int> allowed(0);
+    std::atomic<int> denied(0);
+    
+    auto worker = [&limiter, &allowed, &denied]() {
+        for (int i = 0; i < 2000; ++i) {
+            if (limiter.tryAllow()) {
+                allowed++;
+            } else {
+                denied++;
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    const int numThreads = 8;
+    
+    std::cout << "Starting " << numThreads << " threads, each making 2000 requests..." << std::endl;
+    
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    
+    for (auto& t : threads) {
+        t.join();
+    }
+    
+    std::cout << "Total allowed: " << allowed.load() << std::endl;
+    std::cout << "Total denied: " << denied.load() << std::endl;
+    std::cout << "Final count: " << limiter.getCurrentCount() << std::endl;
+    if (allowed.load() == 1000) {
+        std::cout << "Exactly the limit was admitted!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testKeyed() {
+    std::cout << "=== Aligned Fixed Window: Keyed Test ===" << std::endl;
+    
+    // 3 requests per key per minute, 8 bytes of state per slot
+    KeyedAlignedFixedWindow limiter(3, 60, 1024);
+    
+    std::cout << "Slots: " << limiter.getNumSlots() << " ("
+              << limiter.getNumSlots() * 8 / 1024 << " KiB)" << std::endl;
+    
+    for (const std::string key : {"alice", "alice", "bob", "alice", "alice", "bob"}) {
+        bool ok = limiter.tryAllow(key);
+        std::cout << key << ": " << (ok ? "ALLOWED" : "RATE LIMITED")
+                  << " (count: " << limiter.getCurrentCount(key) << ")" << std::endl;
+    }
+    
+    limiter.reset("alice");
+    std::cout << "After reset, alice count: " << limiter.getCurrentCount("alice")
+              << ", bob count: " << limiter.getCurrentCount("bob") << std::endl;
+    std::cout << std::endl;
+}
+
+void testKeyedConcurrentAccess() {
+    std::cout << "=== Aligned Fixed Window: Keyed Thread Safety Test ===" << std::endl;
+    
+    KeyedAlignedFixedWindow limiter(100, 60, 4096);
+    std::atomic<int> allowed(0);
+    
+    // Every thread hammers the same 10 keys, each starting on a different one
+    // so the threads race on different slots at the same moment
+    auto worker = [&limiter, &allowed](int id) {
+        for (int i = 0; i < 1000; ++i) {
+            if (limiter.tryAllow("key" + std::to_string((i + id) % 10))) {
+                allowed++;
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    const int numThreads = 4;
+    
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    
+    for (auto& t : threads) {
+        t.join();
+    }
+    
+    std::cout << "Total allowed for 10 keys: " << allowed.load() << " (limit: 1000)" << std::endl;
+    std::cout << std::endl;
+}
+
+void testReset() {
+    std::cout << "=== Aligned Fixed Window: Reset Test ===" << std::endl;
+    
+    AlignedFixedWindow limiter(5, 60);
+    limiter.tryAllow(5);
+    std::cout << "Count before reset: " << limiter.getCurrentCount() << std::endl;
+    
+    limiter.reset();
+    std::cout << "Count after reset: " << limiter.getCurrentCount() << std::endl;
+    std::cout << std::endl;
+}
+
+void testWeightedCost() {
+    std::cout << "=== Aligned Fixed Window: Weighted Cost Test ===" << std::endl;
+    
+    AlignedFixedWindow limiter(100, 60);
+    waitForFreshWindow(limiter, 2.0);
+    
+    std::cout << "Report (cost 50): " << (limiter.tryAcquire(50.0) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Read (cost 0.5, charged 1): " << (limiter.tryAcquire(0.5) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Current count: " << limiter.getCurrentCount() << "/" << limiter.getMaxRequests() << std::endl;
+    std::cout << "Report (cost 50): " << (limiter.tryAcquire(50.0) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << std::endl;
+}
+
+} // namespace
+
+void runAllAlignedFixedWindowTests() {
+    try {
+        testBasicUsage();
+        testAlignment();
+        testWindowRollover();
+        testConcurrentAccess();
+        testKeyed();
+        testKeyedConcurrentAccess();
+        testReset();
+        testWeightedCost();
+        
+        std::cout << "All Aligned Fixed Window tests completed successfully!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error in Aligned Fixed Window tests: " << e.what() << std::endl;
+        throw;
+    }
+}
@@ -6,6 +6,8 @@
 #include <atomic>
 #include <iomanip>
 
+namespace {
+
 void testBasicUsage() {
     std::cout << "=== Fixed Window: Basic Usage Test ===" << std::endl;
     
@@ -206,6 +208,41 @@ void testReset() {
     std::cout << std::endl;
 }
 
+void testWeightedCost() {
+    std::cout << "=== Fixed Window: Weighted Cost Test ===" << std::endl;
+    
+    FixedWindow limiter(100, 60);
+    
+    std::cout << "Report (cost 50): " << (limiter.tryAcquire(50.0) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Read (cost 0.25) x 4: ";
+    for (int i = 0; i < 4; ++i) {
+        std::cout << (limiter.tryAcquire(0.25) ? "ALLOWED " : "DENIED ");
+    }
+    std::cout << std::endl;
+    std::cout << "Current count: " << limiter.getCurrentCount() << "/" << limiter.getMaxRequests() << std::endl;
+    std::cout << "Report (cost 50): " << (limiter.tryAcquire(50.0) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Report (cost 49): " << (limiter.tryAcquire(49.0) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << std::endl;
+}
+
+void testSetLimits() {
+    std::cout << "=== Fixed Window: Runtime Limit Change Test ===" << std::endl;
+    
+    FixedWindow limiter(10, 60);
+    limiter.tryAllow(5);
+    std::cout << "Before: " << limiter.getCurrentCount() << "/" << limiter.getMaxRequests() << std::endl;
+    
+    // Raising the limit mid-window keeps the window half used instead of granting a burst
+    limiter.setMaxRequests(100);
+    std::cout << "After setMaxRequests(100): " << limiter.getCurrentCount() << "/"
+              << limiter.getMaxRequests() << std::endl;
+    std::cout << "Request for 50: " << (limiter.tryAllow(50) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Request for 1: " << (limiter.tryAllow() ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << std::endl;
+}
+
+} // namespace
+
 void runAllFixedWindowTests() {
     try {
         testBasicUsage();
@@ -215,6 +252,8 @@ void runAllFixedWindowTests() {
         testConcurrentAccess();
         testTimeRemaining();
         testReset();
+        testWeightedCost();
+        testSetLimits();
         
         std::cout << "All Fixed Window tests completed successfully!" << std::endl;
     } catch (const std::exception& e) {
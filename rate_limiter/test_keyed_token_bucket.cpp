@@ -0,0 +1,225 @@
+#include "keyed_token_bucket.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include <cstdio>
+
+// Reaches into the limiter to replay a request that loaded the limit table
+// just before a reload
+struct KeyedTokenBucketTest {
+    static void settleWithStaleTable() {
+        std::cout << "=== Keyed Token Bucket: Stale Limit Table Test ===" << std::endl;
+        
+        KeyedTokenBucket limiter(10.0, 1.0);
+        limiter.tryConsume("user1", 2);
+        std::shared_ptr<const KeyedTokenBucket::LimitTable> stale = std::atomic_load(&limiter.table_);
+        
+        limiter.setDefaultLimits(100.0, 1.0);
+        std::cout << "user1 after reload: " << limiter.getAvailableTokens("user1") << "/"
+                  << limiter.getLimits("user1").capacity << std::endl;
+        
+        KeyedTokenBucket::Shard& shard = limiter.shardFor("user1");
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            KeyedTokenBucket::Bucket& bucket = shard.buckets.at("user1");
+            limiter.settle(bucket, "user1", *stale, std::chrono::steady_clock::now());
+            std::cout << "Bucket after settling with table v" << stale->version << ": capacity "
+                      << bucket.limits.capacity << ", version " << bucket.version
+                      << " (expected 100, version 2: not rolled back)" << std::endl;
+        }
+        std::cout << "user1 tokens: " << static_cast<int>(limiter.getAvailableTokens("user1"))
+                  << " (expected 80)" << std::endl;
+        std::cout << std::endl;
+    }
+};
+
+namespace {
+
+void testBasicUsage() {
+    std::cout << "=== Keyed Token Bucket: Basic Usage Test ===" << std::endl;
+    
+    KeyedTokenBucket limiter(5.0, 1.0);
+    
+    for (int i = 0; i < 7; ++i) {
+        if (limiter.tryConsume("user1")) {
+            std::cout << "Request " << (i + 1) << " for user1: ALLOWED (tokens remaining: "
+                      << limiter.getAvailableTokens("user1") << ")" << std::endl;
+        } else {
+            std::cout << "Request " << (i + 1) << " for user1: DENIED (rate limited)" << std::endl;
+        }
+    }
+    
+    std::cout << "user2 is tracked separately, tokens: "
+              << limiter.getAvailableTokens("user2") << std::endl;
+    std::cout << "Tracked keys: " << limiter.getNumKeys() << std::endl;
+    std::cout << std::endl;
+}
+
+void testPerKeyLimits() {
+    std::cout << "=== Keyed Token Bucket: Per-Key Limits Test ===" << std::endl;
+    
+    KeyedTokenBucket limiter(3.0, 1.0);
+    limiter.setLimits("premium", 10.0, 5.0);
+    
+    int free = 0;
+    int premium = 0;
+    for (int i = 0; i < 10; ++i) {
+        free += limiter.tryConsume("free-user") ? 1 : 0;
+        premium += limiter.tryConsume("premium") ? 1 : 0;
+    }
+    
+    std::cout << "free-user allowed " << free << " of 10 (capacity "
+              << limiter.getLimits("free-user").capacity << ")" << std::endl;
+    std::cout << "premium allowed " << premium << " of 10 (capacity "
+              << limiter.getLimits("premium").capacity << ")" << std::endl;
+    std::cout << std::endl;
+}
+
+void testHotReload() {
+    std::cout << "=== Keyed Token Bucket: Hot Reload Test ===" << std::endl;
+    
+    KeyedTokenBucket limiter(10.0, 1.0);
+    limiter.tryConsume("user1", 8);
+    std::cout << "user1 before reload: " << limiter.getAvailableTokens("user1")
+              << "/" << limiter.getLimits("user1").capacity << std::endl;
+    
+    // A new object would start full; the rescaled bucket stays 20% full
+    limiter.setDefaultLimits(100.0, 10.0);
+    std::cout << "Limits version: " << limiter.getLimitsVersion() << std::endl;
+    std::cout << "user1 after reload: " << limiter.getAvailableTokens("user1")
+              << "/" << limiter.getLimits("user1").capacity << std::endl;
+    std::cout << "Request for 50 tokens: "
+              << (limiter.tryConsume("user1", 50) ? "ALLOWED" : "DENIED (no burst after reload)") << std::endl;
+    
+    limiter.setLimits("user1", 5.0, 1.0);
+    std::cout << "user1 after override to 5: " << limiter.getAvailableTokens("user1")
+              << "/" << limiter.getLimits("user1").capacity << std::endl;
+    
+    limiter.clearLimits("user1");
+    std::cout << "user1 back on defaults, capacity: " << limiter.getLimits("user1").capacity << std::endl;
+    std::cout << std::endl;
+}
+
+void testLoadFromFile() {
+    std::cout << "=== Keyed Token Bucket: Limit File Test ===" << std::endl;
+    
+    const std::string path = "keyed_token_bucket_limits.csv";
+    {
+        std::ofstream file(path);
+        file << "# key,capacity,refillRate\n"
+             << "*,10,1\n"
+             << "\n"
+             << "partner-a, 100, 20\n"
+             << "partner-b,50,5\n";
+    }
+    
+    KeyedTokenBucket limiter(5.0, 1.0);
+    size_t loaded = limiter.loadLimitsFromFile(path);
+    std::cout << "Loaded " << loaded << " overrides" << std::endl;
+    std::cout << "Default capacity: " << limiter.getDefaultLimits().capacity << std::endl;
+    std::cout << "partner-a: " << limiter.getLimits("partner-a").capacity << " tokens, "
+              << limiter.getLimits("partner-a").refillRate << " tokens/sec" << std::endl;
+    
+    // A malformed file is rejected as a whole
+    {
+        std::ofstream file(path);
+        file << "partner-a,1,1\n"
+             << "partner-b,lots,5\n";
+    }
+    try {
+        limiter.loadLimitsFromFile(path);
+    } catch (const std::invalid_argument& e) {
+        std::cout << "Rejected bad file: " << e.what() << std::endl;
+    }
+    std::cout << "partner-a still has capacity " << limiter.getLimits("partner-a").capacity << std::endl;
+    
+    std::remove(path.c_str());
+    std::cout << std::endl;
+}
+
+void testReloadUnderLoad() {
+    std::cout << "=== Keyed Token Bucket: Reload Under Load Test ===" << std::endl;
+    
+    KeyedTokenBucket limiter(500.0, 0.001);
+    std::atomic<int> allowed(0);
+    std::atomic<bool> done(false);
+    
+    // Each thread starts on a different key, so every key is being
+    // rescaled and consumed from at the same time
+    auto worker = [&limiter, &allowed](int id) {
+        for (int i = 0; i < 2000; ++i) {
+            if (limiter.tryConsume("key" + std::to_string((i + id) % 4))) {
+                allowed++;
+            }
+        }
+    };
+    
+    // Flip the defaults back and forth while the workers run
+    std::thread reloader([&limiter, &done]() {
+        int reloads = 0;
+        while (!done.load()) {
+            limiter.setDefaultLimits(reloads % 2 == 0 ? 1000.0 : 500.0, 0.001);
+            reloads++;
+        }
+        std::cout << "Published " << reloads << " limit tables" << std::endl;
+    });
+    
+    std::vector<std::thread> threads;
+    const int numThreads = 4;
+    
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    
+    for (auto& t : threads) {
+        t.join();
+    }
+    done = true;
+    reloader.join();
+    
+    std::cout << "Total allowed for 4 keys: " << allowed.load()
+              << " (rescaling never grants more than 1000 per key, 4000 total)" << std::endl;
+    std::cout << std::endl;
+}
+
+void testReset() {
+    std::cout << "=== Keyed Token Bucket: Reset Test ===" << std::endl;
+    
+    KeyedTokenBucket limiter(5.0, 1.0);
+    limiter.tryConsume("user1", 5);
+    limiter.tryConsume("user2", 3);
+    std::cout << "Before reset: user1 " << limiter.getAvailableTokens("user1")
+              << ", user2 " << limiter.getAvailableTokens("user2") << std::endl;
+    
+    limiter.reset("user1");
+    std::cout << "After reset(user1): user1 " << limiter.getAvailableTokens("user1")
+              << ", user2 " << limiter.getAvailableTokens("user2") << std::endl;
+    
+    limiter.reset();
+    std::cout << "After reset(): " << limiter.getNumKeys() << " tracked keys" << std::endl;
+    std::cout << std::endl;
+}
+
+} // namespace
+
+void runAllKeyedTokenBucketTests() {
+    try {
+        testBasicUsage();
+        testPerKeyLimits();
+        testHotReload();
+        testLoadFromFile();
+        testReloadUnderLoad();
+        KeyedTokenBucketTest::settleWithStaleTable();
+        testReset();
+        
+        std::cout << "All Keyed Token Bucket tests completed successfully!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error in Keyed Token Bucket tests: " << e.what() << std::endl;
+        throw;
+    }
+}
@@ -5,6 +5,8 @@
 #include <chrono>
 #include <atomic>
 
+namespace {
+
 void testBasicUsage() {
     std::cout << "=== Leaking Bucket: Basic Usage Test ===" << std::endl;
     
@@ -165,6 +167,89 @@ void testReset() {
     std::cout << std::endl;
 }
 
+void testReservation() {
+    std::cout << "=== Leaking Bucket: Reservation Test ===" << std::endl;
+    
+    // 2 requests capacity, 4 requests per second: one request leaks every 250ms
+    LeakingBucket limiter(2, 4.0);
+    limiter.tryAdd(2);
+    
+    auto wait1 = limiter.reserve(1);
+    auto wait2 = limiter.reserve(1);
+    std::cout << "First reservation waits " 
+              << std::chrono::duration_cast<std::chrono::milliseconds>(wait1).count() << "ms" << std::endl;
+    std::cout << "Second reservation waits " 
+              << std::chrono::duration_cast<std::chrono::milliseconds>(wait2).count() << "ms" << std::endl;
+    
+    // Non-waiting callers can't jump the queue while reservations are outstanding
+    if (!limiter.tryAdd()) {
+        std::cout << "tryAdd RATE LIMITED while reservations are outstanding (queue size: " 
+                  << limiter.getQueueSize() << ")" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testAcquire() {
+    std::cout << "=== Leaking Bucket: Blocking Acquire Test ===" << std::endl;
+    
+    // 1 request capacity, 10 requests per second: one request leaks every 100ms
+    LeakingBucket limiter(1, 10.0);
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 5; ++i) {
+        limiter.acquire();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    
+    std::cout << "Added 5 requests in " 
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() 
+              << "ms (expected ~400ms)" << std::endl;
+    
+    if (!limiter.acquireFor(std::chrono::milliseconds(10))) {
+        std::cout << "acquireFor(10ms) gave up: next slot is ~100ms away" << std::endl;
+    }
+    if (limiter.acquireFor(std::chrono::milliseconds(200))) {
+        std::cout << "acquireFor(200ms) waited for the next slot" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testWeightedCost() {
+    std::cout << "=== Leaking Bucket: Weighted Cost Test ===" << std::endl;
+    
+    // Capacity 100, leaking 10 per second
+    LeakingBucket limiter(100, 10.0);
+    
+    std::cout << "Report (cost 50): " << (limiter.tryAcquire(50.0) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Read (cost 2.5): " << (limiter.tryAcquire(2.5) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Queue size: " << limiter.getQueueSize() << " (52.5 rounded up)" << std::endl;
+    std::cout << "Report (cost 50): " << (limiter.tryAcquire(50.0) ? "ALLOWED" : "DENIED") << std::endl;
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    std::cout << "After 300ms, queue size: " << limiter.getQueueSize() << std::endl;
+    std::cout << "Report (cost 50): " << (limiter.tryAcquire(50.0) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << std::endl;
+}
+
+void testSetLimits() {
+    std::cout << "=== Leaking Bucket: Runtime Limit Change Test ===" << std::endl;
+    
+    LeakingBucket bucket(10, 0.5);
+    bucket.tryAdd(8);
+    std::cout << "Before: queue " << bucket.getQueueSize() << "/" << bucket.getCapacity()
+              << ", leak rate " << bucket.getLeakRate() << "/sec" << std::endl;
+    
+    // The queue keeps the same share of the (smaller) bucket
+    bucket.setLimits(5, 2.0);
+    std::cout << "After setLimits(5, 2.0): queue " << bucket.getQueueSize() << "/"
+              << bucket.getCapacity() << ", leak rate " << bucket.getLeakRate() << "/sec" << std::endl;
+    std::cout << "Add 1 more: " << (bucket.tryAdd() ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Add 1 more: " << (bucket.tryAdd() ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << std::endl;
+}
+
+} // namespace
+
 void runAllLeakingBucketTests() {
     try {
         testBasicUsage();
@@ -173,6 +258,10 @@ void runAllLeakingBucketTests() {
         testSmoothOutput();
         testConcurrentAccess();
         testReset();
+        testReservation();
+        testAcquire();
+        testWeightedCost();
+        testSetLimits();
         
         std::cout << "All Leaking Bucket tests completed successfully!" << std::endl;
     } catch (const std::exception& e) {
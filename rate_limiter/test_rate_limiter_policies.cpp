@@ -0,0 +1,293 @@
+#include "rate_limiter.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Names and per-algorithm parameters for the policy matrix
+// ---------------------------------------------------------------------------
+
+template <class T> const char* policyName();
+template <> const char* policyName<TokenBucketAlgorithm>() { return "TokenBucket"; }
+template <> const char* policyName<LeakingBucketAlgorithm>() { return "LeakingBucket"; }
+template <> const char* policyName<FixedWindowAlgorithm>() { return "FixedWindow"; }
+template <> const char* policyName<SlidingWindowLogAlgorithm>() { return "SlidingWindowLog"; }
+template <> const char* policyName<SlidingWindowCounterAlgorithm<>>() { return "SlidingWindowCounter"; }
+template <> const char* policyName<SteadyClock>() { return "SteadyClock"; }
+template <> const char* policyName<CachedClock>() { return "CachedClock"; }
+template <> const char* policyName<ManualClock>() { return "ManualClock"; }
+template <> const char* policyName<NullSync>() { return "NullSync"; }
+template <> const char* policyName<MutexSync>() { return "MutexSync"; }
+template <> const char* policyName<AtomicSync>() { return "AtomicSync"; }
+
+// A limit of 5 per second: bucket capacity 5 refilling 1/s, or 5 per 1s window
+template <class Algorithm>
+typename Algorithm::Config smallConfig() {
+    return {5, 1};
+}
+
+// A limit of 1000 that won't recover during a test run
+template <class Algorithm>
+typename Algorithm::Config largeConfig() {
+    return {1000, 3600};
+}
+
+template <>
+TokenBucketAlgorithm::Config largeConfig<TokenBucketAlgorithm>() {
+    return {1000.0, 0.001};
+}
+
+template <>
+LeakingBucketAlgorithm::Config largeConfig<LeakingBucketAlgorithm>() {
+    return {1000.0, 0.001};
+}
+
+// A limit of 100: bucket capacity 100 refilling 10/s, or 100 per 10s window
+template <class Algorithm>
+typename Algorithm::Config burstConfig() {
+    return {100, 10};
+}
+
+// Requests admitted 1.2s after draining a limit of 5 per second: buckets have
+// regained one token, windows have started over
+template <class Algorithm>
+int admittedAfterRecovery() {
+    return 5;
+}
+
+template <>
+int admittedAfterRecovery<TokenBucketAlgorithm>() {
+    return 1;
+}
+
+template <>
+int admittedAfterRecovery<LeakingBucketAlgorithm>() {
+    return 1;
+}
+
+template <class Algorithm>
+constexpr bool fitsAtomicSync() {
+    return std::is_trivially_copyable<typename Algorithm::State>::value &&
+           sizeof(typename Algorithm::State) <= sizeof(uint64_t);
+}
+
+template <class Algorithm, class Clock, class Sync>
+std::string label() {
+    return std::string("[") + policyName<Algorithm>() + " / " + policyName<Clock>() +
+           " / " + policyName<Sync>() + "]";
+}
+
+// Let time pass for a limiter: a ManualClock jumps, the real clocks wait
+void elapse(ManualClock& clock, std::chrono::milliseconds delta) {
+    clock.advance(delta);
+}
+
+void elapse(SteadyClock&, std::chrono::milliseconds delta) {
+    std::this_thread::sleep_for(delta);
+}
+
+void elapse(CachedClock& clock, std::chrono::milliseconds delta) {
+    std::this_thread::sleep_for(delta);
+    clock.refresh();
+}
+
+// ---------------------------------------------------------------------------
+// Scenarios from the standalone limiter tests, each run for every
+// (Algorithm, Clock, Sync) combination
+// ---------------------------------------------------------------------------
+
+template <class Algorithm, class Clock, class Sync>
+void testBasicUsage() {
+    RateLimiter<Algorithm, Clock, Sync> limiter(smallConfig<Algorithm>());
+    
+    int allowed = 0;
+    int denied = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (limiter.tryAcquire()) {
+            allowed++;
+        } else {
+            denied++;
+        }
+    }
+    
+    std::cout << label<Algorithm, Clock, Sync>() << " basic: "
+              << allowed << " allowed, " << denied << " denied"
+              << (allowed == 5 ? "" : "  <-- expected 5 allowed") << std::endl;
+}
+
+template <class Algorithm, class Clock, class Sync>
+void testBurstCapacity() {
+    RateLimiter<Algorithm, Clock, Sync> limiter(burstConfig<Algorithm>());
+    
+    bool first = limiter.tryAcquire(50.0);
+    bool second = limiter.tryAcquire(60.0);
+    
+    std::cout << label<Algorithm, Clock, Sync>() << " burst of 50: "
+              << (first ? "ALLOWED" : "DENIED") << ", then 60: "
+              << (second ? "ALLOWED" : "DENIED") << ", available "
+              << static_cast<int>(limiter.getAvailable())
+              << (first && !second ? "" : "  <-- expected 50 allowed, 60 denied") << std::endl;
+}
+
+template <class Algorithm, class Clock, class Sync>
+void testWeightedCost() {
+    RateLimiter<Algorithm, Clock, Sync> limiter(burstConfig<Algorithm>());
+    
+    // A report costs 50, a read a quarter; the last report only fits at cost 49
+    std::string decisions;
+    for (double cost : {50.0, 0.25, 0.25, 0.25, 0.25, 50.0, 49.0}) {
+        decisions += limiter.tryAcquire(cost) ? 'A' : 'D';
+    }
+    
+    std::cout << label<Algorithm, Clock, Sync>() << " costs 50, 4 x 0.25, 50, 49: "
+              << decisions << (decisions == "AAAAADA" ? "" : "  <-- expected AAAAADA") << std::endl;
+}
+
+template <class Algorithm, class Clock, class Sync>
+void testRecovery() {
+    RateLimiter<Algorithm, Clock, Sync> limiter(smallConfig<Algorithm>());
+    
+    int drained = 0;
+    while (limiter.tryAcquire()) {
+        drained++;
+    }
+    
+    elapse(limiter.getClock(), std::chrono::milliseconds(1200));
+    int admitted = 0;
+    while (admitted < 10 && limiter.tryAcquire()) {
+        admitted++;
+    }
+    
+    int expected = admittedAfterRecovery<Algorithm>();
+    std::cout << label<Algorithm, Clock, Sync>() << " recovery: drained " << drained
+              << ", admitted " << admitted << " after 1.2s"
+              << (admitted == expected ? "" : "  <-- expected " + std::to_string(expected))
+              << std::endl;
+}
+
+template <class Algorithm, class Clock, class Sync>
+void testReset() {
+    RateLimiter<Algorithm, Clock, Sync> limiter(smallConfig<Algorithm>());
+    
+    for (int i = 0; i < 3; ++i) {
+        limiter.tryAcquire();
+    }
+    double before = limiter.getAvailable();
+    limiter.reset();
+    
+    std::cout << label<Algorithm, Clock, Sync>() << " reset: available "
+              << static_cast<int>(before) << " before, " << limiter.getAvailable() << " after"
+              << (limiter.getAvailable() == 5.0 ? "" : "  <-- expected 5") << std::endl;
+}
+
+template <class Algorithm, class Clock, class Sync>
+void testConcurrentAccess() {
+    RateLimiter<Algorithm, Clock, Sync> limiter(largeConfig<Algorithm>());
+    std::atomic<int> allowed(0);
+    
+    auto worker = [&limiter, &allowed]() {
+        for (int i = 0; i < 1000; ++i) {
+            if (limiter.tryAcquire()) {
+                allowed++;
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    const int numThreads = 4;
+    
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    
+    for (auto& t : threads) {
+        t.join();
+    }
+    
+    std::cout << label<Algorithm, Clock, Sync>() << " " << numThreads
+              << " threads x 1000 requests: " << allowed.load() << " allowed"
+              << (allowed.load() == 1000 ? "" : "  <-- expected 1000") << std::endl;
+}
+
+template <class Algorithm, class Clock, class Sync>
+void runScenarios() {
+    testBasicUsage<Algorithm, Clock, Sync>();
+    testBurstCapacity<Algorithm, Clock, Sync>();
+    testWeightedCost<Algorithm, Clock, Sync>();
+    testRecovery<Algorithm, Clock, Sync>();
+    testReset<Algorithm, Clock, Sync>();
+    
+    // NullSync limiters belong to one thread
+    if constexpr (!std::is_same<Sync, NullSync>::value) {
+        testConcurrentAccess<Algorithm, Clock, Sync>();
+    }
+}
+
+template <class Algorithm, class Clock>
+void runClock() {
+    runScenarios<Algorithm, Clock, NullSync>();
+    runScenarios<Algorithm, Clock, MutexSync>();
+    
+    // AtomicSync only compiles for states that fit in one word
+    if constexpr (fitsAtomicSync<Algorithm>()) {
+        runScenarios<Algorithm, Clock, AtomicSync>();
+    }
+}
+
+template <class Algorithm>
+void runMatrix() {
+    std::cout << "=== Policy Matrix: " << policyName<Algorithm>() << " ===" << std::endl;
+    
+    runClock<Algorithm, ManualClock>();
+    runClock<Algorithm, CachedClock>();
+    runClock<Algorithm, SteadyClock>();
+    
+    std::cout << std::endl;
+}
+
+void testCachedClock() {
+    std::cout << "=== Policy Matrix: Per-Connection Limiter ===" << std::endl;
+    
+    // No locks, no atomics, no clock reads on the admission path
+    RateLimiter<TokenBucketAlgorithm, CachedClock, NullSync> limiter({3.0, 10.0});
+    
+    int allowed = 0;
+    for (int i = 0; i < 5; ++i) {
+        if (limiter.tryAcquire()) {
+            allowed++;
+        }
+    }
+    std::cout << label<TokenBucketAlgorithm, CachedClock, NullSync>()
+              << " before refresh: " << allowed << " of 5 allowed" << std::endl;
+    
+    // Time only moves for the limiter when the owner refreshes the clock
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    std::cout << "After 200ms without refresh, available: " << limiter.getAvailable() << std::endl;
+    limiter.getClock().refresh();
+    std::cout << "After refresh, available: " << limiter.getAvailable() << std::endl;
+    std::cout << std::endl;
+}
+
+} // namespace
+
+void runAllRateLimiterPolicyTests() {
+    try {
+        runMatrix<TokenBucketAlgorithm>();
+        runMatrix<LeakingBucketAlgorithm>();
+        runMatrix<FixedWindowAlgorithm>();
+        runMatrix<SlidingWindowLogAlgorithm>();
+        runMatrix<SlidingWindowCounterAlgorithm<>>();
+        testCachedClock();
+        
+        std::cout << "All Rate Limiter Policy tests completed successfully!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error in Rate Limiter Policy tests: " << e.what() << std::endl;
+        throw;
+    }
+}
@@ -0,0 +1,216 @@
+#include "rate_limiter_telemetry.h"
+#include "thread_slot.h"
+#include "token_bucket.h"
+#include "keyed_token_bucket.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <iomanip>
+#include <string>
+
+namespace {
+
+void printCounters(const std::string& label, const RateLimiterTelemetry::Counters& counters) {
+    std::cout << label << ": " << counters.allowed << " allowed, " << counters.rejected
+              << " rejected, " << counters.nearLimit << " near limit" << std::endl;
+}
+
+void testCounters() {
+    std::cout << "=== Rate Limiter Telemetry: Counters Test ===" << std::endl;
+    
+    RateLimiterTelemetry telemetry(1);
+    TokenBucket limiter(10.0, 0.001);
+    limiter.setTelemetry(&telemetry);
+    
+    for (int i = 0; i < 15; ++i) {
+        limiter.tryConsume();
+    }
+    
+    // Admissions that leave the bucket at least 90% used count as near the limit
+    printCounters("Token bucket after 15 requests", telemetry.getTotals());
+    std::cout << std::endl;
+}
+
+void testKeyShards() {
+    std::cout << "=== Rate Limiter Telemetry: Key Shard Test ===" << std::endl;
+    
+    RateLimiterTelemetry telemetry(16);
+    KeyedTokenBucket limiter(5.0, 0.001);
+    limiter.setTelemetry(&telemetry);
+    
+    for (int i = 0; i < 100; ++i) {
+        limiter.tryConsume("abuser");
+    }
+    for (int i = 0; i < 20; ++i) {
+        limiter.tryConsume("client-" + std::to_string(i));
+    }
+    
+    printCounters("All shards", telemetry.getTotals());
+    size_t hot = telemetry.getKeyShard("abuser");
+    printCounters("Shard " + std::to_string(hot) + " (abuser's shard)", telemetry.getKeyShardCounters(hot));
+    std::cout << std::endl;
+}
+
+void testRejectionLog() {
+    std::cout << "=== Rate Limiter Telemetry: Rejection Log Test ===" << std::endl;
+    
+    // Keep every rejection, in a ring of 4
+    RateLimiterTelemetry telemetry(16, 1, 4);
+    KeyedTokenBucket limiter(2.0, 0.001);
+    limiter.setTelemetry(&telemetry);
+    
+    const std::string longKey = "a-very-long-client-identifier-that-gets-truncated";
+    for (const std::string key : {"alice", "alice", "alice", "alice", "bob", "bob", "bob", "bob"}) {
+        limiter.tryConsume(key);
+    }
+    for (int i = 0; i < 3; ++i) {
+        limiter.tryConsume(longKey);
+    }
+    
+    auto events = telemetry.getRecentRejections();
+    std::cout << "Last " << events.size() << " of " << telemetry.getTotals().rejected
+              << " rejections:" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto& event : events) {
+        std::cout << "  key=" << event.key << " utilization=" << event.utilization << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testConcurrentReaders() {
+    std::cout << "=== Rate Limiter Telemetry: Lock-Free Reader Test ===" << std::endl;
+    
+    RateLimiterTelemetry telemetry(16, 1, 64);
+    std::atomic<bool> done(false);
+    
+    // Writers log every rejection; each key encodes the utilization it was
+    // logged with. Writers are offset from each other, so entries written
+    // side by side hold different keys and a torn copy shows as a mismatch
+    auto writer = [&telemetry](int id) {
+        for (int i = 0; i < 200000; ++i) {
+            int level = (i + id * 25) % 100;
+            telemetry.record("client-" + std::to_string(level), false, level / 100.0);
+        }
+    };
+    
+    int snapshots = 0;
+    int events = 0;
+    int torn = 0;
+    std::thread reader([&]() {
+        while (!done.load()) {
+            for (const auto& event : telemetry.getRecentRejections()) {
+                int level = static_cast<int>(event.utilization * 100.0 + 0.5);
+                if (event.key != "client-" + std::to_string(level)) {
+                    torn++;
+                }
+                events++;
+            }
+            snapshots++;
+        }
+    });
+    
+    std::vector<std::thread> threads;
+    const int numThreads = 4;
+    
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(writer, i);
+    }
+    
+    for (auto& t : threads) {
+        t.join();
+    }
+    done = true;
+    reader.join();
+    
+    printCounters("Totals", telemetry.getTotals());
+    std::cout << "Reader took " << snapshots << " snapshots (" << events << " events), "
+              << torn << " torn" << std::endl;
+    if (torn == 0) {
+        std::cout << "Every event read was consistent!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testSamplingPerInstance() {
+    std::cout << "=== Rate Limiter Telemetry: Per-Instance Sampling Test ===" << std::endl;
+    
+    // One thread alternating between two limiters still logs every second
+    // rejection of each
+    RateLimiterTelemetry first(1, 2);
+    RateLimiterTelemetry second(1, 2);
+    for (int i = 0; i < 8; ++i) {
+        first.record(false, 1.0);
+        second.record(false, 1.0);
+    }
+    
+    std::cout << "Logged " << first.getRecentRejections().size() << " and "
+              << second.getRecentRejections().size() << " of 8 rejections each (expected 4 and 4)"
+              << std::endl;
+    std::cout << std::endl;
+}
+
+void testThreadChurn() {
+    std::cout << "=== Rate Limiter Telemetry: Thread Churn Test ===" << std::endl;
+    
+    RateLimiterTelemetry telemetry(1, 64, 256, 0.9, 4);
+    
+    // Far more short-lived threads than private rows, never more than one alive
+    for (int i = 0; i < 200; ++i) {
+        std::thread([&telemetry]() {
+            telemetry.record(true, 0.0);
+        }).join();
+    }
+    
+    size_t slot = 0;
+    std::thread([&slot]() {
+        slot = currentThreadSlot();
+    }).join();
+    
+    std::cout << "Recorded " << telemetry.getTotals().allowed << " decisions from 200 threads" << std::endl;
+    std::cout << "Thread number after 200 threads exited: " << slot
+              << (slot < 4 ? " (still owns a private row)" : " (on the shared overflow row)") << std::endl;
+    std::cout << std::endl;
+}
+
+void testOverhead() {
+    std::cout << "=== Rate Limiter Telemetry: Overhead Test ===" << std::endl;
+    
+    RateLimiterTelemetry telemetry(1);
+    const int decisions = 10000000;
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < decisions; ++i) {
+        // Mostly admissions, with one rejection in 16
+        telemetry.recordRemaining((i & 15) != 0, i & 1023, 1024.0);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+    
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << decisions << " decisions recorded in " << elapsed / 1e6 << "ms ("
+              << static_cast<double>(elapsed) / decisions << " ns/decision)" << std::endl;
+    printCounters("Totals", telemetry.getTotals());
+    std::cout << std::endl;
+}
+
+} // namespace
+
+void runAllRateLimiterTelemetryTests() {
+    try {
+        testCounters();
+        testKeyShards();
+        testRejectionLog();
+        testConcurrentReaders();
+        testSamplingPerInstance();
+        testThreadChurn();
+        testOverhead();
+        
+        std::cout << "All Rate Limiter Telemetry tests completed successfully!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error in Rate Limiter Telemetry tests: " << e.what() << std::endl;
+        throw;
+    }
+}
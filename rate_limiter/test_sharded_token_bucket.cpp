@@ -0,0 +1,204 @@
+#include "sharded_token_bucket.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <atomic>
+
+namespace {
+
+void testBasicUsage() {
+    std::cout << "=== Sharded Token Bucket: Basic Usage Test ===" << std::endl;
+    
+    // 10 tokens capacity, 2 tokens per second, split across 4 shards
+    ShardedTokenBucket limiter(10.0, 2.0, 4);
+    
+    std::cout << "Initial tokens: " << limiter.getAvailableTokens() << std::endl;
+    std::cout << "Capacity: " << limiter.getCapacity() << std::endl;
+    std::cout << "Refill rate: " << limiter.getRefillRate() << " tokens/sec" << std::endl;
+    std::cout << "Shards: " << limiter.getNumShards() << std::endl;
+    std::cout << std::endl;
+    
+    // A single thread drains its own shard first, then steals from the others
+    int allowed = 0;
+    int denied = 0;
+    
+    for (int i = 0; i < 15; ++i) {
+        if (limiter.tryConsume()) {
+            allowed++;
+        } else {
+            denied++;
+        }
+    }
+    
+    std::cout << "Summary: " << allowed << " allowed, " << denied << " denied" << std::endl;
+    if (allowed == 10) {
+        std::cout << "Single thread used the full aggregate capacity via stealing!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testStealing() {
+    std::cout << "=== Sharded Token Bucket: Stealing Test ===" << std::endl;
+    
+    // 8 tokens over 4 shards = 2 tokens per shard
+    ShardedTokenBucket limiter(8.0, 1.0, 4);
+    
+    std::cout << "Consuming 5 tokens at once (more than one shard holds)..." << std::endl;
+    if (limiter.tryConsume(5)) {
+        std::cout << "Request for 5 tokens ALLOWED, remaining: "
+                  << limiter.getAvailableTokens() << std::endl;
+    } else {
+        std::cout << "Request for 5 tokens DENIED" << std::endl;
+    }
+    
+    std::cout << "Consuming 4 more tokens (only 3 left)..." << std::endl;
+    if (limiter.tryConsume(4)) {
+        std::cout << "Request for 4 tokens ALLOWED" << std::endl;
+    } else {
+        std::cout << "Request for 4 tokens DENIED (remaining: "
+                  << limiter.getAvailableTokens() << ")" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testBoundedStealing() {
+    std::cout << "=== Sharded Token Bucket: Bounded Stealing Test ===" << std::endl;
+    
+    // Only one neighbour is visited, so at most 2 shards of tokens are stranded
+    ShardedTokenBucket limiter(8.0, 1.0, 4, 1000, 1);
+    
+    int allowed = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (limiter.tryConsume()) {
+            allowed++;
+        }
+    }
+    
+    std::cout << "Allowed " << allowed << " of 8 with maxStealShards = 1" << std::endl;
+    std::cout << "Tokens stranded in other shards: " << limiter.getAvailableTokens() << std::endl;
+    
+    limiter.rebalance();
+    if (limiter.tryConsume()) {
+        std::cout << "Rebalance put stranded tokens back into circulation!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testFailedStealKeepsCapacity() {
+    std::cout << "=== Sharded Token Bucket: Failed Steal Test ===" << std::endl;
+    
+    // 10 tokens over 2 shards; a failed steal must not let the shards refill past 10
+    ShardedTokenBucket limiter(10.0, 100.0, 2);
+    limiter.tryConsume(3);
+    std::cout << "Request for 8 tokens with 7 left: "
+              << (limiter.tryAcquire(8.0) ? "ALLOWED" : "DENIED") << std::endl;
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    double available = limiter.getAvailableTokens();
+    std::cout << "Available after 50ms: " << available << " (capacity: "
+              << limiter.getCapacity() << ")" << std::endl;
+    
+    int allowed = 0;
+    for (int i = 0; i < 11; ++i) {
+        if (limiter.tryConsume()) {
+            allowed++;
+        }
+    }
+    std::cout << "Burst of 11: " << allowed << " allowed" << std::endl;
+    if (available <= limiter.getCapacity() && allowed <= 10) {
+        std::cout << "Failed steal didn't create tokens!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testRefill() {
+    std::cout << "=== Sharded Token Bucket: Refill Rate Test ===" << std::endl;
+    
+    // 4 tokens, 2 tokens per second, 2 shards
+    ShardedTokenBucket limiter(4.0, 2.0, 2);
+    
+    limiter.tryConsume(4);
+    std::cout << "Drained bucket, remaining: " << limiter.getAvailableTokens() << std::endl;
+    
+    std::cout << "Waiting 1 second for tokens to refill..." << std::endl;
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    
+    std::cout << "Available tokens after 1 second: "
+              << limiter.getAvailableTokens() << std::endl;
+    
+    if (limiter.tryConsume(2)) {
+        std::cout << "Successfully consumed 2 tokens after refill!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testConcurrentAccess() {
+    std::cout << "=== Sharded Token Bucket: Thread Safety Test ===" << std::endl;
+    
+    // Large burst, negligible refill: total allowed must never exceed capacity
+    ShardedTokenBucket limiter(10000.0, 1.0, 8);
+    std::atomic<int> allowed(0);
+    std::atomic<int> denied(0);
+    
+    auto worker = [&limiter, &allowed, &denied]() {
+        for (int i = 0; i < 5000; ++i) {
+            if (limiter.tryConsume()) {
+                allowed++;
+            } else {
+                denied++;
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    const int numThreads = 4;
+    
+    std::cout << "Starting " << numThreads << " threads, each making 5000 requests..." << std::endl;
+    
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    
+    for (auto& t : threads) {
+        t.join();
+    }
+    
+    std::cout << "Total allowed: " << allowed.load() << std::endl;
+    std::cout << "Total denied: " << denied.load() << std::endl;
+    if (allowed.load() <= 10000 + 1) {
+        std::cout << "Aggregate admission stayed within capacity!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testReset() {
+    std::cout << "=== Sharded Token Bucket: Reset Test ===" << std::endl;
+    
+    ShardedTokenBucket limiter(6.0, 1.0, 3);
+    limiter.tryConsume(6);
+    std::cout << "Tokens before reset: " << limiter.getAvailableTokens() << std::endl;
+    
+    limiter.reset();
+    std::cout << "Tokens after reset: " << limiter.getAvailableTokens() << std::endl;
+    std::cout << std::endl;
+}
+
+} // namespace
+
+void runAllShardedTokenBucketTests() {
+    try {
+        testBasicUsage();
+        testStealing();
+        testBoundedStealing();
+        testFailedStealKeepsCapacity();
+        testRefill();
+        testConcurrentAccess();
+        testReset();
+        
+        std::cout << "All Sharded Token Bucket tests completed successfully!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error in Sharded Token Bucket tests: " << e.what() << std::endl;
+        throw;
+    }
+}
@@ -0,0 +1,227 @@
+#include "shared_token_bucket.h"
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// Unique per run so stale segments from an earlier run don't interfere
+std::string segmentName(const std::string& test) {
+    return "/sdi_rl_test_" + test + "_" + std::to_string(getpid());
+}
+
+} // namespace
+
+// Forces two keys onto one hash, which real keys would need a 64-bit
+// collision for
+struct SharedTokenBucketTest {
+    static void collidingKeys() {
+        std::cout << "=== Shared Token Bucket: Colliding Hashes Test ===" << std::endl;
+        
+        std::string name = segmentName("collide");
+        SharedTokenBucket limiter(name, 5.0, 1.0, 64);
+        const uint64_t hash = 12345;
+        
+        SharedTokenBucket::Slot* alice = limiter.findSlot("alice", hash, true);
+        SharedTokenBucket::Slot* bob = limiter.findSlot("bob", hash, true);
+        std::cout << "alice and bob share a slot: " << (alice == bob ? "yes" : "no (expected)") << std::endl;
+        std::cout << "alice found again: " << (limiter.findSlot("alice", hash, false) == alice ? "yes" : "no")
+                  << ", unseen carol found: " << (limiter.findSlot("carol", hash, false) ? "yes" : "no (expected)")
+                  << std::endl;
+        
+        // Keys differing only past the stored prefix are told apart by length
+        std::string longKey(SharedTokenBucket::KeyPrefixBytes, 'k');
+        SharedTokenBucket::Slot* shorter = limiter.findSlot(longKey, hash + 1, true);
+        SharedTokenBucket::Slot* longer = limiter.findSlot(longKey + "x", hash + 1, true);
+        std::cout << "Keys of " << longKey.size() << " and " << longKey.size() + 1
+                  << " bytes share a slot: " << (shorter == longer ? "yes" : "no (expected)") << std::endl;
+        
+        SharedTokenBucket::unlink(name);
+        std::cout << std::endl;
+    }
+};
+
+namespace {
+
+void testBasicUsage() {
+    std::cout << "=== Shared Token Bucket: Basic Usage Test ===" << std::endl;
+    
+    std::string name = segmentName("basic");
+    SharedTokenBucket limiter(name, 5.0, 1.0, 64);
+    
+    std::cout << "Segment: " << limiter.getName() << std::endl;
+    std::cout << "Capacity: " << limiter.getCapacity() << std::endl;
+    std::cout << "Refill rate: " << limiter.getRefillRate() << " tokens/sec" << std::endl;
+    std::cout << "Key slots: " << limiter.getMaxKeys() << std::endl;
+    std::cout << std::endl;
+    
+    for (int i = 0; i < 7; ++i) {
+        if (limiter.tryConsume("user1")) {
+            std::cout << "Request " << (i + 1) << " for user1: ALLOWED (tokens remaining: "
+                      << limiter.getAvailableTokens("user1") << ")" << std::endl;
+        } else {
+            std::cout << "Request " << (i + 1) << " for user1: DENIED (rate limited)" << std::endl;
+        }
+    }
+    
+    std::cout << "user2 is tracked separately, tokens: "
+              << limiter.getAvailableTokens("user2") << std::endl;
+    
+    SharedTokenBucket::unlink(name);
+    std::cout << std::endl;
+}
+
+void testSharedBetweenInstances() {
+    std::cout << "=== Shared Token Bucket: Shared State Test ===" << std::endl;
+    
+    std::string name = segmentName("shared");
+    SharedTokenBucket first(name, 10.0, 1.0, 64);
+    SharedTokenBucket second(name, 10.0, 1.0, 64);
+    
+    first.tryConsume("api-key", 6);
+    std::cout << "First instance consumed 6 tokens" << std::endl;
+    std::cout << "Second instance sees: " << second.getAvailableTokens("api-key") << " tokens" << std::endl;
+    
+    if (!second.tryConsume("api-key", 6)) {
+        std::cout << "Second instance denied 6 more tokens - the limit is shared!" << std::endl;
+    }
+    
+    SharedTokenBucket::unlink(name);
+    std::cout << std::endl;
+}
+
+void testSurvivesRestart() {
+    std::cout << "=== Shared Token Bucket: Restart Test ===" << std::endl;
+    
+    std::string name = segmentName("restart");
+    {
+        SharedTokenBucket worker(name, 10.0, 1.0, 64);
+        worker.tryConsume("user1", 8);
+        std::cout << "Worker consumed 8 tokens and exited" << std::endl;
+    }
+    
+    SharedTokenBucket restarted(name, 10.0, 1.0, 64);
+    std::cout << "Restarted worker sees: " << restarted.getAvailableTokens("user1") << " tokens" << std::endl;
+    if (restarted.getAvailableTokens("user1") < 5.0) {
+        std::cout << "State survived the restart - no fresh burst!" << std::endl;
+    }
+    
+    SharedTokenBucket::unlink(name);
+    std::cout << std::endl;
+}
+
+void testAcrossProcesses() {
+    std::cout << "=== Shared Token Bucket: Multi-Process Test ===" << std::endl;
+    
+    std::string name = segmentName("fork");
+    SharedTokenBucket parent(name, 100.0, 0.001, 64);
+    
+    const int numChildren = 4;
+    std::cout << "Forking " << numChildren << " workers, each making 50 requests..." << std::endl;
+    
+    for (int i = 0; i < numChildren; ++i) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            int allowed = 0;
+            {
+                SharedTokenBucket child(name, 100.0, 0.001, 64);
+                for (int j = 0; j < 50; ++j) {
+                    if (child.tryConsume("global")) {
+                        allowed++;
+                    }
+                }
+            }
+            _exit(allowed);
+        }
+        if (pid < 0) {
+            throw std::runtime_error("fork failed");
+        }
+    }
+    
+    int totalAllowed = 0;
+    for (int i = 0; i < numChildren; ++i) {
+        int status = 0;
+        wait(&status);
+        if (WIFEXITED(status)) {
+            totalAllowed += WEXITSTATUS(status);
+        }
+    }
+    
+    std::cout << "Total allowed across workers: " << totalAllowed << std::endl;
+    if (totalAllowed == 100) {
+        std::cout << "Workers shared one exact limit!" << std::endl;
+    }
+    
+    SharedTokenBucket::unlink(name);
+    std::cout << std::endl;
+}
+
+void testParameterMismatch() {
+    std::cout << "=== Shared Token Bucket: Parameter Mismatch Test ===" << std::endl;
+    
+    std::string name = segmentName("mismatch");
+    SharedTokenBucket limiter(name, 10.0, 1.0, 64);
+    
+    try {
+        SharedTokenBucket other(name, 20.0, 1.0, 64);
+        std::cout << "Attached with a different capacity (unexpected)" << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cout << "Rejected: " << e.what() << std::endl;
+    }
+    
+    SharedTokenBucket::unlink(name);
+    std::cout << std::endl;
+}
+
+void testFullTable() {
+    std::cout << "=== Shared Token Bucket: Full Table Test ===" << std::endl;
+    
+    std::string name = segmentName("full");
+    SharedTokenBucket limiter(name, 5.0, 1.0, 4);
+    
+    for (int i = 0; i < 6; ++i) {
+        std::string key = "client" + std::to_string(i);
+        std::cout << key << ": " << (limiter.tryConsume(key) ? "ALLOWED" : "DENIED (no free slot)") << std::endl;
+    }
+    
+    SharedTokenBucket::unlink(name);
+    std::cout << std::endl;
+}
+
+void testReset() {
+    std::cout << "=== Shared Token Bucket: Reset Test ===" << std::endl;
+    
+    std::string name = segmentName("reset");
+    SharedTokenBucket limiter(name, 5.0, 1.0, 64);
+    
+    limiter.tryConsume("user1", 5);
+    std::cout << "Tokens before reset: " << limiter.getAvailableTokens("user1") << std::endl;
+    
+    limiter.reset("user1");
+    std::cout << "Tokens after reset: " << limiter.getAvailableTokens("user1") << std::endl;
+    
+    SharedTokenBucket::unlink(name);
+    std::cout << std::endl;
+}
+
+} // namespace
+
+void runAllSharedTokenBucketTests() {
+    try {
+        testBasicUsage();
+        testSharedBetweenInstances();
+        testSurvivesRestart();
+        testAcrossProcesses();
+        testParameterMismatch();
+        testFullTable();
+        testReset();
+        SharedTokenBucketTest::collidingKeys();
+        
+        std::cout << "All Shared Token Bucket tests completed successfully!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error in Shared Token Bucket tests: " << e.what() << std::endl;
+        throw;
+    }
+}
@@ -6,6 +6,8 @@
 #include <atomic>
 #include <iomanip>
 
+namespace {
+
 void testBasicUsage() {
     std::cout << "=== Sliding Window Counter: Basic Usage Test ===" << std::endl;
     
@@ -271,6 +273,36 @@ void testWeightedCounting() {
     std::cout << std::endl;
 }
 
+void testWeightedCost() {
+    std::cout << "=== Sliding Window Counter: Weighted Cost Test ===" << std::endl;
+    
+    SlidingWindowCounter limiter(100, 60, 10);
+    
+    std::cout << "Report (cost 50): " << (limiter.tryAcquire(50.0) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Read (cost 1.5): " << (limiter.tryAcquire(1.5) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Current count: " << limiter.getCurrentCount() << std::endl;
+    std::cout << "Report (cost 50): " << (limiter.tryAcquire(50.0) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Report (cost 48.5): " << (limiter.tryAcquire(48.5) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << std::endl;
+}
+
+void testSetLimits() {
+    std::cout << "=== Sliding Window Counter: Runtime Limit Change Test ===" << std::endl;
+    
+    SlidingWindowCounter limiter(10, 60);
+    limiter.tryAllow(6);
+    std::cout << "Before: " << limiter.getCurrentCount() << "/" << limiter.getMaxRequests() << std::endl;
+    
+    limiter.setMaxRequests(20);
+    std::cout << "After setMaxRequests(20): " << limiter.getCurrentCount() << "/"
+              << limiter.getMaxRequests() << std::endl;
+    std::cout << "Request for 8: " << (limiter.tryAllow(8) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Request for 1: " << (limiter.tryAllow() ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << std::endl;
+}
+
+} // namespace
+
 void runAllSlidingWindowCounterTests() {
     try {
         testBasicUsage();
@@ -282,6 +314,8 @@ void runAllSlidingWindowCounterTests() {
         testReset();
         testSubWindowCount();
         testWeightedCounting();
+        testWeightedCost();
+        testSetLimits();
         
         std::cout << "All Sliding Window Counter tests completed successfully!" << std::endl;
     } catch (const std::exception& e) {
@@ -6,6 +6,8 @@
 #include <atomic>
 #include <iomanip>
 
+namespace {
+
 void testBasicUsage() {
     std::cout << "=== Sliding Window Log: Basic Usage Test ===" << std::endl;
     
@@ -267,6 +269,99 @@ void testAccuracyVsFixedWindow() {
     std::cout << std::endl;
 }
 
+void testWeightedCost() {
+    std::cout << "=== Sliding Window Log: Weighted Cost Test ===" << std::endl;
+    
+    // An expensive request takes one log entry, not one per unit of cost
+    SlidingWindowLog limiter(1000000, 60);
+    
+    std::cout << "Bulk export (cost 999999.5): "
+              << (limiter.tryAcquire(999999.5) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Read (cost 0.5): " << (limiter.tryAcquire(0.5) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Read (cost 0.5): " << (limiter.tryAcquire(0.5) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Current count: " << limiter.getCurrentCount() << "/" << limiter.getMaxRequests() << std::endl;
+    std::cout << std::endl;
+}
+
+void testSetLimits() {
+    std::cout << "=== Sliding Window Log: Runtime Limit Change Test ===" << std::endl;
+    
+    SlidingWindowLog limiter(10, 1);
+    limiter.tryAllow(4);
+    std::cout << "Before: " << limiter.getCurrentCount() << "/" << limiter.getMaxRequests() << std::endl;
+    
+    limiter.setMaxRequests(5);
+    std::cout << "After setMaxRequests(5): " << limiter.getCurrentCount() << "/"
+              << limiter.getMaxRequests() << std::endl;
+    std::cout << "Request for 3: " << (limiter.tryAllow(3) ? "ALLOWED" : "DENIED") << std::endl;
+    
+    // The rescaled entries still expire when the originals would have
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    std::cout << "After window: " << limiter.getCurrentCount() << "/" << limiter.getMaxRequests() << std::endl;
+    std::cout << std::endl;
+}
+
+void testCompactStorage() {
+    std::cout << "=== Sliding Window Log: Compact Storage Test ===" << std::endl;
+    
+    // 10000 requests per 1 second window
+    SlidingWindowLog limiter(10000, 1);
+    for (int i = 0; i < 10000; ++i) {
+        limiter.tryAllow();
+    }
+    
+    // A deque of time_points would need 16+ bytes per entry
+    std::cout << "Logged " << limiter.getCurrentCount() << " requests in "
+              << limiter.getMemoryUsage() << " bytes (" << std::fixed << std::setprecision(2)
+              << static_cast<double>(limiter.getMemoryUsage()) / limiter.getCurrentCount()
+              << " bytes/request)" << std::endl;
+    
+    // Expired chunks go back to the pool and are reused by the next window
+    size_t before = limiter.getMemoryUsage();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    for (int i = 0; i < 10000; ++i) {
+        limiter.tryAllow();
+    }
+    std::cout << "Memory after the window slid: " << limiter.getMemoryUsage() << " bytes"
+              << (limiter.getMemoryUsage() <= before ? " (chunks reused)" : "") << std::endl;
+    
+    std::cout << "Oldest expires in: " << std::setprecision(3)
+              << limiter.getTimeUntilOldestExpires() << "s" << std::endl;
+    std::cout << std::endl;
+}
+
+void testSparseStorage() {
+    std::cout << "=== Sliding Window Log: Sparse and Rescaled Storage Test ===" << std::endl;
+    
+    // Gaps over a second are escaped inside the chunk, not given chunks of their own
+    SlidingWindowLog sparse(10, 5);
+    for (int i = 0; i < 4; ++i) {
+        if (i > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        }
+        sparse.tryAllow();
+    }
+    std::cout << "4 requests 1.1s apart: " << sparse.getCurrentCount() << " logged in "
+              << sparse.getMemoryUsage() << " bytes (expected one 256-byte chunk)" << std::endl;
+    
+    // After a limit change, unit requests keep the compact one-word form
+    SlidingWindowLog rescaled(20000, 1);
+    rescaled.tryAllow();
+    rescaled.setMaxRequests(30000);
+    for (int i = 0; i < 10000; ++i) {
+        rescaled.tryAllow();
+    }
+    std::cout << "10000 requests after setMaxRequests: " << rescaled.getMemoryUsage() << " bytes ("
+              << std::fixed << std::setprecision(2)
+              << static_cast<double>(rescaled.getMemoryUsage()) / rescaled.getCurrentCount()
+              << " bytes/request, as without the change)" << std::endl;
+    std::cout << "Count: " << rescaled.getCurrentCount() << "/" << rescaled.getMaxRequests()
+              << " (expected 10002/30000)" << std::endl;
+    std::cout << std::endl;
+}
+
+} // namespace
+
 void runAllSlidingWindowLogTests() {
     try {
         testBasicUsage();
@@ -278,6 +373,10 @@ void runAllSlidingWindowLogTests() {
         testTimeUntilExpiration();
         testReset();
         testAccuracyVsFixedWindow();
+        testWeightedCost();
+        testSetLimits();
+        testCompactStorage();
+        testSparseStorage();
         
         std::cout << "All Sliding Window Log tests completed successfully!" << std::endl;
     } catch (const std::exception& e) {
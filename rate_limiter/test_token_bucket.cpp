@@ -4,6 +4,9 @@
 #include <vector>
 #include <chrono>
 #include <atomic>
+#include <iomanip>
+
+namespace {
 
 void testBasicUsage() {
     std::cout << "=== Token Bucket: Basic Usage Test ===" << std::endl;
@@ -121,12 +124,135 @@ void testConcurrentAccess() {
     std::cout << std::endl;
 }
 
+void testReservation() {
+    std::cout << "=== Token Bucket: Reservation Test ===" << std::endl;
+    
+    // 2 tokens capacity, 4 tokens per second: one token every 250ms
+    TokenBucket limiter(2.0, 4.0);
+    limiter.tryConsume(2);
+    
+    auto wait1 = limiter.reserve(1);
+    auto wait2 = limiter.reserve(1);
+    std::cout << "First reservation waits " 
+              << std::chrono::duration_cast<std::chrono::milliseconds>(wait1).count() << "ms" << std::endl;
+    std::cout << "Second reservation waits " 
+              << std::chrono::duration_cast<std::chrono::milliseconds>(wait2).count() << "ms" << std::endl;
+    
+    // Non-waiting callers can't jump the queue while reservations are outstanding
+    if (!limiter.tryConsume()) {
+        std::cout << "tryConsume RATE LIMITED while reservations are outstanding (tokens: " 
+                  << limiter.getAvailableTokens() << ")" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testAcquire() {
+    std::cout << "=== Token Bucket: Blocking Acquire Test ===" << std::endl;
+    
+    // 1 token capacity, 10 tokens per second: one token every 100ms
+    TokenBucket limiter(1.0, 10.0);
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 5; ++i) {
+        limiter.acquire();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    
+    std::cout << "Acquired 5 tokens in " 
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() 
+              << "ms (expected ~400ms)" << std::endl;
+    
+    if (!limiter.acquireFor(std::chrono::milliseconds(10))) {
+        std::cout << "acquireFor(10ms) gave up: next token is ~100ms away" << std::endl;
+    }
+    if (limiter.acquireFor(std::chrono::milliseconds(200))) {
+        std::cout << "acquireFor(200ms) waited for the next token" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testFairWaiters() {
+    std::cout << "=== Token Bucket: Fair Waiters Test ===" << std::endl;
+    
+    // No spinning or retrying: each thread blocks until its reserved slot
+    TokenBucket limiter(1.0, 20.0);
+    limiter.tryConsume();
+    std::atomic<int> acquired(0);
+    
+    auto worker = [&limiter, &acquired]() {
+        for (int i = 0; i < 5; ++i) {
+            limiter.acquire();
+            acquired++;
+        }
+    };
+    
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    
+    std::cout << "4 threads acquired " << acquired.load() << " tokens in " 
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() 
+              << "ms (expected ~1000ms at 20 tokens/sec)" << std::endl;
+    std::cout << std::endl;
+}
+
+void testWeightedCost() {
+    std::cout << "=== Token Bucket: Weighted Cost Test ===" << std::endl;
+    
+    // Reads cost 1, reports cost 50, and a cheap ping costs half a token
+    TokenBucket limiter(100.0, 10.0);
+    
+    std::cout << "Report (cost 50): " << (limiter.tryAcquire(50.0) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Report (cost 50): " << (limiter.tryAcquire(50.0) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Ping (cost 0.5): " << (limiter.tryAcquire(0.5) ? "ALLOWED" : "DENIED") << std::endl;
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::cout << "After 100ms, tokens: " << limiter.getAvailableTokens() << std::endl;
+    std::cout << "Ping (cost 0.5): " << (limiter.tryAcquire(0.5) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << "Report (cost 150, above capacity): "
+              << (limiter.tryAcquire(150.0) ? "ALLOWED" : "DENIED") << std::endl;
+    std::cout << std::endl;
+}
+
+void testSetLimits() {
+    std::cout << "=== Token Bucket: Runtime Limit Change Test ===" << std::endl;
+    
+    TokenBucket limiter(10.0, 1.0);
+    limiter.tryConsume(7);
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Before: " << limiter.getAvailableTokens() << "/" << limiter.getCapacity()
+              << " tokens, " << limiter.getRefillRate() << " tokens/sec" << std::endl;
+    
+    // Doubling the limit keeps the bucket 30% full rather than refilling it
+    limiter.setLimits(20.0, 5.0);
+    std::cout << "After doubling: " << limiter.getAvailableTokens() << "/" << limiter.getCapacity()
+              << " tokens, " << limiter.getRefillRate() << " tokens/sec" << std::endl;
+    
+    limiter.setLimits(5.0, 5.0);
+    std::cout << "After shrinking to 5: " << limiter.getAvailableTokens() << "/"
+              << limiter.getCapacity() << " tokens" << std::endl;
+    std::cout << std::endl;
+}
+
+} // namespace
+
 void runAllTokenBucketTests() {
     try {
         testBasicUsage();
         testRefill();
         testBurst();
         testConcurrentAccess();
+        testReservation();
+        testAcquire();
+        testFairWaiters();
+        testWeightedCost();
+        testSetLimits();
         
         std::cout << "All Token Bucket tests completed successfully!" << std::endl;
     } catch (const std::exception& e) {
@@ -0,0 +1,51 @@
+#include "thread_slot.h"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<size_t> freeSlots;  // Min-heap of numbers given back by exited threads
+    size_t nextSlot = 0;            // Lowest number never handed out
+};
+
+// Never destroyed: threads may still exit while statics are being torn down
+Registry& registry() {
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+// Hands the thread's number back when the thread exits
+struct SlotRelease {
+    size_t& slot;
+    
+    ~SlotRelease() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.freeSlots.push_back(slot);
+        std::push_heap(r.freeSlots.begin(), r.freeSlots.end(), std::greater<size_t>());
+        slot = SIZE_MAX;
+    }
+};
+
+} // namespace
+
+void thread_slot_detail::assignSlot(size_t& slot) {
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        if (!r.freeSlots.empty()) {
+            std::pop_heap(r.freeSlots.begin(), r.freeSlots.end(), std::greater<size_t>());
+            slot = r.freeSlots.back();
+            r.freeSlots.pop_back();
+        } else {
+            slot = r.nextSlot++;
+        }
+    }
+    
+    thread_local SlotRelease release{slot};
+    (void)release;
+}
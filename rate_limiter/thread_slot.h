@@ -0,0 +1,36 @@
+#ifndef THREAD_SLOT_H
+#define THREAD_SLOT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace thread_slot_detail {
+
+/**
+ * Take the lowest free number for the calling thread and give it back when
+ * the thread exits (slow path, once per thread)
+ */
+void assignSlot(size_t& slot);
+
+} // namespace thread_slot_detail
+
+/**
+ * Number of the calling thread, assigned on first use
+ *
+ * Numbers start at 0 and belong to one live thread at a time: a thread's
+ * number is handed to a later thread only after it has exited, so numbers
+ * stay below the peak number of threads alive at once, however many
+ * short-lived threads come and go. A thread can use its number to pick a
+ * shard or to own a row of per-thread counters that no other live thread
+ * writes.
+ */
+inline size_t currentThreadSlot() {
+    // Constant-initialized, so reading it needs no TLS init guard on the hot path
+    thread_local size_t slot = SIZE_MAX;
+    if (slot == SIZE_MAX) {
+        thread_slot_detail::assignSlot(slot);
+    }
+    return slot;
+}
+
+#endif // THREAD_SLOT_H
@@ -1,12 +1,16 @@
 #include "token_bucket.h"
+#include "rate_limiter_telemetry.h"
 #include <algorithm>
 #include <stdexcept>
+#include <cmath>
+#include <thread>
 
 TokenBucket::TokenBucket(double capacity, double refillRate)
     : capacity_(capacity)
     , refillRate_(refillRate)
     , tokens_(capacity)  // Start with full bucket
     , lastRefill_(std::chrono::steady_clock::now())
+    , telemetry_(nullptr)
 {
     if (capacity <= 0 || refillRate <= 0) {
         throw std::invalid_argument("Capacity and refill rate must be positive");
@@ -18,7 +22,12 @@ bool TokenBucket::tryConsume() {
 }
 
 bool TokenBucket::tryConsume(int tokens) {
-    if (tokens <= 0) {
+    return tryAcquire(tokens);
+}
+
+bool TokenBucket::tryAcquire(double cost) {
+    // Negated so NaN is rejected too
+    if (!(cost > 0)) {
         return false;
     }
     
@@ -28,12 +37,72 @@ bool TokenBucket::tryConsume(int tokens) {
     refill();
     
     // Check if we have enough tokens
-    if (tokens_ >= tokens) {
+    bool allowed = tokens_ >= cost;
+    if (allowed) {
+        tokens_ -= cost;
+    }
+    
+    RateLimiterTelemetry* telemetry = telemetry_.load(std::memory_order_relaxed);
+    if (telemetry) {
+        telemetry->recordRemaining(allowed, tokens_, capacity_);
+    }
+    
+    return allowed;
+}
+
+std::chrono::nanoseconds TokenBucket::reserve(int tokens) {
+    if (tokens <= 0) {
+        throw std::invalid_argument("Token count must be positive");
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    refill();
+    
+    // Take the tokens now; any shortfall is debt paid back by future refills
+    tokens_ -= tokens;
+    return timeUntil(0.0);
+}
+
+std::chrono::nanoseconds TokenBucket::acquire() {
+    return acquire(1);
+}
+
+std::chrono::nanoseconds TokenBucket::acquire(int tokens) {
+    auto wait = reserve(tokens);
+    if (wait.count() > 0) {
+        std::this_thread::sleep_for(wait);
+    }
+    return wait;
+}
+
+bool TokenBucket::acquireFor(std::chrono::nanoseconds timeout) {
+    return acquireFor(1, timeout);
+}
+
+bool TokenBucket::acquireFor(int tokens, std::chrono::nanoseconds timeout) {
+    if (tokens <= 0) {
+        return false;
+    }
+    
+    std::chrono::nanoseconds wait;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        refill();
+        
+        // Only reserve if the wait fits in the timeout
+        wait = timeUntil(tokens);
+        if (wait > timeout) {
+            return false;
+        }
         tokens_ -= tokens;
-        return true;
     }
     
-    return false;
+    if (wait.count() > 0) {
+        std::this_thread::sleep_for(wait);
+    }
+    return true;
 }
 
 double TokenBucket::getAvailableTokens() const {
@@ -46,13 +115,34 @@ double TokenBucket::getAvailableTokens() const {
 }
 
 double TokenBucket::getCapacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     return capacity_;
 }
 
 double TokenBucket::getRefillRate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     return refillRate_;
 }
 
+void TokenBucket::setLimits(double capacity, double refillRate) {
+    if (capacity <= 0 || refillRate <= 0) {
+        throw std::invalid_argument("Capacity and refill rate must be positive");
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    // Settle the time elapsed so far at the old rate
+    refill();
+    
+    tokens_ *= capacity / capacity_;
+    capacity_ = capacity;
+    refillRate_ = refillRate;
+}
+
+void TokenBucket::setTelemetry(RateLimiterTelemetry* telemetry) {
+    telemetry_.store(telemetry, std::memory_order_relaxed);
+}
+
 void TokenBucket::reset() {
     std::lock_guard<std::mutex> lock(mutex_);
     tokens_ = capacity_;
@@ -73,3 +163,11 @@ void TokenBucket::refill() {
     }
 }
 
+std::chrono::nanoseconds TokenBucket::timeUntil(double level) const {
+    if (tokens_ >= level) {
+        return std::chrono::nanoseconds(0);
+    }
+    
+    double seconds = (level - tokens_) / refillRate_;
+    return std::chrono::nanoseconds(static_cast<int64_t>(std::ceil(seconds * 1e9)));
+}
@@ -5,6 +5,8 @@
 #include <mutex>
 #include <atomic>
 
+class RateLimiterTelemetry;
+
 /**
  * Token Bucket Rate Limiter
  * 
@@ -35,9 +37,54 @@ public:
      */
     bool tryConsume(int tokens);
     
+    /**
+     * Try to admit a request with an arbitrary (possibly fractional) cost
+     * @param cost Tokens the request costs; costs above capacity never succeed
+     * @return true if the cost was consumed, false otherwise
+     */
+    bool tryAcquire(double cost);
+    
+    /**
+     * Reserve tokens without waiting, going into debt if the bucket is short
+     * 
+     * Reservations are served in arrival order: while the bucket is in debt,
+     * tryConsume() fails and later reservations queue up behind earlier ones.
+     * @param tokens Number of tokens to reserve
+     * @return Time until the reserved tokens are covered (zero if available now)
+     */
+    std::chrono::nanoseconds reserve(int tokens);
+    
+    /**
+     * Wait until a token is available and consume it
+     * @return Time spent waiting
+     */
+    std::chrono::nanoseconds acquire();
+    
+    /**
+     * Wait until multiple tokens are available and consume them
+     * @param tokens Number of tokens to consume
+     * @return Time spent waiting
+     */
+    std::chrono::nanoseconds acquire(int tokens);
+    
+    /**
+     * Consume a token, waiting at most timeout for it
+     * @param timeout Maximum time to wait
+     * @return true if the token was consumed, false if it would take longer than timeout
+     */
+    bool acquireFor(std::chrono::nanoseconds timeout);
+    
+    /**
+     * Consume multiple tokens, waiting at most timeout for them
+     * @param tokens Number of tokens to consume
+     * @param timeout Maximum time to wait
+     * @return true if the tokens were consumed, false if it would take longer than timeout
+     */
+    bool acquireFor(int tokens, std::chrono::nanoseconds timeout);
+    
     /**
      * Get the current number of available tokens
-     * @return Number of tokens currently available
+     * @return Number of tokens currently available (negative while reservations are outstanding)
      */
     double getAvailableTokens() const;
     
@@ -53,6 +100,23 @@ public:
      */
     double getRefillRate() const;
     
+    /**
+     * Change the capacity and refill rate without dropping state
+     *
+     * Tokens earned so far are credited at the old rate, then the token count
+     * is rescaled by newCapacity / oldCapacity, so a bucket that was 30% full
+     * stays 30% full (and outstanding debt shrinks or grows with it).
+     * @param capacity New maximum number of tokens
+     * @param refillRate New tokens added per second
+     */
+    void setLimits(double capacity, double refillRate);
+    
+    /**
+     * Record every tryConsume() / tryAcquire() decision into telemetry
+     * @param telemetry Telemetry to record into (must outlive the bucket), or nullptr to stop
+     */
+    void setTelemetry(RateLimiterTelemetry* telemetry);
+    
     /**
      * Reset the bucket to full capacity
      */
@@ -64,11 +128,17 @@ private:
     double tokens_;             // Current token count
     std::chrono::steady_clock::time_point lastRefill_;  // Last time tokens were refilled
     mutable std::mutex mutex_;  // Mutex for thread safety
+    std::atomic<RateLimiterTelemetry*> telemetry_;  // Decision telemetry, if any
     
     /**
      * Refill tokens based on elapsed time
      */
     void refill();
+    
+    /**
+     * Time until the bucket climbs back to the given token level (mutex must be held)
+     */
+    std::chrono::nanoseconds timeUntil(double level) const;
 };
 
 #endif // TOKEN_BUCKET_H
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -8,7 +13,7 @@
 #include <unordered_map>
 #include "xxh64.hpp"
 
-namespace {
+namespace scache_detail {
 	struct TransparentHash {
 		using is_transparent = void;
 
@@ -25,7 +30,7 @@ namespace {
 			return a == b;
 		}
 	};
-};
+}
 
 struct CachedString {
 	size_t index;
@@ -33,60 +38,113 @@ struct CachedString {
 	CachedString(size_t i) : index(i) {}
 };
 
+// Append-only byte arena: copies strings into large blocks and hands back
+// views that stay valid until clear() or destruction. Strings longer than a
+// block get a block of their own. Not thread-safe.
+class StringArena {
+public:
+	explicit StringArena(size_t block_size = 64 * 1024, size_t alignment = 1)
+		: block_size(block_size), alignment(alignment), used(block_size), reserved(0) {
+		if (block_size == 0 || alignment == 0 || (alignment & (alignment - 1)) != 0)
+			throw std::invalid_argument("block_size must be positive and alignment a power of two");
+	}
+
+	std::string_view store(std::string_view sv) {
+		if (sv.empty())
+			return std::string_view();
+
+		char* ptr;
+		if (sv.size() > block_size) {
+			// Dedicated block; the current one keeps filling
+			large_blocks.emplace_back(std::make_unique<char[]>(sv.size()));
+			reserved += sv.size();
+			ptr = large_blocks.back().get();
+		} else {
+			if (used + sv.size() > block_size) {
+				blocks.emplace_back(std::make_unique<char[]>(block_size));
+				reserved += block_size;
+				used = 0;
+			}
+			ptr = blocks.back().get() + used;
+			used += sv.size();
+			align_used();
+		}
+
+		std::memcpy(ptr, sv.data(), sv.size());
+		return std::string_view(ptr, sv.size());
+	}
+
+	// Take ownership of a caller's buffer, e.g. a file read in one go, so views
+	// into it live as long as the stored strings
+	void adopt(std::unique_ptr<char[]> buffer, size_t size) {
+		large_blocks.emplace_back(std::move(buffer));
+		reserved += size;
+	}
+
+	// Bytes allocated for blocks, used or not
+	size_t bytes_reserved() const { return reserved; }
+
+	void clear() {
+		blocks.clear();
+		large_blocks.clear();
+		used = block_size;
+		reserved = 0;
+	}
+private:
+	void align_used() {
+		used = std::min(block_size, (used + alignment - 1) & ~(alignment - 1));
+	}
+
+	size_t block_size;
+	size_t alignment;
+	size_t used;
+	size_t reserved;
+	std::vector<std::unique_ptr<char[]>> blocks;
+	std::vector<std::unique_ptr<char[]>> large_blocks;
+};
+
 class StringsCache {
 	static const size_t BLOCK_SIZE = 64 * 1024;
 	static const size_t DEFAULT_ALIGNMENT = alignof(std::max_align_t);
 
 public:
-	StringsCache() {
-		blocks.emplace_back(std::make_unique<char[]>(BLOCK_SIZE));
-		used = 0;
-
+	StringsCache() : arena(BLOCK_SIZE, DEFAULT_ALIGNMENT) {
 		intern("");
 	}
 
 	CachedString intern(std::string_view sv) {
-		if (used + sv.size() > BLOCK_SIZE) {
-			blocks.emplace_back(std::make_unique<char[]>(BLOCK_SIZE));
-			used = 0;
-		}
+		std::lock_guard<std::mutex> lock(mutex);
 
 		auto it = map.find(sv);
 		if (it != map.end()) {
 			return CachedString(it->second);
 		}
 
-		auto* ptr = blocks.back().get() + used;
-		std::memcpy(ptr, sv.data(), sv.size());
-
 		size_t i = index.size();
-		std::string_view stored(ptr, sv.size());
+		std::string_view stored = arena.store(sv);
 
 		map[stored] = i;
 		index.push_back(stored);
 
-		used += sv.size();
-		align_used();
-
 		return CachedString(i);
 	}
 
 	std::string_view resolve(CachedString id) const {
+		std::lock_guard<std::mutex> lock(mutex);
 		if (id.index >= index.size())
 			throw std::runtime_error("id.index >= index.size()");
 		return index.at(id.index);
 	}
 
-	size_t size() const { return index.size(); }
+	size_t size() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return index.size();
+	}
 	bool empty() const { return size() == 0; }
 private:
-	void align_used() {
-		used = (used + DEFAULT_ALIGNMENT - 1) & ~(DEFAULT_ALIGNMENT - 1);
-	}
-
 	std::vector<std::string_view> index;
-	std::unordered_map<std::string_view, size_t, TransparentHash, TransparentEq> map;
+	std::unordered_map<std::string_view, size_t, scache_detail::TransparentHash, scache_detail::TransparentEq> map;
 
-	size_t used;
-	std::vector<std::unique_ptr<char[]>> blocks;
-};
\ No newline at end of file
+	StringArena arena;
+	mutable std::mutex mutex;	// intern() may reallocate index while another thread resolves
+};
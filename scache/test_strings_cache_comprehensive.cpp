@@ -9,6 +9,7 @@
 #include <cassert>
 #include <stdexcept>
 #include <cstring>
+#include <string>
 
 // Test counter for tracking test results
 static int testsPassed = 0;
@@ -479,6 +480,41 @@ void testVeryLongStrings() {
     std::cout << std::endl;
 }
 
+void testStringArena() {
+    std::cout << "\n=== StringArena Tests ===" << std::endl;
+    
+    StringArena arena(1024);
+    
+    std::string_view first = arena.store("hello");
+    std::string_view second = arena.store("world");
+    ASSERT(first == "hello" && second == "world", "Stored strings read back correctly");
+    ASSERT(second.data() == first.data() + first.size(), "Unaligned arena packs strings back to back");
+    ASSERT(arena.bytes_reserved() == 1024, "Small strings share one block");
+    
+    // Views stay valid while later strings open new blocks
+    for (int i = 0; i < 1000; ++i) {
+        arena.store("filler string number " + std::to_string(i));
+    }
+    ASSERT(first == "hello", "View is stable after new blocks are allocated");
+    
+    // Larger than a block: gets a dedicated block instead of overflowing
+    std::string huge(5000, 'H');
+    std::string_view hugeView = arena.store(huge);
+    ASSERT(hugeView == huge, "String larger than a block stored correctly");
+    
+    arena.clear();
+    ASSERT(arena.bytes_reserved() == 0, "clear() releases every block");
+    
+    // Same through the cache, whose blocks are 64KB
+    StringsCache cache;
+    std::string hugeKey(100000, 'K');
+    CachedString cached = cache.intern(hugeKey);
+    ASSERT(cache.resolve(cached) == hugeKey, "String larger than 64KB interned correctly");
+    ASSERT(cache.intern(hugeKey).index == cached.index, "Large duplicate returns same index");
+    
+    std::cout << std::endl;
+}
+
 void runAllComprehensiveTests() {
     std::cout << "========================================" << std::endl;
     std::cout << "  Comprehensive StringsCache Test Suite" << std::endl;
@@ -505,6 +541,7 @@ void runAllComprehensiveTests() {
         testLargeScale();
         testSpecialCharacters();
         testVeryLongStrings();
+        testStringArena();
         
         std::cout << "\n========================================" << std::endl;
         std::cout << "Test Results:" << std::endl;
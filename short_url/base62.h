@@ -0,0 +1,174 @@
+#ifndef BASE62_H
+#define BASE62_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace base62_detail {
+
+// Digit value of every byte, -1 for bytes outside the base62 alphabet
+struct DecodeTable {
+    int8_t values[256];
+    
+    constexpr DecodeTable() : values() {
+        for (int c = 0; c < 256; ++c) {
+            values[c] = -1;
+        }
+        for (int i = 0; i < 10; ++i) {
+            values['0' + i] = static_cast<int8_t>(i);
+        }
+        for (int i = 0; i < 26; ++i) {
+            values['a' + i] = static_cast<int8_t>(10 + i);
+            values['A' + i] = static_cast<int8_t>(36 + i);
+        }
+    }
+};
+
+inline constexpr DecodeTable DECODE_TABLE;
+inline constexpr char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+} // namespace base62_detail
+
+/**
+ * Base62 Codec
+ *
+ * Converts between 64-bit ids and base62 short codes (0-9, a-z, A-Z):
+ * - Encoding writes digits back to front into a stack buffer; dividing by
+ *   the constant 62 compiles to a multiply and shift, and nothing is
+ *   allocated unless a std::string is asked for
+ * - Decoding looks every byte up in a 256-entry table and checks validity
+ *   once per code, so a code costs one load and one multiply-add per byte
+ *   with no per-character branches
+ * - Codes of up to MaxLength digits are accepted; decoding reports codes
+ *   whose value does not fit in 64 bits instead of wrapping around
+ * - Codes may be padded with leading '0's to a fixed width; they decode to
+ *   the same value as the unpadded code
+ */
+class Base62 {
+public:
+    static constexpr int Radix = 62;
+    static constexpr size_t MaxLength = 11;     // Digits in the encoding of UINT64_MAX
+    
+    /**
+     * Encode a value into a caller's buffer
+     * @param value Value to encode
+     * @param out Buffer of at least MaxLength bytes; not null-terminated
+     * @return Number of digits written (no leading zeros, "0" for 0)
+     */
+    static size_t encode(uint64_t value, char* out) {
+        char buffer[MaxLength];
+        char* end = buffer + MaxLength;
+        char* begin = end;
+        do {
+            *--begin = base62_detail::DIGITS[value % Radix];
+            value /= Radix;
+        } while (value != 0);
+        
+        size_t length = static_cast<size_t>(end - begin);
+        for (size_t i = 0; i < length; ++i) {
+            out[i] = begin[i];
+        }
+        return length;
+    }
+    
+    /**
+     * Encode a value, optionally padded to a fixed width
+     * @param value Value to encode
+     * @param width Minimum number of digits; shorter codes are padded with leading '0's (default: 0)
+     * @return Base62 code
+     */
+    static std::string encode(uint64_t value, size_t width = 0) {
+        char buffer[MaxLength];
+        size_t length = encode(value, buffer);
+        
+        std::string code;
+        code.reserve(width > length ? width : length);
+        if (width > length) {
+            code.append(width - length, '0');
+        }
+        code.append(buffer, length);
+        return code;
+    }
+    
+    /**
+     * Decode a code
+     * @param code Base62 code; leading '0's are allowed
+     * @param value Output: decoded value, set only on success
+     * @return false if the code is empty, longer than MaxLength, contains a
+     *         byte outside the alphabet, or does not fit in 64 bits
+     */
+    static bool decode(std::string_view code, uint64_t& value) {
+        if (code.empty() || code.size() > MaxLength) {
+            return false;
+        }
+        
+        // Ten digits can't overflow (62^10 < 2^64); only the eleventh needs checking
+        size_t safe = code.size() < MaxLength ? code.size() : MaxLength - 1;
+        uint64_t result = 0;
+        int invalid = 0;
+        for (size_t i = 0; i < safe; ++i) {
+            int digit = base62_detail::DECODE_TABLE.values[static_cast<unsigned char>(code[i])];
+            invalid |= digit;
+            result = result * Radix + static_cast<uint64_t>(digit);
+        }
+        
+        if (safe < code.size()) {
+            int digit = base62_detail::DECODE_TABLE.values[static_cast<unsigned char>(code[safe])];
+            invalid |= digit;
+            if (invalid >= 0 && result > (UINT64_MAX - static_cast<uint64_t>(digit)) / Radix) {
+                return false;
+            }
+            result = result * Radix + static_cast<uint64_t>(digit);
+        }
+        
+        if (invalid < 0) {
+            return false;
+        }
+        value = result;
+        return true;
+    }
+    
+    /**
+     * Check whether a code decodes
+     * @param code Base62 code
+     * @return true if decode() would succeed
+     */
+    static bool isValid(std::string_view code) {
+        uint64_t value;
+        return decode(code, value);
+    }
+    
+    /**
+     * Validate many codes at once, e.g. the short codes of a bulk import
+     *
+     * Every byte of every code is looked up, with no early exit, so the
+     * loop runs without data-dependent branches until the final overflow
+     * check of full-length codes.
+     * @param codes Codes to check
+     * @param count Number of codes
+     * @param valid Output: count flags, 1 if the code is valid and 0 otherwise
+     * @return Number of valid codes
+     */
+    static size_t validateBatch(const std::string_view* codes, size_t count, uint8_t* valid) {
+        size_t numValid = 0;
+        for (size_t i = 0; i < count; ++i) {
+            std::string_view code = codes[i];
+            size_t length = code.size() < MaxLength ? code.size() : MaxLength;
+            
+            int invalid = (code.empty() || code.size() > MaxLength) ? -1 : 0;
+            for (size_t j = 0; j < length; ++j) {
+                invalid |= base62_detail::DECODE_TABLE.values[static_cast<unsigned char>(code[j])];
+            }
+            
+            // Only full-length codes can overflow
+            bool ok = invalid >= 0 && (length < MaxLength || isValid(code));
+            valid[i] = ok ? 1 : 0;
+            numValid += ok ? 1 : 0;
+        }
+        return numValid;
+    }
+};
+
+#endif // BASE62_H
@@ -0,0 +1,276 @@
+#include "click_analytics.h"
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+// Source of ClickAnalytics instance ids; never reused, so a thread's cached
+// buffer can't be mistaken for one of a destroyed instance
+std::atomic<uint64_t> nextInstanceId(1);
+
+// Buffer the calling thread registered with the instance it last recorded into
+struct CachedBuffer {
+    uint64_t instanceId = 0;
+    void* buffer = nullptr;
+};
+
+thread_local CachedBuffer cachedBuffer;
+
+// splitmix64 finalizer; visitor ids (e.g. addresses) are rarely well mixed
+uint64_t mixVisitor(uint64_t visitor) {
+    visitor ^= visitor >> 30;
+    visitor *= 0xbf58476d1ce4e5b9ULL;
+    visitor ^= visitor >> 27;
+    visitor *= 0x94d049bb133111ebULL;
+    visitor ^= visitor >> 31;
+    return visitor;
+}
+
+size_t roundUpToPowerOfTwo(size_t n) {
+    size_t power = 1;
+    while (power < n) {
+        power <<= 1;
+    }
+    return power;
+}
+
+} // namespace
+
+ClickAnalytics::ClickAnalytics(size_t retainedMinutes, std::chrono::milliseconds flushInterval,
+                               size_t bufferCapacity)
+    : instanceId_(nextInstanceId.fetch_add(1))
+    , retainedMinutes_(retainedMinutes)
+    , flushInterval_(flushInterval)
+    , bufferMask_(roundUpToPowerOfTwo(bufferCapacity) - 1)
+    , minute_(currentMinute())
+    , stopping_(false)
+{
+    if (retainedMinutes == 0) {
+        throw std::invalid_argument("Retained minutes must be positive");
+    }
+    if (bufferCapacity == 0) {
+        throw std::invalid_argument("Buffer capacity must be positive");
+    }
+    aggregator_ = std::thread(&ClickAnalytics::run, this);
+}
+
+ClickAnalytics::~ClickAnalytics() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        stopping_ = true;
+    }
+    stopCondition_.notify_one();
+    aggregator_.join();
+}
+
+void ClickAnalytics::record(uint64_t link, uint64_t visitor) {
+    Buffer* buffer = threadBuffer();
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    if (head - buffer->tail.load(std::memory_order_acquire) > bufferMask_) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    buffer->clicks[head & bufferMask_] = Click{link, visitor, minute_.load(std::memory_order_relaxed)};
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void ClickAnalytics::flush() {
+    drain();
+}
+
+ClickAnalytics::ClickStats ClickAnalytics::linkStats(uint64_t link) const {
+    std::shared_lock<std::shared_mutex> lock(statsMutex_);
+    auto it = links_.find(link);
+    if (it == links_.end()) {
+        return ClickStats{0, 0};
+    }
+    return ClickStats{it->second.clicks, it->second.visitors.estimate()};
+}
+
+std::vector<ClickAnalytics::MinuteStats> ClickAnalytics::linkMinutes(uint64_t link) const {
+    std::vector<MinuteStats> result;
+    std::shared_lock<std::shared_mutex> lock(statsMutex_);
+    auto it = links_.find(link);
+    if (it != links_.end()) {
+        for (const Bucket& bucket : it->second.minutes) {
+            result.push_back(MinuteStats{bucket.minute, bucket.clicks, bucket.visitors.estimate()});
+        }
+    }
+    return result;
+}
+
+std::vector<ClickAnalytics::MinuteStats> ClickAnalytics::minutes() const {
+    std::vector<MinuteStats> result;
+    std::shared_lock<std::shared_mutex> lock(statsMutex_);
+    for (const Bucket& bucket : totals_) {
+        result.push_back(MinuteStats{bucket.minute, bucket.clicks, bucket.visitors.estimate()});
+    }
+    return result;
+}
+
+std::vector<std::pair<uint64_t, ClickAnalytics::ClickStats>> ClickAnalytics::topLinks(size_t count) const {
+    std::vector<std::pair<uint64_t, const LinkState*>> ranked;
+    std::shared_lock<std::shared_mutex> lock(statsMutex_);
+    ranked.reserve(links_.size());
+    for (const auto& entry : links_) {
+        ranked.emplace_back(entry.first, &entry.second);
+    }
+    
+    // Ties in link order, so equal counts rank the same way on every call
+    auto moreClicks = [](const std::pair<uint64_t, const LinkState*>& a,
+                         const std::pair<uint64_t, const LinkState*>& b) {
+        return a.second->clicks != b.second->clicks ? a.second->clicks > b.second->clicks : a.first < b.first;
+    };
+    count = std::min(count, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), moreClicks);
+    
+    std::vector<std::pair<uint64_t, ClickStats>> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        result.emplace_back(ranked[i].first, ClickStats{ranked[i].second->clicks, ranked[i].second->visitors.estimate()});
+    }
+    return result;
+}
+
+void ClickAnalytics::remove(const uint64_t* links, size_t count) {
+    // Buffered clicks would bring the links back at the next pass
+    drain();
+    
+    std::unique_lock<std::shared_mutex> lock(statsMutex_);
+    for (size_t i = 0; i < count; ++i) {
+        links_.erase(links[i]);
+    }
+}
+
+uint64_t ClickAnalytics::droppedClicks() const {
+    uint64_t dropped = 0;
+    std::lock_guard<std::mutex> lock(buffersMutex_);
+    for (const auto& buffer : buffers_) {
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+void ClickAnalytics::clear() {
+    std::lock_guard<std::mutex> drainLock(drainMutex_);
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex_);
+        for (auto& buffer : buffers_) {
+            buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(statsMutex_);
+    links_.clear();
+    totals_.clear();
+}
+
+int64_t ClickAnalytics::currentMinute() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::minutes>(now).count();
+}
+
+ClickAnalytics::Buffer* ClickAnalytics::threadBuffer() {
+    if (cachedBuffer.instanceId == instanceId_) {
+        return static_cast<Buffer*>(cachedBuffer.buffer);
+    }
+    
+    // Found again by a thread alternating between instances, or taken over
+    // by a new thread given an exited thread's id
+    std::thread::id self = std::this_thread::get_id();
+    Buffer* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex_);
+        for (const auto& existing : buffers_) {
+            if (existing->owner == self) {
+                buffer = existing.get();
+                break;
+            }
+        }
+        if (!buffer) {
+            buffers_.emplace_back(new Buffer());
+            buffer = buffers_.back().get();
+            buffer->owner = self;
+            buffer->clicks.reset(new Click[bufferMask_ + 1]);
+        }
+    }
+    
+    cachedBuffer.instanceId = instanceId_;
+    cachedBuffer.buffer = buffer;
+    return buffer;
+}
+
+void ClickAnalytics::drain() {
+    std::lock_guard<std::mutex> drainLock(drainMutex_);
+    minute_.store(currentMinute(), std::memory_order_relaxed);
+    
+    // Copy the clicks out first, so the rings free up before folding starts
+    drained_.clear();
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex_);
+        for (auto& buffer : buffers_) {
+            uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+            for (; tail != head; ++tail) {
+                drained_.push_back(buffer->clicks[tail & bufferMask_]);
+            }
+            buffer->tail.store(tail, std::memory_order_release);
+        }
+    }
+    if (drained_.empty()) {
+        return;
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(statsMutex_);
+    for (const Click& click : drained_) {
+        uint64_t visitorHash = click.visitor == 0 ? 0 : mixVisitor(click.visitor);
+        LinkState& link = links_[click.link];
+        link.clicks++;
+        if (visitorHash != 0) {
+            link.visitors.add(visitorHash);
+        }
+        addToMinutes(link.minutes, click, visitorHash);
+        addToMinutes(totals_, click, visitorHash);
+    }
+}
+
+void ClickAnalytics::addToMinutes(std::deque<Bucket>& buckets, const Click& click, uint64_t visitorHash) {
+    // Retention counts minutes, not buckets: a quiet minute leaves no bucket
+    if (!buckets.empty() && click.minute <= buckets.back().minute - static_cast<int64_t>(retainedMinutes_)) {
+        return;
+    }
+    
+    // Clicks arrive nearly in minute order; search from the newest bucket
+    auto it = buckets.end();
+    while (it != buckets.begin() && std::prev(it)->minute > click.minute) {
+        --it;
+    }
+    if (it == buckets.begin() || std::prev(it)->minute != click.minute) {
+        it = buckets.insert(it, Bucket{click.minute, 0, HyperLogLog()});
+    } else {
+        --it;
+    }
+    
+    it->clicks++;
+    if (visitorHash != 0) {
+        it->visitors.add(visitorHash);
+    }
+    
+    int64_t oldest = buckets.back().minute - static_cast<int64_t>(retainedMinutes_) + 1;
+    while (buckets.front().minute < oldest) {
+        buckets.pop_front();
+    }
+}
+
+void ClickAnalytics::run() {
+    std::unique_lock<std::mutex> lock(stopMutex_);
+    while (!stopping_) {
+        stopCondition_.wait_for(lock, flushInterval_);
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
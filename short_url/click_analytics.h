@@ -0,0 +1,219 @@
+#ifndef CLICK_ANALYTICS_H
+#define CLICK_ANALYTICS_H
+
+#include "hyperloglog.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Click Analytics
+ *
+ * Click counting that stays off the redirect path's critical section:
+ * - record() appends to a ring buffer owned by the calling thread: no lock,
+ *   no allocation, no shared counter. A full buffer drops the click and
+ *   counts it (droppedClicks()) rather than make the redirect wait
+ * - A background aggregator drains every buffer each flush interval and
+ *   folds the clicks into per-link totals and per-minute rollups, per link
+ *   and over all links. Unique visitors are HyperLogLog estimates
+ * - Queries read the aggregates under a shared lock that only the
+ *   aggregator takes exclusively, so they never touch the buffers
+ *
+ * Links are identified by a 64-bit key chosen by the caller (UrlShortener
+ * derives one from the short code). Each thread that records gets its own
+ * buffer, kept until destruction. Minutes are wall-clock minutes since the
+ * Unix epoch, read from a clock the aggregator refreshes, so a click is
+ * stamped to within a flush interval.
+ */
+class ClickAnalytics {
+public:
+    /**
+     * Click count and unique visitor estimate
+     */
+    struct ClickStats {
+        uint64_t clicks;            // Clicks recorded
+        uint64_t uniqueVisitors;    // Estimated distinct non-zero visitor ids
+    };
+    
+    /**
+     * Clicks of one minute
+     */
+    struct MinuteStats {
+        int64_t minute;             // Minutes since the Unix epoch
+        uint64_t clicks;
+        uint64_t uniqueVisitors;
+    };
+    
+    /**
+     * Constructor; starts the aggregator thread
+     * @param retainedMinutes Minute rollups kept per link and overall (default: 60)
+     * @param flushInterval Time between aggregator passes (default: 100ms)
+     * @param bufferCapacity Clicks each thread's buffer holds, rounded up to a power of two (default: 8192)
+     * @throws std::invalid_argument if retainedMinutes or bufferCapacity is 0
+     */
+    explicit ClickAnalytics(size_t retainedMinutes = 60,
+                            std::chrono::milliseconds flushInterval = std::chrono::milliseconds(100),
+                            size_t bufferCapacity = 8192);
+    
+    /**
+     * Destructor; stops the aggregator. No thread may record meanwhile.
+     */
+    ~ClickAnalytics();
+    
+    // Non-copyable
+    ClickAnalytics(const ClickAnalytics&) = delete;
+    ClickAnalytics& operator=(const ClickAnalytics&) = delete;
+    
+    /**
+     * Record a click
+     * @param link Link key
+     * @param visitor Visitor id (e.g. a hash of the client address); 0 if
+     *        unknown, which counts the click but not a visitor
+     */
+    void record(uint64_t link, uint64_t visitor);
+    
+    /**
+     * Fold every click recorded so far into the aggregates now, instead of
+     * at the aggregator's next pass
+     */
+    void flush();
+    
+    /**
+     * Get the totals of a link
+     * @param link Link key
+     * @return Clicks and unique visitors since the link's first click, zeros if none
+     */
+    ClickStats linkStats(uint64_t link) const;
+    
+    /**
+     * Get the retained minute rollups of a link
+     * @param link Link key
+     * @return Minutes with clicks, oldest first
+     */
+    std::vector<MinuteStats> linkMinutes(uint64_t link) const;
+    
+    /**
+     * Get the retained minute rollups over all links
+     * @return Minutes with clicks, oldest first
+     */
+    std::vector<MinuteStats> minutes() const;
+    
+    /**
+     * Get the most clicked links
+     * @param count Maximum number of links
+     * @return Link keys and totals, most clicks first
+     */
+    std::vector<std::pair<uint64_t, ClickStats>> topLinks(size_t count) const;
+    
+    /**
+     * Forget the totals and minute rollups of links, e.g. once they are
+     * deleted and their keys may be reused. Their clicks still count in
+     * minutes().
+     * @param links Link keys
+     * @param count Number of links
+     */
+    void remove(const uint64_t* links, size_t count);
+    
+    /**
+     * Get the clicks dropped because a thread's buffer was full
+     * @return Dropped clicks since construction
+     */
+    uint64_t droppedClicks() const;
+    
+    /**
+     * Discard every click, aggregated or still buffered. Not safe while
+     * other threads record.
+     */
+    void clear();
+    
+    /**
+     * Get the current minute
+     * @return Minutes since the Unix epoch
+     */
+    static int64_t currentMinute();
+
+private:
+    struct Click {
+        uint64_t link;
+        uint64_t visitor;
+        int64_t minute;
+    };
+    
+    // Single-producer (the owning thread), single-consumer (the drainer) ring
+    struct Buffer {
+        std::thread::id owner;
+        std::unique_ptr<Click[]> clicks;
+        alignas(64) std::atomic<uint64_t> head{0};      // Next slot to write, advanced by the owner
+        alignas(64) std::atomic<uint64_t> tail{0};      // Next slot to read, advanced by the drainer
+        std::atomic<uint64_t> dropped{0};               // Clicks refused while full
+    };
+    
+    struct Bucket {
+        int64_t minute;
+        uint64_t clicks;
+        HyperLogLog visitors;
+    };
+    
+    struct LinkState {
+        uint64_t clicks = 0;
+        HyperLogLog visitors;
+        std::deque<Bucket> minutes;                     // Retained minutes, oldest first
+    };
+    
+    const uint64_t instanceId_;                         // Unique per instance, for threads' cached buffers
+    const size_t retainedMinutes_;
+    const std::chrono::milliseconds flushInterval_;
+    const size_t bufferMask_;                           // Buffer capacity - 1
+    std::atomic<int64_t> minute_;                       // Clock read by record(), refreshed per pass
+    
+    mutable std::mutex buffersMutex_;                   // Guards buffers_ (registration, not the rings)
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+    std::mutex drainMutex_;                             // One drainer at a time
+    std::vector<Click> drained_;                        // Clicks of the current pass, reused
+    
+    mutable std::shared_mutex statsMutex_;              // Aggregates below; exclusive for folding
+    std::unordered_map<uint64_t, LinkState> links_;
+    std::deque<Bucket> totals_;                         // Minute rollups over all links
+    
+    std::mutex stopMutex_;
+    std::condition_variable stopCondition_;
+    bool stopping_;
+    std::thread aggregator_;
+    
+    /**
+     * Get the calling thread's buffer, registering one on first use
+     * @return The thread's buffer
+     */
+    Buffer* threadBuffer();
+    
+    /**
+     * Drain every buffer and fold the clicks into the aggregates
+     */
+    void drain();
+    
+    /**
+     * Add a click to a minute series, creating its bucket and dropping
+     * buckets past retention
+     * @param buckets Series, oldest first
+     * @param click Click to add
+     * @param visitorHash Mixed visitor id, 0 if unknown
+     */
+    void addToMinutes(std::deque<Bucket>& buckets, const Click& click, uint64_t visitorHash);
+    
+    /**
+     * Aggregator thread body
+     */
+    void run();
+};
+
+#endif // CLICK_ANALYTICS_H
@@ -0,0 +1,367 @@
+#ifndef CONCURRENT_MAP_H
+#define CONCURRENT_MAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * Concurrent Read-Optimized Hash Map
+ *
+ * Map for data that is written once and looked up many times (short code
+ * -> URL):
+ * - find() is lock-free: it follows atomically published bucket chains and
+ *   never blocks, even while the table is being resized
+ * - Inserts lock one of NumStripes stripe mutexes, so writers to different
+ *   stripes proceed in parallel
+ * - Growing the table takes an exclusive lock that only writers wait on.
+ *   The old bucket array may still be in use by readers, so it is kept
+ *   until clear() or destruction (at most as many links again as entries)
+ *
+ * Entries are never overwritten. erase() unlinks an entry but doesn't
+ * free it: readers may still be using it, so the caller gets its memory
+ * back (Erased) and decides when that's safe. Otherwise the value pointers
+ * handed out by find() and insertOrGet() stay valid until clear(). clear()
+ * must not run concurrently with any other call.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ConcurrentMap {
+    struct Node;
+    struct Link;
+
+public:
+    /**
+     * Memory of an erased entry, freed on destruction
+     */
+    class Erased {
+    public:
+        Erased() = default;
+        Erased(Erased&& other) noexcept
+            : node_(other.node_)
+            , links_(std::move(other.links_))
+        {
+            other.node_ = nullptr;
+        }
+        Erased& operator=(Erased&& other) noexcept {
+            std::swap(node_, other.node_);
+            std::swap(links_, other.links_);
+            return *this;
+        }
+        ~Erased() {
+            delete node_;
+            for (Link* link : links_) {
+                delete link;
+            }
+        }
+        
+        /**
+         * Check whether an entry was erased
+         * @return true unless the key was absent
+         */
+        explicit operator bool() const { return node_ != nullptr; }
+    
+    private:
+        friend class ConcurrentMap;
+        const Node* node_ = nullptr;
+        std::vector<Link*> links_;      // Unlinked chain links, the entry's and those copied
+    };
+    
+    /**
+     * Constructor
+     * @param initialBuckets Initial number of buckets, rounded up to a power of two (default: 64)
+     */
+    explicit ConcurrentMap(size_t initialBuckets = 64)
+        : initialBuckets_(roundUpToPowerOfTwo(std::max(initialBuckets, NumStripes)))
+        , size_(0)
+    {
+        reset();
+    }
+    
+    ~ConcurrentMap() {
+        destroyNodes();
+    }
+    
+    // Non-copyable
+    ConcurrentMap(const ConcurrentMap&) = delete;
+    ConcurrentMap& operator=(const ConcurrentMap&) = delete;
+    
+    /**
+     * Look up a key without locking
+     * @param key Key to look up
+     * @return Pointer to the value, or nullptr if the key is absent
+     */
+    const Value* find(const Key& key) const {
+        size_t hash = Hash()(key);
+        const Table* table = table_.load(std::memory_order_acquire);
+        
+        for (const Link* link = table->buckets[hash & table->mask].load(std::memory_order_acquire);
+             link; link = link->next) {
+            if (link->node->hash == hash && link->node->key == key) {
+                return &link->node->value;
+            }
+        }
+        return nullptr;
+    }
+    
+    /**
+     * Insert a key if it is absent
+     *
+     * makeValue is called at most once, only when the key is absent, while
+     * the key's stripe is locked: no other insert of the same key can run
+     * until the entry is published.
+     * @param key Key to insert
+     * @param makeValue Callable returning the value to store
+     * @return Pointer to the stored value, and whether this call inserted it
+     */
+    template <typename MakeValue>
+    std::pair<const Value*, bool> insertOrGet(const Key& key, MakeValue makeValue) {
+        return emplaceOrGet(key, [&key, &makeValue]() { return std::make_pair(key, makeValue()); });
+    }
+    
+    /**
+     * Insert a key if it is absent, letting the caller choose the stored key
+     *
+     * Like insertOrGet(), but makeEntry returns the (key, value) pair to
+     * store. The stored key must compare equal to key; this lets non-owning
+     * keys (e.g. string_view) be looked up with a caller's temporary and
+     * stored as a view of longer-lived memory.
+     * @param key Key to look up
+     * @param makeEntry Callable returning std::pair<Key, Value>
+     * @return Pointer to the stored value, and whether this call inserted it
+     */
+    template <typename MakeEntry>
+    std::pair<const Value*, bool> emplaceOrGet(const Key& key, MakeEntry makeEntry) {
+        size_t hash = Hash()(key);
+        size_t count;
+        Table* table;
+        const Value* value;
+        {
+            std::shared_lock<std::shared_mutex> resizeLock(resizeMutex_);
+            std::lock_guard<std::mutex> lock(stripes_[hash & (NumStripes - 1)]);
+            
+            table = table_.load(std::memory_order_relaxed);
+            std::atomic<Link*>& head = table->buckets[hash & table->mask];
+            for (Link* link = head.load(std::memory_order_relaxed); link; link = link->next) {
+                if (link->node->hash == hash && link->node->key == key) {
+                    return {&link->node->value, false};
+                }
+            }
+            
+            std::pair<Key, Value> entry = makeEntry();
+            Node* node = new Node{std::move(entry.first), std::move(entry.second), hash};
+            head.store(new Link{node, head.load(std::memory_order_relaxed)}, std::memory_order_release);
+            value = &node->value;
+            count = size_.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+        
+        // Keep the load factor at or below 1
+        if (count > table->mask + 1) {
+            grow();
+        }
+        return {value, true};
+    }
+    
+    /**
+     * Insert a key-value pair if the key is absent
+     * @param key Key to insert
+     * @param value Value to store
+     * @return true if inserted, false if the key was already present
+     */
+    bool insert(const Key& key, const Value& value) {
+        return insertOrGet(key, [&value]() { return value; }).second;
+    }
+    
+    /**
+     * Unlink a key's entry without freeing it
+     *
+     * Readers walk chains without locking, so links are never modified:
+     * the links ahead of the entry are copied onto the rest of its chain
+     * and the copy is published in one store. The entry and the replaced
+     * links are handed back, still readable by lookups already under way.
+     * @param key Key to erase
+     * @return Memory of the entry, to destroy once no reader can hold it;
+     *         empty if the key was absent
+     */
+    Erased erase(const Key& key) {
+        size_t hash = Hash()(key);
+        Erased erased;
+        std::shared_lock<std::shared_mutex> resizeLock(resizeMutex_);
+        std::lock_guard<std::mutex> lock(stripes_[hash & (NumStripes - 1)]);
+        
+        Table* table = table_.load(std::memory_order_relaxed);
+        std::atomic<Link*>& head = table->buckets[hash & table->mask];
+        Link* target = head.load(std::memory_order_relaxed);
+        while (target && !(target->node->hash == hash && target->node->key == key)) {
+            target = target->next;
+        }
+        if (!target) {
+            return erased;
+        }
+        
+        Link* rest = target->next;
+        for (Link* link = head.load(std::memory_order_relaxed); link != target; link = link->next) {
+            rest = new Link{link->node, rest};
+            erased.links_.push_back(link);
+        }
+        erased.links_.push_back(target);
+        erased.node_ = target->node;
+        head.store(rest, std::memory_order_release);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return erased;
+    }
+    
+    /**
+     * Grow the table ahead of a bulk insert so it isn't rehashed along the way
+     * @param count Number of entries expected
+     */
+    void reserve(size_t count) {
+        std::unique_lock<std::shared_mutex> resizeLock(resizeMutex_);
+        size_t numBuckets = roundUpToPowerOfTwo(count);
+        if (numBuckets > table_.load(std::memory_order_relaxed)->mask + 1) {
+            rehash(numBuckets);
+        }
+    }
+    
+    /**
+     * Get the number of entries
+     * @return Number of entries
+     */
+    size_t size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * Call fn(key, value) for every entry. Inserts made while iterating may
+     * or may not be visited.
+     * @param fn Callable taking (const Key&, const Value&)
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        const Table* table = table_.load(std::memory_order_acquire);
+        for (size_t i = 0; i <= table->mask; ++i) {
+            for (const Link* link = table->buckets[i].load(std::memory_order_acquire); link; link = link->next) {
+                fn(link->node->key, link->node->value);
+            }
+        }
+    }
+    
+    /**
+     * Remove every entry. Not safe while other threads use the map.
+     */
+    void clear() {
+        std::unique_lock<std::shared_mutex> resizeLock(resizeMutex_);
+        destroyNodes();
+        reset();
+    }
+
+private:
+    struct Node {
+        Key key;
+        Value value;
+        size_t hash;
+    };
+    
+    // Chains link to nodes rather than embed them, so a resize relinks
+    // entries without copying keys or values
+    struct Link {
+        const Node* node;
+        Link* next;
+    };
+    
+    struct Table {
+        size_t mask;                                    // Number of buckets - 1
+        std::unique_ptr<std::atomic<Link*>[]> buckets;  // Chain heads
+        
+        explicit Table(size_t numBuckets)
+            : mask(numBuckets - 1)
+            , buckets(new std::atomic<Link*>[numBuckets])
+        {
+            for (size_t i = 0; i < numBuckets; ++i) {
+                buckets[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+        
+        ~Table() {
+            for (size_t i = 0; i <= mask; ++i) {
+                Link* link = buckets[i].load(std::memory_order_relaxed);
+                while (link) {
+                    Link* next = link->next;
+                    delete link;
+                    link = next;
+                }
+            }
+        }
+    };
+    
+    // Tables never have fewer buckets than stripes, so a bucket keeps its stripe across resizes
+    static constexpr size_t NumStripes = 64;
+    
+    size_t initialBuckets_;                         // Bucket count after construction or clear()
+    std::atomic<Table*> table_;                     // Table used by readers and writers
+    std::vector<std::unique_ptr<Table>> tables_;    // Current table and the ones it replaced
+    std::atomic<size_t> size_;                      // Number of entries
+    std::shared_mutex resizeMutex_;                 // Shared by inserts, exclusive for growing
+    std::mutex stripes_[NumStripes];                // Serialize inserts per stripe
+    
+    void grow() {
+        std::unique_lock<std::shared_mutex> resizeLock(resizeMutex_);
+        
+        size_t numBuckets = table_.load(std::memory_order_relaxed)->mask + 1;
+        if (size_.load(std::memory_order_relaxed) <= numBuckets) {
+            return;  // Another writer already grew it
+        }
+        rehash(numBuckets * 2);
+    }
+    
+    // Caller holds resizeMutex_ exclusively
+    void rehash(size_t numBuckets) {
+        Table* old = table_.load(std::memory_order_relaxed);
+        std::unique_ptr<Table> table(new Table(numBuckets));
+        for (size_t i = 0; i <= old->mask; ++i) {
+            for (Link* link = old->buckets[i].load(std::memory_order_relaxed); link; link = link->next) {
+                std::atomic<Link*>& head = table->buckets[link->node->hash & table->mask];
+                head.store(new Link{link->node, head.load(std::memory_order_relaxed)}, std::memory_order_relaxed);
+            }
+        }
+        
+        // Readers still walking the old table finish there safely
+        table_.store(table.get(), std::memory_order_release);
+        tables_.push_back(std::move(table));
+    }
+    
+    void reset() {
+        tables_.clear();
+        tables_.emplace_back(new Table(initialBuckets_));
+        table_.store(tables_.back().get(), std::memory_order_release);
+        size_.store(0, std::memory_order_relaxed);
+    }
+    
+    void destroyNodes() {
+        // Every node is linked exactly once from the current table
+        const Table* table = table_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i <= table->mask; ++i) {
+            for (const Link* link = table->buckets[i].load(std::memory_order_relaxed); link; link = link->next) {
+                delete link->node;
+            }
+        }
+    }
+    
+    static size_t roundUpToPowerOfTwo(size_t n) {
+        size_t power = 1;
+        while (power < n) {
+            power <<= 1;
+        }
+        return power;
+    }
+};
+
+template <typename Key, typename Value, typename Hash>
+constexpr size_t ConcurrentMap<Key, Value, Hash>::NumStripes;
+
+#endif // CONCURRENT_MAP_H
@@ -0,0 +1,226 @@
+#include "csv_stream.h"
+#include <cstring>
+
+CsvReader::CsvReader(const std::string& filename, size_t bufferSize)
+    : file_(filename, std::ios::binary)
+    , buffer_(new char[bufferSize > 0 ? bufferSize : 1])
+    , capacity_(bufferSize > 0 ? bufferSize : 1)
+    , begin_(0)
+    , end_(0)
+    , eof_(!file_.is_open())
+{
+}
+
+bool CsvReader::isOpen() const {
+    return file_.is_open();
+}
+
+size_t CsvReader::next(std::string_view* fields, size_t maxFields) {
+    if (maxFields == 0) {
+        return 0;
+    }
+    
+    size_t recordEnd;
+    while (!findRecordEnd(maxFields, recordEnd)) {
+        refill();
+    }
+    if (begin_ == end_) {
+        return 0;
+    }
+    
+    char* data = buffer_.get();
+    size_t end = recordEnd;
+    if (end > begin_ && data[end - 1] == '\r') {
+        end--;
+    }
+    
+    size_t numFields = 0;
+    size_t i = begin_;
+    while (true) {
+        bool last = numFields + 1 == maxFields;
+        size_t start = i;
+        size_t fieldEnd;
+        
+        if (i < end && data[i] == '"') {
+            // Unquote in place; the write position never passes the read position
+            size_t out = i++;
+            start = out;
+            while (i < end) {
+                if (data[i] == '"') {
+                    if (i + 1 < end && data[i + 1] == '"') {
+                        data[out++] = '"';
+                        i += 2;
+                        continue;
+                    }
+                    i++;
+                    break;
+                }
+                data[out++] = data[i++];
+            }
+            fieldEnd = out;
+            
+            // Drop anything between the closing quote and the next separator
+            while (i < end && (last || data[i] != ',')) {
+                i++;
+            }
+        } else {
+            if (last) {
+                i = end;
+            } else {
+                const void* comma = std::memchr(data + i, ',', end - i);
+                i = comma ? static_cast<size_t>(static_cast<const char*>(comma) - data) : end;
+            }
+            fieldEnd = i;
+        }
+        
+        fields[numFields++] = std::string_view(data + start, fieldEnd - start);
+        if (i >= end) {
+            break;
+        }
+        i++;  // Skip the comma
+    }
+    
+    begin_ = recordEnd < end_ ? recordEnd + 1 : end_;
+    return numFields;
+}
+
+bool CsvReader::findRecordEnd(size_t maxFields, size_t& recordEnd) const {
+    const char* data = buffer_.get();
+    size_t field = 0;
+    size_t i = begin_;
+    
+    while (true) {
+        if (i < end_ && data[i] == '"') {
+            // A quoted field runs to its closing quote, line breaks included
+            i++;
+            while (true) {
+                if (i >= end_) {
+                    if (!eof_) {
+                        return false;
+                    }
+                    recordEnd = end_;  // Unterminated quote: the rest of the file
+                    return true;
+                }
+                if (data[i] == '"') {
+                    if (i + 1 >= end_ && !eof_) {
+                        return false;  // Can't tell a closing quote from a doubled one yet
+                    }
+                    if (i + 1 < end_ && data[i + 1] == '"') {
+                        i += 2;
+                        continue;
+                    }
+                    i++;
+                    break;
+                }
+                i++;
+            }
+        }
+        
+        // Unquoted text runs to the next comma, or to the line break for the last field
+        bool last = field + 1 >= maxFields;
+        if (last) {
+            const void* newline = std::memchr(data + i, '\n', end_ - i);
+            i = newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) : end_;
+        } else {
+            while (i < end_ && data[i] != '\n' && data[i] != ',') {
+                i++;
+            }
+        }
+        
+        if (i >= end_) {
+            if (!eof_) {
+                return false;
+            }
+            recordEnd = end_;
+            return true;
+        }
+        if (data[i] == '\n') {
+            recordEnd = i;
+            return true;
+        }
+        i++;
+        field++;
+    }
+}
+
+void CsvReader::refill() {
+    if (begin_ > 0) {
+        std::memmove(buffer_.get(), buffer_.get() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+    } else if (end_ == capacity_) {
+        // One record fills the whole buffer
+        std::unique_ptr<char[]> grown(new char[capacity_ * 2]);
+        std::memcpy(grown.get(), buffer_.get(), end_);
+        buffer_ = std::move(grown);
+        capacity_ *= 2;
+    }
+    
+    file_.read(buffer_.get() + end_, static_cast<std::streamsize>(capacity_ - end_));
+    end_ += static_cast<size_t>(file_.gcount());
+    if (!file_) {
+        eof_ = true;
+    }
+}
+
+CsvWriter::CsvWriter(const std::string& filename, size_t bufferSize)
+    : file_(filename, std::ios::binary | std::ios::trunc)
+    , bufferSize_(bufferSize)
+{
+    buffer_.reserve(bufferSize_ + 1024);
+}
+
+bool CsvWriter::isOpen() const {
+    return file_.is_open();
+}
+
+void CsvWriter::write(std::string_view first, std::string_view second) {
+    appendField(first);
+    buffer_ += ',';
+    appendField(second);
+    buffer_ += '\n';
+    
+    if (buffer_.size() >= bufferSize_) {
+        flush();
+    }
+}
+
+void CsvWriter::write(std::string_view first, std::string_view second, std::string_view third) {
+    appendField(first);
+    buffer_ += ',';
+    appendField(second);
+    buffer_ += ',';
+    appendField(third);
+    buffer_ += '\n';
+    
+    if (buffer_.size() >= bufferSize_) {
+        flush();
+    }
+}
+
+bool CsvWriter::finish() {
+    flush();
+    file_.close();
+    return file_.good();
+}
+
+void CsvWriter::appendField(std::string_view field) {
+    if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+        buffer_.append(field.data(), field.size());
+        return;
+    }
+    
+    buffer_ += '"';
+    for (char c : field) {
+        if (c == '"') {
+            buffer_ += '"';
+        }
+        buffer_ += c;
+    }
+    buffer_ += '"';
+}
+
+void CsvWriter::flush() {
+    file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+}
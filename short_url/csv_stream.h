@@ -0,0 +1,123 @@
+#ifndef CSV_STREAM_H
+#define CSV_STREAM_H
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * Streaming CSV Reader
+ *
+ * Reads a CSV file through one large buffer and splits records in place:
+ * - Fields are string_views into the buffer, valid until the next call, so
+ *   reading a record allocates nothing
+ * - Quoted fields may contain commas, line breaks and doubled quotes ("");
+ *   quotes are removed and "" collapsed to " inside the buffer
+ * - A record that doesn't fit grows the buffer; memory stays bounded by the
+ *   longest record, not the file size
+ * - Lines may end in \n or \r\n
+ *
+ * The last field a caller asks for takes the rest of the record when it
+ * isn't quoted, commas included, so files that wrote URLs with commas
+ * unquoted still read back whole.
+ */
+class CsvReader {
+public:
+    /**
+     * Constructor
+     * @param filename File to read
+     * @param bufferSize Initial buffer size (default: 1MB)
+     */
+    explicit CsvReader(const std::string& filename, size_t bufferSize = 1024 * 1024);
+    
+    /**
+     * Check whether the file could be opened
+     * @return true if open
+     */
+    bool isOpen() const;
+    
+    /**
+     * Read the next record
+     * @param fields Output: the record's fields
+     * @param maxFields Size of fields; the last one takes the rest of the record
+     * @return Number of fields read (a blank line has one empty field), 0 at end of file
+     */
+    size_t next(std::string_view* fields, size_t maxFields);
+
+private:
+    std::ifstream file_;
+    std::unique_ptr<char[]> buffer_;
+    size_t capacity_;           // Size of buffer_
+    size_t begin_;              // Start of unread data
+    size_t end_;                // End of data read from the file
+    bool eof_;                  // Whether the file has been read to the end
+    
+    /**
+     * Find the end of the record starting at begin_
+     * @param maxFields Number of fields the caller splits into
+     * @param recordEnd Output: offset of the line break, or end_ at end of file
+     * @return false if the record continues past the data in the buffer
+     */
+    bool findRecordEnd(size_t maxFields, size_t& recordEnd) const;
+    
+    /**
+     * Move unread data to the front of the buffer, growing it if it's full,
+     * and read more of the file
+     */
+    void refill();
+};
+
+/**
+ * Streaming CSV Writer
+ *
+ * Collects records in one large buffer and writes it out when full.
+ * Fields that contain a comma, quote or line break are quoted.
+ */
+class CsvWriter {
+public:
+    /**
+     * Constructor
+     * @param filename File to create or overwrite
+     * @param bufferSize Bytes collected per write (default: 1MB)
+     */
+    explicit CsvWriter(const std::string& filename, size_t bufferSize = 1024 * 1024);
+    
+    /**
+     * Check whether the file could be opened
+     * @return true if open
+     */
+    bool isOpen() const;
+    
+    /**
+     * Append a two-field record
+     * @param first First field
+     * @param second Second field
+     */
+    void write(std::string_view first, std::string_view second);
+    
+    /**
+     * Append a three-field record
+     * @param first First field
+     * @param second Second field
+     * @param third Third field
+     */
+    void write(std::string_view first, std::string_view second, std::string_view third);
+    
+    /**
+     * Write out the buffer and close the file
+     * @return true if everything reached the file
+     */
+    bool finish();
+
+private:
+    std::ofstream file_;
+    std::string buffer_;        // Records not yet written
+    size_t bufferSize_;         // Flush threshold
+    
+    void appendField(std::string_view field);
+    void flush();
+};
+
+#endif // CSV_STREAM_H
@@ -0,0 +1,261 @@
+#ifndef FINGERPRINT_INDEX_H
+#define FINGERPRINT_INDEX_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * Concurrent Fingerprint Index
+ *
+ * Insert-only open-addressing table from 64-bit fingerprints to 64-bit
+ * references, for dedup indexes whose keys (long URLs) are already stored
+ * once elsewhere. A slot is just the fingerprint and the reference, 16
+ * bytes, with no per-entry allocation:
+ * - Fingerprints may collide. Lookups take a matcher that checks a
+ *   candidate reference against the stored key; entries whose fingerprints
+ *   are equal simply sit further along the (linear) probe sequence
+ * - find() is lock-free: a writer claims a slot by compare-exchanging its
+ *   reference and then publishes it with a release store of the fingerprint
+ * - Inserts lock one of NumStripes stripes picked by fingerprint, so two
+ *   inserts of the same key can't both succeed
+ * - The load factor stays at or below 3/4. Growing takes an exclusive lock
+ *   that only writers wait on; readers may still probe the replaced slot
+ *   array, so it is kept until clear() (at most as many slots again)
+ *
+ * Reference 0 marks an empty slot and can't be stored. clear() must not
+ * run concurrently with any other call.
+ */
+class FingerprintIndex {
+public:
+    /**
+     * Constructor
+     * @param initialSlots Initial number of slots, rounded up to a power of two (default: 1024)
+     */
+    explicit FingerprintIndex(size_t initialSlots = 1024)
+        : initialSlots_(roundUpToPowerOfTwo(std::max(initialSlots, MinSlots)))
+        , size_(0)
+    {
+        reset();
+    }
+    
+    // Non-copyable
+    FingerprintIndex(const FingerprintIndex&) = delete;
+    FingerprintIndex& operator=(const FingerprintIndex&) = delete;
+    
+    /**
+     * Look up a key without locking
+     * @param fingerprint Fingerprint of the key
+     * @param matches Callable taking a candidate reference, returning whether it refers to the key
+     * @return Reference of the key, or 0 if absent
+     */
+    template <typename Matches>
+    uint64_t find(uint64_t fingerprint, Matches matches) const {
+        fingerprint = storedFingerprint(fingerprint);
+        const Table* table = table_.load(std::memory_order_acquire);
+        
+        for (size_t i = fingerprint & table->mask; ; i = (i + 1) & table->mask) {
+            const Slot& slot = table->slots[i];
+            uint64_t found = slot.fingerprint.load(std::memory_order_acquire);
+            if (found == fingerprint) {
+                uint64_t ref = slot.ref.load(std::memory_order_relaxed);
+                if (matches(ref)) {
+                    return ref;
+                }
+            } else if (found == 0 && slot.ref.load(std::memory_order_acquire) == 0) {
+                return 0;  // End of the run; a claimed slot not yet published doesn't end it
+            }
+        }
+    }
+    
+    /**
+     * Insert a key if it is absent
+     *
+     * makeRef is called at most once, only when no candidate matches, while
+     * the fingerprint's stripe is locked.
+     * @param fingerprint Fingerprint of the key
+     * @param matches Callable taking a candidate reference, returning whether it refers to the key
+     * @param makeRef Callable returning the key's (non-zero) reference
+     * @return Reference of the key, and whether this call inserted it
+     */
+    template <typename Matches, typename MakeRef>
+    std::pair<uint64_t, bool> findOrInsert(uint64_t fingerprint, Matches matches, MakeRef makeRef) {
+        fingerprint = storedFingerprint(fingerprint);
+        while (true) {
+            {
+                std::shared_lock<std::shared_mutex> resizeLock(resizeMutex_);
+                std::lock_guard<std::mutex> lock(stripes_[fingerprint & (NumStripes - 1)]);
+                
+                Table* table = table_.load(std::memory_order_relaxed);
+                size_t i = fingerprint & table->mask;
+                for (; ; i = (i + 1) & table->mask) {
+                    Slot& slot = table->slots[i];
+                    uint64_t found = slot.fingerprint.load(std::memory_order_acquire);
+                    if (found == fingerprint) {
+                        uint64_t ref = slot.ref.load(std::memory_order_relaxed);
+                        if (matches(ref)) {
+                            return {ref, false};
+                        }
+                    } else if (found == 0 && slot.ref.load(std::memory_order_acquire) == 0) {
+                        break;
+                    }
+                }
+                
+                // Grow before the insert rather than after, so inserts can
+                // never outrun a pending resize and fill the table
+                if (size_.load(std::memory_order_relaxed) < maxSize(*table)) {
+                    uint64_t ref = makeRef();
+                    
+                    // Writers of other stripes may claim free slots first
+                    uint64_t expected = 0;
+                    while (!table->slots[i].ref.compare_exchange_strong(expected, ref, std::memory_order_acq_rel)) {
+                        expected = 0;
+                        i = (i + 1) & table->mask;
+                    }
+                    table->slots[i].fingerprint.store(fingerprint, std::memory_order_release);
+                    size_.fetch_add(1, std::memory_order_relaxed);
+                    return {ref, true};
+                }
+            }
+            grow();
+        }
+    }
+    
+    /**
+     * Grow the table ahead of a bulk insert so it isn't rehashed along the way
+     * @param count Number of entries expected
+     */
+    void reserve(size_t count) {
+        std::unique_lock<std::shared_mutex> resizeLock(resizeMutex_);
+        size_t numSlots = roundUpToPowerOfTwo(count + count / 3 + 1);
+        if (numSlots > table_.load(std::memory_order_relaxed)->mask + 1) {
+            rehash(numSlots);
+        }
+    }
+    
+    /**
+     * Get the number of entries
+     * @return Number of entries
+     */
+    size_t size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * Get the memory held by slot arrays, the current one and those it replaced
+     * @return Bytes
+     */
+    size_t memoryUsage() const {
+        std::shared_lock<std::shared_mutex> resizeLock(resizeMutex_);
+        size_t bytes = 0;
+        for (const auto& table : tables_) {
+            bytes += (table->mask + 1) * sizeof(Slot);
+        }
+        return bytes;
+    }
+    
+    /**
+     * Remove every entry. Not safe while other threads use the index.
+     */
+    void clear() {
+        std::unique_lock<std::shared_mutex> resizeLock(resizeMutex_);
+        reset();
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> fingerprint;      // 0 until published
+        std::atomic<uint64_t> ref;              // 0 until claimed
+    };
+    
+    struct Table {
+        size_t mask;                            // Number of slots - 1
+        std::unique_ptr<Slot[]> slots;
+        
+        explicit Table(size_t numSlots)
+            : mask(numSlots - 1)
+            , slots(new Slot[numSlots])
+        {
+            for (size_t i = 0; i < numSlots; ++i) {
+                slots[i].fingerprint.store(0, std::memory_order_relaxed);
+                slots[i].ref.store(0, std::memory_order_relaxed);
+            }
+        }
+    };
+    
+    // Slots claimed but not yet counted are bounded by the stripe count, so
+    // a table this large always keeps a free slot past the 3/4 limit
+    static constexpr size_t NumStripes = 64;
+    static constexpr size_t MinSlots = 4 * NumStripes;
+    
+    size_t initialSlots_;                           // Slot count after construction or clear()
+    std::atomic<Table*> table_;                     // Table used by readers and writers
+    std::vector<std::unique_ptr<Table>> tables_;    // Current table and the ones it replaced
+    std::atomic<size_t> size_;                      // Number of entries
+    mutable std::shared_mutex resizeMutex_;         // Shared by inserts, exclusive for growing
+    std::mutex stripes_[NumStripes];                // Serialize inserts per stripe
+    
+    // 0 means "empty"; the fingerprint it would collide with is harmless
+    static uint64_t storedFingerprint(uint64_t fingerprint) {
+        return fingerprint == 0 ? 1 : fingerprint;
+    }
+    
+    static size_t maxSize(const Table& table) {
+        return (table.mask + 1) - (table.mask + 1) / 4;
+    }
+    
+    void grow() {
+        std::unique_lock<std::shared_mutex> resizeLock(resizeMutex_);
+        
+        const Table* table = table_.load(std::memory_order_relaxed);
+        if (size_.load(std::memory_order_relaxed) < maxSize(*table)) {
+            return;  // Another writer already grew it
+        }
+        rehash((table->mask + 1) * 2);
+    }
+    
+    // Caller holds resizeMutex_ exclusively, so every claimed slot is published
+    void rehash(size_t numSlots) {
+        const Table* old = table_.load(std::memory_order_relaxed);
+        std::unique_ptr<Table> table(new Table(numSlots));
+        for (size_t i = 0; i <= old->mask; ++i) {
+            uint64_t fingerprint = old->slots[i].fingerprint.load(std::memory_order_relaxed);
+            if (fingerprint == 0) {
+                continue;
+            }
+            size_t j = fingerprint & table->mask;
+            while (table->slots[j].ref.load(std::memory_order_relaxed) != 0) {
+                j = (j + 1) & table->mask;
+            }
+            table->slots[j].ref.store(old->slots[i].ref.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            table->slots[j].fingerprint.store(fingerprint, std::memory_order_relaxed);
+        }
+        
+        // Readers still probing the old table finish there safely
+        table_.store(table.get(), std::memory_order_release);
+        tables_.push_back(std::move(table));
+    }
+    
+    void reset() {
+        tables_.clear();
+        tables_.emplace_back(new Table(initialSlots_));
+        table_.store(tables_.back().get(), std::memory_order_release);
+        size_.store(0, std::memory_order_relaxed);
+    }
+    
+    static size_t roundUpToPowerOfTwo(size_t n) {
+        size_t power = 1;
+        while (power < n) {
+            power <<= 1;
+        }
+        return power;
+    }
+};
+
+#endif // FINGERPRINT_INDEX_H
@@ -0,0 +1,130 @@
+#ifndef HYPERLOGLOG_H
+#define HYPERLOGLOG_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * HyperLogLog Distinct Counter
+ *
+ * Estimates the number of distinct 64-bit hashes added, with a standard
+ * error of about 1.6% (2^12 registers):
+ * - Starts sparse: a sorted list of the registers set so far, 4 bytes
+ *   each, estimated by linear counting. Most click buckets see few
+ *   visitors and never need more
+ * - Switches to 4096 one-byte registers once the list would be as large,
+ *   and estimates with the HyperLogLog formula, falling back to linear
+ *   counting while it is more accurate (small cardinalities)
+ *
+ * Hashes must be well mixed (all 64 bits); the caller hashes its values.
+ * Not thread-safe.
+ */
+class HyperLogLog {
+public:
+    static constexpr unsigned Precision = 12;
+    static constexpr size_t NumRegisters = size_t(1) << Precision;
+    
+    /**
+     * Add a hash
+     * @param hash 64-bit hash of the value
+     */
+    void add(uint64_t hash) {
+        set(static_cast<uint32_t>(hash >> (64 - Precision)), rank(hash << Precision));
+    }
+    
+    /**
+     * Add every hash another counter has seen
+     * @param other Counter to merge in
+     */
+    void merge(const HyperLogLog& other) {
+        if (other.registers_.empty()) {
+            for (uint32_t entry : other.sparse_) {
+                set(entry >> 8, static_cast<uint8_t>(entry & 0xFF));
+            }
+            return;
+        }
+        
+        if (registers_.empty()) {
+            toDense();
+        }
+        for (size_t i = 0; i < NumRegisters; ++i) {
+            registers_[i] = std::max(registers_[i], other.registers_[i]);
+        }
+    }
+    
+    /**
+     * Estimate the number of distinct hashes added
+     * @return Estimate, 0 if nothing was added
+     */
+    uint64_t estimate() const {
+        const double m = double(NumRegisters);
+        if (registers_.empty()) {
+            // Sparse lists stay below a quarter of the registers, so some are zero
+            return static_cast<uint64_t>(std::llround(m * std::log(m / double(NumRegisters - sparse_.size()))));
+        }
+        
+        double sum = 0.0;
+        size_t zeros = 0;
+        for (uint8_t value : registers_) {
+            sum += std::ldexp(1.0, -int(value));
+            zeros += value == 0;
+        }
+        double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+        if (estimate <= 2.5 * m && zeros > 0) {
+            estimate = m * std::log(m / double(zeros));
+        }
+        return static_cast<uint64_t>(std::llround(estimate));
+    }
+    
+    /**
+     * Get the heap memory held
+     * @return Bytes
+     */
+    size_t memoryUsage() const {
+        return sparse_.capacity() * sizeof(uint32_t) + registers_.capacity();
+    }
+
+private:
+    std::vector<uint32_t> sparse_;      // register << 8 | rank, sorted by register; unused once dense
+    std::vector<uint8_t> registers_;    // NumRegisters ranks once dense, empty before
+    
+    // Position of the first set bit among the bits below the register index
+    static uint8_t rank(uint64_t bits) {
+        uint8_t rank = 1;
+        while (rank <= 64 - Precision && !(bits & (uint64_t(1) << 63))) {
+            bits <<= 1;
+            rank++;
+        }
+        return rank;
+    }
+    
+    void set(uint32_t index, uint8_t value) {
+        if (!registers_.empty()) {
+            registers_[index] = std::max(registers_[index], value);
+            return;
+        }
+        
+        auto it = std::lower_bound(sparse_.begin(), sparse_.end(), index << 8);
+        if (it != sparse_.end() && (*it >> 8) == index) {
+            *it = std::max(*it, (index << 8) | value);
+            return;
+        }
+        sparse_.insert(it, (index << 8) | value);
+        if (sparse_.size() * sizeof(uint32_t) >= NumRegisters) {
+            toDense();
+        }
+    }
+    
+    void toDense() {
+        registers_.assign(NumRegisters, 0);
+        for (uint32_t entry : sparse_) {
+            registers_[entry >> 8] = static_cast<uint8_t>(entry & 0xFF);
+        }
+        std::vector<uint32_t>().swap(sparse_);
+    }
+};
+
+#endif // HYPERLOGLOG_H
@@ -0,0 +1,104 @@
+#ifndef ID_SCRAMBLER_H
+#define ID_SCRAMBLER_H
+
+#include <cstdint>
+#include <stdexcept>
+
+/**
+ * Keyed Id Scrambler
+ *
+ * Bijective permutation of the ids below 2^bits, built as a balanced
+ * Feistel network: each round mixes one half of the id with a keyed hash
+ * of the other half. Every round is invertible whatever the hash, so the
+ * whole network is too:
+ * - scramble() never maps two ids to the same value, so codes built from
+ *   scrambled ids can't collide
+ * - unscramble() recovers the id, so a scrambled code still indexes a dense
+ *   array directly
+ * - Without the key, consecutive ids give values that look unrelated
+ *
+ * This hides the order codes were issued in; it is not encryption and
+ * shouldn't protect anything secret.
+ */
+class IdScrambler {
+public:
+    /**
+     * Constructor
+     * @param key Secret that selects the permutation
+     * @param bits Width of the permuted id range; even, from 2 to 64
+     * @param rounds Feistel rounds (default: 4)
+     */
+    IdScrambler(uint64_t key, unsigned bits, unsigned rounds = 4)
+        : halfBits_(bits / 2)
+        , halfMask_(0)
+        , rounds_(rounds)
+    {
+        if (bits < 2 || bits > 64 || bits % 2 != 0) {
+            throw std::invalid_argument("Scrambler width must be an even number of bits from 2 to 64");
+        }
+        if (rounds == 0 || rounds > MaxRounds) {
+            throw std::invalid_argument("Scrambler rounds must be between 1 and 16");
+        }
+        halfMask_ = (UINT64_C(1) << halfBits_) - 1;
+        
+        // Independent-looking round keys from one key
+        uint64_t state = key;
+        for (unsigned i = 0; i < rounds_; ++i) {
+            state += UINT64_C(0x9E3779B97F4A7C15);
+            roundKeys_[i] = mix(state);
+        }
+    }
+    
+    /**
+     * Map an id to its scrambled value
+     * @param id Id below 2^bits
+     * @return Scrambled value below 2^bits
+     */
+    uint64_t scramble(uint64_t id) const {
+        uint64_t left = id >> halfBits_;
+        uint64_t right = id & halfMask_;
+        for (unsigned i = 0; i < rounds_; ++i) {
+            uint64_t next = left ^ round(right, i);
+            left = right;
+            right = next;
+        }
+        return (left << halfBits_) | right;
+    }
+    
+    /**
+     * Recover the id a value was scrambled from
+     * @param value Value below 2^bits
+     * @return Id below 2^bits
+     */
+    uint64_t unscramble(uint64_t value) const {
+        uint64_t left = value >> halfBits_;
+        uint64_t right = value & halfMask_;
+        for (unsigned i = rounds_; i-- > 0;) {
+            uint64_t previous = right ^ round(left, i);
+            right = left;
+            left = previous;
+        }
+        return (left << halfBits_) | right;
+    }
+
+private:
+    static constexpr unsigned MaxRounds = 16;
+    
+    unsigned halfBits_;                 // Width of each Feistel half
+    uint64_t halfMask_;                 // (1 << halfBits_) - 1
+    unsigned rounds_;                   // Number of rounds
+    uint64_t roundKeys_[MaxRounds];     // Key mixed into each round
+    
+    uint64_t round(uint64_t half, unsigned i) const {
+        return mix(half ^ roundKeys_[i]) & halfMask_;
+    }
+    
+    // splitmix64 finalizer
+    static uint64_t mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+        x = (x ^ (x >> 27)) * UINT64_C(0x94D049BB133111EB);
+        return x ^ (x >> 31);
+    }
+};
+
+#endif // ID_SCRAMBLER_H
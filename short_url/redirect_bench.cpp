@@ -0,0 +1,294 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * Load generator for redirect_server
+ *
+ * Usage: redirect_bench [port] [connections] [pipeline] [seconds] [threads] [urls]
+ *   port         Server port on 127.0.0.1 (default: 8080)
+ *   connections  Keep-alive connections (default: 64)
+ *   pipeline     Requests in flight per connection (default: 16)
+ *   seconds      Measured duration (default: 5)
+ *   threads      Client threads; connections are split among them (default: 1)
+ *   urls         URLs shortened through POST before the run (default: 10000)
+ *
+ * Each connection keeps `pipeline` GET requests for the shortened codes in
+ * flight and sends one more for every response. Reports redirects per second.
+ */
+
+namespace {
+
+// One parsed response
+struct Response {
+    int status;
+    std::string_view body;
+};
+
+int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error("socket failed");
+    }
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot connect to port " + std::to_string(port));
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+void sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                std::this_thread::yield();
+                continue;
+            }
+            throw std::runtime_error("send failed");
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+/**
+ * Parse one response from the front of a buffer
+ * @return Bytes consumed, 0 if the response is incomplete
+ */
+size_t parseResponse(std::string_view data, Response& response) {
+    size_t headEnd = data.find("\r\n\r\n");
+    if (headEnd == std::string_view::npos || headEnd < 12) {
+        return 0;
+    }
+    std::string_view head = data.substr(0, headEnd);
+    response.status = std::atoi(std::string(head.substr(9, 3)).c_str());
+    
+    size_t contentLength = 0;
+    size_t header = head.find("Content-Length: ");
+    if (header != std::string_view::npos) {
+        contentLength = std::strtoul(head.data() + header + 16, nullptr, 10);
+    }
+    size_t total = headEnd + 4 + contentLength;
+    if (data.size() < total) {
+        return 0;
+    }
+    response.body = data.substr(headEnd + 4, contentLength);
+    return total;
+}
+
+// Shorten numUrls URLs through POST and return their codes
+std::vector<std::string> populate(uint16_t port, size_t numUrls) {
+    const size_t batch = 256;
+    int fd = connectTo(port);
+    std::vector<std::string> codes;
+    std::string input;
+    char buffer[64 * 1024];
+    
+    for (size_t first = 0; first < numUrls; first += batch) {
+        size_t count = std::min(batch, numUrls - first);
+        std::string requests;
+        for (size_t i = first; i < first + count; ++i) {
+            std::string url = "https://www.example.com/bench/" + std::to_string(i);
+            requests += "POST / HTTP/1.1\r\nHost: localhost\r\nContent-Length: " +
+                        std::to_string(url.size()) + "\r\n\r\n" + url;
+        }
+        sendAll(fd, requests);
+        
+        size_t received = 0;
+        while (received < count) {
+            ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                ::close(fd);
+                throw std::runtime_error("server closed the connection while populating");
+            }
+            input.append(buffer, static_cast<size_t>(n));
+            
+            Response response;
+            size_t offset = 0;
+            while (size_t used = parseResponse(std::string_view(input).substr(offset), response)) {
+                if (response.status != 201) {
+                    ::close(fd);
+                    throw std::runtime_error("POST returned " + std::to_string(response.status));
+                }
+                codes.emplace_back(response.body.substr(response.body.rfind('/') + 1));
+                offset += used;
+                received++;
+            }
+            input.erase(0, offset);
+        }
+    }
+    
+    ::close(fd);
+    return codes;
+}
+
+struct ClientConnection {
+    int fd;
+    std::string input;          // Bytes of unparsed responses
+    std::string output;         // Requests not yet sent
+    size_t next;                // Next request to send, index into the request list
+};
+
+struct ThreadResult {
+    uint64_t responses = 0;
+    uint64_t redirects = 0;
+};
+
+bool flushOutput(ClientConnection& connection) {
+    while (!connection.output.empty()) {
+        ssize_t n = ::send(connection.fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+        if (n < 0) {
+            return errno == EAGAIN || errno == EINTR;
+        }
+        connection.output.erase(0, static_cast<size_t>(n));
+    }
+    return true;
+}
+
+// Drive a set of connections until the deadline
+void runClient(uint16_t port, size_t numConnections, size_t pipeline, const std::vector<std::string>& requests,
+               std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point deadline,
+               ThreadResult& result) {
+    int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    std::vector<ClientConnection> connections(numConnections);
+    for (size_t i = 0; i < numConnections; ++i) {
+        ClientConnection& connection = connections[i];
+        connection.fd = connectTo(port);
+        ::fcntl(connection.fd, F_SETFL, ::fcntl(connection.fd, F_GETFL) | O_NONBLOCK);
+        connection.next = (i * 7919) % requests.size();
+        
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        event.data.ptr = &connection;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, connection.fd, &event);
+    }
+    
+    auto queueRequests = [&requests](ClientConnection& connection, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            connection.output += requests[connection.next];
+            connection.next = (connection.next + 1) % requests.size();
+        }
+    };
+    
+    std::this_thread::sleep_until(start);
+    for (auto& connection : connections) {
+        queueRequests(connection, pipeline);
+        flushOutput(connection);
+    }
+    
+    char buffer[64 * 1024];
+    epoll_event events[256];
+    while (std::chrono::steady_clock::now() < deadline) {
+        int count = ::epoll_wait(epollFd, events, 256, 10);
+        for (int i = 0; i < count; ++i) {
+            ClientConnection& connection = *static_cast<ClientConnection*>(events[i].data.ptr);
+            size_t completed = 0;
+            while (true) {
+                ssize_t n = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+                if (n <= 0) {
+                    break;
+                }
+                connection.input.append(buffer, static_cast<size_t>(n));
+            }
+            
+            Response response;
+            size_t offset = 0;
+            while (size_t used = parseResponse(std::string_view(connection.input).substr(offset), response)) {
+                offset += used;
+                completed++;
+                if (response.status == 301 || response.status == 302) {
+                    result.redirects++;
+                }
+            }
+            connection.input.erase(0, offset);
+            result.responses += completed;
+            
+            queueRequests(connection, completed);
+            flushOutput(connection);
+        }
+    }
+    
+    for (auto& connection : connections) {
+        ::close(connection.fd);
+    }
+    ::close(epollFd);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        uint16_t port = argc > 1 ? static_cast<uint16_t>(std::stoi(argv[1])) : 8080;
+        size_t numConnections = argc > 2 ? std::stoul(argv[2]) : 64;
+        size_t pipeline = argc > 3 ? std::stoul(argv[3]) : 16;
+        double seconds = argc > 4 ? std::stod(argv[4]) : 5.0;
+        size_t numThreads = argc > 5 ? std::stoul(argv[5]) : 1;
+        size_t numUrls = argc > 6 ? std::stoul(argv[6]) : 10000;
+        if (numConnections == 0 || pipeline == 0 || numThreads == 0 || numUrls == 0) {
+            throw std::invalid_argument("connections, pipeline, threads and urls must be positive");
+        }
+        numThreads = std::min(numThreads, numConnections);
+        
+        std::cout << "Shortening " << numUrls << " URLs..." << std::endl;
+        std::vector<std::string> requests;
+        for (const auto& code : populate(port, numUrls)) {
+            requests.push_back("GET /" + code + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        }
+        
+        std::cout << "Running " << seconds << "s: " << numConnections << " connections, pipeline "
+                  << pipeline << ", " << numThreads << " threads" << std::endl;
+        auto start = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+        auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(seconds));
+        
+        std::vector<ThreadResult> results(numThreads);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < numThreads; ++t) {
+            size_t share = numConnections / numThreads + (t < numConnections % numThreads ? 1 : 0);
+            threads.emplace_back(runClient, port, share, pipeline, std::cref(requests), start, deadline,
+                                 std::ref(results[t]));
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        
+        ThreadResult total;
+        for (const auto& result : results) {
+            total.responses += result.responses;
+            total.redirects += result.redirects;
+        }
+        std::cout << "Responses:    " << total.responses << std::endl;
+        std::cout << "Redirects:    " << total.redirects << std::endl;
+        std::cout << "Redirects/s:  " << static_cast<uint64_t>(total.redirects / seconds) << std::endl;
+        return total.redirects == total.responses ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
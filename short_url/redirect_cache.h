@@ -0,0 +1,242 @@
+#ifndef REDIRECT_CACHE_H
+#define REDIRECT_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Redirect Cache
+ *
+ * Bounded short code -> URL cache for the hot end of redirect traffic:
+ * - NumShards shards, each behind its own reader-writer lock; lookups take
+ *   the shared lock, so concurrent hits never wait on each other
+ * - Each shard evicts with CLOCK: a hit only sets the entry's reference
+ *   bit, and the hand evicts the first entry found without one. Entries
+ *   start unreferenced, so codes seen once leave before repeatedly hit ones
+ * - Unknown codes are cached too (an empty URL), so probes for codes that
+ *   don't exist stop reaching the store
+ *
+ * A miss hands out a ticket that insert() checks: an invalidate() between
+ * the two drops the insert, so a lookup racing a write can't cache the
+ * value it read before the write.
+ */
+class RedirectCache {
+public:
+    static constexpr size_t NumShards = 16;
+    
+    /**
+     * Hit and miss counters, summed over the shards
+     */
+    struct Stats {
+        uint64_t hits;              // Lookups answered with a URL
+        uint64_t negativeHits;      // Lookups answered "unknown code"
+        uint64_t misses;            // Lookups that had to go to the store
+        uint64_t evictions;         // Entries dropped to make room
+        
+        /**
+         * Get the share of lookups answered by the cache
+         * @return Hits of both kinds over all lookups, 0 if there were none
+         */
+        double hitRatio() const {
+            uint64_t lookups = hits + negativeHits + misses;
+            return lookups == 0 ? 0.0 : double(hits + negativeHits) / double(lookups);
+        }
+    };
+    
+    /**
+     * Constructor
+     * @param capacity Maximum number of entries, split evenly over the
+     *        shards (rounded up); 0 disables the cache
+     */
+    explicit RedirectCache(size_t capacity)
+        : shardCapacity_((capacity + NumShards - 1) / NumShards)
+    {
+        for (Shard& shard : shards_) {
+            shard.entries.reset(new Entry[shardCapacity_]);
+        }
+    }
+    
+    // Non-copyable
+    RedirectCache(const RedirectCache&) = delete;
+    RedirectCache& operator=(const RedirectCache&) = delete;
+    
+    /**
+     * Get the number of entries the cache can hold
+     * @return Capacity, 0 if disabled
+     */
+    size_t capacity() const {
+        return shardCapacity_ * NumShards;
+    }
+    
+    /**
+     * Look up a short code
+     * @param code Short code
+     * @param url Output: the cached URL, empty for a cached unknown code
+     * @param ticket Output on a miss: pass to insert() with the store's answer
+     * @return true on a hit, false if the store must be asked
+     */
+    bool find(const std::string& code, std::string& url, uint64_t& ticket) {
+        if (shardCapacity_ == 0) {
+            ticket = 0;
+            return false;
+        }
+        
+        Shard& shard = shardFor(code);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.slots.find(code);
+        if (it == shard.slots.end()) {
+            ticket = shard.version;
+            shard.misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        
+        Entry& entry = shard.entries[it->second];
+        entry.referenced.store(true, std::memory_order_relaxed);
+        url = entry.url;
+        (url.empty() ? shard.negativeHits : shard.hits).fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    /**
+     * Cache the store's answer for a code that missed
+     * @param code Short code
+     * @param url URL from the store, empty if the code is unknown
+     * @param ticket Ticket from the find() that missed
+     */
+    void insert(const std::string& code, const std::string& url, uint64_t ticket) {
+        if (shardCapacity_ == 0) {
+            return;
+        }
+        
+        Shard& shard = shardFor(code);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (shard.version != ticket || shard.slots.count(code) != 0) {
+            return;  // Invalidated since the miss, or cached by another thread
+        }
+        
+        size_t slot;
+        if (!shard.freeSlots.empty()) {
+            slot = shard.freeSlots.back();
+            shard.freeSlots.pop_back();
+        } else if (shard.used < shardCapacity_) {
+            slot = shard.used++;
+        } else {
+            // Sweep the hand, clearing reference bits, to the first unreferenced entry
+            while (shard.entries[shard.hand].referenced.exchange(false, std::memory_order_relaxed)) {
+                shard.hand = (shard.hand + 1) % shardCapacity_;
+            }
+            slot = shard.hand;
+            shard.hand = (shard.hand + 1) % shardCapacity_;
+            shard.slots.erase(shard.entries[slot].code);
+            shard.evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        Entry& entry = shard.entries[slot];
+        entry.code = code;
+        entry.url = url;
+        entry.referenced.store(false, std::memory_order_relaxed);
+        shard.slots.emplace(code, slot);
+    }
+    
+    /**
+     * Drop a code after its mapping was written, including a cached
+     * "unknown code" answer
+     * @param code Short code
+     */
+    void invalidate(const std::string& code) {
+        if (shardCapacity_ == 0) {
+            return;
+        }
+        
+        Shard& shard = shardFor(code);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.version++;
+        auto it = shard.slots.find(code);
+        if (it != shard.slots.end()) {
+            releaseSlot(shard, it->second);
+            shard.slots.erase(it);
+        }
+    }
+    
+    /**
+     * Drop every entry; the counters are kept
+     */
+    void clear() {
+        for (Shard& shard : shards_) {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.version++;
+            for (const auto& slot : shard.slots) {
+                releaseSlot(shard, slot.second);
+            }
+            shard.slots.clear();
+            shard.freeSlots.clear();
+            shard.used = 0;
+            shard.hand = 0;
+        }
+    }
+    
+    /**
+     * Get the hit and miss counters
+     * @return Counters summed over the shards
+     */
+    Stats stats() const {
+        Stats total = {0, 0, 0, 0};
+        for (const Shard& shard : shards_) {
+            total.hits += shard.hits.load(std::memory_order_relaxed);
+            total.negativeHits += shard.negativeHits.load(std::memory_order_relaxed);
+            total.misses += shard.misses.load(std::memory_order_relaxed);
+            total.evictions += shard.evictions.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    struct Entry {
+        std::string code;
+        std::string url;                            // Empty for an unknown code
+        std::atomic<bool> referenced{false};        // Set by hits, cleared by the hand
+    };
+    
+    // Aligned so shards locked by different threads don't share cache lines
+    struct alignas(64) Shard {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string, size_t> slots;  // Code -> index into entries
+        std::unique_ptr<Entry[]> entries;               // Fixed array of shardCapacity_ entries
+        std::vector<size_t> freeSlots;                  // Invalidated entries below used
+        size_t used = 0;                                // Entries handed out so far
+        size_t hand = 0;                                // CLOCK hand
+        uint64_t version = 0;                           // Bumped by every invalidation
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> negativeHits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> evictions{0};
+    };
+    
+    size_t shardCapacity_;                  // Entries per shard
+    Shard shards_[NumShards];
+    
+    Shard& shardFor(const std::string& code) {
+        // High bits pick the shard; the shard's map uses the whole hash
+        size_t hash = std::hash<std::string>()(code);
+        return shards_[(hash >> 28) % NumShards];
+    }
+    
+    // Free an entry's strings; the caller erases it from slots
+    void releaseSlot(Shard& shard, size_t slot) {
+        Entry& entry = shard.entries[slot];
+        std::string().swap(entry.code);
+        std::string().swap(entry.url);
+        entry.referenced.store(false, std::memory_order_relaxed);
+        shard.freeSlots.push_back(slot);
+    }
+};
+
+#endif // REDIRECT_CACHE_H
@@ -0,0 +1,696 @@
+#include "redirect_server.h"
+#include "url_shortener.h"
+#include "xxh64.hpp"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t INITIAL_INPUT_BYTES = 16 * 1024;
+constexpr size_t MAX_HEAD_BYTES = 8 * 1024;             // Request line and headers
+constexpr size_t MAX_BODY_BYTES = 64 * 1024;
+constexpr size_t MAX_PENDING_OUTPUT = 1024 * 1024;      // Stop reading a client that doesn't read
+constexpr size_t MAX_IOV = 512;                         // Pieces per sendmsg()
+constexpr int MAX_EVENTS = 256;
+
+// Fixed response pieces. Every response ends with END or END_CLOSE, so
+// the parts before it end in a header line.
+constexpr std::string_view FOUND = "HTTP/1.1 302 Found\r\nLocation: ";
+constexpr std::string_view MOVED = "HTTP/1.1 301 Moved Permanently\r\nLocation: ";
+constexpr std::string_view CREATED = "HTTP/1.1 201 Created\r\nLocation: ";
+constexpr std::string_view NO_BODY = "\r\nContent-Length: 0\r\n";
+constexpr std::string_view BAD_REQUEST = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n";
+constexpr std::string_view NOT_FOUND = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n";
+constexpr std::string_view NOT_ALLOWED =
+    "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET, HEAD, POST\r\nContent-Length: 0\r\n";
+constexpr std::string_view LENGTH_REQUIRED = "HTTP/1.1 411 Length Required\r\nContent-Length: 0\r\n";
+constexpr std::string_view TOO_LARGE = "HTTP/1.1 413 Payload Too Large\r\nContent-Length: 0\r\n";
+constexpr std::string_view HEAD_TOO_LARGE =
+    "HTTP/1.1 431 Request Header Fields Too Large\r\nContent-Length: 0\r\n";
+constexpr std::string_view END = "\r\n";
+constexpr std::string_view END_CLOSE = "Connection: close\r\n\r\n";
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if ((a[i] | 0x20) != (b[i] | 0x20)) {  // ASCII letters only; fine for header names and tokens
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// Bytes a header value may carry as they are: printable ASCII. A CR or LF
+// in a URL would end the Location header and start one of the URL's own.
+bool isHeaderByte(char c) {
+    return c >= 0x20 && c < 0x7F;
+}
+
+// Bytes a POSTed URL may contain: anything but ASCII control characters
+bool isUrlByte(char c) {
+    return static_cast<unsigned char>(c) >= 0x20 && c != 0x7F;
+}
+
+std::runtime_error socketError(const char* what) {
+    return std::runtime_error(std::string(what) + ": " + std::strerror(errno));
+}
+
+} // namespace
+
+/**
+ * One thread's listening socket, epoll set and connections
+ */
+class RedirectServer::Reactor {
+public:
+    Reactor(UrlShortener& shortener, int redirectStatus, int stopFd)
+        : shortener_(shortener)
+        , redirect_(redirectStatus == 301 ? MOVED : FOUND)
+        , stopFd_(stopFd)
+        , listenFd_(-1)
+        , epollFd_(-1)
+    {
+    }
+    
+    ~Reactor() {
+        for (auto& entry : connections_) {
+            ::close(entry.first);
+        }
+        if (listenFd_ >= 0) {
+            ::close(listenFd_);
+        }
+        if (epollFd_ >= 0) {
+            ::close(epollFd_);
+        }
+    }
+    
+    /**
+     * Create the listening socket and epoll set
+     * @param port Port to bind; 0 picks a free one
+     * @return The bound port
+     */
+    uint16_t open(uint16_t port) {
+        listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd_ < 0) {
+            throw socketError("socket");
+        }
+        int one = 1;
+        ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) {
+            throw socketError("SO_REUSEPORT");
+        }
+        
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+        if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            throw socketError("bind");
+        }
+        if (::listen(listenFd_, SOMAXCONN) < 0) {
+            throw socketError("listen");
+        }
+        socklen_t length = sizeof(address);
+        ::getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &length);
+        
+        epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd_ < 0) {
+            throw socketError("epoll_create1");
+        }
+        watch(listenFd_, &listenFd_, EPOLLIN | EPOLLET);
+        watch(stopFd_, &stopFd_, EPOLLIN);  // Level-triggered: stays ready once signalled
+        return ntohs(address.sin_port);
+    }
+    
+    /**
+     * Serve events until the stop eventfd is signalled
+     */
+    void run() {
+        epoll_event events[MAX_EVENTS];
+        while (true) {
+            int count = ::epoll_wait(epollFd_, events, MAX_EVENTS, -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            
+            for (int i = 0; i < count; ++i) {
+                void* tag = events[i].data.ptr;
+                if (tag == &stopFd_) {
+                    return;
+                }
+                if (tag == &listenFd_) {
+                    acceptAll();
+                    continue;
+                }
+                
+                Connection& connection = *static_cast<Connection*>(tag);
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    close(connection);
+                    continue;
+                }
+                if ((events[i].events & EPOLLOUT) && !onWritable(connection)) {
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    onReadable(connection);
+                }
+            }
+        }
+    }
+
+private:
+    // A response part: fixed text or stored URL (data), or a range of scratch
+    struct Piece {
+        const char* data;       // nullptr for a scratch range
+        size_t offset;          // Start in scratch when data is nullptr
+        size_t size;
+    };
+    
+    struct Connection {
+        int fd;
+        std::unique_ptr<char[]> input;      // Received bytes
+        size_t capacity;                    // Size of input
+        size_t begin;                       // Start of the first unanswered request
+        size_t end;                         // End of received bytes
+        std::vector<Piece> pieces;          // Responses not yet sent
+        std::string scratch;                // Generated response text (short URLs, lengths, encoded URLs)
+        std::string pending;                // Bytes a short write left over
+        bool closing;                       // Close once the output is sent
+        bool readPaused;                    // Reading stopped until pending drains
+        uint64_t visitor;                   // Hash of the client address, for click analytics
+    };
+    
+    UrlShortener& shortener_;
+    std::string_view redirect_;             // Status line of redirects
+    int stopFd_;
+    int listenFd_;
+    int epollFd_;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+    
+    void watch(int fd, void* tag, uint32_t events) {
+        epoll_event event = {};
+        event.events = events;
+        event.data.ptr = tag;
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+            throw socketError("epoll_ctl");
+        }
+    }
+    
+    void acceptAll() {
+        while (true) {
+            sockaddr_storage peer;
+            socklen_t peerLength = sizeof(peer);
+            int fd = ::accept4(listenFd_, reinterpret_cast<sockaddr*>(&peer), &peerLength,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                return;  // EAGAIN, or out of descriptors until a connection closes
+            }
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            
+            std::unique_ptr<Connection> connection(new Connection{
+                fd, std::unique_ptr<char[]>(new char[INITIAL_INPUT_BYTES]), INITIAL_INPUT_BYTES,
+                0, 0, {}, {}, {}, false, false, visitorOf(peer)});
+            Connection* tag = connection.get();
+            connections_.emplace(fd, std::move(connection));
+            try {
+                watch(fd, tag, EPOLLIN | EPOLLOUT | EPOLLET);
+            } catch (const std::runtime_error&) {
+                close(*tag);
+            }
+        }
+    }
+    
+    // The address without the port: one visitor may open many connections
+    static uint64_t visitorOf(const sockaddr_storage& peer) {
+        uint64_t hash = 0;
+        if (peer.ss_family == AF_INET) {
+            const in_addr& address = reinterpret_cast<const sockaddr_in&>(peer).sin_addr;
+            hash = xxh64::hash(reinterpret_cast<const char*>(&address), sizeof(address), 0);
+        } else if (peer.ss_family == AF_INET6) {
+            const in6_addr& address = reinterpret_cast<const sockaddr_in6&>(peer).sin6_addr;
+            hash = xxh64::hash(reinterpret_cast<const char*>(&address), sizeof(address), 0);
+        }
+        return hash;
+    }
+    
+    void close(Connection& connection) {
+        int fd = connection.fd;
+        ::close(fd);  // Also removes it from the epoll set
+        connections_.erase(fd);
+    }
+    
+    // Read until the socket is drained (edge-triggered), answering as requests complete
+    void onReadable(Connection& connection) {
+        while (!connection.closing) {
+            if (connection.pending.size() > MAX_PENDING_OUTPUT) {
+                connection.readPaused = true;
+                break;
+            }
+            makeRoom(connection);
+            
+            ssize_t received = ::recv(connection.fd, connection.input.get() + connection.end,
+                                      connection.capacity - connection.end, 0);
+            if (received > 0) {
+                connection.end += static_cast<size_t>(received);
+                handleRequests(connection);
+                if (!flush(connection)) {
+                    return;
+                }
+                continue;
+            }
+            if (received == 0) {
+                connection.closing = true;  // Peer is done sending; answer what it sent
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                close(connection);
+                return;
+            }
+            break;
+        }
+        
+        if (flush(connection) && connection.closing && connection.pending.empty()) {
+            close(connection);
+        }
+    }
+    
+    // Send what a short write left over; false if the connection was closed
+    bool onWritable(Connection& connection) {
+        if (connection.pending.empty()) {
+            return true;
+        }
+        if (!flush(connection)) {
+            return false;
+        }
+        if (!connection.pending.empty()) {
+            return true;
+        }
+        if (connection.closing) {
+            close(connection);
+            return false;
+        }
+        if (connection.readPaused) {
+            connection.readPaused = false;
+            onReadable(connection);
+            return false;  // onReadable() may have closed it
+        }
+        return true;
+    }
+    
+    // Leave free space after the received bytes, growing the buffer for a large body
+    void makeRoom(Connection& connection) {
+        if (connection.begin == connection.end) {
+            connection.begin = connection.end = 0;
+        } else if (connection.begin > 0 && connection.capacity - connection.end < MAX_HEAD_BYTES) {
+            std::memmove(connection.input.get(), connection.input.get() + connection.begin,
+                         connection.end - connection.begin);
+            connection.end -= connection.begin;
+            connection.begin = 0;
+        }
+        if (connection.end == connection.capacity) {
+            // One request fills the buffer; limits are enforced when it's parsed
+            size_t capacity = connection.capacity * 2;
+            std::unique_ptr<char[]> grown(new char[capacity]);
+            std::memcpy(grown.get(), connection.input.get(), connection.end);
+            connection.input = std::move(grown);
+            connection.capacity = capacity;
+        }
+    }
+    
+    // Answer every complete request in the buffer
+    void handleRequests(Connection& connection) {
+        while (!connection.closing) {
+            const char* data = connection.input.get() + connection.begin;
+            size_t available = connection.end - connection.begin;
+            const void* headEnd = ::memmem(data, available, "\r\n\r\n", 4);
+            if (!headEnd) {
+                if (available > MAX_HEAD_BYTES) {
+                    reject(connection, HEAD_TOO_LARGE);
+                }
+                return;
+            }
+            size_t headBytes = static_cast<const char*>(headEnd) - data + 4;
+            if (headBytes > MAX_HEAD_BYTES) {
+                reject(connection, HEAD_TOO_LARGE);
+                return;
+            }
+            
+            // Request line: METHOD SP target SP HTTP/1.x
+            std::string_view head(data, headBytes - 2);
+            size_t lineEnd = head.find("\r\n");
+            std::string_view line = head.substr(0, lineEnd);
+            size_t space1 = line.find(' ');
+            size_t space2 = line.find(' ', space1 + 1);
+            if (space1 == std::string_view::npos || space2 == std::string_view::npos) {
+                reject(connection, BAD_REQUEST);
+                return;
+            }
+            std::string_view method = line.substr(0, space1);
+            std::string_view target = line.substr(space1 + 1, space2 - space1 - 1);
+            std::string_view version = line.substr(space2 + 1);
+            if (version != "HTTP/1.1" && version != "HTTP/1.0") {
+                reject(connection, BAD_REQUEST);
+                return;
+            }
+            
+            // Only the headers that frame the request or the connection matter
+            bool keepAlive = version == "HTTP/1.1";
+            bool chunked = false;
+            bool hasLength = false;
+            size_t contentLength = 0;
+            size_t position = lineEnd + 2;
+            while (position < head.size()) {
+                size_t end = head.find("\r\n", position);
+                std::string_view header = head.substr(position, end - position);
+                position = end + 2;
+                size_t colon = header.find(':');
+                if (colon == std::string_view::npos) {
+                    continue;
+                }
+                std::string_view name = header.substr(0, colon);
+                std::string_view value = trim(header.substr(colon + 1));
+                if (equalsIgnoreCase(name, "Content-Length")) {
+                    contentLength = 0;
+                    hasLength = !value.empty();
+                    for (char c : value) {
+                        if (c < '0' || c > '9' || contentLength > MAX_BODY_BYTES) {
+                            hasLength = false;
+                            contentLength = MAX_BODY_BYTES + 1;
+                            break;
+                        }
+                        contentLength = contentLength * 10 + (c - '0');
+                    }
+                } else if (equalsIgnoreCase(name, "Connection")) {
+                    if (equalsIgnoreCase(value, "close")) {
+                        keepAlive = false;
+                    } else if (equalsIgnoreCase(value, "keep-alive")) {
+                        keepAlive = true;
+                    }
+                } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+                    chunked = true;
+                }
+            }
+            
+            if (chunked) {
+                reject(connection, LENGTH_REQUIRED);  // Bodies must have a Content-Length
+                return;
+            }
+            if (contentLength > MAX_BODY_BYTES) {
+                reject(connection, hasLength ? TOO_LARGE : BAD_REQUEST);
+                return;
+            }
+            if (available < headBytes + contentLength) {
+                return;  // Body still arriving
+            }
+            
+            std::string_view body(data + headBytes, contentLength);
+            connection.begin += headBytes + contentLength;
+            connection.closing = !keepAlive;
+            respond(connection, method, target, body, hasLength);
+        }
+    }
+    
+    void respond(Connection& connection, std::string_view method, std::string_view target,
+                 std::string_view body, bool hasLength) {
+        std::string_view end = connection.closing ? END_CLOSE : END;
+        
+        if (method == "GET" || method == "HEAD") {
+            // Query and fragment aren't part of the code
+            std::string_view code = target.substr(0, target.find_first_of("?#"));
+            if (code.size() < 2 || code[0] != '/') {
+                add(connection, NOT_FOUND);
+                add(connection, end);
+                return;
+            }
+            std::string_view longUrl = shortener_.expand(code.substr(1), connection.visitor);
+            if (longUrl.empty()) {
+                add(connection, NOT_FOUND);
+                add(connection, end);
+                return;
+            }
+            add(connection, redirect_);
+            if (std::all_of(longUrl.begin(), longUrl.end(), isHeaderByte)) {
+                add(connection, longUrl);
+            } else {
+                addEncoded(connection, longUrl);  // Stored by a load or an API call, not by POST
+            }
+            add(connection, NO_BODY);
+            add(connection, end);
+            return;
+        }
+        
+        if (method == "POST") {
+            if (!hasLength) {
+                connection.closing = true;
+                add(connection, LENGTH_REQUIRED);
+                add(connection, END_CLOSE);
+                return;
+            }
+            
+            // A trailing line break (as from echo or a text file) isn't part
+            // of the URL; any other control byte makes it unusable as one
+            while (!body.empty() && (body.back() == '\n' || body.back() == '\r')) {
+                body.remove_suffix(1);
+            }
+            if (target != "/" || body.empty() || !std::all_of(body.begin(), body.end(), isUrlByte)) {
+                add(connection, target != "/" ? NOT_FOUND : BAD_REQUEST);
+                add(connection, end);
+                return;
+            }
+            
+            size_t offset = connection.scratch.size();
+            connection.scratch += shortener_.shorten(body);
+            size_t urlSize = connection.scratch.size() - offset;
+            size_t lengthOffset = connection.scratch.size();
+            connection.scratch += "\r\nContent-Type: text/plain\r\nContent-Length: ";
+            connection.scratch += std::to_string(urlSize);
+            connection.scratch += "\r\n";
+            size_t lengthSize = connection.scratch.size() - lengthOffset;
+            
+            add(connection, CREATED);
+            addScratch(connection, offset, urlSize);
+            addScratch(connection, lengthOffset, lengthSize);
+            add(connection, end);
+            addScratch(connection, offset, urlSize);
+            return;
+        }
+        
+        add(connection, NOT_ALLOWED);
+        add(connection, end);
+    }
+    
+    // Answer a request that can't be parsed or framed, then close
+    void reject(Connection& connection, std::string_view status) {
+        connection.closing = true;
+        add(connection, status);
+        add(connection, END_CLOSE);
+    }
+    
+    void add(Connection& connection, std::string_view text) {
+        connection.pieces.push_back(Piece{text.data(), 0, text.size()});
+    }
+    
+    void addScratch(Connection& connection, size_t offset, size_t size) {
+        connection.pieces.push_back(Piece{nullptr, offset, size});
+    }
+    
+    // Add text with every byte a header can't carry percent-encoded
+    void addEncoded(Connection& connection, std::string_view text) {
+        static constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+        size_t offset = connection.scratch.size();
+        for (char c : text) {
+            if (isHeaderByte(c)) {
+                connection.scratch += c;
+            } else {
+                unsigned char byte = static_cast<unsigned char>(c);
+                connection.scratch += '%';
+                connection.scratch += HEX_DIGITS[byte >> 4];
+                connection.scratch += HEX_DIGITS[byte & 0x0F];
+            }
+        }
+        addScratch(connection, offset, connection.scratch.size() - offset);
+    }
+    
+    // Send queued responses; false if the connection failed and was closed
+    bool flush(Connection& connection) {
+        // Output must stay in order: behind leftovers, responses are copied too
+        if (!connection.pending.empty()) {
+            for (const Piece& piece : connection.pieces) {
+                connection.pending.append(pieceData(connection, piece), piece.size);
+            }
+            connection.pieces.clear();
+            connection.scratch.clear();
+            return sendPending(connection);
+        }
+        
+        size_t next = 0;
+        while (next < connection.pieces.size()) {
+            iovec iov[MAX_IOV];
+            size_t count = std::min(MAX_IOV, connection.pieces.size() - next);
+            size_t total = 0;
+            for (size_t i = 0; i < count; ++i) {
+                const Piece& piece = connection.pieces[next + i];
+                iov[i].iov_base = const_cast<char*>(pieceData(connection, piece));
+                iov[i].iov_len = piece.size;
+                total += piece.size;
+            }
+            
+            msghdr message = {};
+            message.msg_iov = iov;
+            message.msg_iovlen = count;
+            ssize_t sent = ::sendmsg(connection.fd, &message, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    close(connection);
+                    return false;
+                }
+                sent = 0;
+            }
+            
+            if (static_cast<size_t>(sent) < total) {
+                // Keep the unsent tail for EPOLLOUT
+                size_t skip = static_cast<size_t>(sent);
+                for (size_t i = next; i < connection.pieces.size(); ++i) {
+                    const Piece& piece = connection.pieces[i];
+                    size_t start = std::min(skip, piece.size);
+                    skip -= start;
+                    connection.pending.append(pieceData(connection, piece) + start, piece.size - start);
+                }
+                break;
+            }
+            next += count;
+        }
+        
+        connection.pieces.clear();
+        connection.scratch.clear();
+        return true;
+    }
+    
+    bool sendPending(Connection& connection) {
+        while (!connection.pending.empty()) {
+            ssize_t sent = ::send(connection.fd, connection.pending.data(), connection.pending.size(),
+                                  MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return true;
+                }
+                close(connection);
+                return false;
+            }
+            connection.pending.erase(0, static_cast<size_t>(sent));
+        }
+        return true;
+    }
+    
+    static const char* pieceData(const Connection& connection, const Piece& piece) {
+        return piece.data ? piece.data : connection.scratch.data() + piece.offset;
+    }
+};
+
+RedirectServer::RedirectServer(UrlShortener& shortener, uint16_t port, size_t numThreads, int redirectStatus)
+    : shortener_(shortener)
+    , port_(port)
+    , numThreads_(numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency()))
+    , redirectStatus_(redirectStatus)
+    , stopFd_(-1)
+{
+    if (redirectStatus != 301 && redirectStatus != 302) {
+        throw std::invalid_argument("Redirect status must be 301 or 302");
+    }
+}
+
+RedirectServer::~RedirectServer() {
+    stop();
+}
+
+void RedirectServer::start() {
+    if (!threads_.empty()) {
+        return;
+    }
+    
+    try {
+        stopFd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (stopFd_ < 0) {
+            throw socketError("eventfd");
+        }
+        
+        // The first socket resolves port 0; the others share its port
+        for (size_t i = 0; i < numThreads_; ++i) {
+            reactors_.emplace_back(new Reactor(shortener_, redirectStatus_, stopFd_));
+            port_ = reactors_.back()->open(port_);
+        }
+    } catch (...) {
+        reactors_.clear();
+        if (stopFd_ >= 0) {
+            ::close(stopFd_);
+            stopFd_ = -1;
+        }
+        throw;
+    }
+    
+    for (auto& reactor : reactors_) {
+        threads_.emplace_back(&Reactor::run, reactor.get());
+    }
+}
+
+void RedirectServer::stop() {
+    if (threads_.empty()) {
+        return;
+    }
+    
+    uint64_t one = 1;
+    ssize_t written = ::write(stopFd_, &one, sizeof(one));
+    (void)written;
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+    reactors_.clear();
+    ::close(stopFd_);
+    stopFd_ = -1;
+}
+
+uint16_t RedirectServer::port() const {
+    return port_;
+}
@@ -0,0 +1,90 @@
+#ifndef REDIRECT_SERVER_H
+#define REDIRECT_SERVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Forward declaration
+class UrlShortener;
+
+/**
+ * HTTP Redirect Server (Linux)
+ *
+ * Minimal HTTP/1.1 front-end for a UrlShortener:
+ *   GET /<code>   302 (or 301) with the long URL in Location, 404 if unknown
+ *   HEAD /<code>  Same as GET
+ *   POST /        Body is a long URL; 201 with the short URL in Location and body,
+ *                 400 if it contains control characters (a trailing line break is dropped)
+ *
+ * One reactor per thread, each with its own SO_REUSEPORT listening socket
+ * and edge-triggered epoll set, so the kernel spreads connections over the
+ * threads and nothing is shared between them but the shortener:
+ * - Connections are kept alive (HTTP/1.1 default, or HTTP/1.0 with
+ *   "Connection: keep-alive") and requests may be pipelined. Every request
+ *   that arrived in one read is answered with a single sendmsg()
+ * - A redirect is gathered from fixed header pieces and the URL view
+ *   expand() returns, without copying the URL; only bytes the socket
+ *   doesn't take at once are copied aside. A stored URL with bytes a
+ *   header can't carry (e.g. CR or LF from a loaded file) is sent
+ *   percent-encoded instead, so it can't add headers of its own
+ * - Request heads are limited to 8KB and bodies to 64KB
+ * - Redirects (GET and HEAD) are clicks for the shortener's analytics,
+ *   if attached, with the client's IP address as the visitor
+ *
+ * The shortener's clear() and replacing loads must not run while the
+ * server is started: responses point into its storage.
+ */
+class RedirectServer {
+public:
+    /**
+     * Constructor
+     * @param shortener Shortener to serve; must outlive the server
+     * @param port TCP port to listen on (all interfaces); 0 picks a free one
+     * @param numThreads Reactor threads; 0 uses the hardware concurrency (default: 0)
+     * @param redirectStatus 302 (default), or 301 to let clients cache redirects
+     * @throws std::invalid_argument if redirectStatus is neither 301 nor 302
+     */
+    RedirectServer(UrlShortener& shortener, uint16_t port, size_t numThreads = 0, int redirectStatus = 302);
+    
+    /**
+     * Destructor; stops the server
+     */
+    ~RedirectServer();
+    
+    // Non-copyable
+    RedirectServer(const RedirectServer&) = delete;
+    RedirectServer& operator=(const RedirectServer&) = delete;
+    
+    /**
+     * Bind the listening sockets and start the reactor threads
+     * @throws std::runtime_error if a socket can't be set up
+     */
+    void start();
+    
+    /**
+     * Stop the reactor threads and close every connection
+     */
+    void stop();
+    
+    /**
+     * Get the port being listened on
+     * @return Port, resolved after start() when constructed with 0
+     */
+    uint16_t port() const;
+
+private:
+    class Reactor;
+    
+    UrlShortener& shortener_;
+    uint16_t port_;                                 // Listening port
+    size_t numThreads_;                             // Reactor count
+    int redirectStatus_;                            // 301 or 302
+    int stopFd_;                                    // eventfd that wakes every reactor to stop
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    std::vector<std::thread> threads_;
+};
+
+#endif // REDIRECT_SERVER_H
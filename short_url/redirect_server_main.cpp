@@ -0,0 +1,68 @@
+#include "redirect_server.h"
+#include "url_shortener.h"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <pthread.h>
+#include <string>
+
+/**
+ * Redirect server
+ *
+ * Usage: redirect_server [port] [threads] [data file]
+ *   port       TCP port (default: 8080)
+ *   threads    Reactor threads, 0 for one per core (default: 0)
+ *   data file  CSV file or binary snapshot (*.snap) to serve
+ *
+ * Purges expired links once a second. Runs until SIGINT or SIGTERM, then
+ * prints the most clicked codes.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        uint16_t port = argc > 1 ? static_cast<uint16_t>(std::stoi(argv[1])) : 8080;
+        size_t numThreads = argc > 2 ? std::stoul(argv[2]) : 0;
+        std::string dataFile = argc > 3 ? argv[3] : "";
+        
+        // Short URLs point back at this server
+        UrlShortener shortener("http://localhost:" + std::to_string(port) + "/");
+        ClickAnalytics analytics;
+        if (!dataFile.empty()) {
+            bool snapshot = dataFile.size() > 5 && dataFile.compare(dataFile.size() - 5, 5, ".snap") == 0;
+            bool loaded = snapshot ? shortener.loadSnapshot(dataFile) : shortener.loadFromFile(dataFile);
+            if (!loaded) {
+                std::cerr << "Cannot load " << dataFile << std::endl;
+                return 1;
+            }
+            std::cout << "Loaded " << shortener.size() << " URLs from " << dataFile << std::endl;
+        }
+        shortener.setAnalytics(&analytics);
+        
+        // Block the stop signals before the reactors start, so only sigwait() sees them
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        
+        RedirectServer server(shortener, port, numThreads);
+        server.start();
+        std::cout << "Serving on port " << server.port() << " (Ctrl+C to stop)" << std::endl;
+        
+        timespec purgeInterval = {1, 0};
+        while (sigtimedwait(&signals, nullptr, &purgeInterval) < 0) {
+            shortener.purgeExpired();
+        }
+        server.stop();
+        std::cout << "Stopped" << std::endl;
+        
+        analytics.flush();
+        for (const auto& link : shortener.getTopLinks(10)) {
+            std::cout << "  " << link.first << ": " << link.second.clicks << " clicks, ~"
+                      << link.second.uniqueVisitors << " visitors" << std::endl;
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -1,12 +1,29 @@
 #include "url_shortener.h"
+#include "csv_stream.h"
+#include "url_fingerprint.h"
 #include <iostream>
 #include <iomanip>
 #include <thread>
 #include <vector>
 #include <set>
+#include <utility>
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <cstdio>
+#include <fstream>
+#include <chrono>
+#include <string>
+#include <string_view>
+
+#ifdef __linux__
+#include "redirect_server.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
 
 // Test counter
 static int testsPassed = 0;
@@ -50,16 +67,20 @@ void testExpand() {
     std::string shortUrl = shortener.shorten(longUrl);
     
     // Extract short code (remove base URL "https://short.ly/")
-    std::string shortCode = shortUrl.substr(18);  // Remove base URL
+    std::string shortCode = shortUrl.substr(17);  // Remove base URL
     
     // Test expand with short code
-    std::string expanded = shortener.expand(shortCode);
+    std::string_view expanded = shortener.expand(shortCode);
     ASSERT(expanded == longUrl, "Expand returns original URL");
     
     // Test expandUrl with full short URL
-    std::string expanded2 = shortener.expandUrl(shortUrl);
+    std::string_view expanded2 = shortener.expandUrl(shortUrl);
     ASSERT(expanded2 == longUrl, "expandUrl returns original URL");
     
+    // Both return a view of the one stored copy, not a new string
+    ASSERT(expanded.data() == expanded2.data(), "Expand returns a view of the stored URL");
+    ASSERT(shortener.expandUrl(shortUrl + "/").data() == expanded.data(), "Trailing slash is trimmed without copying");
+    
     std::cout << std::endl;
 }
 
@@ -98,6 +119,70 @@ void testBase62Encoding() {
     std::cout << std::endl;
 }
 
+void testBase62Codec() {
+    std::cout << "\n=== Base62 Codec Test ===" << std::endl;
+    
+    // Largest value still round-trips; one more digit's worth overflows
+    uint64_t decoded = 0;
+    std::string maxCode = Base62::encode(UINT64_MAX);
+    ASSERT(maxCode == "lYGhA16ahyf", "UINT64_MAX encodes to 11 digits");
+    ASSERT(Base62::decode(maxCode, decoded) && decoded == UINT64_MAX, "UINT64_MAX round-trips");
+    ASSERT(!Base62::decode("lYGhA16ahyg", decoded), "Value one above UINT64_MAX is rejected");
+    ASSERT(!Base62::decode("ZZZZZZZZZZZ", decoded), "Largest 11-digit code is rejected");
+    ASSERT(!Base62::decode("100000000000", decoded), "Codes longer than MaxLength are rejected");
+    
+    // Fixed-width codes
+    ASSERT(Base62::encode(62, 6) == "000010", "Value is padded to the requested width");
+    ASSERT(Base62::encode(UINT64_MAX, 4) == maxCode, "Width shorter than the code is ignored");
+    ASSERT(Base62::decode("000010", decoded) && decoded == 62, "Padded code decodes to the same value");
+    
+    // Invalid input
+    ASSERT(!Base62::isValid(""), "Empty code is invalid");
+    ASSERT(!Base62::isValid("ab-c"), "Code with '-' is invalid");
+    ASSERT(!Base62::isValid(std::string("a\xff", 2)), "Code with a non-ASCII byte is invalid");
+    bool threw = false;
+    try {
+        UrlShortener::decodeBase62("abc!");
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT(threw, "decodeBase62 throws on invalid input");
+    
+    // Batch validation agrees with decode()
+    std::vector<std::string_view> codes = {"0", "Zz", "", "bad code", "lYGhA16ahyf", "lYGhA16ahyg", "000000000001"};
+    std::vector<uint8_t> valid(codes.size());
+    size_t numValid = Base62::validateBatch(codes.data(), codes.size(), valid.data());
+    bool agrees = true;
+    for (size_t i = 0; i < codes.size(); ++i) {
+        agrees = agrees && (valid[i] == 1) == Base62::isValid(codes[i]);
+    }
+    ASSERT(numValid == 3 && agrees, "Batch validation flags match decode()");
+    
+    // Encode and decode throughput
+    const uint64_t iterations = 10000000;
+    char buffer[Base62::MaxLength];
+    uint64_t checksum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        size_t length = Base62::encode(i * 0x9E3779B97F4A7C15ULL, buffer);
+        uint64_t value = 0;
+        Base62::decode(std::string_view(buffer, length), value);
+        checksum += value;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now() - start).count();
+    
+    uint64_t expected = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        expected += i * 0x9E3779B97F4A7C15ULL;
+    }
+    ASSERT(checksum == expected, "Random 64-bit values round-trip");
+    std::cout << "  " << std::fixed << std::setprecision(1)
+              << static_cast<double>(elapsed) / iterations << " ns per encode + decode" << std::endl;
+    
+    std::cout << std::endl;
+}
+
 void testMultipleUrls() {
     std::cout << "\n=== Multiple URLs Test ===" << std::endl;
     
@@ -120,7 +205,7 @@ void testMultipleUrls() {
     // Verify all can be expanded
     bool allExpanded = true;
     for (size_t i = 0; i < urls.size(); ++i) {
-        std::string expanded = shortener.expandUrl(shortUrls[i]);
+        std::string_view expanded = shortener.expandUrl(shortUrls[i]);
         if (expanded != urls[i]) {
             allExpanded = false;
             break;
@@ -144,7 +229,7 @@ void testExists() {
     std::string longUrl = "https://www.test.com";
     std::string shortUrl = shortener.shorten(longUrl);
     // Extract short code (remove base URL "https://short.ly/")
-    std::string shortCode = shortUrl.substr(18);
+    std::string shortCode = shortUrl.substr(17);
     
     ASSERT(shortener.exists(shortCode), "exists returns true for existing code");
     ASSERT(!shortener.exists("nonexistent"), "exists returns false for non-existent code");
@@ -218,7 +303,7 @@ void testSaveLoadRoundtrip() {
     // Verify all URLs match
     bool allMatch = true;
     for (size_t i = 0; i < originalUrls.size(); ++i) {
-        std::string expanded = shortener2.expandUrl(shortUrls[i]);
+        std::string_view expanded = shortener2.expandUrl(shortUrls[i]);
         if (expanded != originalUrls[i]) {
             allMatch = false;
             break;
@@ -279,11 +364,11 @@ void testInvalidInputs() {
     }
     
     // Test expand with non-existent code
-    std::string expanded = shortener.expand("nonexistent");
+    std::string_view expanded = shortener.expand("nonexistent");
     ASSERT(expanded.empty(), "expand with non-existent code returns empty");
     
     // Test expandUrl with invalid URL
-    std::string expanded2 = shortener.expandUrl("https://different.com/abc");
+    std::string_view expanded2 = shortener.expandUrl("https://different.com/abc");
     ASSERT(expanded2.empty(), "expandUrl with invalid URL returns empty");
     
     std::cout << std::endl;
@@ -328,7 +413,7 @@ void testLargeScale() {
     // Verify all can be expanded
     bool allExpanded = true;
     for (size_t i = 0; i < shortUrls.size(); ++i) {
-        std::string expanded = shortener.expandUrl(shortUrls[i]);
+        std::string_view expanded = shortener.expandUrl(shortUrls[i]);
         if (expanded.empty()) {
             allExpanded = false;
             break;
@@ -341,6 +426,761 @@ void testLargeScale() {
     std::cout << std::endl;
 }
 
+void testShortenBatch() {
+    std::cout << "\n=== Batch Shorten Test ===" << std::endl;
+    
+    UrlShortener shortener;
+    std::string existing = shortener.shorten("https://www.example.com/existing");
+    std::vector<std::string_view> batch = {
+        "https://www.example.com/a", "https://www.example.com/existing",
+        "https://www.example.com/b", "https://www.example.com/a"};
+    std::vector<std::string> shortUrls = shortener.shortenBatch(batch.data(), batch.size());
+    
+    ASSERT(shortUrls.size() == 4, "One short URL per input");
+    ASSERT(shortUrls[1] == existing, "Existing URL keeps its code");
+    ASSERT(shortUrls[0] == shortUrls[3] && shortUrls[0] != shortUrls[2], "Repeats in the batch share a code");
+    ASSERT(shortUrls[0] == "https://short.ly/2" && shortUrls[2] == "https://short.ly/3",
+           "New URLs take consecutive ids in input order");
+    ASSERT(shortener.size() == 3 && shortener.expandUrl(shortUrls[2]) == "https://www.example.com/b",
+           "Batch URLs are stored once and expand");
+    ASSERT(shortener.shorten("https://www.example.com/b") == shortUrls[2], "shorten() finds batch URLs");
+    
+    std::vector<std::string_view> invalid = {"https://www.example.com/c", ""};
+    bool threw = false;
+    try {
+        shortener.shortenBatch(invalid.data(), invalid.size());
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT(threw && !shortener.expand("4").size(), "Empty URL rejects the whole batch");
+    
+    // Bulk creation against one call per URL
+    const size_t numUrls = 200000;
+    std::vector<std::string> urls;
+    for (size_t i = 0; i < numUrls; ++i) {
+        urls.push_back("https://www.example.com/bulk/" + std::to_string(i));
+    }
+    std::vector<std::string_view> views(urls.begin(), urls.end());
+    
+    UrlShortener single;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& url : views) {
+        single.shorten(url);
+    }
+    auto singleTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    UrlShortener bulk;
+    start = std::chrono::steady_clock::now();
+    std::vector<std::string> bulkUrls = bulk.shortenBatch(views.data(), views.size());
+    auto bulkTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    ASSERT(bulk.size() == numUrls && bulk.expandUrl(bulkUrls[123456]) == urls[123456], "Bulk batch is complete");
+    std::cout << "Shortened " << numUrls << " URLs: " << singleTime << "ms one by one, "
+              << bulkTime << "ms in one batch" << std::endl;
+    std::cout << std::endl;
+}
+
+void testNonSequentialCodes() {
+    std::cout << "\n=== Non-Sequential Codes Test ===" << std::endl;
+    
+    const std::string filename = "test_urls_codes.csv";
+    {
+        std::ofstream file(filename);
+        file << "short_code,long_url\n"
+             << "5,https://www.example.com/five\n"
+             << "05,https://www.example.com/padded\n"        // Not canonical: an alias of its own
+             << "my-link,https://www.example.com/custom\n"
+             << "zzzzzzzz,https://www.example.com/huge\n";  // Beyond the id table
+    }
+    
+    UrlShortener shortener;
+    ASSERT(shortener.loadFromFile(filename), "Load codes of every kind");
+    ASSERT(shortener.size() == 4, "All 4 codes stored");
+    ASSERT(shortener.expand("5") == "https://www.example.com/five", "Generated-style code expands");
+    ASSERT(shortener.expand("05") == "https://www.example.com/padded", "Zero-padded code is distinct from \"5\"");
+    ASSERT(shortener.expand("my-link") == "https://www.example.com/custom", "Custom code expands");
+    ASSERT(shortener.expand("zzzzzzzz") == "https://www.example.com/huge", "Out-of-range code expands");
+    ASSERT(!shortener.exists("6") && !shortener.exists("my-link2"), "Unknown codes don't exist");
+    
+    // Custom and out-of-range codes don't move the sequence
+    std::string next = shortener.shorten("https://www.example.com/next");
+    ASSERT(next == "https://short.ly/6", "Next generated code follows the highest loaded id");
+    
+    std::remove(filename.c_str());
+    
+    // Expanding a generated code is a decode plus an array read
+    const int numUrls = 100000;
+    for (int i = 0; i < numUrls; ++i) {
+        shortener.shorten("https://www.example.com/bulk/" + std::to_string(i));
+    }
+    std::vector<std::string> codes;
+    for (int i = 1; i <= numUrls; ++i) {
+        codes.push_back(UrlShortener::encodeBase62(i));
+    }
+    size_t totalLength = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 10; ++round) {
+        for (const auto& code : codes) {
+            totalLength += shortener.expand(code).size();
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+    std::cout << "Expand: " << std::fixed << std::setprecision(1)
+              << static_cast<double>(elapsed) / (10.0 * numUrls) << " ns/lookup" << std::endl;
+    ASSERT(totalLength > 0, "Bulk codes expand");
+    
+    std::cout << std::endl;
+}
+
+void testScrambledCodes() {
+    std::cout << "\n=== Scrambled Codes Test ===" << std::endl;
+    
+    // Every id of a small range maps to a distinct value and back
+    IdScrambler small(12345, 16);
+    std::vector<bool> seen(1 << 16, false);
+    bool bijective = true;
+    for (uint64_t id = 0; id < (1 << 16); ++id) {
+        uint64_t value = small.scramble(id);
+        bijective = bijective && value < (1 << 16) && !seen[value] && small.unscramble(value) == id;
+        seen[value] = true;
+    }
+    ASSERT(bijective, "Scrambler is a bijection on 16-bit ids");
+    
+    bool threw = false;
+    try {
+        IdScrambler odd(1, 15);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT(threw, "Odd scrambler width is rejected");
+    
+    // 4 threads reserving blocks of 256 ids shorten 40000 URLs
+    UrlShortener shortener("https://short.ly/", 0xC0FFEE, 256);
+    const int numThreads = 4;
+    const int urlsPerThread = 10000;
+    std::vector<std::vector<std::string>> shortUrls(numThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&shortener, &shortUrls, t]() {
+            for (int i = 0; i < urlsPerThread; ++i) {
+                shortUrls[t].push_back(shortener.shorten(
+                    "https://www.example.com/scrambled/" + std::to_string(t) + "/" + std::to_string(i)));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    std::set<std::string> unique;
+    bool allExpand = true;
+    size_t maxLength = 0;
+    for (int t = 0; t < numThreads; ++t) {
+        for (int i = 0; i < urlsPerThread; ++i) {
+            const std::string& shortUrl = shortUrls[t][i];
+            unique.insert(shortUrl);
+            maxLength = std::max(maxLength, shortUrl.size() - std::string("https://short.ly/").size());
+            allExpand = allExpand && shortener.expandUrl(shortUrl) ==
+                "https://www.example.com/scrambled/" + std::to_string(t) + "/" + std::to_string(i);
+        }
+    }
+    ASSERT(unique.size() == numThreads * urlsPerThread, "Scrambled codes never collide");
+    ASSERT(allExpand, "Every scrambled code expands to its URL");
+    ASSERT(maxLength <= 6, "Scrambled codes stay within 6 characters");
+    std::cout << "  First codes of thread 0: " << shortUrls[0][0] << ", " << shortUrls[0][1]
+              << ", " << shortUrls[0][2] << std::endl;
+    ASSERT(shortUrls[0][0] != "https://short.ly/1" && shortUrls[0][1] != "https://short.ly/2",
+           "Codes are not sequential");
+    
+    // Codes survive a save/load with the same key and keep indexing the table
+    const std::string filename = "test_urls_scrambled.csv";
+    ASSERT(shortener.saveToFile(filename), "Save scrambled codes");
+    UrlShortener loaded("https://short.ly/", 0xC0FFEE, 256);
+    ASSERT(loaded.loadFromFile(filename), "Load scrambled codes");
+    ASSERT(loaded.size() == shortener.size(), "Loaded every code");
+    ASSERT(loaded.expandUrl(shortUrls[2][500]) == shortener.expandUrl(shortUrls[2][500]),
+           "Loaded code expands to the same URL");
+    std::string next = loaded.shorten("https://www.example.com/after-load");
+    ASSERT(unique.count(next) == 0 && loaded.expandUrl(next) == "https://www.example.com/after-load",
+           "New code after load doesn't reuse a loaded one");
+    std::remove(filename.c_str());
+    
+    std::cout << std::endl;
+}
+
+void testSnapshot() {
+    std::cout << "\n=== Binary Snapshot Test ===" << std::endl;
+    
+    const std::string snapshotFile = "test_urls.snap";
+    const std::string csvFile = "test_urls_snap.csv";
+    const int numUrls = 500000;
+    
+    UrlShortener shortener;
+    for (int i = 0; i < numUrls; ++i) {
+        shortener.shorten("https://www.example.com/articles/" + std::to_string(i) + "?ref=newsletter");
+    }
+    {
+        // A custom code travels in the snapshot too
+        std::ofstream file(csvFile);
+        file << "short_code,long_url\nmy-link,https://www.example.com/custom\n";
+    }
+    UrlShortener withAlias;
+    withAlias.loadFromFile(csvFile);
+    std::string aliasUrl = withAlias.shorten("https://www.example.com/after-alias");
+    ASSERT(withAlias.saveSnapshot(snapshotFile), "Save snapshot with an alias");
+    UrlShortener aliasLoaded;
+    ASSERT(aliasLoaded.loadSnapshot(snapshotFile) && aliasLoaded.expand("my-link") == "https://www.example.com/custom",
+           "Alias survives a snapshot round trip");
+    ASSERT(aliasLoaded.expandUrl(aliasUrl) == "https://www.example.com/after-alias", "Generated code survives too");
+    
+    ASSERT(shortener.saveSnapshot(snapshotFile), "Save " + std::to_string(numUrls) + " URLs to a snapshot");
+    ASSERT(shortener.saveToFile(csvFile), "Save the same URLs to CSV");
+    
+    UrlShortener fromCsv;
+    auto start = std::chrono::steady_clock::now();
+    fromCsv.loadFromFile(csvFile);
+    auto csvMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    UrlShortener fromSnapshot;
+    start = std::chrono::steady_clock::now();
+    bool loaded = fromSnapshot.loadSnapshot(snapshotFile);
+    auto snapshotMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "  Load " << numUrls << " URLs: CSV " << csvMs << "ms, snapshot " << snapshotMs << "ms" << std::endl;
+    
+    ASSERT(loaded, "Load snapshot");
+    ASSERT(fromSnapshot.size() == fromCsv.size() && fromSnapshot.size() == shortener.size(),
+           "Snapshot and CSV load the same number of URLs");
+    bool same = true;
+    for (int i = 0; i < numUrls; i += 997) {
+        std::string longUrl = "https://www.example.com/articles/" + std::to_string(i) + "?ref=newsletter";
+        std::string shortUrl = shortener.shorten(longUrl);
+        same = same && fromSnapshot.expandUrl(shortUrl) == longUrl && fromSnapshot.shorten(longUrl) == shortUrl;
+    }
+    ASSERT(same, "Snapshot restores both directions");
+    ASSERT(fromSnapshot.shorten("https://www.example.com/new") == shortener.shorten("https://www.example.com/new"),
+           "Next id is restored");
+    
+    // Flip one byte in the middle of a section
+    {
+        std::fstream file(snapshotFile, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(1000000);
+        file.put('#');
+    }
+    ASSERT(!fromSnapshot.loadSnapshot(snapshotFile), "Corrupt snapshot is rejected");
+    ASSERT(fromSnapshot.size() == shortener.size(), "Rejected load leaves the database untouched");
+    ASSERT(!fromSnapshot.loadSnapshot(csvFile), "CSV file is not mistaken for a snapshot");
+    ASSERT(!fromSnapshot.loadSnapshot("no_such_file.snap"), "Missing snapshot is rejected");
+    
+    std::remove(snapshotFile.c_str());
+    std::remove(csvFile.c_str());
+    std::cout << std::endl;
+}
+
+void testCsvStreaming() {
+    std::cout << "\n=== Streaming CSV Test ===" << std::endl;
+    
+    const std::string filename = "test_urls_quoted.csv";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << "short_code,long_url\r\n"
+             << "1,\"https://www.example.com/search?q=a,b\"\r\n"
+             << "say-hi,\"https://www.example.com/say?\"\"hi\"\"\"\n"
+             << "\"multi\nline\",https://www.example.com/multiline\n"
+             << "\n"
+             << "old-list,https://www.example.com/list?ids=1,2,3\n"
+             << "bad-line-without-url\n"
+             << "2,https://www.example.com/last";  // No trailing line break
+    }
+    
+    // A tiny buffer splits records across refills and grows for long ones
+    CsvReader reader(filename, 8);
+    std::string_view fields[2];
+    std::vector<std::pair<std::string, std::string>> records;
+    while (size_t numFields = reader.next(fields, 2)) {
+        records.emplace_back(std::string(fields[0]), numFields > 1 ? std::string(fields[1]) : "<none>");
+    }
+    ASSERT(records.size() == 8, "Reader returns every record, blank lines included");
+    ASSERT(records[1].second == "https://www.example.com/search?q=a,b", "Quoted comma stays in the field");
+    ASSERT(records[2].second == "https://www.example.com/say?\"hi\"", "Doubled quotes collapse");
+    ASSERT(records[3].first == "multi\nline", "Quoted line break stays in the field");
+    ASSERT(records[5].second == "https://www.example.com/list?ids=1,2,3", "Unquoted last field keeps its commas");
+    ASSERT(records[7].second == "https://www.example.com/last", "Last record without a line break is read");
+    
+    UrlShortener shortener;
+    ASSERT(shortener.loadFromFile(filename), "Load quoted CSV");
+    ASSERT(shortener.size() == 5, "Blank and invalid lines are skipped");
+    ASSERT(shortener.expand("say-hi") == "https://www.example.com/say?\"hi\"", "Quoted URL expands");
+    
+    // Saving quotes what needs it, so the file reads back the same
+    ASSERT(shortener.saveToFile(filename), "Save with quoting");
+    UrlShortener reloaded;
+    ASSERT(reloaded.loadFromFile(filename) && reloaded.size() == 5, "Reload quoted CSV");
+    ASSERT(reloaded.expand("multi\nline") == "https://www.example.com/multiline" &&
+           reloaded.expand("1") == "https://www.example.com/search?q=a,b", "Quoted fields round-trip");
+    
+    // Merging keeps existing mappings and adds the rest
+    {
+        std::ofstream file(filename);
+        file << "short_code,long_url\n"
+             << "1,https://www.example.com/conflict\n"
+             << "7,https://www.example.com/seven\n"
+             << "merged-in,https://www.example.com/merged\n";
+    }
+    ASSERT(reloaded.loadFromFile(filename, true), "Merge import");
+    ASSERT(reloaded.size() == 7, "Merge adds only new codes");
+    ASSERT(reloaded.expand("1") == "https://www.example.com/search?q=a,b", "Existing code keeps its URL");
+    ASSERT(reloaded.expand("merged-in") == "https://www.example.com/merged", "New code is added");
+    ASSERT(reloaded.shorten("https://www.example.com/after-merge") == "https://short.ly/8",
+           "Generated codes continue after merged ids");
+    
+    std::remove(filename.c_str());
+    std::cout << std::endl;
+}
+
+void testUrlFingerprints() {
+    std::cout << "\n=== URL Fingerprint Test ===" << std::endl;
+    
+    ASSERT(UrlFingerprint::canonicalize("HTTP://WWW.Example.COM:80") == "http://www.example.com/",
+           "Scheme and host are lowercased, default port dropped, empty path becomes /");
+    ASSERT(UrlFingerprint::canonicalize("https://Example.com:443/A%2fb%7e?q=%41#Top") ==
+           "https://example.com/A%2Fb~?q=A#Top", "Escapes are normalized, path and fragment kept");
+    ASSERT(UrlFingerprint::canonicalize("http://User@Example.com:8080?x") == "http://User@example.com:8080/?x",
+           "User info and other ports are kept");
+    ASSERT(UrlFingerprint::canonicalize("http://[::1]:80/") == "http://[::1]/", "IPv6 host keeps its colons");
+    std::string canonical = UrlFingerprint::canonicalize("Mailto:Someone@Example.com %7e");
+    ASSERT(canonical == "Mailto:Someone@Example.com ~", "URLs without an authority only get escapes normalized");
+    ASSERT(UrlFingerprint::canonicalize(canonical) == canonical, "Canonicalization is idempotent");
+    
+    std::string longUrl = "https://www.example.com/?q=" + std::string(10000, 'x');
+    ASSERT(UrlFingerprint::compute(longUrl) == UrlFingerprint::compute(std::string(longUrl)) &&
+           UrlFingerprint::compute(longUrl) != UrlFingerprint::compute(longUrl + "y"),
+           "Fingerprints are deterministic and differ for different URLs");
+    
+    // Colliding fingerprints are told apart by the matcher
+    FingerprintIndex index;
+    bool allInserted = true;
+    for (uint64_t ref = 1; ref <= 1000; ++ref) {
+        allInserted &= index.findOrInsert(42, [ref](uint64_t other) { return other == ref; },
+                                          [ref]() { return ref; }).second;
+    }
+    bool allFound = true;
+    for (uint64_t ref = 1; ref <= 1000; ++ref) {
+        allFound &= index.find(42, [ref](uint64_t other) { return other == ref; }) == ref;
+    }
+    ASSERT(allInserted && allFound && index.size() == 1000, "Entries sharing a fingerprint are all kept");
+    ASSERT(!index.findOrInsert(42, [](uint64_t other) { return other == 500; }, []() { return uint64_t(1); }).second,
+           "Insert finds the matching entry among equal fingerprints");
+    ASSERT(index.find(42, [](uint64_t) { return false; }) == 0 && index.find(0, [](uint64_t) { return true; }) == 0,
+           "Lookup without a match reports absence");
+    
+    // Sized up front, the index stays more than half full of 16-byte slots
+    FingerprintIndex sized;
+    const size_t numEntries = 150000;
+    sized.reserve(numEntries);
+    for (uint64_t ref = 1; ref <= numEntries; ++ref) {
+        sized.findOrInsert(UrlFingerprint::compute(std::to_string(ref)), [ref](uint64_t other) { return other == ref; },
+                           [ref]() { return ref; });
+    }
+    double bytesPerEntry = double(sized.memoryUsage()) / double(sized.size());
+    ASSERT(sized.size() == numEntries && bytesPerEntry < 32.0, "Reverse index stays under 32 bytes per entry");
+    std::cout << "  Reverse index: " << std::fixed << std::setprecision(1) << bytesPerEntry
+              << " bytes per URL" << std::endl;
+    
+    // Spellings of one URL share a code only when canonicalizing
+    UrlShortener plain;
+    UrlShortener canonicalizing("https://short.ly/", 0, 1, true);
+    ASSERT(plain.shorten("HTTP://Example.com") != plain.shorten("http://example.com/"), "Spellings differ by default");
+    std::string shortUrl = canonicalizing.shorten("HTTP://Example.com:80");
+    ASSERT(canonicalizing.shorten("http://example.com/") == shortUrl &&
+           canonicalizing.shortenBatch(std::vector<std::string_view>{"http://EXAMPLE.com"}.data(), 1)[0] == shortUrl,
+           "Canonical spellings share one code");
+    ASSERT(canonicalizing.expand("1") == "http://example.com/", "The canonical spelling is stored");
+    
+    // Codes outside the table are found by fingerprint too
+    const std::string filename = "test_urls_fingerprint.csv";
+    {
+        std::ofstream file(filename);
+        file << "short_code,long_url\nmy-link,https://www.example.com/custom\n";
+    }
+    ASSERT(plain.loadFromFile(filename, true), "Merge a custom code");
+    ASSERT(plain.shorten("https://www.example.com/custom") == "https://short.ly/my-link",
+           "Shortening a loaded URL returns its custom code");
+    std::remove(filename.c_str());
+    
+    std::cout << std::endl;
+}
+
+void testClickAnalytics() {
+    std::cout << "\n=== Click Analytics Test ===" << std::endl;
+    
+    // Estimates: exact-ish while sparse, within a few percent once dense
+    HyperLogLog small;
+    HyperLogLog large;
+    for (uint64_t i = 1; i <= 100000; ++i) {
+        uint64_t hash = xxh64::hash(reinterpret_cast<const char*>(&i), sizeof(i), 0);
+        if (i <= 100) {
+            small.add(hash);
+            small.add(hash);
+        }
+        large.add(hash);
+    }
+    ASSERT(small.estimate() >= 98 && small.estimate() <= 102 && small.memoryUsage() < 1024,
+           "Small sets are counted closely in a few hundred bytes");
+    ASSERT(large.estimate() > 97000 && large.estimate() < 103000 && large.memoryUsage() <= 4096,
+           "100k distinct hashes estimated within 3% in 4KB");
+    HyperLogLog merged = small;
+    merged.merge(large);
+    ASSERT(merged.estimate() == large.estimate(), "Merging a subset changes nothing");
+    
+    ClickAnalytics analytics(60, std::chrono::milliseconds(10));
+    UrlShortener shortener;
+    shortener.setAnalytics(&analytics);
+    
+    const std::string filename = "test_urls_clicks.csv";
+    {
+        std::ofstream file(filename);
+        file << "short_code,long_url\n"
+             << "1,https://www.example.com/one\n"
+             << "2,https://www.example.com/two\n"
+             << "my-link,https://www.example.com/custom\n";
+    }
+    ASSERT(shortener.loadFromFile(filename), "Load codes");
+    std::remove(filename.c_str());
+    
+    for (uint64_t visitor = 1; visitor <= 50; ++visitor) {
+        shortener.expand("1", visitor);
+        shortener.expand("1", visitor);
+    }
+    for (int i = 0; i < 30; ++i) {
+        shortener.expand("my-link", 7);
+    }
+    shortener.expand("2");
+    shortener.expandUrl("https://short.ly/2");
+    shortener.expand("unknown", 1);
+    shortener.exists("1");
+    analytics.flush();
+    
+    ClickAnalytics::ClickStats stats{};
+    ASSERT(shortener.getClickStats("1", stats) && stats.clicks == 100 && stats.uniqueVisitors == 50,
+           "Clicks and unique visitors of a generated code");
+    ASSERT(shortener.getClickStats("my-link", stats) && stats.clicks == 30 && stats.uniqueVisitors == 1,
+           "Clicks of a custom code");
+    ASSERT(shortener.getClickStats("2", stats) && stats.clicks == 2 && stats.uniqueVisitors == 0,
+           "Clicks without a visitor count no visitors");
+    ASSERT(!shortener.getClickStats("unknown", stats), "Unknown codes have no stats");
+    
+    auto top = shortener.getTopLinks(2);
+    ASSERT(top.size() == 2 && top[0].first == "1" && top[1].first == "my-link" && top[1].second.clicks == 30,
+           "Top links by clicks, custom codes named");
+    
+    auto history = shortener.getClickHistory("1");
+    uint64_t historyClicks = 0;
+    for (const auto& minute : history) {
+        historyClicks += minute.clicks;
+    }
+    ASSERT(!history.empty() && historyClicks == 100 && history.back().minute <= ClickAnalytics::currentMinute(),
+           "Minute rollups add up to the total");
+    uint64_t allClicks = 0;
+    for (const auto& minute : analytics.minutes()) {
+        allClicks += minute.clicks;
+    }
+    ASSERT(allClicks == 132, "Overall rollups count every click, and only clicks");
+    
+    // Redirect threads record without waiting; clicks a full buffer refuses are counted
+    ClickAnalytics busy(60, std::chrono::milliseconds(1), 1024);
+    shortener.setAnalytics(&busy);
+    const int numThreads = 4;
+    const int clicksPerThread = 20000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&shortener, t]() {
+            for (int i = 0; i < clicksPerThread; ++i) {
+                shortener.expand(i % 2 ? "1" : "2", static_cast<uint64_t>(t * clicksPerThread + i + 1));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    busy.flush();
+    ClickAnalytics::ClickStats one{};
+    ClickAnalytics::ClickStats two{};
+    shortener.getClickStats("1", one);
+    shortener.getClickStats("2", two);
+    std::cout << "Concurrent clicks: " << one.clicks + two.clicks << " counted, "
+              << busy.droppedClicks() << " dropped" << std::endl;
+    ASSERT(one.clicks + two.clicks + busy.droppedClicks() == uint64_t(numThreads) * clicksPerThread,
+           "Every concurrent click is counted or reported dropped");
+    
+    shortener.clear();
+    ASSERT(busy.topLinks(10).empty() && busy.minutes().empty(), "clear() also clears the analytics");
+    shortener.setAnalytics(nullptr);
+    shortener.shorten("https://www.example.com/after");
+    shortener.expand("1");
+    ASSERT(shortener.getClickStats("1", stats) && stats.clicks == 0, "Detached analytics record nothing");
+    
+    std::cout << std::endl;
+}
+
+void testLinkExpiry() {
+    std::cout << "\n=== Link Expiry and Alias Test ===" << std::endl;
+    
+    UrlShortener shortener;
+    std::string permanent = shortener.shorten("https://www.example.com/permanent");
+    
+    // Aliases are names of their own choosing, outside the generated-code space
+    ASSERT(shortener.addAlias("spring-sale", "https://www.example.com/permanent"), "Alias added");
+    ASSERT(shortener.expand("spring-sale") == "https://www.example.com/permanent", "Alias expands");
+    ASSERT(shortener.shorten("https://www.example.com/permanent") == permanent, "Alias doesn't replace the generated code");
+    ASSERT(!shortener.addAlias("spring-sale", "https://www.example.com/other"), "Taken alias is refused");
+    bool reserved = false;
+    try {
+        shortener.addAlias("abc", "https://www.example.com/other");
+    } catch (const std::invalid_argument&) {
+        reserved = true;
+    }
+    ASSERT(reserved, "Alias that a generated code could take is reserved");
+    bool invalid = false;
+    try {
+        shortener.addAlias("no spaces", "https://www.example.com/other");
+    } catch (const std::invalid_argument&) {
+        invalid = true;
+    }
+    ASSERT(invalid, "Alias with characters outside [0-9A-Za-z_-] is refused");
+    
+    // Expiring links are never deduplicated
+    std::string shortLived = shortener.shorten("https://www.example.com/flash", std::chrono::seconds(1));
+    std::string again = shortener.shorten("https://www.example.com/flash", std::chrono::seconds(1));
+    std::string longLived = shortener.shorten("https://www.example.com/flash", std::chrono::seconds(3600));
+    ASSERT(shortLived != again && again != longLived, "Each expiring link gets its own code");
+    ASSERT(shortener.addAlias("flash-sale", "https://www.example.com/flash", std::chrono::seconds(1)),
+           "Expiring alias added");
+    std::string shortLivedCode = shortLived.substr(std::string("https://short.ly/").size());
+    ASSERT(shortener.expand(shortLivedCode) == "https://www.example.com/flash" &&
+           shortener.expand("flash-sale") == "https://www.example.com/flash", "Expiring links expand before expiry");
+    
+    ClickAnalytics analytics;
+    shortener.setAnalytics(&analytics);
+    shortener.expand(shortLivedCode);
+    shortener.setAnalytics(nullptr);
+    analytics.flush();
+    ASSERT(analytics.topLinks(10).size() == 1, "Click on an expiring link recorded");
+    
+    // Expiry times are whole seconds; wait until they have passed
+    size_t sizeBefore = shortener.size();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    ASSERT(shortener.expand(shortLivedCode).empty() && shortener.expand("flash-sale").empty() &&
+           !shortener.exists("flash-sale"), "Expired links stop expanding before they are purged");
+    ASSERT(!shortener.addAlias("flash-sale", "https://www.example.com/next"), "Expired alias is taken until purged");
+    
+    shortener.setAnalytics(&analytics);
+    size_t purged = shortener.purgeExpired();
+    ASSERT(purged == 3 && shortener.size() == sizeBefore - 3, "Purge removes only the expired links");
+    ASSERT(analytics.topLinks(10).empty(), "Purge drops the clicks of removed links");
+    shortener.setAnalytics(nullptr);
+    ASSERT(shortener.purgeExpired() == 0, "Nothing left to purge");
+    ASSERT(shortener.addAlias("flash-sale", "https://www.example.com/next") &&
+           shortener.expand("flash-sale") == "https://www.example.com/next", "Purged alias can be reused");
+    ASSERT(shortener.expand(longLived.substr(std::string("https://short.ly/").size())) == "https://www.example.com/flash" &&
+           shortener.expand(permanent.substr(std::string("https://short.ly/").size())) == "https://www.example.com/permanent",
+           "Other links are untouched");
+    
+    // Expiry times survive a save and load, in CSV files and snapshots
+    const std::string filename = "test_urls_expiry.csv";
+    const std::string snapshotName = "test_urls_expiry.snap";
+    ASSERT(shortener.saveToFile(filename) && shortener.saveSnapshot(snapshotName), "Save with expiring links");
+    for (const std::string& file : {filename, snapshotName}) {
+        UrlShortener loaded;
+        bool ok = file == filename ? loaded.loadFromFile(file) : loaded.loadSnapshot(file);
+        std::string longLivedCode = longLived.substr(std::string("https://short.ly/").size());
+        ASSERT(ok && loaded.size() == shortener.size() && loaded.expand(longLivedCode) == "https://www.example.com/flash",
+               "Expiring link loaded from " + file);
+        ASSERT(loaded.shorten("https://www.example.com/flash") != longLived, "Loaded expiring link stays out of dedup");
+    }
+    {
+        std::ofstream file(filename);
+        file << "short_code,long_url,expires_at\n"
+             << "old-link,https://www.example.com/old,1000\n"
+             << "keep,\"https://www.example.com/a,b\"\n";
+    }
+    UrlShortener loaded;
+    ASSERT(loaded.loadFromFile(filename) && loaded.size() == 1 && loaded.expand("keep") == "https://www.example.com/a,b",
+           "Rows that have expired are skipped");
+    std::remove(filename.c_str());
+    std::remove(snapshotName.c_str());
+    
+    std::cout << std::endl;
+}
+
+void testConcurrentAccess() {
+    std::cout << "\n=== Concurrent Access Test ===" << std::endl;
+    
+    UrlShortener shortener;
+    
+    const int numThreads = 8;
+    const int numUrls = 5000;
+    std::vector<std::vector<std::string>> results(numThreads, std::vector<std::string>(numUrls));
+    std::atomic<bool> done(false);
+    std::atomic<int> wrongExpansions(0);
+    std::atomic<long> lookups(0);
+    
+    // Writers shorten the same URLs in different orders
+    auto writer = [&](int id) {
+        for (int n = 0; n < numUrls; ++n) {
+            int i = (n * 7 + id * 613) % numUrls;
+            results[id][i] = shortener.shorten("https://www.example.com/item/" + std::to_string(i));
+        }
+    };
+    
+    // Readers expand codes while the maps grow; a code is either missing or correct
+    auto reader = [&]() {
+        long count = 0;
+        while (!done.load()) {
+            for (int i = 1; i <= numUrls; ++i) {
+                std::string_view expanded = shortener.expand(UrlShortener::encodeBase62(i));
+                if (!expanded.empty() && expanded.compare(0, 29, "https://www.example.com/item/") != 0) {
+                    wrongExpansions++;
+                }
+                count++;
+            }
+        }
+        lookups += count;
+    };
+    
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 2; ++i) {
+        readers.emplace_back(reader);
+    }
+    std::vector<std::thread> writers;
+    for (int i = 0; i < numThreads; ++i) {
+        writers.emplace_back(writer, i);
+    }
+    for (auto& t : writers) {
+        t.join();
+    }
+    done = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+    
+    bool sameCodes = true;
+    bool allExpanded = true;
+    for (int i = 0; i < numUrls; ++i) {
+        for (int t = 1; t < numThreads; ++t) {
+            sameCodes = sameCodes && results[t][i] == results[0][i];
+        }
+        allExpanded = allExpanded &&
+            shortener.expandUrl(results[0][i]) == "https://www.example.com/item/" + std::to_string(i);
+    }
+    
+    std::cout << numThreads << " writers, " << lookups.load() << " concurrent lookups" << std::endl;
+    ASSERT(shortener.size() == numUrls, "Each URL stored once");
+    ASSERT(sameCodes, "All threads got the same short code for a URL");
+    ASSERT(allExpanded, "Every short code expands to its URL");
+    ASSERT(wrongExpansions.load() == 0, "Concurrent lookups never saw a wrong URL");
+    
+    std::cout << std::endl;
+}
+
+#ifdef __linux__
+// Send raw requests to a local port and read until the server closes
+std::string exchangeHttp(uint16_t port, const std::vector<std::string>& parts) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    timeval timeout = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return "";
+    }
+    
+    for (const auto& part : parts) {
+        send(fd, part.data(), part.size(), MSG_NOSIGNAL);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    
+    std::string reply;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        reply.append(buffer, static_cast<size_t>(n));
+    }
+    close(fd);
+    return reply;
+}
+
+void testRedirectServer() {
+    std::cout << "\n=== HTTP Redirect Server Test ===" << std::endl;
+    
+    UrlShortener shortener;
+    std::string code = shortener.shorten("https://www.example.com/served").substr(17);
+    RedirectServer server(shortener, 0, 2);
+    server.start();
+    ASSERT(server.port() != 0, "Server listens on a free port");
+    
+    // Pipelined keep-alive requests, answered in order on one connection
+    std::string reply = exchangeHttp(server.port(), {
+        "GET /" + code + " HTTP/1.1\r\nHost: test\r\n\r\n"
+        "GET /unknown HTTP/1.1\r\nHost: test\r\n\r\n"
+        "POST / HTTP/1.1\r\nContent-Length: 29\r\n\r\nhttps://www.example.com/post\n"
+        "DELETE /" + code + " HTTP/1.1\r\nConnection: close\r\n\r\n"});
+    size_t redirect = reply.find("HTTP/1.1 302 Found\r\nLocation: https://www.example.com/served\r\n");
+    size_t notFound = reply.find("HTTP/1.1 404 Not Found");
+    size_t created = reply.find("HTTP/1.1 201 Created\r\nLocation: https://short.ly/");
+    size_t notAllowed = reply.find("HTTP/1.1 405 Method Not Allowed");
+    ASSERT(redirect == 0, "GET redirects to the long URL");
+    ASSERT(notFound != std::string::npos && notFound > redirect, "Unknown code is 404");
+    ASSERT(created != std::string::npos && created > notFound, "POST shortens the body");
+    ASSERT(notAllowed != std::string::npos && notAllowed > created, "Other methods are 405");
+    ASSERT(reply.find("Connection: close") != std::string::npos, "Connection: close is honored");
+    ASSERT(shortener.expand(code).size() > 0 && shortener.size() == 2, "POSTed URL is stored");
+    
+    // A request split over several reads, on HTTP/1.0 (closed after one response)
+    reply = exchangeHttp(server.port(), {"GET /" + code + " HT", "TP/1.0\r\nHo", "st: test\r\n\r\n"});
+    ASSERT(reply.find("302 Found") != std::string::npos, "Request split across reads is answered");
+    
+    reply = exchangeHttp(server.port(), {"NOT-HTTP\r\n\r\n"});
+    ASSERT(reply.find("400 Bad Request") == 9, "Malformed request is 400");
+    
+    // A URL must not be able to add headers to the redirect
+    std::string injected = "http://a.example/\r\nSet-Cookie: pwned=1";
+    reply = exchangeHttp(server.port(), {
+        "POST / HTTP/1.1\r\nConnection: close\r\nContent-Length: " + std::to_string(injected.size()) +
+        "\r\n\r\n" + injected});
+    ASSERT(reply.find("HTTP/1.1 400 Bad Request") == 0 && shortener.size() == 2, "POST with a CR LF in the URL is 400");
+    std::string loaded = shortener.shorten(injected).substr(17);
+    reply = exchangeHttp(server.port(), {"GET /" + loaded + " HTTP/1.1\r\nConnection: close\r\n\r\n"});
+    ASSERT(reply.find("Location: http://a.example/%0D%0ASet-Cookie: pwned=1\r\n") != std::string::npos &&
+           reply.find("\r\nSet-Cookie") == std::string::npos,
+           "Stored URL with a CR LF is percent-encoded in Location");
+    
+    server.stop();
+    RedirectServer permanent(shortener, 0, 1, 301);
+    permanent.start();
+    reply = exchangeHttp(permanent.port(), {"HEAD /" + code + " HTTP/1.1\r\nConnection: close\r\n\r\n"});
+    ASSERT(reply.find("HTTP/1.1 301 Moved Permanently") == 0, "301 can be chosen");
+    
+    bool threw = false;
+    try {
+        RedirectServer invalid(shortener, 0, 1, 307);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT(threw, "Other redirect statuses are rejected");
+    
+    std::cout << std::endl;
+}
+#endif
+
 void runAllTests() {
     std::cout << "========================================" << std::endl;
     std::cout << "  URL Shortener Test Suite" << std::endl;
@@ -354,6 +1194,7 @@ void runAllTests() {
         testExpand();
         testDuplicateUrls();
         testBase62Encoding();
+        testBase62Codec();
         testMultipleUrls();
         testExists();
         testSaveAndLoad();
@@ -363,6 +1204,18 @@ void runAllTests() {
         testInvalidInputs();
         testStats();
         testLargeScale();
+        testShortenBatch();
+        testNonSequentialCodes();
+        testScrambledCodes();
+        testSnapshot();
+        testCsvStreaming();
+        testUrlFingerprints();
+        testClickAnalytics();
+        testLinkExpiry();
+#ifdef __linux__
+        testRedirectServer();
+#endif
+        testConcurrentAccess();
         
         std::cout << "\n========================================" << std::endl;
         std::cout << "Test Results:" << std::endl;
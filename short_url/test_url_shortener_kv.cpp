@@ -5,6 +5,11 @@
 #include <map>
 #include <cassert>
 #include <cstdio>
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <atomic>
 
 // Test counter
 static int testsPassed = 0;
@@ -48,7 +53,7 @@ void testExpandKV() {
     std::string shortUrl = shortener.shorten(longUrl);
     
     // Extract short code
-    std::string shortCode = shortUrl.substr(18);  // Remove base URL
+    std::string shortCode = shortUrl.substr(17);  // Remove base URL
     
     // Test expand with short code
     std::string expanded = shortener.expand(shortCode);
@@ -164,7 +169,7 @@ void testServerManagement() {
     
     // Shorten a URL and check which server it's on
     std::string shortUrl = shortener.shorten("https://www.example.com");
-    std::string shortCode = shortUrl.substr(18);
+    std::string shortCode = shortUrl.substr(17);
     std::string server = shortener.getServerForKey(shortCode);
     
     ASSERT(!server.empty(), "Server assignment works");
@@ -192,7 +197,7 @@ void testDistributedStorage() {
     for (int i = 0; i < 100; ++i) {
         std::string url = "https://www.example.com/page/" + std::to_string(i);
         std::string shortUrl = shortener.shorten(url);
-        std::string shortCode = shortUrl.substr(18);
+        std::string shortCode = shortUrl.substr(17);
         std::string server = shortener.getServerForKey(shortCode);
         serverCounts[server]++;
     }
@@ -226,6 +231,337 @@ void testEmptyAndClearKV() {
     std::cout << std::endl;
 }
 
+void testIndexSegmentsKV() {
+    std::cout << "\n=== KeyValue Store: Index Segments Test ===" << std::endl;
+    
+    const std::string filename = "test_urls_kv_segments.csv";
+    const size_t numUrls = 20000;
+    
+    // Spans many index segments, with a partial one at the end
+    UrlShortenerKV shortener;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < numUrls; ++i) {
+        shortener.shorten("https://www.example.com/item/" + std::to_string(i));
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+    std::cout << "Shortened " << numUrls << " URLs in " << elapsed << "ms" << std::endl;
+    
+    ASSERT(shortener.size() == numUrls, "Index counts every URL");
+    ASSERT(shortener.saveToFile(filename), "Save walks every index segment");
+    
+    UrlShortenerKV shortener2;
+    ASSERT(shortener2.loadFromFile(filename), "Load from file successful");
+    ASSERT(shortener2.size() == numUrls, "Loaded shortener has every URL");
+    ASSERT(shortener2.expand(shortener.shorten("https://www.example.com/item/12345").substr(17))
+           == "https://www.example.com/item/12345", "URL from a sealed segment survives the round trip");
+    ASSERT(shortener2.getServers().size() == 1, "Loading keeps the server list");
+    
+    std::remove(filename.c_str());
+    std::cout << std::endl;
+}
+
+void testShortenBatchKV() {
+    std::cout << "\n=== KeyValue Store: Batch Shorten Test ===" << std::endl;
+    
+    UrlShortenerKV shortener;
+    std::string existing = shortener.shorten("https://www.example.com/existing");
+    std::vector<std::string_view> batch = {
+        "https://www.example.com/a", "https://www.example.com/existing",
+        "https://www.example.com/b", "https://www.example.com/a"};
+    std::vector<std::string> shortUrls = shortener.shortenBatch(batch.data(), batch.size());
+    
+    ASSERT(shortUrls.size() == 4 && shortUrls[1] == existing, "Existing URL keeps its code");
+    ASSERT(shortUrls[0] == shortUrls[3] && shortUrls[0] != shortUrls[2], "Repeats in the batch share a code");
+    ASSERT(shortener.size() == 3, "Index counts each new URL once");
+    ASSERT(shortener.expandUrl(shortUrls[2]) == "https://www.example.com/b", "Batch URLs expand");
+    ASSERT(shortener.shorten("https://www.example.com/b") == shortUrls[2], "Reverse mappings are stored");
+    std::string next = shortener.shorten("https://www.example.com/after");
+    ASSERT(next != shortUrls[0] && next != shortUrls[2] && shortener.size() == 4, "Ids continue after the batch");
+    
+    // Bulk creation against one call per URL, spanning many index segments
+    const size_t numUrls = 20000;
+    std::vector<std::string> urls;
+    for (size_t i = 0; i < numUrls; ++i) {
+        urls.push_back("https://www.example.com/bulk/" + std::to_string(i));
+    }
+    std::vector<std::string_view> views(urls.begin(), urls.end());
+    
+    UrlShortenerKV single;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& url : urls) {
+        single.shorten(url);
+    }
+    auto singleTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    UrlShortenerKV bulk;
+    start = std::chrono::steady_clock::now();
+    std::vector<std::string> bulkUrls = bulk.shortenBatch(views.data(), views.size());
+    auto bulkTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    ASSERT(bulk.size() == numUrls && bulk.expandUrl(bulkUrls[12345]) == urls[12345], "Bulk batch is complete");
+    
+    const std::string filename = "test_urls_kv_batch.csv";
+    UrlShortenerKV reloaded;
+    ASSERT(bulk.saveToFile(filename) && reloaded.loadFromFile(filename) && reloaded.size() == numUrls,
+           "Batch index segments round-trip");
+    std::remove(filename.c_str());
+    
+    std::cout << "Shortened " << numUrls << " URLs: " << singleTime << "ms one by one, "
+              << bulkTime << "ms in one batch" << std::endl;
+    std::cout << std::endl;
+}
+
+void testSnapshotKV() {
+    std::cout << "\n=== KeyValue Store: Binary Snapshot Test ===" << std::endl;
+    
+    const std::string filename = "test_urls_kv.snap";
+    const size_t numUrls = 1000;
+    
+    UrlShortenerKV shortener;
+    for (size_t i = 0; i < numUrls; ++i) {
+        shortener.shorten("https://www.example.com/snap/" + std::to_string(i));
+    }
+    ASSERT(shortener.saveSnapshot(filename), "Save snapshot");
+    
+    UrlShortenerKV loaded;
+    ASSERT(loaded.loadSnapshot(filename), "Load snapshot");
+    ASSERT(loaded.size() == numUrls, "Snapshot restores every URL");
+    std::string shortUrl = shortener.shorten("https://www.example.com/snap/777");
+    ASSERT(loaded.expandUrl(shortUrl) == "https://www.example.com/snap/777", "Snapshot code expands");
+    ASSERT(loaded.shorten("https://www.example.com/snap/777") == shortUrl, "Reverse mapping is restored");
+    
+    // The snapshot keeps the store's lease boundary, past every id handed out
+    std::string fresh = loaded.shorten("https://www.example.com/snap/new");
+    ASSERT(UrlShortenerKV::decodeBase62(fresh.substr(std::string("https://short.ly/").size())) > numUrls,
+           "Next id resumes past the snapshot's ids");
+    
+    // Reloading from the store sees the index written by the bulk load
+    ASSERT(loaded.saveToFile(filename + ".csv"), "Loaded index can be walked");
+    UrlShortenerKV fromCsv;
+    ASSERT(fromCsv.loadFromFile(filename + ".csv") && fromCsv.size() == numUrls + 1,
+           "Index written by the snapshot load is complete");
+    
+    std::remove(filename.c_str());
+    std::remove((filename + ".csv").c_str());
+    std::cout << std::endl;
+}
+
+void testMergeImportKV() {
+    std::cout << "\n=== KeyValue Store: Merge Import Test ===" << std::endl;
+    
+    const std::string filename = "test_urls_kv_merge.csv";
+    UrlShortenerKV shortener;
+    std::string first = shortener.shorten("https://www.example.com/one");
+    {
+        std::ofstream file(filename);
+        file << "short_code,long_url\n"
+             << first.substr(17) << ",https://www.example.com/conflict\n"
+             << "custom,\"https://www.example.com/a,b\"\n"
+             << "z,https://www.example.com/zed\n";
+    }
+    
+    ASSERT(shortener.loadFromFile(filename, true), "Merge import");
+    ASSERT(shortener.size() == 3, "Merge adds only new codes");
+    ASSERT(shortener.expandUrl(first) == "https://www.example.com/one", "Existing code keeps its URL");
+    ASSERT(shortener.expand("custom") == "https://www.example.com/a,b", "Quoted URL is imported");
+    ASSERT(shortener.shorten("https://www.example.com/zed") == "https://short.ly/z", "Reverse mapping is merged");
+    
+    // Export runs in key order
+    ASSERT(shortener.saveToFile(filename), "Save merged database");
+    std::ifstream file(filename);
+    std::string line;
+    std::vector<std::string> lines;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    ASSERT(lines.size() == 4 && lines[2].compare(0, 7, "custom,") == 0 && lines[3].compare(0, 2, "z,") == 0,
+           "Codes are written in key order");
+    
+    std::remove(filename.c_str());
+    std::cout << std::endl;
+}
+
+void testRedirectCacheKV() {
+    std::cout << "\n=== KeyValue Store: Redirect Cache Test ===" << std::endl;
+    
+    UrlShortenerKV shortener;
+    std::string shortUrl = shortener.shorten("https://www.example.com/viral");
+    std::string code = shortUrl.substr(17);
+    for (int i = 0; i < 3; ++i) {
+        shortener.expand(code);
+    }
+    RedirectCache::Stats stats = shortener.getCacheStats();
+    ASSERT(stats.misses == 1 && stats.hits == 2, "Repeated redirects are served from the cache");
+    
+    // Unknown codes are cached until a write maps them
+    ASSERT(shortener.expand("2").empty() && shortener.expand("2").empty(), "Unknown code expands to empty");
+    ASSERT(shortener.getCacheStats().negativeHits == 1, "Unknown code is cached");
+    ASSERT(shortener.shorten("https://www.example.com/second") == "https://short.ly/2", "Next code is 2");
+    ASSERT(shortener.expand("2") == "https://www.example.com/second", "Shortening invalidates the cached miss");
+    
+    const std::string filename = "test_urls_kv_cache.csv";
+    ASSERT(shortener.expand("custom").empty(), "Custom code is unknown before import");
+    {
+        std::ofstream file(filename);
+        file << "short_code,long_url\ncustom,https://www.example.com/custom\n";
+    }
+    shortener.loadFromFile(filename, true);
+    ASSERT(shortener.expand("custom") == "https://www.example.com/custom", "Merge import invalidates the cached miss");
+    
+    // This store can't expire links, so rows that would expire aren't imported
+    {
+        std::ofstream file(filename);
+        file << "short_code,long_url,expires_at\n"
+             << "temporary,https://www.example.com/temporary,4000000000\n"
+             << "lasting,\"https://www.example.com/a,b\"\n";
+    }
+    shortener.loadFromFile(filename, true);
+    ASSERT(shortener.expand("temporary").empty() && shortener.expand("lasting") == "https://www.example.com/a,b",
+           "Expiring rows are skipped");
+    std::remove(filename.c_str());
+    
+    shortener.clear();
+    ASSERT(shortener.expand(code).empty(), "Clear drops cached URLs");
+    
+    // A small cache evicts but never serves a wrong URL
+    UrlShortenerKV small("https://short.ly/", 150, 32);
+    std::vector<std::string> codes;
+    for (int i = 0; i < 200; ++i) {
+        codes.push_back(small.shorten("https://www.example.com/page" + std::to_string(i)).substr(17));
+    }
+    bool allCorrect = true;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 200; ++i) {
+            // A few hot codes get most of the traffic
+            int index = i % 4 == 0 ? i : i % 8;
+            allCorrect &= small.expand(codes[index]) == "https://www.example.com/page" + std::to_string(index);
+        }
+    }
+    stats = small.getCacheStats();
+    ASSERT(allCorrect, "Small cache expands every code correctly");
+    ASSERT(stats.evictions > 0, "Small cache evicts");
+    ASSERT(stats.hitRatio() > 0.5, "Hot codes keep the hit ratio up");
+    std::cout << "  Hit ratio: " << std::fixed << std::setprecision(2) << stats.hitRatio()
+              << " (" << stats.evictions << " evictions)" << std::endl;
+    
+    // Concurrent redirects share the cache
+    std::atomic<int> wrong(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&small, &codes, &wrong, t]() {
+            for (int i = 0; i < 2000; ++i) {
+                int index = (i * 7 + t) % 16;
+                if (small.expand(codes[index]) != "https://www.example.com/page" + std::to_string(index)) {
+                    wrong++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT(wrong == 0, "Concurrent redirects expand correctly");
+    
+    UrlShortenerKV uncached("https://short.ly/", 150, 0);
+    uncached.shorten("https://www.example.com/uncached");
+    ASSERT(uncached.expand("1") == "https://www.example.com/uncached", "Disabled cache still expands");
+    ASSERT(uncached.getCacheStats().hitRatio() == 0.0, "Disabled cache counts nothing");
+    
+    std::cout << std::endl;
+}
+
+void testFingerprintDedupKV() {
+    std::cout << "\n=== KeyValue Store: Fingerprint Dedup Test ===" << std::endl;
+    
+    UrlShortenerKV plain;
+    ASSERT(plain.shorten("https://www.example.com/a") == plain.shorten("https://www.example.com/a"),
+           "Same URL is found by its fingerprint");
+    ASSERT(plain.shorten("HTTPS://www.example.com/a") != plain.shorten("https://www.example.com/a"),
+           "Spellings differ by default");
+    
+    UrlShortenerKV canonicalizing("https://short.ly/", 150, 8192, true);
+    std::string shortUrl = canonicalizing.shorten("HTTPS://WWW.Example.com:443");
+    std::vector<std::string_view> batch = {"https://www.example.com/", "https://www.example.com/%7Euser",
+                                           "https://WWW.example.com/~user"};
+    std::vector<std::string> shortUrls = canonicalizing.shortenBatch(batch.data(), batch.size());
+    ASSERT(shortUrls[0] == shortUrl && shortUrls[1] == shortUrls[2], "Canonical spellings share one code");
+    ASSERT(canonicalizing.expand("1") == "https://www.example.com/", "The canonical spelling is stored");
+    size_t totalUrls;
+    size_t totalCodes;
+    canonicalizing.getStats(totalUrls, totalCodes);
+    ASSERT(totalUrls == 2, "One reverse entry per distinct URL");
+    
+    // Imported codes are found by fingerprint, and survive a snapshot round trip
+    const std::string filename = "test_urls_kv_fingerprint.csv";
+    const std::string snapshotFile = "test_urls_kv_fingerprint.snap";
+    {
+        std::ofstream file(filename);
+        file << "short_code,long_url\nmy-link,https://www.example.com/custom\nagain,https://www.example.com/custom\n";
+    }
+    ASSERT(plain.loadFromFile(filename, true), "Merge custom codes");
+    ASSERT(plain.shorten("https://www.example.com/custom") == "https://short.ly/my-link",
+           "Shortening a loaded URL returns its first code");
+    ASSERT(plain.saveSnapshot(snapshotFile), "Save snapshot");
+    UrlShortenerKV restored;
+    ASSERT(restored.loadSnapshot(snapshotFile) &&
+           restored.shorten("https://www.example.com/a") == plain.shorten("https://www.example.com/a"),
+           "Restored reverse entries dedup");
+    std::remove(filename.c_str());
+    std::remove(snapshotFile.c_str());
+    
+    std::cout << std::endl;
+}
+
+void testIdLeasingKV() {
+    std::cout << "\n=== KeyValue Store: Id Leasing Test ===" << std::endl;
+    
+    // Leases of 4 ids; the store's counter is advanced once per lease
+    UrlShortenerKV shortener("https://short.ly/", 150, 8192, false, 4);
+    const std::string base = "https://short.ly/";
+    auto idOf = [&base](const std::string& shortUrl) {
+        return UrlShortenerKV::decodeBase62(shortUrl.substr(base.size()));
+    };
+    
+    bool sequential = true;
+    for (uint64_t i = 1; i <= 10; ++i) {
+        sequential = sequential && idOf(shortener.shorten("https://www.example.com/lease/" + std::to_string(i))) == i;
+    }
+    ASSERT(sequential, "Consecutive leases hand out ids in order");
+    
+    std::vector<std::string> urls;
+    for (int i = 0; i < 9; ++i) {
+        urls.push_back("https://www.example.com/lease/batch/" + std::to_string(i));
+    }
+    std::vector<std::string_view> views(urls.begin(), urls.end());
+    std::vector<std::string> batch = shortener.shortenBatch(views.data(), views.size());
+    ASSERT(idOf(batch.front()) == 11 && idOf(batch.back()) == 19, "A batch larger than a lease gets consecutive ids");
+    
+    // Ids taken by loaded codes are never leased again
+    const std::string filename = "test_urls_kv_lease.csv";
+    {
+        std::ofstream file(filename);
+        file << "short_code,long_url\nZZ,https://www.example.com/lease/loaded\n";
+    }
+    ASSERT(shortener.loadFromFile(filename, true), "Merge a code past the lease");
+    uint64_t loadedId = UrlShortenerKV::decodeBase62("ZZ");
+    ASSERT(idOf(shortener.shorten("https://www.example.com/lease/after")) > loadedId, "Leasing resumes past loaded ids");
+    std::remove(filename.c_str());
+    
+    bool threw = false;
+    try {
+        UrlShortenerKV invalid("https://short.ly/", 150, 8192, false, 0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT(threw, "Id block size 0 is rejected");
+    
+    std::cout << std::endl;
+}
+
 void runAllKVTests() {
     std::cout << "========================================" << std::endl;
     std::cout << "  URL Shortener (KeyValue Store) Tests" << std::endl;
@@ -243,6 +579,13 @@ void runAllKVTests() {
         testServerManagement();
         testDistributedStorage();
         testEmptyAndClearKV();
+        testIndexSegmentsKV();
+        testShortenBatchKV();
+        testSnapshotKV();
+        testMergeImportKV();
+        testRedirectCacheKV();
+        testFingerprintDedupKV();
+        testIdLeasingKV();
         
         std::cout << "\n========================================" << std::endl;
         std::cout << "Test Results:" << std::endl;
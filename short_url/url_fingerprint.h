@@ -0,0 +1,164 @@
+#ifndef URL_FINGERPRINT_H
+#define URL_FINGERPRINT_H
+
+#include "xxh64.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * URL Fingerprints
+ *
+ * Helpers for the shorteners' reverse (URL -> code) indexes, which key
+ * by a 64-bit fingerprint instead of the URL itself:
+ * - compute() is xxh64, so fingerprints are the same across processes and
+ *   builds and may be persisted (UrlShortenerKV stores them as keys)
+ * - canonicalize() applies the syntax-based normalizations of RFC 3986
+ *   (6.2.2) that never change what a URL refers to, so spellings of the
+ *   same URL can share one short code
+ *
+ * A fingerprint only selects candidates: equal fingerprints don't imply
+ * equal URLs, and callers confirm a match against the stored URL.
+ */
+class UrlFingerprint {
+public:
+    /**
+     * Fingerprint a URL
+     * @param url URL, as stored (canonicalize first if the index does)
+     * @return 64-bit fingerprint
+     */
+    static uint64_t compute(std::string_view url) {
+        // Chained over 4KB blocks; xxh64 recurses per 32 bytes
+        uint64_t hash = Seed;
+        for (size_t offset = 0; offset < url.size(); offset += BlockSize) {
+            hash = xxh64::hash(url.data() + offset, std::min(BlockSize, url.size() - offset), hash);
+        }
+        return hash;
+    }
+    
+    /**
+     * Normalize a URL's spelling
+     *
+     * For "scheme://authority..." URLs the scheme and host are lowercased
+     * (user info is left alone), an empty or default port (80 for http, 443
+     * for https) is dropped, and an empty path becomes "/". Anywhere in the
+     * URL, percent-escapes of unreserved characters (letters, digits, "-._~")
+     * are decoded and the others get uppercase hex digits. Paths are
+     * otherwise kept as they are: "." segments, query order and fragments
+     * may all be significant to the server.
+     * @param url URL to normalize
+     * @return Canonical spelling; idempotent
+     */
+    static std::string canonicalize(std::string_view url) {
+        std::string result;
+        result.reserve(url.size() + 1);
+        
+        size_t pos = 0;
+        size_t schemeEnd = url.find("://");
+        if (schemeEnd != std::string_view::npos && isScheme(url.substr(0, schemeEnd))) {
+            appendLower(result, url.substr(0, schemeEnd));
+            std::string scheme = result;
+            result += "://";
+            
+            size_t authorityEnd = std::min(url.find_first_of("/?#", schemeEnd + 3), url.size());
+            std::string_view host = url.substr(schemeEnd + 3, authorityEnd - schemeEnd - 3);
+            size_t at = host.rfind('@');
+            if (at != std::string_view::npos) {
+                appendEscaped(result, host.substr(0, at + 1));
+                host.remove_prefix(at + 1);
+            }
+            
+            // A colon inside an IPv6 literal ("[::1]") isn't a port separator
+            std::string_view port;
+            size_t colon = host.rfind(':');
+            if (colon != std::string_view::npos && host.find(']', colon) == std::string_view::npos) {
+                port = host.substr(colon + 1);
+                host = host.substr(0, colon);
+            }
+            appendLower(result, host);
+            if (!port.empty() && !(scheme == "http" && port == "80") && !(scheme == "https" && port == "443")) {
+                result += ':';
+                result.append(port.data(), port.size());
+            }
+            
+            pos = authorityEnd;
+            if (pos == url.size() || url[pos] != '/') {
+                result += '/';
+            }
+        }
+        
+        appendEscaped(result, url.substr(pos));
+        return result;
+    }
+
+private:
+    static constexpr uint64_t Seed = 0x75726c6670ULL;   // "urlfp"
+    static constexpr size_t BlockSize = 4096;
+    
+    // RFC 3986: ALPHA *( ALPHA / DIGIT / "+" / "-" / "." )
+    static bool isScheme(std::string_view scheme) {
+        if (scheme.empty() || !isAlpha(scheme[0])) {
+            return false;
+        }
+        for (char c : scheme) {
+            if (!isAlpha(c) && !(c >= '0' && c <= '9') && c != '+' && c != '-' && c != '.') {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    static bool isAlpha(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+    
+    static bool isUnreserved(char c) {
+        return isAlpha(c) || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_' || c == '~';
+    }
+    
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+    
+    static void appendLower(std::string& out, std::string_view text) {
+        for (char c : text) {
+            out += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+    }
+    
+    static void appendEscaped(std::string& out, std::string_view text) {
+        static constexpr char HexDigits[] = "0123456789ABCDEF";
+        for (size_t i = 0; i < text.size(); ++i) {
+            int high;
+            int low;
+            if (text[i] != '%' || i + 2 >= text.size() || (high = hexValue(text[i + 1])) < 0 ||
+                (low = hexValue(text[i + 2])) < 0) {
+                out += text[i];
+                continue;
+            }
+            
+            char decoded = static_cast<char>(high * 16 + low);
+            if (isUnreserved(decoded)) {
+                out += decoded;
+            } else {
+                out += '%';
+                out += HexDigits[high];
+                out += HexDigits[low];
+            }
+            i += 2;
+        }
+    }
+};
+
+#endif // URL_FINGERPRINT_H
@@ -0,0 +1,211 @@
+#ifndef URL_PAGE_TABLE_H
+#define URL_PAGE_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+/**
+ * Paged URL Table
+ *
+ * Dense array of URLs indexed directly by numeric short code id, for ids
+ * handed out sequentially. Lookup is two dependent loads (directory entry,
+ * then slot) with no hashing and no locks; a slot costs 16 bytes, an
+ * optional expiry time included.
+ *
+ * - Pages of PageSize slots are allocated on first write, so sparse id
+ *   ranges only pay for the pages they touch
+ * - Slots hold views of URLs owned elsewhere (an arena); they are
+ *   published with a release store and read with an acquire load
+ * - Each id is written at most once. Writers never block each other: page
+ *   allocation and writers racing for one id are settled with compare-exchange
+ * - An erased id reads as unused but is never handed out again, so a
+ *   reader racing the erase sees either the whole entry or nothing
+ *
+ * clear() must not run concurrently with any other call.
+ */
+class UrlPageTable {
+public:
+    static constexpr unsigned PageBits = 16;
+    static constexpr unsigned DirectoryBits = 16;
+    static constexpr uint64_t PageSize = uint64_t(1) << PageBits;
+    static constexpr uint64_t Capacity = uint64_t(1) << (PageBits + DirectoryBits);  // Ids below this fit
+    
+    UrlPageTable()
+        : directory_(new std::atomic<Page*>[DirectorySize])
+        , size_(0)
+    {
+        for (size_t i = 0; i < DirectorySize; ++i) {
+            directory_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+    
+    ~UrlPageTable() {
+        clear();
+    }
+    
+    // Non-copyable
+    UrlPageTable(const UrlPageTable&) = delete;
+    UrlPageTable& operator=(const UrlPageTable&) = delete;
+    
+    /**
+     * Look up an id without locking
+     * @param id Short code id, below Capacity
+     * @return View of the URL, or an empty view if the id is unused
+     */
+    std::string_view get(uint64_t id) const {
+        uint32_t expiresAt;
+        return get(id, expiresAt);
+    }
+    
+    /**
+     * Look up an id and its expiry time without locking
+     * @param id Short code id, below Capacity
+     * @param expiresAt Output: expiry time given to set(), 0 if none; set if found
+     * @return View of the URL, or an empty view if the id is unused
+     */
+    std::string_view get(uint64_t id, uint32_t& expiresAt) const {
+        const Page* page = directory_[id >> PageBits].load(std::memory_order_acquire);
+        if (!page) {
+            return std::string_view();
+        }
+        
+        const Slot& slot = page->slots[id & (PageSize - 1)];
+        const char* data = slot.data.load(std::memory_order_acquire);
+        if (!isStored(data)) {
+            return std::string_view();
+        }
+        expiresAt = slot.expiresAt;
+        return std::string_view(data, slot.length);
+    }
+    
+    /**
+     * Store the URL for an unused id
+     * @param id Short code id, below Capacity
+     * @param url Non-empty URL, shorter than 4GB; the table keeps the view, not a copy
+     * @param expiresAt Expiry time kept with the URL (the table doesn't interpret it), 0 for none
+     * @return true if stored, false if the id was already in use
+     */
+    bool set(uint64_t id, std::string_view url, uint32_t expiresAt = 0) {
+        std::atomic<Page*>& entry = directory_[id >> PageBits];
+        Page* page = entry.load(std::memory_order_acquire);
+        if (!page) {
+            Page* fresh = new Page();
+            if (entry.compare_exchange_strong(page, fresh, std::memory_order_acq_rel)) {
+                page = fresh;
+            } else {
+                delete fresh;  // Another writer installed the page first
+            }
+        }
+        
+        // Claim the slot first, so the length is only written by the winner
+        Slot& slot = page->slots[id & (PageSize - 1)];
+        const char* expected = nullptr;
+        if (slot.data.load(std::memory_order_relaxed) ||
+            !slot.data.compare_exchange_strong(expected, claimed(), std::memory_order_relaxed)) {
+            return false;
+        }
+        slot.length = static_cast<uint32_t>(url.size());
+        slot.expiresAt = expiresAt;
+        slot.data.store(url.data(), std::memory_order_release);
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    /**
+     * Remove the URL of an id. The id stays taken: set() refuses it.
+     * @param id Short code id, below Capacity
+     * @return true if a URL was removed, false if the id was unused
+     */
+    bool erase(uint64_t id) {
+        Page* page = directory_[id >> PageBits].load(std::memory_order_acquire);
+        if (!page) {
+            return false;
+        }
+        
+        std::atomic<const char*>& data = page->slots[id & (PageSize - 1)].data;
+        const char* expected = data.load(std::memory_order_relaxed);
+        while (isStored(expected)) {
+            if (data.compare_exchange_weak(expected, erased(), std::memory_order_relaxed)) {
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * Get the number of ids in use
+     * @return Number of stored URLs
+     */
+    size_t size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * Call fn(id, url, expiresAt) for every stored URL, in id order
+     * @param fn Callable taking (uint64_t, std::string_view, uint32_t)
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (size_t d = 0; d < DirectorySize; ++d) {
+            const Page* page = directory_[d].load(std::memory_order_acquire);
+            if (!page) {
+                continue;
+            }
+            for (uint64_t i = 0; i < PageSize; ++i) {
+                const Slot& slot = page->slots[i];
+                const char* data = slot.data.load(std::memory_order_acquire);
+                if (isStored(data)) {
+                    fn((uint64_t(d) << PageBits) | i, std::string_view(data, slot.length), slot.expiresAt);
+                }
+            }
+        }
+    }
+    
+    /**
+     * Remove every URL and free the pages. Not safe while other threads use the table.
+     */
+    void clear() {
+        for (size_t i = 0; i < DirectorySize; ++i) {
+            delete directory_[i].exchange(nullptr, std::memory_order_relaxed);
+        }
+        size_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<const char*> data{nullptr};     // URL bytes; null while the id is unused
+        uint32_t length = 0;                        // Written before data is published
+        uint32_t expiresAt = 0;                     // Likewise
+    };
+    
+    struct Page {
+        Slot slots[PageSize];
+    };
+    
+    static constexpr size_t DirectorySize = size_t(1) << DirectoryBits;
+    
+    // Placeholder data of a slot whose writer hasn't published the URL yet
+    static const char* claimed() {
+        static const char marker = 0;
+        return &marker;
+    }
+    
+    // Data of an erased slot, never claimed again
+    static const char* erased() {
+        static const char marker = 0;
+        return &marker;
+    }
+    
+    static bool isStored(const char* data) {
+        return data && data != claimed() && data != erased();
+    }
+    
+    std::unique_ptr<std::atomic<Page*>[]> directory_;   // Page per PageSize ids, allocated on demand
+    std::atomic<size_t> size_;                          // Number of ids in use
+};
+
+#endif // URL_PAGE_TABLE_H
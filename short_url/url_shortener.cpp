@@ -1,224 +1,721 @@
 #include "url_shortener.h"
+#include "url_fingerprint.h"
+#include "url_snapshot.h"
+#include "csv_stream.h"
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
 
-// Base62 character set: 0-9, a-z, A-Z
-static const char BASE62_CHARS[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
-static const int BASE62 = 62;
+namespace {
 
-UrlShortener::UrlShortener(const std::string& baseUrl)
+// 62^6 > UrlPageTable::Capacity, so longer codes can't index the table
+constexpr size_t MAX_TABLE_CODE_LENGTH = 6;
+
+// Scrambled ids stay within the table's id range
+constexpr unsigned TABLE_ID_BITS = UrlPageTable::PageBits + UrlPageTable::DirectoryBits;
+
+// Tags reverse index references that hold a table id; other references are
+// addresses, which leave the top bit clear
+constexpr uint64_t TABLE_REF = uint64_t(1) << 63;
+
+// Source of UrlShortener generations; never reused, so a thread's reserved
+// block can't be mistaken for one from another instance or before clear()
+std::atomic<uint64_t> nextGeneration(1);
+
+struct IdBlock {
+    uint64_t generation = 0;    // Generation the block was reserved in
+    uint64_t next = 0;          // Next id to hand out
+    uint64_t end = 0;           // One past the last reserved id
+};
+
+// Code of a hash map entry, stored as a 32-bit length and the characters
+std::string_view recordCode(const char* record) {
+    uint32_t length;
+    std::memcpy(&length, record, sizeof(length));
+    return std::string_view(record + sizeof(length), length);
+}
+
+// Seconds since the Unix epoch, the unit of expiry times
+uint32_t currentTime() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(now).count());
+}
+
+bool isExpired(uint32_t expiresAt) {
+    return expiresAt != 0 && currentTime() >= expiresAt;
+}
+
+uint32_t expiryTime(std::chrono::seconds ttl) {
+    if (ttl.count() <= 0) {
+        throw std::invalid_argument("TTL must be positive");
+    }
+    uint64_t expiresAt = uint64_t(currentTime()) + static_cast<uint64_t>(ttl.count());
+    if (expiresAt > UINT32_MAX) {
+        throw std::invalid_argument("TTL is too long");
+    }
+    return static_cast<uint32_t>(expiresAt);
+}
+
+// Parses an expiry time written by saveToFile()
+bool parseExpiry(std::string_view text, uint32_t& expiresAt) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), expiresAt);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// Soonest expiry on top of the expiry heap
+template <typename Expiry>
+bool expiresLater(const Expiry& a, const Expiry& b) {
+    return a.expiresAt > b.expiresAt;
+}
+
+} // namespace
+
+UrlShortener::UrlShortener(const std::string& baseUrl, uint64_t scrambleKey, size_t idBlockSize,
+                           bool canonicalizeUrls)
     : baseUrl_(baseUrl)
     , nextId_(1)  // Start from 1, 0 encodes to "0"
+    , idBlockSize_(idBlockSize)
+    , generation_(nextGeneration.fetch_add(1))
+    , canonicalizeUrls_(canonicalizeUrls)
+    , analytics_(nullptr)
 {
     if (baseUrl.empty()) {
         throw std::invalid_argument("Base URL cannot be empty");
     }
+    if (idBlockSize == 0) {
+        throw std::invalid_argument("Id block size must be positive");
+    }
+    if (scrambleKey != 0) {
+        scrambler_.emplace(scrambleKey, TABLE_ID_BITS);
+    }
 }
 
-std::string UrlShortener::shorten(const std::string& longUrl) {
+std::string UrlShortener::shorten(std::string_view longUrl) {
     if (longUrl.empty()) {
         throw std::invalid_argument("Long URL cannot be empty");
     }
     
+    std::string canonical;
+    std::string_view url = storedForm(longUrl, canonical);
+    uint64_t fingerprint = UrlFingerprint::compute(url);
+    auto matches = [this, url](uint64_t ref) { return urlOf(ref) == url; };
+    
     // Check if URL already exists
-    auto it = reverseMap_.find(longUrl);
-    if (it != reverseMap_.end()) {
-        // URL already shortened, return existing short URL
-        return baseUrl_ + it->second;
+    uint64_t ref = reverseIndex_.find(fingerprint, matches);
+    if (ref == 0) {
+        // Generate new short code unless another thread shortened the same
+        // URL first. The code is mapped before reverseIndex_ publishes it,
+        // so any thread that sees the code can expand it.
+        ref = reverseIndex_.findOrInsert(fingerprint, matches, [this, url]() {
+            return generateShortCode(storeString(url));
+        }).first;
     }
     
-    // Generate new short code
-    std::string shortCode = generateShortCode();
+    return shortUrlOf(ref);
+}
+
+std::vector<std::string> UrlShortener::shortenBatch(const std::string_view* longUrls, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (longUrls[i].empty()) {
+            throw std::invalid_argument("Long URL cannot be empty");
+        }
+    }
     
-    // Store mapping
-    urlMap_[shortCode] = longUrl;
-    reverseMap_[longUrl] = shortCode;
+    // Grow the reverse index once and take a block of ids up front
+    reverseIndex_.reserve(reverseIndex_.size() + count);
+    const uint64_t firstId = nextId_.fetch_add(count);
+    uint64_t id = firstId;
     
-    return baseUrl_ + shortCode;
+    // One probe per URL: the reverse index finds existing URLs, including
+    // repeats earlier in the batch, and inserts the rest with the next id
+    std::vector<std::string> shortUrls(count);
+    std::string canonical;
+    for (size_t i = 0; i < count; ++i) {
+        std::string_view url = storedForm(longUrls[i], canonical);
+        auto matches = [this, url](uint64_t ref) { return urlOf(ref) == url; };
+        uint64_t ref = reverseIndex_.findOrInsert(UrlFingerprint::compute(url), matches, [this, url, &id]() {
+            std::string_view storedUrl = storeString(url);
+            uint64_t codeRef;
+            char code[Base62::MaxLength];
+            if (!insertShortCode(std::string_view(code, encodeTableId(id++, code)), storedUrl, codeRef)) {
+                codeRef = generateShortCode(storedUrl);  // Id taken by a loaded code
+            }
+            return codeRef;
+        }).first;
+        shortUrls[i] = shortUrlOf(ref);
+    }
+    
+    // Hand back the ids repeats didn't use, unless other threads took ids since
+    uint64_t blockEnd = firstId + count;
+    nextId_.compare_exchange_strong(blockEnd, id);
+    return shortUrls;
 }
 
-std::string UrlShortener::expand(const std::string& shortCode) {
-    if (shortCode.empty()) {
-        return "";
+std::string UrlShortener::shorten(std::string_view longUrl, std::chrono::seconds ttl) {
+    if (longUrl.empty()) {
+        throw std::invalid_argument("Long URL cannot be empty");
+    }
+    uint32_t expiresAt = expiryTime(ttl);
+    
+    std::string canonical;
+    std::string_view url = storedForm(longUrl, canonical);
+    char code[Base62::MaxLength];
+    size_t length;
+    do {
+        length = encodeTableId(takeId(), code);
+    } while (!insertExpiring(std::string_view(code, length), url, expiresAt));
+    
+    return baseUrl_ + std::string(code, length);
+}
+
+bool UrlShortener::addAlias(std::string_view alias, std::string_view longUrl, std::chrono::seconds ttl) {
+    if (longUrl.empty()) {
+        throw std::invalid_argument("Long URL cannot be empty");
+    }
+    if (alias.empty() || alias.size() > MaxAliasLength) {
+        throw std::invalid_argument("Alias must be 1 to " + std::to_string(MaxAliasLength) + " characters");
+    }
+    for (char c : alias) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+            throw std::invalid_argument("Alias may only contain letters, digits, '-' and '_'");
+        }
+    }
+    uint64_t id;
+    if (decodeTableId(alias, id)) {
+        throw std::invalid_argument("Alias is reserved for generated codes");
+    }
+    if (ttl.count() < 0) {
+        throw std::invalid_argument("TTL cannot be negative");
+    }
+    
+    std::string canonical;
+    std::string_view url = storedForm(longUrl, canonical);
+    if (ttl.count() > 0) {
+        return insertExpiring(alias, url, expiryTime(ttl));
+    }
+    
+    // Unlike loaded codes, an alias doesn't enter the reverse index
+    uint64_t ref;
+    return insertShortCode(alias, storeString(url), ref);
+}
+
+size_t UrlShortener::purgeExpired() {
+    std::vector<uint64_t> links;
+    {
+        std::lock_guard<std::mutex> lock(expiryMutex_);
+        auto now = std::chrono::steady_clock::now();
+        while (!retired_.empty() && now - retired_.front().removedAt >= ReclaimDelay) {
+            retired_.pop_front();
+        }
+        
+        uint32_t time = currentTime();
+        while (!expiries_.empty() && expiries_.front().expiresAt <= time) {
+            std::pop_heap(expiries_.begin(), expiries_.end(), expiresLater<Expiry>);
+            Retired retired{now, std::move(expiries_.back().record), {}};
+            expiries_.pop_back();
+            
+            // Readers that found the link before it expired may still use it
+            std::string_view code = recordCode(retired.record.get());
+            uint64_t id;
+            if (decodeTableId(code, id)) {
+                urlTable_.erase(id);
+                links.push_back(TABLE_REF | id);
+            } else {
+                links.push_back(reinterpret_cast<uintptr_t>(aliasMap_.find(code)));
+                retired.entry = aliasMap_.erase(code);
+            }
+            retired_.push_back(std::move(retired));
+        }
+    }
+    
+    ClickAnalytics* analytics = analytics_.load(std::memory_order_acquire);
+    if (analytics && !links.empty()) {
+        analytics->remove(links.data(), links.size());
+    }
+    return links.size();
+}
+
+std::string_view UrlShortener::expand(std::string_view shortCode) const {
+    return expand(shortCode, 0);
+}
+
+std::string_view UrlShortener::expand(std::string_view shortCode, uint64_t visitor) const {
+    uint64_t link;
+    std::string_view longUrl = lookup(shortCode, link);
+    if (!longUrl.empty()) {
+        ClickAnalytics* analytics = analytics_.load(std::memory_order_acquire);
+        if (analytics) {
+            analytics->record(link, visitor);
+        }
+    }
+    return longUrl;
+}
+
+std::string_view UrlShortener::lookup(std::string_view shortCode, uint64_t& link) const {
+    // Generated codes index the table directly; only other codes are hashed
+    uint64_t id;
+    if (decodeTableId(shortCode, id)) {
+        uint32_t expiresAt = 0;
+        std::string_view longUrl = urlTable_.get(id, expiresAt);
+        if (isExpired(expiresAt)) {
+            return std::string_view();
+        }
+        link = TABLE_REF | id;
+        return longUrl;
     }
     
-    auto it = urlMap_.find(shortCode);
-    if (it != urlMap_.end()) {
-        return it->second;
+    const StoredUrl* entry = aliasMap_.find(shortCode);
+    if (entry && !isExpired(entry->expiresAt)) {
+        link = reinterpret_cast<uintptr_t>(entry);
+        return entry->url;
     }
     
-    return "";
+    return std::string_view();
 }
 
-std::string UrlShortener::expandUrl(const std::string& shortUrl) {
-    std::string shortCode = extractShortCode(shortUrl);
+std::string_view UrlShortener::expandUrl(std::string_view shortUrl) const {
+    std::string_view shortCode = extractShortCode(shortUrl);
     if (shortCode.empty()) {
-        return "";
+        return std::string_view();
     }
     
     return expand(shortCode);
 }
 
-bool UrlShortener::exists(const std::string& shortCode) const {
-    return urlMap_.find(shortCode) != urlMap_.end();
+bool UrlShortener::exists(std::string_view shortCode) const {
+    uint64_t link;
+    return !lookup(shortCode, link).empty();
 }
 
 size_t UrlShortener::size() const {
-    return urlMap_.size();
+    return urlTable_.size() + aliasMap_.size();
 }
 
 bool UrlShortener::empty() const {
-    return urlMap_.empty();
+    return size() == 0;
 }
 
 void UrlShortener::clear() {
-    urlMap_.clear();
-    reverseMap_.clear();
+    urlTable_.clear();
+    aliasMap_.clear();
+    reverseIndex_.clear();
+    strings_.clear();
     nextId_ = 1;
+    generation_ = nextGeneration.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(expiryMutex_);
+        expiries_.clear();
+        retired_.clear();
+    }
+    
+    // Ids restart and alias entries are freed, so old clicks would land on new codes
+    ClickAnalytics* analytics = analytics_.load(std::memory_order_acquire);
+    if (analytics) {
+        analytics->clear();
+    }
 }
 
 bool UrlShortener::saveToFile(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
+    CsvWriter writer(filename);
+    if (!writer.isOpen()) {
         return false;
     }
     
-    // Write CSV header
-    file << "short_code,long_url\n";
+    // Write CSV header; links that don't expire leave out the last column
+    writer.write("short_code", "long_url", "expires_at");
     
-    // Write all mappings
-    for (const auto& pair : urlMap_) {
-        file << pair.first << "," << pair.second << "\n";
-    }
+    // Write all live mappings, generated codes in id order
+    auto write = [&writer](std::string_view shortCode, std::string_view longUrl, uint32_t expiresAt) {
+        if (expiresAt == 0) {
+            writer.write(shortCode, longUrl);
+        } else if (!isExpired(expiresAt)) {
+            writer.write(shortCode, longUrl, std::to_string(expiresAt));
+        }
+    };
+    urlTable_.forEach([this, &write](uint64_t id, std::string_view longUrl, uint32_t expiresAt) {
+        char code[Base62::MaxLength];
+        write(std::string_view(code, encodeTableId(id, code)), longUrl, expiresAt);
+    });
+    aliasMap_.forEach([&write](std::string_view shortCode, const StoredUrl& entry) {
+        write(shortCode, entry.url, entry.expiresAt);
+    });
     
-    file.close();
-    return file.good();
+    return writer.finish();
 }
 
-bool UrlShortener::loadFromFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+bool UrlShortener::loadFromFile(const std::string& filename, bool merge) {
+    CsvReader reader(filename);
+    if (!reader.isOpen()) {
         return false;
     }
     
-    // Clear existing data
-    clear();
+    if (!merge) {
+        clear();
+    }
     
-    std::string line;
+    std::string_view fields[3];
+    size_t maxFields = 3;
     bool firstLine = true;
     
-    while (std::getline(file, line)) {
-        // Skip header line
+    while (size_t numFields = reader.next(fields, maxFields)) {
+        // Skip header line. Files without an expires_at column may have
+        // unquoted commas in URLs, which only a last field takes in whole.
         if (firstLine) {
             firstLine = false;
+            if (numFields < 3 || fields[2] != "expires_at") {
+                maxFields = 2;
+            }
             continue;
         }
         
-        // Skip empty lines
-        if (line.empty()) {
+        // Parse CSV record: short_code,long_url[,expires_at]; skip empty,
+        // invalid and expired lines
+        if (numFields < 2 || fields[0].empty() || fields[1].empty()) {
             continue;
         }
-        
-        // Parse CSV line: short_code,long_url
-        size_t commaPos = line.find(',');
-        if (commaPos == std::string::npos) {
-            continue;  // Invalid line
+        uint32_t expiresAt = 0;
+        if (numFields == 3 && !fields[2].empty() && !parseExpiry(fields[2], expiresAt)) {
+            continue;
         }
+        if (isExpired(expiresAt)) {
+            continue;
+        }
+        std::string_view shortCode = fields[0];
+        std::string canonical;
+        std::string_view longUrl = storedForm(fields[1], canonical);
         
-        std::string shortCode = line.substr(0, commaPos);
-        std::string longUrl = line.substr(commaPos + 1);
-        
-        // Store mapping
-        urlMap_[shortCode] = longUrl;
-        reverseMap_[longUrl] = shortCode;
+        // Store mapping; the first line wins if a code or URL repeats, and
+        // existing mappings win when merging
+        if (expiresAt != 0) {
+            insertExpiring(shortCode, longUrl, expiresAt);
+        } else {
+            std::string_view storedUrl = storeString(longUrl);
+            uint64_t ref;
+            if (insertShortCode(shortCode, storedUrl, ref)) {
+                reverseIndex_.findOrInsert(UrlFingerprint::compute(storedUrl),
+                                           [this, storedUrl](uint64_t existing) { return urlOf(existing) == storedUrl; },
+                                           [ref]() { return ref; });
+            }
+        }
         
-        // Update nextId_ based on decoded short code
-        try {
-            uint64_t decodedId = decodeBase62(shortCode);
-            if (decodedId >= nextId_) {
-                nextId_ = decodedId + 1;
+        // Generated codes continue after the highest id loaded; other codes
+        // can't collide with them
+        uint64_t decodedId;
+        uint64_t next = nextId_.load();
+        if (decodeTableId(shortCode, decodedId)) {
+            while (decodedId >= next && !nextId_.compare_exchange_weak(next, decodedId + 1)) {
             }
-        } catch (...) {
-            // If decoding fails, continue with current nextId_
         }
     }
     
-    file.close();
     return true;
 }
 
-void UrlShortener::getStats(size_t& totalUrls, size_t& totalShortCodes) const {
-    totalUrls = reverseMap_.size();
-    totalShortCodes = urlMap_.size();
+bool UrlShortener::saveSnapshot(const std::string& filename) const {
+    UrlSnapshotWriter writer(filename);
+    if (!writer.isOpen()) {
+        return false;
+    }
+    
+    urlTable_.forEach([this, &writer](uint64_t id, std::string_view longUrl, uint32_t expiresAt) {
+        if (!isExpired(expiresAt)) {
+            char code[Base62::MaxLength];
+            writer.add(std::string_view(code, encodeTableId(id, code)), longUrl, expiresAt);
+        }
+    });
+    aliasMap_.forEach([&writer](std::string_view shortCode, const StoredUrl& entry) {
+        if (!isExpired(entry.expiresAt)) {
+            writer.add(shortCode, entry.url, entry.expiresAt);
+        }
+    });
+    
+    return writer.finish(nextId_.load());
 }
 
-std::string UrlShortener::encodeBase62(uint64_t num) {
-    if (num == 0) {
-        return "0";
+bool UrlShortener::loadSnapshot(const std::string& filename, size_t numThreads) {
+    UrlSnapshotReader snapshot;
+    if (!snapshot.read(filename, numThreads)) {
+        return false;
     }
     
-    std::string result;
-    while (num > 0) {
-        result = BASE62_CHARS[num % BASE62] + result;
-        num /= BASE62;
+    clear();
+    
+    // Size the reverse index once instead of doubling it all the way up
+    reverseIndex_.reserve(snapshot.numRecords());
+    
+    // Records stay where the file was read; the arena keeps the buffer alive
+    size_t bufferSize;
+    std::unique_ptr<char[]> buffer = snapshot.release(bufferSize);
+    {
+        std::lock_guard<std::mutex> lock(stringsMutex_);
+        strings_.adopt(std::move(buffer), bufferSize);
     }
     
-    return result;
+    url_snapshot::parallelFor(snapshot.numSections(), numThreads, [this, &snapshot](size_t section) {
+        snapshot.forEachRecord(section, [this](std::string_view shortCode, std::string_view longUrl,
+                                               uint32_t expiresAt) {
+            if (shortCode.empty() || longUrl.empty() || isExpired(expiresAt)) {
+                return;
+            }
+            
+            // Expiring links are copied out, to be freed on their own
+            std::string canonical;
+            if (expiresAt != 0) {
+                insertExpiring(shortCode, storedForm(longUrl, canonical), expiresAt);
+                return;
+            }
+            
+            // Only a URL whose spelling changes needs a copy of its own
+            if (storedForm(longUrl, canonical) != longUrl) {
+                longUrl = storeString(canonical);
+            }
+            uint64_t ref;
+            if (insertShortCode(shortCode, longUrl, ref)) {
+                reverseIndex_.findOrInsert(UrlFingerprint::compute(longUrl),
+                                           [this, longUrl](uint64_t existing) { return urlOf(existing) == longUrl; },
+                                           [ref]() { return ref; });
+            }
+        });
+    });
+    
+    nextId_.store(snapshot.nextId());
+    return true;
 }
 
-uint64_t UrlShortener::decodeBase62(const std::string& encoded) {
-    uint64_t result = 0;
-    uint64_t base = 1;
+void UrlShortener::setAnalytics(ClickAnalytics* analytics) {
+    analytics_.store(analytics, std::memory_order_release);
+}
+
+bool UrlShortener::getClickStats(std::string_view shortCode, ClickAnalytics::ClickStats& stats) const {
+    uint64_t link;
+    if (lookup(shortCode, link).empty()) {
+        return false;
+    }
     
-    for (int i = static_cast<int>(encoded.length()) - 1; i >= 0; --i) {
-        char c = encoded[i];
-        
-        // Find character index in BASE62_CHARS
-        int charIndex = -1;
-        if (c >= '0' && c <= '9') {
-            charIndex = c - '0';
-        } else if (c >= 'a' && c <= 'z') {
-            charIndex = 10 + (c - 'a');
-        } else if (c >= 'A' && c <= 'Z') {
-            charIndex = 36 + (c - 'A');
-        } else {
-            throw std::invalid_argument("Invalid base62 character: " + std::string(1, c));
+    ClickAnalytics* analytics = analytics_.load(std::memory_order_acquire);
+    stats = analytics ? analytics->linkStats(link) : ClickAnalytics::ClickStats{0, 0};
+    return true;
+}
+
+std::vector<ClickAnalytics::MinuteStats> UrlShortener::getClickHistory(std::string_view shortCode) const {
+    uint64_t link;
+    ClickAnalytics* analytics = analytics_.load(std::memory_order_acquire);
+    if (!analytics || lookup(shortCode, link).empty()) {
+        return {};
+    }
+    return analytics->linkMinutes(link);
+}
+
+std::vector<std::pair<std::string, ClickAnalytics::ClickStats>> UrlShortener::getTopLinks(size_t count) const {
+    std::vector<std::pair<std::string, ClickAnalytics::ClickStats>> result;
+    ClickAnalytics* analytics = analytics_.load(std::memory_order_acquire);
+    if (!analytics) {
+        return result;
+    }
+    
+    auto top = analytics->topLinks(count);
+    
+    // Alias keys are value addresses; one pass over the map names them all
+    std::unordered_map<uint64_t, std::string_view> aliasCodes;
+    for (const auto& entry : top) {
+        if (!(entry.first & TABLE_REF)) {
+            aliasCodes.emplace(entry.first, std::string_view());
         }
-        
-        result += charIndex * base;
-        base *= BASE62;
+    }
+    if (!aliasCodes.empty()) {
+        aliasMap_.forEach([&aliasCodes](const std::string_view& code, const StoredUrl& entry) {
+            auto it = aliasCodes.find(reinterpret_cast<uintptr_t>(&entry));
+            if (it != aliasCodes.end()) {
+                it->second = code;
+            }
+        });
     }
     
+    char buffer[Base62::MaxLength];
+    for (const auto& entry : top) {
+        if (entry.first & TABLE_REF) {
+            size_t length = encodeTableId(entry.first & ~TABLE_REF, buffer);
+            result.emplace_back(std::string(buffer, length), entry.second);
+        } else {
+            result.emplace_back(std::string(aliasCodes[entry.first]), entry.second);
+        }
+    }
     return result;
 }
 
-std::string UrlShortener::generateShortCode() {
-    // Generate short code from nextId_
-    std::string shortCode = encodeBase62(nextId_);
+void UrlShortener::getStats(size_t& totalUrls, size_t& totalShortCodes) const {
+    totalUrls = reverseIndex_.size();
+    totalShortCodes = size();
+}
+
+std::string UrlShortener::encodeBase62(uint64_t num) {
+    return Base62::encode(num);
+}
+
+uint64_t UrlShortener::decodeBase62(std::string_view encoded) {
+    uint64_t value;
+    if (!Base62::decode(encoded, value)) {
+        throw std::invalid_argument("Invalid base62 string: " + std::string(encoded));
+    }
+    return value;
+}
+
+uint64_t UrlShortener::generateShortCode(std::string_view storedUrl) {
+    // Each thread draws its own IDs, so only codes loaded from a file can collide
+    char code[Base62::MaxLength];
+    uint64_t ref;
+    while (!insertShortCode(std::string_view(code, encodeTableId(takeId(), code)), storedUrl, ref)) {
+    }
     
-    // Ensure uniqueness (shouldn't happen with sequential IDs, but safety check)
-    while (urlMap_.find(shortCode) != urlMap_.end()) {
-        nextId_++;
-        shortCode = encodeBase62(nextId_);
+    return ref;
+}
+
+uint64_t UrlShortener::takeId() {
+    if (idBlockSize_ == 1) {
+        return nextId_.fetch_add(1);
     }
     
-    nextId_++;
-    return shortCode;
+    // One block per thread; switching to another shortener abandons the rest of it
+    thread_local IdBlock block;
+    uint64_t generation = generation_.load(std::memory_order_relaxed);
+    if (block.generation != generation || block.next == block.end) {
+        block.generation = generation;
+        block.next = nextId_.fetch_add(idBlockSize_);
+        block.end = block.next + idBlockSize_;
+    }
+    return block.next++;
+}
+
+size_t UrlShortener::encodeTableId(uint64_t id, char* out) const {
+    // Ids past the table keep their value: scrambled values are all below
+    // Capacity, so the two ranges can't produce the same code
+    if (scrambler_ && id < UrlPageTable::Capacity) {
+        id = scrambler_->scramble(id);
+    }
+    return Base62::encode(id, out);
+}
+
+bool UrlShortener::insertShortCode(std::string_view shortCode, std::string_view storedUrl, uint64_t& ref) {
+    uint64_t id;
+    if (decodeTableId(shortCode, id)) {
+        // A merge may race a generated id for the slot; set() lets one win.
+        // The code is the id's encoding, so it needs no copy.
+        if (!urlTable_.set(id, storedUrl)) {
+            return false;
+        }
+        ref = TABLE_REF | id;
+        return true;
+    }
+    
+    return aliasMap_.emplaceOrGet(shortCode, [this, shortCode, storedUrl, &ref]() {
+        std::string record(sizeof(uint32_t) + shortCode.size(), '\0');
+        uint32_t length = static_cast<uint32_t>(shortCode.size());
+        std::memcpy(&record[0], &length, sizeof(length));
+        std::memcpy(&record[sizeof(length)], shortCode.data(), shortCode.size());
+        
+        const char* stored = storeString(record).data();
+        ref = reinterpret_cast<uintptr_t>(stored);
+        return std::make_pair(recordCode(stored), StoredUrl{storedUrl, 0});
+    }).second;
+}
+
+bool UrlShortener::insertExpiring(std::string_view shortCode, std::string_view url, uint32_t expiresAt) {
+    Expiry expiry{expiresAt, std::unique_ptr<char[]>(new char[sizeof(uint32_t) + shortCode.size() + url.size()])};
+    char* record = expiry.record.get();
+    uint32_t length = static_cast<uint32_t>(shortCode.size());
+    std::memcpy(record, &length, sizeof(length));
+    std::memcpy(record + sizeof(length), shortCode.data(), shortCode.size());
+    std::memcpy(record + sizeof(length) + shortCode.size(), url.data(), url.size());
+    std::string_view storedUrl(record + sizeof(length) + shortCode.size(), url.size());
+    
+    uint64_t id;
+    bool inserted;
+    if (decodeTableId(shortCode, id)) {
+        inserted = urlTable_.set(id, storedUrl, expiresAt);
+    } else {
+        inserted = aliasMap_.emplaceOrGet(shortCode, [record, storedUrl, expiresAt]() {
+            return std::make_pair(recordCode(record), StoredUrl{storedUrl, expiresAt});
+        }).second;
+    }
+    if (!inserted) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(expiryMutex_);
+    expiries_.push_back(std::move(expiry));
+    std::push_heap(expiries_.begin(), expiries_.end(), expiresLater<Expiry>);
+    return true;
+}
+
+std::string_view UrlShortener::codeOf(uint64_t ref, char* buffer) const {
+    if (ref & TABLE_REF) {
+        return std::string_view(buffer, encodeTableId(ref & ~TABLE_REF, buffer));
+    }
+    return recordCode(reinterpret_cast<const char*>(static_cast<uintptr_t>(ref)));
+}
+
+std::string_view UrlShortener::urlOf(uint64_t ref) const {
+    if (ref & TABLE_REF) {
+        return urlTable_.get(ref & ~TABLE_REF);
+    }
+    const char* record = reinterpret_cast<const char*>(static_cast<uintptr_t>(ref));
+    const StoredUrl* entry = aliasMap_.find(recordCode(record));
+    return entry ? entry->url : std::string_view();
+}
+
+std::string UrlShortener::shortUrlOf(uint64_t ref) const {
+    char buffer[Base62::MaxLength];
+    std::string_view code = codeOf(ref, buffer);
+    std::string shortUrl;
+    shortUrl.reserve(baseUrl_.size() + code.size());
+    shortUrl.append(baseUrl_).append(code.data(), code.size());
+    return shortUrl;
+}
+
+std::string_view UrlShortener::storedForm(std::string_view url, std::string& canonical) const {
+    if (!canonicalizeUrls_) {
+        return url;
+    }
+    canonical = UrlFingerprint::canonicalize(url);
+    return canonical;
+}
+
+bool UrlShortener::decodeTableId(std::string_view shortCode, uint64_t& id) const {
+    if (shortCode.empty() || shortCode.size() > MAX_TABLE_CODE_LENGTH ||
+        (shortCode[0] == '0' && shortCode.size() > 1)) {
+        return false;
+    }
+    
+    uint64_t value;
+    if (!Base62::decode(shortCode, value) || value >= UrlPageTable::Capacity) {
+        return false;
+    }
+    id = scrambler_ ? scrambler_->unscramble(value) : value;
+    return true;
+}
+
+std::string_view UrlShortener::storeString(std::string_view str) {
+    std::lock_guard<std::mutex> lock(stringsMutex_);
+    return strings_.store(str);
 }
 
-std::string UrlShortener::extractShortCode(const std::string& shortUrl) const {
+std::string_view UrlShortener::extractShortCode(std::string_view shortUrl) const {
     // Check if URL starts with baseUrl_
-    if (shortUrl.find(baseUrl_) != 0) {
-        return "";
+    if (shortUrl.compare(0, baseUrl_.length(), baseUrl_) != 0) {
+        return std::string_view();
     }
     
     // Extract the part after baseUrl_
-    std::string shortCode = shortUrl.substr(baseUrl_.length());
+    std::string_view shortCode = shortUrl.substr(baseUrl_.length());
     
     // Remove any trailing slashes or whitespace
-    while (!shortCode.empty() && (shortCode.back() == '/' || std::isspace(shortCode.back()))) {
-        shortCode.pop_back();
+    while (!shortCode.empty() &&
+           (shortCode.back() == '/' || std::isspace(static_cast<unsigned char>(shortCode.back())))) {
+        shortCode.remove_suffix(1);
     }
     
     return shortCode;
@@ -1,55 +1,180 @@
 #ifndef URL_SHORTENER_H
 #define URL_SHORTENER_H
 
+#include "base62.h"
+#include "click_analytics.h"
+#include "concurrent_map.h"
+#include "fingerprint_index.h"
+#include "id_scrambler.h"
+#include "url_page_table.h"
+#include "scache.h"
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <mutex>
 #include <fstream>
 #include <stdexcept>
 #include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 /**
  * URL Shortener Service
  * 
  * Provides URL shortening functionality with:
  * - Base62 encoding for short names
- * - Database-like interface with unordered_map storage
+ * - Database-like interface with concurrent hash map storage
  * - CSV file persistence (save/load)
+ *
+ * Generated short codes are the base62 encoding of a sequential id, so
+ * expand() decodes the code and reads the URL straight out of a paged array
+ * indexed by id. Codes that aren't the canonical encoding of an id in the
+ * array's range (e.g. custom codes loaded from a file) live in a hash map.
+ * Given a scramble key, ids are passed through a keyed bijection
+ * (IdScrambler) before encoding: codes stop revealing how many URLs exist
+ * or which came next, yet still decode back to a dense array index.
+ *
+ * Thread-safe without external locking: expand() and exists() never take a
+ * lock, and shorten() draws IDs from an atomic counter and locks only the
+ * reverse index stripe of the URL. With an id block size above 1, each thread
+ * reserves that many ids at a time and the shared counter is touched once
+ * per block. Two threads shortening the same
+ * URL get the same short code. clear(), loadFromFile() (unless merging) and
+ * loadSnapshot() replace the whole database and must not run concurrently
+ * with other calls.
+ *
+ * Each URL is copied once into an append-only arena, as is each code kept
+ * in the hash map; the table and map hold string_views into it. expand()
+ * hands out such a view directly, so a redirect lookup allocates nothing.
+ * Views stay valid until clear() or the next load.
+ *
+ * Dedup (URL -> code) goes through a FingerprintIndex: 16 bytes per URL,
+ * a 64-bit fingerprint of the URL and a reference to its code (the table
+ * id itself for generated codes). A fingerprint match is confirmed by
+ * comparing the URL the referenced code expands to, so the index never
+ * holds a URL of its own. Optionally, URLs are canonicalized (see
+ * UrlFingerprint::canonicalize()) before they are stored, and spellings of
+ * the same URL share one code.
+ *
+ * Links may expire (shorten() with a TTL, addAlias()) and codes may be
+ * chosen by the caller (addAlias()). Either kind is a link of its own,
+ * outside dedup. An expiring link stores its expiry time in its table slot
+ * or map entry: expand() checks it and stops returning the URL once the
+ * time passes, so only expiring links cost a clock read. purgeExpired()
+ * then removes expired links in expiry order, from a min-heap, and
+ * reclaims their memory once no redirect can still be reading it: the
+ * URL views expand() returned for an expiring link stay valid for at
+ * least ReclaimDelay past its expiry.
+ *
+ * With a ClickAnalytics attached, expand() records a click per code found,
+ * handing it to the calling thread's buffer without waiting on anything;
+ * exists() and the click queries don't count as clicks.
  */
 class UrlShortener {
 public:
     /**
      * Constructor
      * @param baseUrl Base URL for shortened links (e.g., "https://short.ly/")
+     * @param scrambleKey Key for non-sequential codes; 0 keeps codes sequential (default: 0)
+     * @param idBlockSize Ids each thread reserves at a time (default: 1)
+     * @param canonicalizeUrls Whether to store (and dedup) URLs in canonical form (default: false)
      */
-    explicit UrlShortener(const std::string& baseUrl = "https://short.ly/");
+    explicit UrlShortener(const std::string& baseUrl = "https://short.ly/",
+                          uint64_t scrambleKey = 0, size_t idBlockSize = 1,
+                          bool canonicalizeUrls = false);
     
     /**
      * Shorten a URL
      * @param longUrl The original long URL to shorten
      * @return Shortened URL (baseUrl + short code)
      */
-    std::string shorten(const std::string& longUrl);
+    std::string shorten(std::string_view longUrl);
+    
+    /**
+     * Shorten many URLs at once
+     *
+     * The reverse index is grown once for the whole batch and the ids come
+     * from one block of the shared counter. Each URL then costs a single
+     * reverse index probe that either finds it (stored earlier, or repeated
+     * within the batch) or inserts it with the block's next id. Ids left
+     * over by repeats go back to the counter unless another thread took
+     * ids meanwhile. Safe to run alongside other shorten calls.
+     * @param longUrls URLs to shorten
+     * @param count Number of URLs
+     * @return Shortened URLs, in input order; repeats get the same one
+     * @throws std::invalid_argument if any URL is empty (nothing is stored)
+     */
+    std::vector<std::string> shortenBatch(const std::string_view* longUrls, size_t count);
+    
+    /**
+     * Shorten a URL under a new code that expires
+     *
+     * Every call creates a link of its own: the URL isn't deduplicated
+     * against other links, and later shorten() calls don't return this code.
+     * @param longUrl The original long URL to shorten
+     * @param ttl Time until the code stops expanding, in whole seconds
+     * @return Shortened URL (baseUrl + short code)
+     * @throws std::invalid_argument if the URL is empty or ttl isn't positive
+     */
+    std::string shorten(std::string_view longUrl, std::chrono::seconds ttl);
+    
+    /**
+     * Map a code of the caller's choosing (a vanity alias) to a URL
+     *
+     * Aliases are extra names: they don't take part in dedup, so shorten()
+     * keeps returning the URL's generated code. Codes that shorten() could
+     * generate are reserved. An expired alias can be reused once
+     * purgeExpired() has removed it.
+     * @param alias 1 to MaxAliasLength characters from [0-9A-Za-z_-]
+     * @param longUrl URL the alias expands to
+     * @param ttl Time until the alias expires, or 0 to keep it (default: 0)
+     * @return true if added, false if the alias is taken
+     * @throws std::invalid_argument if the URL is empty, the alias is invalid or
+     *         reserved, or ttl is negative
+     */
+    bool addAlias(std::string_view alias, std::string_view longUrl,
+                  std::chrono::seconds ttl = std::chrono::seconds(0));
+    
+    /**
+     * Remove expired links, soonest expiry first, without scanning the rest;
+     * also frees the memory of links removed at least ReclaimDelay ago. Safe
+     * to run alongside every call but clear() and replacing loads.
+     * @return Number of links removed
+     */
+    size_t purgeExpired();
     
     /**
      * Expand a short code to the original URL
      * @param shortCode The short code (without base URL)
-     * @return Original long URL, or empty string if not found
+     * @return View of the original long URL, or an empty view if not found
      */
-    std::string expand(const std::string& shortCode);
+    std::string_view expand(std::string_view shortCode) const;
+    
+    /**
+     * Expand a short code, recording the click with its visitor
+     * @param shortCode The short code (without base URL)
+     * @param visitor Visitor id for unique visitor counts (e.g. a hash of the client address), 0 if unknown
+     * @return View of the original long URL, or an empty view if not found
+     */
+    std::string_view expand(std::string_view shortCode, uint64_t visitor) const;
     
     /**
      * Expand a full shortened URL to the original URL
      * @param shortUrl The full shortened URL
-     * @return Original long URL, or empty string if not found
+     * @return View of the original long URL, or an empty view if not found
      */
-    std::string expandUrl(const std::string& shortUrl);
+    std::string_view expandUrl(std::string_view shortUrl) const;
     
     /**
      * Check if a short code exists
      * @param shortCode The short code to check
      * @return true if code exists, false otherwise
      */
-    bool exists(const std::string& shortCode) const;
+    bool exists(std::string_view shortCode) const;
     
     /**
      * Get the number of shortened URLs
@@ -69,7 +194,10 @@ public:
     void clear();
     
     /**
-     * Save the database to a CSV file
+     * Save the database to a CSV file, streamed through a large write buffer.
+     * Fields containing commas, quotes or line breaks are quoted. Expiring
+     * links get a third field, their expiry time in seconds since the Unix
+     * epoch; expired ones aren't saved, here or in saveSnapshot().
      * @param filename Path to the CSV file
      * @return true if successful, false otherwise
      */
@@ -77,18 +205,78 @@ public:
     
     /**
      * Load the database from a CSV file
+     *
+     * The file is streamed through a fixed buffer (see CsvReader), so
+     * memory grows with the data kept, not the file size. Rows with an
+     * expires_at column (saveToFile() writes one for expiring links) load
+     * as expiring links; expired ones are skipped. With merge, the
+     * rows are added to the current database instead of replacing it:
+     * existing codes and URLs keep their mappings, and the merge may run
+     * while other threads use the shortener.
      * @param filename Path to the CSV file
+     * @param merge Whether to keep the current mappings (default: false)
+     * @return true if successful, false otherwise
+     */
+    bool loadFromFile(const std::string& filename, bool merge = false);
+    
+    /**
+     * Save the database to a binary snapshot (see url_snapshot.h)
+     * @param filename Path to the snapshot file
      * @return true if successful, false otherwise
      */
-    bool loadFromFile(const std::string& filename);
+    bool saveSnapshot(const std::string& filename) const;
+    
+    /**
+     * Load the database from a binary snapshot, replacing the current one
+     *
+     * The file is read in one go and every checksum is verified before
+     * anything is replaced, so a corrupt snapshot leaves the database as it
+     * was. Sections are then inserted on parallel threads, straight from the
+     * file buffer (the arena takes it over, nothing is copied). Codes in a
+     * snapshot are unique, as saveSnapshot() writes them.
+     * @param filename Path to the snapshot file
+     * @param numThreads Loader threads; 0 uses the hardware concurrency (default: 0)
+     * @return true if loaded, false if the file is unreadable or corrupt
+     */
+    bool loadSnapshot(const std::string& filename, size_t numThreads = 0);
     
     /**
      * Get statistics about the database
-     * @param totalUrls Output: total number of URLs
+     * @param totalUrls Output: total number of distinct URLs
      * @param totalShortCodes Output: total number of short codes
      */
     void getStats(size_t& totalUrls, size_t& totalShortCodes) const;
     
+    /**
+     * Attach click analytics, recorded by expand() from then on
+     * @param analytics Analytics to record into, or nullptr to stop recording;
+     *        must outlive its use here. clear() and loads clear it as well,
+     *        since codes get new identities
+     */
+    void setAnalytics(ClickAnalytics* analytics);
+    
+    /**
+     * Get the clicks of a short code, as aggregated so far
+     * @param shortCode The short code
+     * @param stats Output: clicks and unique visitors (zeros without analytics)
+     * @return true if the code exists, false otherwise
+     */
+    bool getClickStats(std::string_view shortCode, ClickAnalytics::ClickStats& stats) const;
+    
+    /**
+     * Get the retained per-minute clicks of a short code
+     * @param shortCode The short code
+     * @return Minutes with clicks, oldest first; empty if the code doesn't exist
+     */
+    std::vector<ClickAnalytics::MinuteStats> getClickHistory(std::string_view shortCode) const;
+    
+    /**
+     * Get the most clicked short codes
+     * @param count Maximum number of codes
+     * @return Codes and their clicks, most clicks first
+     */
+    std::vector<std::pair<std::string, ClickAnalytics::ClickStats>> getTopLinks(size_t count) const;
+    
     /**
      * Encode a number to base62 (public for testing/utility)
      * @param num Number to encode
@@ -100,27 +288,154 @@ public:
      * Decode a base62 string to a number (public for testing/utility)
      * @param encoded Base62 encoded string
      * @return Decoded number
+     * @throws std::invalid_argument if the string is not valid base62 or overflows 64 bits
      */
-    static uint64_t decodeBase62(const std::string& encoded);
+    static uint64_t decodeBase62(std::string_view encoded);
+    
+    static constexpr size_t MaxAliasLength = 64;
+    
+    // Minimum time between removing an expired link and freeing its memory
+    static constexpr std::chrono::seconds ReclaimDelay{10};
 
 private:
+    // URL of an aliasMap_ code
+    struct StoredUrl {
+        std::string_view url;
+        uint32_t expiresAt;         // Seconds since the Unix epoch, 0 if the code doesn't expire
+    };
+    
+    // Expiring link, owning its code and URL: [u32 code length][code][URL]
+    struct Expiry {
+        uint32_t expiresAt;
+        std::unique_ptr<char[]> record;
+    };
+    
+    // Memory of a removed link, kept until readers are done with it
+    struct Retired {
+        std::chrono::steady_clock::time_point removedAt;
+        std::unique_ptr<char[]> record;
+        ConcurrentMap<std::string_view, StoredUrl>::Erased entry;   // Unlinked aliasMap_ entry, if an alias
+    };
+    
     std::string baseUrl_;                    // Base URL for shortened links
-    std::unordered_map<std::string, std::string> urlMap_;  // shortCode -> longUrl
-    std::unordered_map<std::string, std::string> reverseMap_;  // longUrl -> shortCode
-    uint64_t nextId_;                        // Next ID to use for encoding
+    StringArena strings_;                    // Single copy of every URL and short code
+    std::mutex stringsMutex_;                // Serializes writers to strings_
+    UrlPageTable urlTable_;                  // id -> longUrl, for generated codes
+    ConcurrentMap<std::string_view, StoredUrl> aliasMap_;  // shortCode -> longUrl, for other codes
+    FingerprintIndex reverseIndex_;          // URL fingerprint -> code reference (see codeOf())
+    std::atomic<uint64_t> nextId_;           // Next ID to use for encoding
+    std::optional<IdScrambler> scrambler_;   // Maps table ids to code values, if codes are scrambled
+    size_t idBlockSize_;                     // Ids reserved per thread at a time
+    std::atomic<uint64_t> generation_;       // Unique per instance and clear(); invalidates reserved blocks
+    bool canonicalizeUrls_;                  // Whether URLs are canonicalized before they are stored
+    std::atomic<ClickAnalytics*> analytics_; // Click recorder, if attached
+    std::mutex expiryMutex_;                 // Guards expiries_ and retired_
+    std::vector<Expiry> expiries_;           // Min-heap of expiring links by expiry time
+    std::deque<Retired> retired_;            // Removed links not yet freed, oldest first
+    
+    /**
+     * Look up a short code without recording a click
+     * @param shortCode Short code
+     * @param link Output: analytics key of the code: its table id tagged with the top bit,
+     *        or the address of its aliasMap_ value; set if found
+     * @return View of the URL, or an empty view if not found
+     */
+    std::string_view lookup(std::string_view shortCode, uint64_t& link) const;
+    
+    /**
+     * Take an unused id, from this thread's reserved block when blocks are enabled
+     * @return Id not handed out before (since the last clear())
+     */
+    uint64_t takeId();
+    
+    /**
+     * Encode a urlTable_ id as a short code
+     * @param id Id to encode
+     * @param out Buffer of at least Base62::MaxLength bytes
+     * @return Code length
+     */
+    size_t encodeTableId(uint64_t id, char* out) const;
+    
+    /**
+     * Generate a unique short code and map it to a URL
+     * @param storedUrl URL the new short code expands to, already in strings_
+     * @return Reference to the new code (see codeOf())
+     */
+    uint64_t generateShortCode(std::string_view storedUrl);
+    
+    /**
+     * Map a short code to a URL, in urlTable_ or aliasMap_ depending on the code
+     * @param shortCode Short code to claim
+     * @param storedUrl URL it expands to, in memory owned by strings_
+     * @param ref Output: reference to the code (see codeOf()), set only on success
+     * @return true if mapped, false if the code was taken
+     */
+    bool insertShortCode(std::string_view shortCode, std::string_view storedUrl, uint64_t& ref);
+    
+    /**
+     * Map a short code to a URL until an expiry time, copying both into a
+     * record the expiry index owns
+     * @param shortCode Short code to claim
+     * @param url URL it expands to
+     * @param expiresAt Expiry time, in seconds since the Unix epoch
+     * @return true if mapped, false if the code was taken
+     */
+    bool insertExpiring(std::string_view shortCode, std::string_view url, uint32_t expiresAt);
+    
+    /**
+     * Get the code a reverse index reference stands for: a table id tagged
+     * with the top bit, or the address of a length-prefixed copy of the code
+     * in strings_
+     * @param ref Reference from insertShortCode()
+     * @param buffer Buffer of at least Base62::MaxLength bytes, for table codes
+     * @return View of the code, in buffer or strings_
+     */
+    std::string_view codeOf(uint64_t ref, char* buffer) const;
+    
+    /**
+     * Get the URL a reverse index reference's code expands to
+     * @param ref Reference from insertShortCode()
+     * @return View of the URL
+     */
+    std::string_view urlOf(uint64_t ref) const;
+    
+    /**
+     * Build the short URL for a reverse index reference
+     * @param ref Reference from insertShortCode()
+     * @return baseUrl_ + code
+     */
+    std::string shortUrlOf(uint64_t ref) const;
+    
+    /**
+     * Get the spelling a URL is stored and deduplicated under
+     * @param url URL as given
+     * @param canonical Holds the canonical spelling when URLs are canonicalized
+     * @return url itself, or a view of canonical
+     */
+    std::string_view storedForm(std::string_view url, std::string& canonical) const;
+    
+    /**
+     * Decode a short code to a urlTable_ id
+     * @param shortCode Short code
+     * @param id Output: decoded (and unscrambled) id
+     * @return true if the code is the canonical base62 encoding of a value below
+     *         UrlPageTable::Capacity (no leading zeros), false otherwise
+     */
+    bool decodeTableId(std::string_view shortCode, uint64_t& id) const;
     
     /**
-     * Generate a unique short code
-     * @return Unique short code
+     * Copy a string into the arena
+     * @param str String to copy
+     * @return View of the copy, valid until clear()
      */
-    std::string generateShortCode();
+    std::string_view storeString(std::string_view str);
     
     /**
      * Extract short code from a full shortened URL
      * @param shortUrl Full shortened URL
-     * @return Short code, or empty string if invalid
+     * @return View of the short code within shortUrl, or empty view if invalid
      */
-    std::string extractShortCode(const std::string& shortUrl) const;
+    std::string_view extractShortCode(std::string_view shortUrl) const;
 };
 
 #endif // URL_SHORTENER_H
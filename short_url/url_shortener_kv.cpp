@@ -1,39 +1,45 @@
 #include "url_shortener_kv.h"
 #include "../key_value_store/kv_store.h"
+#include "base62.h"
+#include "url_fingerprint.h"
+#include "url_snapshot.h"
+#include "csv_stream.h"
 #include <sstream>
 #include <algorithm>
 #include <cctype>
-#include <set>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
 
-// Base62 character set: 0-9, a-z, A-Z
-static const char BASE62_CHARS[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
-static const int BASE62 = 62;
+constexpr size_t UrlShortenerKV::IndexSegmentSize;
 
-UrlShortenerKV::UrlShortenerKV(const std::string& baseUrl, int virtualNodesPerNode)
+UrlShortenerKV::UrlShortenerKV(const std::string& baseUrl, int virtualNodesPerNode, size_t cacheCapacity,
+                               bool canonicalizeUrls, size_t idBlockSize)
     : baseUrl_(baseUrl)
     , kvStore_(std::make_unique<KeyValueStore>(virtualNodesPerNode))
     , reverseKvStore_(std::make_unique<KeyValueStore>(virtualNodesPerNode))
+    , redirectCache_(std::make_unique<RedirectCache>(cacheCapacity))
     , nextId_(1)
+    , leaseEnd_(1)
+    , idBlockSize_(idBlockSize)
+    , indexSize_(0)
+    , sealedSegments_(0)
+    , openSegmentSize_(0)
+    , canonicalizeUrls_(canonicalizeUrls)
 {
     if (baseUrl.empty()) {
         throw std::invalid_argument("Base URL cannot be empty");
     }
+    if (idBlockSize == 0) {
+        throw std::invalid_argument("Id block size must be positive");
+    }
     
     // Add default server for single-node operation
     kvStore_->addServer("server1");
     reverseKvStore_->addServer("server1");
     
-    // Load nextId_ from store if it exists
-    std::string nextIdStr = kvStore_->get(NEXT_ID_KEY);
-    if (!nextIdStr.empty()) {
-        try {
-            nextId_ = std::stoull(nextIdStr);
-        } catch (...) {
-            nextId_ = 1;
-        }
-    }
-    
-    // Load index from store if it exists
+    // Ids are leased on first use; load index from store if it exists
     loadIndex();
 }
 
@@ -45,8 +51,9 @@ std::string UrlShortenerKV::shorten(const std::string& longUrl) {
     }
     
     // Check if URL already exists using reverse store
-    std::string reverseKey = LONG_URL_PREFIX + longUrl;
-    std::string existingCode = reverseKvStore_->get(reverseKey);
+    std::string url = storedForm(longUrl);
+    std::string reverseKey;
+    std::string existingCode = findCode(url, UrlFingerprint::compute(url), reverseKey);
     
     if (!existingCode.empty()) {
         // URL already shortened, return existing short URL
@@ -59,23 +66,136 @@ std::string UrlShortenerKV::shorten(const std::string& longUrl) {
     
     // Store in both stores
     std::string shortCodeKey = SHORT_CODE_PREFIX + shortCode;
-    kvStore_->set(shortCodeKey, longUrl);
+    kvStore_->set(shortCodeKey, url);
     reverseKvStore_->set(reverseKey, shortCode);
+    redirectCache_->invalidate(shortCode);  // May hold "unknown code" from an earlier probe
     
     // Add to index
-    shortCodeIndex_.push_back(shortCode);
-    saveIndex();
+    appendToIndex(shortCode);
     
     return baseUrl_ + shortCode;
 }
 
+std::vector<std::string> UrlShortenerKV::shortenBatch(const std::string_view* longUrls, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (longUrls[i].empty()) {
+            throw std::invalid_argument("Long URL cannot be empty");
+        }
+    }
+    
+    // Repeats in the batch map to the slot of their first occurrence. The
+    // slot keys view urls, which is reserved so it never moves them.
+    std::unordered_map<std::string_view, size_t> slots;
+    slots.reserve(count);
+    std::vector<size_t> slotOf(count);
+    std::vector<std::string> urls;
+    urls.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string url = storedForm(longUrls[i]);
+        auto it = slots.find(url);
+        if (it == slots.end()) {
+            urls.push_back(std::move(url));
+            it = slots.emplace(urls.back(), urls.size() - 1).first;
+        }
+        slotOf[i] = it->second;
+    }
+    
+    std::vector<uint64_t> fingerprints(urls.size());
+    std::vector<std::string> reverseKeys(urls.size());
+    for (size_t j = 0; j < urls.size(); ++j) {
+        fingerprints[j] = UrlFingerprint::compute(urls[j]);
+        reverseKeys[j] = reverseKey(fingerprints[j]);
+    }
+    
+    // One reverse lookup pass, then one pass reading back the URLs of the
+    // codes found to confirm them; empty codes are the new URLs
+    std::vector<std::string> codes = reverseKvStore_->getBatch(reverseKeys);
+    std::vector<size_t> found;
+    std::vector<std::string> codeKeys;
+    for (size_t j = 0; j < codes.size(); ++j) {
+        if (!codes[j].empty()) {
+            found.push_back(j);
+            codeKeys.push_back(SHORT_CODE_PREFIX + codes[j]);
+        }
+    }
+    std::vector<std::string> foundUrls = kvStore_->getBatch(codeKeys);
+    for (size_t k = 0; k < found.size(); ++k) {
+        size_t j = found[k];
+        if (foundUrls[k] != urls[j]) {
+            codes[j] = findCode(urls[j], fingerprints[j], reverseKeys[j]);  // Another URL's fingerprint
+        }
+    }
+    
+    std::vector<size_t> missing;
+    for (size_t j = 0; j < codes.size(); ++j) {
+        if (codes[j].empty()) {
+            missing.push_back(j);
+        }
+    }
+    
+    if (!missing.empty()) {
+        uint64_t id = getNextId(missing.size());
+        std::vector<std::pair<std::string, std::string>> entries;
+        entries.reserve(missing.size());
+        for (size_t j : missing) {
+            codes[j] = encodeBase62(id++);
+            entries.emplace_back(SHORT_CODE_PREFIX + codes[j], urls[j]);
+        }
+        
+        std::vector<bool> stored = kvStore_->setBatch(entries, false);
+        std::vector<std::pair<std::string, std::string>> reverse;
+        reverse.reserve(missing.size());
+        for (size_t k = 0; k < missing.size(); ++k) {
+            size_t j = missing[k];
+            if (!stored[k]) {
+                // Id taken by a loaded code
+                codes[j] = generateShortCode();
+                kvStore_->set(SHORT_CODE_PREFIX + codes[j], urls[j]);
+            }
+            reverse.emplace_back(std::move(reverseKeys[j]), codes[j]);
+            appendToIndex(codes[j], false);
+            redirectCache_->invalidate(codes[j]);
+        }
+        
+        // New URLs of the batch sharing a fingerprint can't share its key
+        std::vector<bool> added = reverseKvStore_->setBatch(reverse, false);
+        for (size_t k = 0; k < missing.size(); ++k) {
+            if (!added[k]) {
+                size_t j = missing[k];
+                findCode(urls[j], fingerprints[j], reverseKeys[j]);
+                reverseKvStore_->set(reverseKeys[j], codes[j]);
+            }
+        }
+        
+        // Sealed segments were written as they filled; the open one once, here
+        if (openSegmentSize_ > 0) {
+            kvStore_->set(indexSegmentKey(sealedSegments_), openSegment_);
+        }
+    }
+    
+    std::vector<std::string> shortUrls(count);
+    for (size_t i = 0; i < count; ++i) {
+        shortUrls[i] = baseUrl_ + codes[slotOf[i]];
+    }
+    return shortUrls;
+}
+
 std::string UrlShortenerKV::expand(const std::string& shortCode) {
     if (shortCode.empty()) {
         return "";
     }
     
+    std::string longUrl;
+    uint64_t ticket = 0;
+    if (redirectCache_->find(shortCode, longUrl, ticket)) {
+        return longUrl;
+    }
+    
+    // Unknown codes are cached as an empty URL too
     std::string key = SHORT_CODE_PREFIX + shortCode;
-    return kvStore_->get(key);
+    longUrl = kvStore_->get(key);
+    redirectCache_->insert(shortCode, longUrl, ticket);
+    return longUrl;
 }
 
 std::string UrlShortenerKV::expandUrl(const std::string& shortUrl) {
@@ -93,7 +213,7 @@ bool UrlShortenerKV::exists(const std::string& shortCode) const {
 }
 
 size_t UrlShortenerKV::size() const {
-    return shortCodeIndex_.size();
+    return indexSize_;
 }
 
 bool UrlShortenerKV::empty() const {
@@ -101,99 +221,193 @@ bool UrlShortenerKV::empty() const {
 }
 
 void UrlShortenerKV::clear() {
+    // KeyValueStore::clear() drops the servers too; keep the cluster as it was
+    std::vector<std::string> servers = getServers();
     kvStore_->clear();
     reverseKvStore_->clear();
-    shortCodeIndex_.clear();
+    redirectCache_->clear();
+    for (const auto& serverId : servers) {
+        addServer(serverId);
+    }
+    
+    indexSize_ = 0;
+    sealedSegments_ = 0;
+    openSegment_.clear();
+    openSegmentSize_ = 0;
     nextId_ = 1;
-    saveNextId(nextId_);
-    saveIndex();
+    leaseEnd_ = 1;
 }
 
 bool UrlShortenerKV::saveToFile(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
+    CsvWriter writer(filename);
+    if (!writer.isOpen()) {
         return false;
     }
     
     // Write CSV header
-    file << "short_code,long_url\n";
-    
-    // Iterate through index and write all mappings
-    for (const auto& shortCode : shortCodeIndex_) {
-        std::string key = SHORT_CODE_PREFIX + shortCode;
-        std::string longUrl = kvStore_->get(key);
-        
-        if (!longUrl.empty()) {
-            file << shortCode << "," << longUrl << "\n";
+    writer.write("short_code", "long_url");
+    
+    // Page through the short codes in key order, one store lock per page
+    const size_t prefixLength = std::strlen(SHORT_CODE_PREFIX);
+    std::string lastKey;
+    while (true) {
+        auto page = kvStore_->scan(SHORT_CODE_PREFIX, lastKey, ExportPageSize);
+        for (const auto& entry : page) {
+            writer.write(std::string_view(entry.first).substr(prefixLength), entry.second);
         }
+        if (page.size() < ExportPageSize) {
+            break;
+        }
+        lastKey = page.back().first;
     }
     
-    file.close();
-    return file.good();
+    return writer.finish();
 }
 
-bool UrlShortenerKV::loadFromFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+bool UrlShortenerKV::loadFromFile(const std::string& filename, bool merge) {
+    CsvReader reader(filename);
+    if (!reader.isOpen()) {
         return false;
     }
     
-    // Clear existing data
-    clear();
+    if (!merge) {
+        clear();
+    }
     
-    std::string line;
-    bool firstLine = true;
+    // Rows are committed ImportBatchSize at a time, one store lock per batch.
+    // Codes and URLs already mapped (earlier rows, or the current data when
+    // merging) keep their mapping.
+    const size_t prefixLength = std::strlen(SHORT_CODE_PREFIX);
+    std::vector<std::pair<std::string, std::string>> codes;
+    std::vector<std::pair<std::string, std::string>> reverse;
+    std::vector<size_t> reverseRows;        // Row in codes of each reverse entry
+    codes.reserve(ImportBatchSize);
+    reverse.reserve(ImportBatchSize);
     uint64_t maxId = 0;
     
-    while (std::getline(file, line)) {
-        // Skip header line
+    auto commit = [&]() {
+        std::vector<bool> stored = kvStore_->setBatch(codes, false);
+        for (size_t i = 0; i < codes.size(); ++i) {
+            if (!stored[i]) {
+                continue;
+            }
+            std::string shortCode = codes[i].first.substr(prefixLength);
+            appendToIndex(shortCode, false);
+            redirectCache_->invalidate(shortCode);
+            
+            // Loaded ids must not be leased again
+            uint64_t decodedId;
+            if (Base62::decode(shortCode, decodedId) && decodedId > maxId) {
+                maxId = decodedId;
+            }
+            reverse.emplace_back(reverseKey(UrlFingerprint::compute(codes[i].second)), std::move(shortCode));
+            reverseRows.push_back(i);
+        }
+        
+        // A key already taken is an earlier mapping of the URL, which is
+        // kept, or another URL with the same fingerprint
+        std::vector<bool> added = reverseKvStore_->setBatch(reverse, false);
+        for (size_t k = 0; k < reverse.size(); ++k) {
+            const std::string& url = codes[reverseRows[k]].second;
+            std::string freeKey;
+            if (!added[k] && findCode(url, UrlFingerprint::compute(url), freeKey).empty()) {
+                reverseKvStore_->set(freeKey, reverse[k].second);
+            }
+        }
+        codes.clear();
+        reverse.clear();
+        reverseRows.clear();
+    };
+    
+    std::string_view fields[3];
+    size_t maxFields = 3;
+    bool firstLine = true;
+    while (size_t numFields = reader.next(fields, maxFields)) {
+        // Skip header line. Without an expires_at column, a URL's unquoted
+        // commas stay in the last field.
         if (firstLine) {
             firstLine = false;
+            if (numFields < 3 || fields[2] != "expires_at") {
+                maxFields = 2;
+            }
             continue;
         }
         
-        // Skip empty lines
-        if (line.empty()) {
+        // Parse CSV record: short_code,long_url[,expires_at]; skip empty and
+        // invalid lines, and expiring links, which this store can't expire
+        if (numFields < 2 || fields[0].empty() || fields[1].empty() || (numFields == 3 && !fields[2].empty())) {
             continue;
         }
         
-        // Parse CSV line: short_code,long_url
-        size_t commaPos = line.find(',');
-        if (commaPos == std::string::npos) {
-            continue;  // Invalid line
+        codes.emplace_back(SHORT_CODE_PREFIX + std::string(fields[0]), storedForm(fields[1]));
+        if (codes.size() == ImportBatchSize) {
+            commit();
         }
-        
-        std::string shortCode = line.substr(0, commaPos);
-        std::string longUrl = line.substr(commaPos + 1);
-        
-        // Store in both stores
-        std::string shortCodeKey = SHORT_CODE_PREFIX + shortCode;
-        std::string reverseKey = LONG_URL_PREFIX + longUrl;
-        
-        kvStore_->set(shortCodeKey, longUrl);
-        reverseKvStore_->set(reverseKey, shortCode);
-        
-        // Add to index
-        shortCodeIndex_.push_back(shortCode);
-        
-        // Update nextId_ based on decoded short code
-        try {
-            uint64_t decodedId = decodeBase62(shortCode);
-            if (decodedId > maxId) {
-                maxId = decodedId;
+    }
+    commit();
+    
+    // Sealed segments were written as they filled; the open one once, here
+    if (openSegmentSize_ > 0) {
+        kvStore_->set(indexSegmentKey(sealedSegments_), openSegment_);
+    }
+    
+    if (maxId > 0) {
+        reserveIdsThrough(maxId);
+    }
+    
+    return true;
+}
+
+bool UrlShortenerKV::saveSnapshot(const std::string& filename) const {
+    UrlSnapshotWriter writer(filename);
+    if (!writer.isOpen()) {
+        return false;
+    }
+    
+    for (size_t segment = 0; segment <= sealedSegments_; ++segment) {
+        for (const auto& shortCode : readIndexSegment(segment)) {
+            std::string longUrl = kvStore_->get(SHORT_CODE_PREFIX + shortCode);
+            if (!longUrl.empty()) {
+                writer.add(shortCode, longUrl);
             }
-        } catch (...) {
-            // If decoding fails, continue
         }
     }
     
-    if (maxId > 0) {
-        nextId_ = maxId + 1;
-        saveNextId(nextId_);
+    // Other instances may have leased ids past this one's
+    return writer.finish(lastLeasedId() + 1);
+}
+
+bool UrlShortenerKV::loadSnapshot(const std::string& filename, size_t numThreads) {
+    UrlSnapshotReader snapshot;
+    if (!snapshot.read(filename, numThreads)) {
+        return false;
     }
     
-    saveIndex();
-    file.close();
+    clear();
+    
+    // The store serializes writers, so insert on this thread
+    for (size_t section = 0; section < snapshot.numSections(); ++section) {
+        snapshot.forEachRecord(section, [this](std::string_view code, std::string_view url, uint32_t expiresAt) {
+            if (expiresAt != 0) {
+                return;  // Can't be expired here
+            }
+            std::string shortCode(code);
+            std::string longUrl = storedForm(url);
+            kvStore_->set(SHORT_CODE_PREFIX + shortCode, longUrl);
+            std::string reverseKey;
+            if (findCode(longUrl, UrlFingerprint::compute(longUrl), reverseKey).empty()) {
+                reverseKvStore_->set(reverseKey, shortCode);
+            }
+            appendToIndex(shortCode, false);
+        });
+    }
+    if (openSegmentSize_ > 0) {
+        kvStore_->set(indexSegmentKey(sealedSegments_), openSegment_);
+    }
+    
+    if (snapshot.nextId() > 1) {
+        reserveIdsThrough(snapshot.nextId() - 1);
+    }
     return true;
 }
 
@@ -202,6 +416,10 @@ void UrlShortenerKV::getStats(size_t& totalUrls, size_t& totalShortCodes) const
     totalShortCodes = kvStore_->getTotalEntries();
 }
 
+RedirectCache::Stats UrlShortenerKV::getCacheStats() const {
+    return redirectCache_->stats();
+}
+
 bool UrlShortenerKV::addServer(const std::string& serverId) {
     bool result1 = kvStore_->addServer(serverId);
     bool result2 = reverseKvStore_->addServer(serverId);
@@ -224,43 +442,15 @@ std::string UrlShortenerKV::getServerForKey(const std::string& shortCode) const
 }
 
 std::string UrlShortenerKV::encodeBase62(uint64_t num) {
-    if (num == 0) {
-        return "0";
-    }
-    
-    std::string result;
-    while (num > 0) {
-        result = BASE62_CHARS[num % BASE62] + result;
-        num /= BASE62;
-    }
-    
-    return result;
+    return Base62::encode(num);
 }
 
 uint64_t UrlShortenerKV::decodeBase62(const std::string& encoded) {
-    uint64_t result = 0;
-    uint64_t base = 1;
-    
-    for (int i = static_cast<int>(encoded.length()) - 1; i >= 0; --i) {
-        char c = encoded[i];
-        
-        // Find character index in BASE62_CHARS
-        int charIndex = -1;
-        if (c >= '0' && c <= '9') {
-            charIndex = c - '0';
-        } else if (c >= 'a' && c <= 'z') {
-            charIndex = 10 + (c - 'a');
-        } else if (c >= 'A' && c <= 'Z') {
-            charIndex = 36 + (c - 'A');
-        } else {
-            throw std::invalid_argument("Invalid base62 character: " + std::string(1, c));
-        }
-        
-        result += charIndex * base;
-        base *= BASE62;
+    uint64_t value;
+    if (!Base62::decode(encoded, value)) {
+        throw std::invalid_argument("Invalid base62 string: " + encoded);
     }
-    
-    return result;
+    return value;
 }
 
 std::string UrlShortenerKV::generateShortCode() {
@@ -281,6 +471,25 @@ std::string UrlShortenerKV::generateShortCode() {
     return shortCode;
 }
 
+std::string UrlShortenerKV::findCode(const std::string& url, uint64_t fingerprint, std::string& freeKey) const {
+    // Walk the URLs sharing the fingerprint until one reads back equal
+    for (size_t probe = 0; ; ++probe) {
+        std::string key = reverseKey(fingerprint, probe);
+        std::string code = reverseKvStore_->get(key);
+        if (code.empty()) {
+            freeKey = std::move(key);
+            return code;
+        }
+        if (kvStore_->get(SHORT_CODE_PREFIX + code) == url) {
+            return code;
+        }
+    }
+}
+
+std::string UrlShortenerKV::storedForm(std::string_view url) const {
+    return canonicalizeUrls_ ? UrlFingerprint::canonicalize(url) : std::string(url);
+}
+
 std::string UrlShortenerKV::extractShortCode(const std::string& shortUrl) const {
     // Check if URL starts with baseUrl_
     if (shortUrl.find(baseUrl_) != 0) {
@@ -298,54 +507,115 @@ std::string UrlShortenerKV::extractShortCode(const std::string& shortUrl) const
     return shortCode;
 }
 
-uint64_t UrlShortenerKV::getNextId() {
-    std::string idStr = kvStore_->get(NEXT_ID_KEY);
-    if (!idStr.empty()) {
-        try {
-            uint64_t id = std::stoull(idStr);
-            nextId_ = id + 1;
-        } catch (...) {
-            // If parsing fails, use current nextId_
-        }
+uint64_t UrlShortenerKV::getNextId(size_t count) {
+    if (leaseEnd_ - nextId_ < count) {
+        // A batch larger than a block leases exactly what it needs
+        leaseIds(std::max<uint64_t>(count, idBlockSize_));
     }
     
-    uint64_t currentId = nextId_;
-    saveNextId(nextId_);
-    nextId_++;
+    uint64_t id = nextId_;
+    nextId_ += count;
+    return id;
+}
+
+void UrlShortenerKV::leaseIds(uint64_t count) {
+    uint64_t last;
+    if (!kvStore_->increment(NEXT_ID_KEY, count, last)) {
+        throw std::runtime_error("Cannot lease ids from the store");
+    }
     
-    return currentId;
+    // A block right after the current one extends it, so what's left of the
+    // current one stays usable (and a batch gets consecutive ids)
+    uint64_t first = last - count + 1;
+    if (first != leaseEnd_) {
+        nextId_ = first;
+    }
+    leaseEnd_ = last + 1;
 }
 
-void UrlShortenerKV::saveNextId(uint64_t id) {
-    kvStore_->set(NEXT_ID_KEY, std::to_string(id));
+void UrlShortenerKV::reserveIdsThrough(uint64_t id) {
+    // A lease racing in between may push the counter past id, which only
+    // leaves a gap
+    uint64_t last;
+    if (kvStore_->increment(NEXT_ID_KEY, 0, last) && last < id) {
+        kvStore_->increment(NEXT_ID_KEY, id - last, last);
+    }
+    if (nextId_ <= id) {
+        nextId_ = std::min(id + 1, leaseEnd_);
+    }
 }
 
-void UrlShortenerKV::saveIndex() {
-    // Store index as comma-separated list
-    std::ostringstream oss;
-    for (size_t i = 0; i < shortCodeIndex_.size(); ++i) {
-        if (i > 0) {
-            oss << ",";
-        }
-        oss << shortCodeIndex_[i];
+uint64_t UrlShortenerKV::lastLeasedId() const {
+    uint64_t last = 0;
+    std::string value = kvStore_->get(NEXT_ID_KEY);
+    std::from_chars(value.data(), value.data() + value.size(), last);
+    return last;
+}
+
+void UrlShortenerKV::appendToIndex(const std::string& shortCode, bool writeOpenSegment) {
+    if (openSegmentSize_ > 0) {
+        openSegment_ += ",";
+    }
+    openSegment_ += shortCode;
+    openSegmentSize_++;
+    indexSize_++;
+    
+    // Only the open segment is rewritten, so this is bounded by IndexSegmentSize
+    bool sealing = openSegmentSize_ == IndexSegmentSize;
+    if (writeOpenSegment || sealing) {
+        kvStore_->set(indexSegmentKey(sealedSegments_), openSegment_);
+    }
+    
+    if (sealing) {
+        sealedSegments_++;
+        kvStore_->set(INDEX_SEGMENT_COUNT_KEY, std::to_string(sealedSegments_));
+        openSegment_.clear();
+        openSegmentSize_ = 0;
     }
-    kvStore_->set(INDEX_KEY, oss.str());
 }
 
 void UrlShortenerKV::loadIndex() {
-    std::string indexStr = kvStore_->get(INDEX_KEY);
-    if (indexStr.empty()) {
-        return;
+    sealedSegments_ = 0;
+    std::string countStr = kvStore_->get(INDEX_SEGMENT_COUNT_KEY);
+    if (!countStr.empty()) {
+        try {
+            sealedSegments_ = std::stoull(countStr);
+        } catch (...) {
+            sealedSegments_ = 0;
+        }
     }
     
-    shortCodeIndex_.clear();
-    std::istringstream iss(indexStr);
+    // Sealed segments are full by construction; only the open one needs reading
+    openSegment_ = kvStore_->get(indexSegmentKey(sealedSegments_));
+    openSegmentSize_ = openSegment_.empty() ? 0 : std::count(openSegment_.begin(), openSegment_.end(), ',') + 1;
+    indexSize_ = sealedSegments_ * IndexSegmentSize + openSegmentSize_;
+}
+
+std::vector<std::string> UrlShortenerKV::readIndexSegment(size_t segment) const {
+    std::vector<std::string> codes;
+    std::istringstream iss(kvStore_->get(indexSegmentKey(segment)));
     std::string code;
     
     while (std::getline(iss, code, ',')) {
         if (!code.empty()) {
-            shortCodeIndex_.push_back(code);
+            codes.push_back(code);
         }
     }
+    
+    return codes;
 }
 
+std::string UrlShortenerKV::indexSegmentKey(size_t segment) {
+    return INDEX_SEGMENT_PREFIX + std::to_string(segment);
+}
+
+std::string UrlShortenerKV::reverseKey(uint64_t fingerprint, size_t probe) {
+    char digits[Base62::MaxLength];
+    std::string key = LONG_URL_PREFIX;
+    key.append(digits, Base62::encode(fingerprint, digits));
+    if (probe > 0) {
+        key += '.';
+        key += std::to_string(probe);
+    }
+    return key;
+}
@@ -6,7 +6,9 @@
 #include <stdexcept>
 #include <cstdint>
 #include <memory>
+#include <string_view>
 #include <vector>
+#include "redirect_cache.h"
 
 // Forward declaration
 class KeyValueStore;
@@ -19,6 +21,31 @@ class KeyValueStore;
  * - Base62 encoding for short names
  * - KeyValueStore backend for distributed/horizontal scaling
  * - CSV file persistence (save/load)
+ *
+ * The list of short codes is persisted as append-only index segments of
+ * IndexSegmentSize codes each ("index:0", "index:1", ...). Shortening a URL
+ * rewrites only the open (last) segment, so the cost per new URL doesn't
+ * grow with the number of URLs; sealed segments are read back one at a
+ * time, only when the whole index is walked (saveToFile).
+ *
+ * expand() is served from a RedirectCache in front of the store when it
+ * can: hot codes and recently probed unknown codes are answered without
+ * building a store key or taking the store's lock. Every write that maps a
+ * code invalidates its cache entry.
+ *
+ * The reverse store (URL -> code, for dedup) is keyed by a fingerprint of
+ * the URL, LONG_URL_PREFIX plus at most 11 base62 digits, so each URL is
+ * kept once: as the value of its code. A fingerprint match counts only if
+ * the code's URL reads back equal; a URL whose fingerprint is already taken
+ * by another URL uses the key with ".1" appended, then ".2", and so on.
+ * Optionally, URLs are canonicalized (see UrlFingerprint::canonicalize())
+ * before they are stored, so spellings of the same URL share one code.
+ *
+ * Ids are leased from the store in blocks: a counter in the store holds the
+ * last id leased, and each lease advances it atomically by idBlockSize, so
+ * shortening writes nothing to the counter until the block runs out and
+ * instances sharing the counter never hand out the same id. Ids left in a
+ * block when the instance goes away are skipped, not reused.
  */
 class UrlShortenerKV {
 public:
@@ -26,10 +53,17 @@ public:
      * Constructor
      * @param baseUrl Base URL for shortened links (e.g., "https://short.ly/")
      * @param virtualNodesPerNode Number of virtual nodes per server for consistent hashing (default: 150)
+     * @param cacheCapacity Short codes kept in the redirect cache; 0 disables it (default: 8192)
+     * @param canonicalizeUrls Whether to store (and dedup) URLs in canonical form (default: false)
+     * @param idBlockSize Ids leased from the store at a time (default: 1024)
+     * @throws std::invalid_argument if baseUrl is empty or idBlockSize is 0
      */
     explicit UrlShortenerKV(
         const std::string& baseUrl = "https://short.ly/",
-        int virtualNodesPerNode = 150
+        int virtualNodesPerNode = 150,
+        size_t cacheCapacity = 8192,
+        bool canonicalizeUrls = false,
+        size_t idBlockSize = 1024
     );
     
     /**
@@ -47,11 +81,27 @@ public:
      * Shorten a URL
      * @param longUrl The original long URL to shorten
      * @return Shortened URL (baseUrl + short code)
+     * @throws std::runtime_error if ids can't be leased (no server available)
      */
     std::string shorten(const std::string& longUrl);
     
     /**
-     * Expand a short code to the original URL
+     * Shorten many URLs at once
+     *
+     * Repeats within the batch are handled once, existing URLs are found
+     * with one batched reverse lookup, and the new ones take consecutive
+     * ids (at most one lease) and are stored with one batch per store and
+     * one write of the open index segment.
+     * @param longUrls URLs to shorten
+     * @param count Number of URLs
+     * @return Shortened URLs, in input order; repeats get the same one
+     * @throws std::invalid_argument if any URL is empty (nothing is stored)
+     */
+    std::vector<std::string> shortenBatch(const std::string_view* longUrls, size_t count);
+    
+    /**
+     * Expand a short code to the original URL, from the redirect cache when
+     * the code (or its absence) is cached
      * @param shortCode The short code (without base URL)
      * @return Original long URL, or empty string if not found
      */
@@ -89,26 +139,56 @@ public:
     void clear();
     
     /**
-     * Save the database to a CSV file
+     * Save the database to a CSV file, in short code key order. The store is
+     * read a page at a time and the file written through a large buffer.
      * @param filename Path to the CSV file
      * @return true if successful, false otherwise
      */
     bool saveToFile(const std::string& filename) const;
     
     /**
-     * Load the database from a CSV file
+     * Load the database from a CSV file, streamed through a fixed buffer
+     * and committed to the store in batches. Links saved with an expiry
+     * time (by UrlShortener) are skipped, here and in loadSnapshot(): this
+     * store has no expiry.
      * @param filename Path to the CSV file
+     * @param merge Whether to add to the current database instead of
+     *        replacing it; existing codes and URLs keep their mappings (default: false)
      * @return true if successful, false otherwise
      */
-    bool loadFromFile(const std::string& filename);
+    bool loadFromFile(const std::string& filename, bool merge = false);
+    
+    /**
+     * Save the database to a binary snapshot (see url_snapshot.h)
+     * @param filename Path to the snapshot file
+     * @return true if successful, false otherwise
+     */
+    bool saveSnapshot(const std::string& filename) const;
+    
+    /**
+     * Load the database from a binary snapshot, replacing the current one.
+     * Checksums are verified on parallel threads before anything is
+     * replaced; the store is then filled on the calling thread, writing
+     * each index segment once.
+     * @param filename Path to the snapshot file
+     * @param numThreads Threads used to verify the file; 0 uses the hardware concurrency (default: 0)
+     * @return true if loaded, false if the file is unreadable or corrupt
+     */
+    bool loadSnapshot(const std::string& filename, size_t numThreads = 0);
     
     /**
      * Get statistics about the database
-     * @param totalUrls Output: total number of URLs
+     * @param totalUrls Output: total number of distinct URLs
      * @param totalShortCodes Output: total number of short codes
      */
     void getStats(size_t& totalUrls, size_t& totalShortCodes) const;
     
+    /**
+     * Get the redirect cache counters
+     * @return Hits, negative hits, misses and evictions since construction
+     */
+    RedirectCache::Stats getCacheStats() const;
+    
     /**
      * Add a server to the KeyValue store cluster
      * @param serverId Server identifier
@@ -147,21 +227,33 @@ public:
      * Decode a base62 string to a number (public for testing/utility)
      * @param encoded Base62 encoded string
      * @return Decoded number
+     * @throws std::invalid_argument if the string is not valid base62 or overflows 64 bits
      */
     static uint64_t decodeBase62(const std::string& encoded);
 
 private:
     std::string baseUrl_;                    // Base URL for shortened links
     std::unique_ptr<KeyValueStore> kvStore_; // KeyValue store backend
-    std::unique_ptr<KeyValueStore> reverseKvStore_; // Reverse mapping: longUrl -> shortCode
-    uint64_t nextId_;                        // Next ID to use for encoding
-    std::vector<std::string> shortCodeIndex_; // Index of all short codes for iteration
+    std::unique_ptr<KeyValueStore> reverseKvStore_; // Reverse mapping: URL fingerprint -> shortCode
+    std::unique_ptr<RedirectCache> redirectCache_;  // Hot short code -> URL entries, in front of kvStore_
+    uint64_t nextId_;                        // Next ID to use for encoding, from the current lease
+    uint64_t leaseEnd_;                      // One past the last leased ID; nextId_ == leaseEnd_ when used up
+    size_t idBlockSize_;                     // IDs leased from the store at a time
+    size_t indexSize_;                       // Number of short codes in the index
+    size_t sealedSegments_;                  // Full index segments, never rewritten
+    std::string openSegment_;                // Comma-separated codes of the last, partial segment
+    size_t openSegmentSize_;                 // Number of codes in openSegment_
+    bool canonicalizeUrls_;                  // Whether URLs are canonicalized before they are stored
     
     // Key prefixes for different data types
     static constexpr const char* SHORT_CODE_PREFIX = "sc:";
-    static constexpr const char* LONG_URL_PREFIX = "url:";
-    static constexpr const char* NEXT_ID_KEY = "next_id";
-    static constexpr const char* INDEX_KEY = "index";
+    static constexpr const char* LONG_URL_PREFIX = "url:";      // Followed by a URL fingerprint
+    static constexpr const char* NEXT_ID_KEY = "next_id";       // Last ID leased by any instance
+    static constexpr const char* INDEX_SEGMENT_PREFIX = "index:";
+    static constexpr const char* INDEX_SEGMENT_COUNT_KEY = "index_segments";
+    static constexpr size_t IndexSegmentSize = 256;  // Short codes per index segment
+    static constexpr size_t ImportBatchSize = 4096;  // CSV rows per store batch
+    static constexpr size_t ExportPageSize = 4096;   // Store entries read per page when saving
     
     /**
      * Generate a unique short code
@@ -169,6 +261,23 @@ private:
      */
     std::string generateShortCode();
     
+    /**
+     * Find the code of a URL through the reverse store
+     * @param url URL in stored form
+     * @param fingerprint UrlFingerprint::compute(url)
+     * @param freeKey Output if not found: the URL's reverse key, the first
+     *        key of the fingerprint not taken by another URL
+     * @return Short code, or empty string if the URL isn't stored
+     */
+    std::string findCode(const std::string& url, uint64_t fingerprint, std::string& freeKey) const;
+    
+    /**
+     * Get the spelling a URL is stored and deduplicated under
+     * @param url URL as given
+     * @return url, canonicalized if enabled
+     */
+    std::string storedForm(std::string_view url) const;
+    
     /**
      * Extract short code from a full shortened URL
      * @param shortUrl Full shortened URL
@@ -177,24 +286,68 @@ private:
     std::string extractShortCode(const std::string& shortUrl) const;
     
     /**
-     * Get next ID from store or generate new one
+     * Take ids from the current lease, leasing more when it runs short
+     * @param count Number of consecutive ids to take (default: 1)
+     * @return First id taken
+     * @throws std::runtime_error if ids can't be leased
+     */
+    uint64_t getNextId(size_t count = 1);
+    
+    /**
+     * Lease a block of ids by advancing the store's counter
+     * @param count Number of ids
+     * @throws std::runtime_error if the counter can't be advanced
      */
-    uint64_t getNextId();
+    void leaseIds(uint64_t count);
     
     /**
-     * Save next ID to store
+     * Mark ids as taken, e.g. by loaded codes: advance the store's counter
+     * to at least id and drop them from the current lease
+     * @param id Last id taken
      */
-    void saveNextId(uint64_t id);
+    void reserveIdsThrough(uint64_t id);
     
     /**
-     * Save index to store
+     * Read the store's counter
+     * @return Last id leased by any instance, 0 if none
      */
-    void saveIndex();
+    uint64_t lastLeasedId() const;
     
     /**
-     * Load index from store
+     * Append a short code to the open index segment, sealing it when full
+     * @param shortCode The short code to append
+     * @param writeOpenSegment Whether to persist the open segment now; bulk
+     *        loads pass false and write it once at the end (default: true)
+     */
+    void appendToIndex(const std::string& shortCode, bool writeOpenSegment = true);
+    
+    /**
+     * Load the index position from store: the sealed segment count and the
+     * open segment. Sealed segments stay in the store until they are walked.
      */
     void loadIndex();
+    
+    /**
+     * Read one index segment back from the store
+     * @param segment Segment number
+     * @return Short codes in the segment, in insertion order
+     */
+    std::vector<std::string> readIndexSegment(size_t segment) const;
+    
+    /**
+     * Get the store key of an index segment
+     * @param segment Segment number
+     * @return Key of the segment
+     */
+    static std::string indexSegmentKey(size_t segment);
+    
+    /**
+     * Get a reverse store key of a URL fingerprint
+     * @param fingerprint URL fingerprint
+     * @param probe 0 for the first URL with the fingerprint, n for the one after n others (default: 0)
+     * @return Key of the reverse entry
+     */
+    static std::string reverseKey(uint64_t fingerprint, size_t probe = 0);
 };
 
 #endif // URL_SHORTENER_KV_H
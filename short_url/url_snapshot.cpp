@@ -0,0 +1,207 @@
+#include "url_snapshot.h"
+#include "xxh64.hpp"
+
+namespace {
+
+// Fixed-size file header; integers in host byte order
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t numSections;
+    uint64_t directoryOffset;
+    uint64_t nextId;
+    uint64_t numRecords;
+    uint64_t directoryChecksum;
+    uint64_t headerChecksum;        // checksum() of every field above
+};
+
+constexpr size_t HEADER_CHECKED_BYTES = offsetof(FileHeader, headerChecksum);
+constexpr size_t DIRECTORY_ENTRY_WORDS = 4;             // offset, size, records, checksum
+constexpr size_t RECORD_PREFIX_BYTES = 3 * sizeof(uint32_t);   // Code length, URL length, expiry
+constexpr size_t V1_RECORD_PREFIX_BYTES = 2 * sizeof(uint32_t);
+
+// xxh64 is written recursively; bounded blocks keep unoptimized builds off deep stacks
+constexpr size_t CHECKSUM_BLOCK_SIZE = 4096;
+
+} // namespace
+
+uint64_t url_snapshot::checksum(const char* data, size_t size) {
+    uint64_t hash = 0;
+    for (size_t offset = 0; offset < size; offset += CHECKSUM_BLOCK_SIZE) {
+        hash = xxh64::hash(data + offset, std::min(CHECKSUM_BLOCK_SIZE, size - offset), hash);
+    }
+    return hash;
+}
+
+UrlSnapshotWriter::UrlSnapshotWriter(const std::string& filename, size_t sectionBytes)
+    : file_(filename, std::ios::binary | std::ios::trunc)
+    , sectionBytes_(sectionBytes)
+    , sectionRecords_(0)
+    , numRecords_(0)
+{
+    // Room for the header, written last once the directory is known
+    FileHeader header = {};
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    section_.reserve(sectionBytes_);
+}
+
+bool UrlSnapshotWriter::isOpen() const {
+    return file_.is_open();
+}
+
+void UrlSnapshotWriter::add(std::string_view code, std::string_view url, uint32_t expiresAt) {
+    uint32_t prefix[3] = {static_cast<uint32_t>(code.size()), static_cast<uint32_t>(url.size()), expiresAt};
+    section_.append(reinterpret_cast<const char*>(prefix), sizeof(prefix));
+    section_.append(code.data(), code.size());
+    section_.append(url.data(), url.size());
+    sectionRecords_++;
+    numRecords_++;
+    
+    if (section_.size() >= sectionBytes_) {
+        closeSection();
+    }
+}
+
+bool UrlSnapshotWriter::finish(uint64_t nextId) {
+    if (sectionRecords_ > 0) {
+        closeSection();
+    }
+    
+    FileHeader header = {};
+    std::memcpy(header.magic, url_snapshot::Magic, sizeof(header.magic));
+    header.version = url_snapshot::Version;
+    header.numSections = directory_.size() / DIRECTORY_ENTRY_WORDS;
+    header.directoryOffset = static_cast<uint64_t>(file_.tellp());
+    header.nextId = nextId;
+    header.numRecords = numRecords_;
+    
+    const char* directory = reinterpret_cast<const char*>(directory_.data());
+    size_t directoryBytes = directory_.size() * sizeof(uint64_t);
+    header.directoryChecksum = url_snapshot::checksum(directory, directoryBytes);
+    header.headerChecksum = url_snapshot::checksum(reinterpret_cast<const char*>(&header),
+                                                   HEADER_CHECKED_BYTES);
+    
+    file_.write(directory, static_cast<std::streamsize>(directoryBytes));
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file_.close();
+    return file_.good();
+}
+
+void UrlSnapshotWriter::closeSection() {
+    directory_.push_back(static_cast<uint64_t>(file_.tellp()));
+    directory_.push_back(section_.size());
+    directory_.push_back(sectionRecords_);
+    directory_.push_back(url_snapshot::checksum(section_.data(), section_.size()));
+    
+    file_.write(section_.data(), static_cast<std::streamsize>(section_.size()));
+    section_.clear();
+    sectionRecords_ = 0;
+}
+
+UrlSnapshotReader::UrlSnapshotReader()
+    : data_(nullptr)
+    , size_(0)
+    , numRecords_(0)
+    , nextId_(0)
+    , recordPrefixBytes_(RECORD_PREFIX_BYTES)
+{
+}
+
+bool UrlSnapshotReader::read(const std::string& filename, size_t numThreads) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    // One read of the whole file; records are used where they land
+    std::streamoff fileSize = file.tellg();
+    if (fileSize < static_cast<std::streamoff>(sizeof(FileHeader))) {
+        return false;
+    }
+    size_ = static_cast<size_t>(fileSize);
+    buffer_.reset(new char[size_]);
+    data_ = buffer_.get();
+    file.seekg(0);
+    if (!file.read(buffer_.get(), fileSize)) {
+        return false;
+    }
+    
+    FileHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, url_snapshot::Magic, sizeof(header.magic)) != 0 ||
+        header.version < 1 || header.version > url_snapshot::Version ||
+        header.headerChecksum != url_snapshot::checksum(data_, HEADER_CHECKED_BYTES)) {
+        return false;
+    }
+    recordPrefixBytes_ = header.version == 1 ? V1_RECORD_PREFIX_BYTES : RECORD_PREFIX_BYTES;
+    
+    // Directory must sit inside the file and match its checksum
+    const uint64_t entryBytes = DIRECTORY_ENTRY_WORDS * sizeof(uint64_t);
+    if (header.directoryOffset < sizeof(FileHeader) || header.directoryOffset > size_ ||
+        header.numSections > (size_ - header.directoryOffset) / entryBytes ||
+        header.directoryChecksum != url_snapshot::checksum(data_ + header.directoryOffset,
+                                                           header.numSections * entryBytes)) {
+        return false;
+    }
+    
+    sections_.resize(header.numSections);
+    std::memcpy(sections_.data(), data_ + header.directoryOffset, header.numSections * entryBytes);
+    
+    uint64_t totalRecords = 0;
+    for (const Section& section : sections_) {
+        if (section.offset < sizeof(FileHeader) || section.offset > header.directoryOffset ||
+            section.size > header.directoryOffset - section.offset) {
+            return false;
+        }
+        totalRecords += section.records;
+    }
+    if (totalRecords != header.numRecords) {
+        return false;
+    }
+    
+    std::atomic<bool> valid(true);
+    url_snapshot::parallelFor(sections_.size(), numThreads, [this, &valid](size_t i) {
+        if (!verifySection(sections_[i])) {
+            valid.store(false, std::memory_order_relaxed);
+        }
+    });
+    if (!valid.load()) {
+        return false;
+    }
+    
+    numRecords_ = header.numRecords;
+    nextId_ = header.nextId;
+    return true;
+}
+
+std::unique_ptr<char[]> UrlSnapshotReader::release(size_t& size) {
+    size = size_;
+    return std::move(buffer_);
+}
+
+bool UrlSnapshotReader::verifySection(const Section& section) const {
+    const char* begin = data_ + section.offset;
+    if (url_snapshot::checksum(begin, section.size) != section.checksum) {
+        return false;
+    }
+    
+    // The records must exactly fill the section, or forEachRecord() would run past it
+    uint64_t remaining = section.size;
+    const char* p = begin;
+    for (uint64_t i = 0; i < section.records; ++i) {
+        if (remaining < recordPrefixBytes_) {
+            return false;
+        }
+        uint32_t lengths[2];
+        std::memcpy(lengths, p, sizeof(lengths));
+        uint64_t recordBytes = recordPrefixBytes_ + uint64_t(lengths[0]) + lengths[1];
+        if (recordBytes > remaining) {
+            return false;
+        }
+        p += recordBytes;
+        remaining -= recordBytes;
+    }
+    return remaining == 0;
+}
@@ -0,0 +1,214 @@
+#ifndef URL_SNAPSHOT_H
+#define URL_SNAPSHOT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * Binary URL Snapshot
+ *
+ * Versioned binary dump of (short code, long URL, expiry) records, the
+ * fast alternative to the CSV files:
+ *
+ *   Header    magic "URLSNAP\0", version, section count, directory offset,
+ *             next id, record count, checksum of the header
+ *   Sections  records of [u32 code length][u32 URL length][u32 expiry][code][URL]
+ *   Directory per section: offset, size, record count, checksum
+ *
+ * The expiry is in seconds since the Unix epoch, 0 for links that don't
+ * expire. Version 1 records have no expiry field and still load.
+ *
+ * Sections are independently checksummed (xxh64) and located through the
+ * directory, so a loader can verify and decode them on separate threads.
+ * Nothing needs escaping or parsing beyond the length prefixes, and the
+ * strings are used in place: the loaded file is one buffer that the caller
+ * can keep and point views into. Integers are stored in host byte order.
+ */
+namespace url_snapshot {
+
+inline constexpr char Magic[8] = {'U', 'R', 'L', 'S', 'N', 'A', 'P', '\0'};
+inline constexpr uint32_t Version = 2;
+
+/**
+ * Checksum a byte range
+ * @param data Bytes to checksum
+ * @param size Number of bytes
+ * @return xxh64 checksums of 4KB blocks, each seeded with the previous one
+ */
+uint64_t checksum(const char* data, size_t size);
+
+/**
+ * Run fn(i) for every i below count on up to numThreads threads
+ * @param count Number of work items
+ * @param numThreads Thread limit; 0 uses the hardware concurrency
+ * @param fn Callable taking size_t
+ */
+template <typename Fn>
+void parallelFor(size_t count, size_t numThreads, Fn fn) {
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    numThreads = std::min(numThreads, count);
+    
+    std::atomic<size_t> next(0);
+    auto worker = [&next, count, &fn]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            fn(i);
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < numThreads; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace url_snapshot
+
+/**
+ * Streams records into a snapshot file, one section at a time
+ */
+class UrlSnapshotWriter {
+public:
+    /**
+     * Constructor
+     * @param filename File to create or overwrite
+     * @param sectionBytes Target section size; a section is closed once it reaches this (default: 4MB)
+     */
+    explicit UrlSnapshotWriter(const std::string& filename, size_t sectionBytes = 4 * 1024 * 1024);
+    
+    /**
+     * Check whether the file could be opened
+     * @return true if open
+     */
+    bool isOpen() const;
+    
+    /**
+     * Append a record
+     * @param code Short code
+     * @param url Long URL
+     * @param expiresAt Expiry time in seconds since the Unix epoch, 0 for none (default: 0)
+     */
+    void add(std::string_view code, std::string_view url, uint32_t expiresAt = 0);
+    
+    /**
+     * Write the last section, the directory and the header
+     * @param nextId Next id to generate, restored on load
+     * @return true if everything reached the file
+     */
+    bool finish(uint64_t nextId);
+
+private:
+    std::ofstream file_;
+    size_t sectionBytes_;                   // Target section size
+    std::string section_;                   // Records of the open section
+    uint64_t sectionRecords_;               // Records in section_
+    uint64_t numRecords_;                   // Records written so far
+    std::vector<uint64_t> directory_;       // offset, size, records, checksum per closed section
+    
+    void closeSection();
+};
+
+/**
+ * A snapshot file read into memory and verified
+ */
+class UrlSnapshotReader {
+public:
+    UrlSnapshotReader();
+    
+    /**
+     * Read a snapshot file and verify every checksum
+     * @param filename Snapshot file
+     * @param numThreads Threads used to verify sections; 0 uses the hardware concurrency
+     * @return false if the file can't be read, isn't a snapshot of a known
+     *         version, or is truncated or corrupt
+     */
+    bool read(const std::string& filename, size_t numThreads = 0);
+    
+    /**
+     * Get the number of sections
+     * @return Section count
+     */
+    size_t numSections() const { return sections_.size(); }
+    
+    /**
+     * Get the number of records in all sections
+     * @return Record count
+     */
+    uint64_t numRecords() const { return numRecords_; }
+    
+    /**
+     * Get the next id saved with the snapshot
+     * @return Next id to generate
+     */
+    uint64_t nextId() const { return nextId_; }
+    
+    /**
+     * Call fn(code, url, expiresAt) for every record of a section, in file
+     * order. Sections can be walked concurrently; the views point into the
+     * buffer.
+     * @param section Section index, below numSections()
+     * @param fn Callable taking (std::string_view, std::string_view, uint32_t)
+     */
+    template <typename Fn>
+    void forEachRecord(size_t section, Fn fn) const {
+        const char* p = data_ + sections_[section].offset;
+        for (uint64_t i = 0; i < sections_[section].records; ++i) {
+            uint32_t codeLength;
+            uint32_t urlLength;
+            uint32_t expiresAt = 0;
+            std::memcpy(&codeLength, p, sizeof(codeLength));
+            std::memcpy(&urlLength, p + sizeof(codeLength), sizeof(urlLength));
+            if (recordPrefixBytes_ > sizeof(codeLength) + sizeof(urlLength)) {
+                std::memcpy(&expiresAt, p + sizeof(codeLength) + sizeof(urlLength), sizeof(expiresAt));
+            }
+            p += recordPrefixBytes_;
+            std::string_view code(p, codeLength);
+            std::string_view url(p + codeLength, urlLength);
+            p += codeLength + urlLength;
+            fn(code, url, expiresAt);
+        }
+    }
+    
+    /**
+     * Hand the buffer the record views point into to the caller, e.g. to a
+     * StringArena. The reader can still walk records while the caller keeps
+     * the buffer alive.
+     * @param size Output: buffer size in bytes
+     * @return The buffer
+     */
+    std::unique_ptr<char[]> release(size_t& size);
+
+private:
+    struct Section {
+        uint64_t offset;        // Start of the records in the buffer
+        uint64_t size;          // Bytes of records
+        uint64_t records;       // Number of records
+        uint64_t checksum;      // checksum() of the bytes
+    };
+    
+    std::unique_ptr<char[]> buffer_;    // Whole file, until release()
+    const char* data_;                  // Whole file, also after release()
+    size_t size_;                       // File size
+    std::vector<Section> sections_;     // Parsed directory
+    uint64_t numRecords_;               // Records in all sections
+    uint64_t nextId_;                   // Next id saved with the snapshot
+    size_t recordPrefixBytes_;          // Length fields (and expiry, from version 2) per record
+    
+    bool verifySection(const Section& section) const;
+};
+
+#endif // URL_SNAPSHOT_H